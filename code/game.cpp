@@ -9,6 +9,7 @@
 #include "rendering/openGLFunctions.hpp"
 #include "rendering/renderer.hpp"
 #include "utils/meshGenerators.hpp"
+#include "utils/meshSimplifier.hpp"
 #include "utils/camera.hpp"
 #include "utils/arcBallController.hpp"
 #include "utils/flyCameraController.hpp"
@@ -17,9 +18,6 @@
 // TODO:
 // -----
 //  - 3D Transform implementation
-//  - Defines in shaderprogram before compiling
-//      Shaderprogram p;
-//      init(&p, {"xyz.frag", "xyz.vert"}, alloc, const char* defines);
 //  - Debug rendering (Lines, spheres..., just color)
 //  - Collision detection system (Raycasts into world)
 //  - Textures from Shaderfiles (Maybe animated)
@@ -79,9 +77,51 @@ AutoShaderProgram imageShader;
 AutoShaderProgram skyShader;
 AutoShaderProgram postProcessShader;
 AutoShaderProgram testShader;
-Framebuffer postProcessFramebuffer;
-Texture testTexture;
+UniformHandle<Texture*> postFrameUniform;
+UniformHandle<Texture*> postDepthUniform;
+RenderGraph renderGraph;
+WorkQueue workQueue;
+TextureLoader textureLoader;
+AsyncTexture* testTexture;
+TextureAtlas atlas;
+SpriteBatch spriteBatch;
+#define ICON_COUNT 24
+AtlasRegion iconRegions[ICON_COUNT];
+
+// Round icons of different sizes and colors, all packed into the atlas
+void createIcons()
+{
+    TextureData icons[ICON_COUNT];
+    for (int i = 0; i < ICON_COUNT; i++)
+    {
+        TextureData& icon = icons[i];
+        icon.width = 16 + (i * 7) % 49;
+        icon.height = 16 + (i * 13) % 49;
+        icon.numChannels = 4;
+        icon.alloc = gameAlloc;
+        icon.blk = gameAlloc->alloc(icon.width * icon.height * 4);
+        icon.data = (byte*) icon.blk.data;
+        vec3 color = vec3((i % 3) / 2.0f, (i % 5) / 4.0f, (i % 7) / 6.0f);
+        for (int y = 0; y < icon.height; y++) {
+            for (int x = 0; x < icon.width; x++) {
+                vec2 d = vec2((x + 0.5f) / icon.width, (y + 0.5f) / icon.height) * 2.0f - vec2(1.0f);
+                byte* p = &icon.data[(y * icon.width + x) * 4];
+                p[0] = (byte)(color.x * 255);
+                p[1] = (byte)(color.y * 255);
+                p[2] = (byte)(color.z * 255);
+                p[3] = (byte)(clamp((1.0f - length(d)) * 8.0f, 0.0f, 1.0f) * 255);
+            }
+        }
+    }
+    insert(&atlas, icons, ICON_COUNT, iconRegions);
+    for (int i = 0; i < ICON_COUNT; i++) {
+        shutdown(&icons[i]);
+    }
+}
+
 MaterialRenderer materialRenderer;
+LodMesh lodSphere;
+LodInstance lodSphereInstance;
 void gameAfterReload() 
 {
     // Set game options
@@ -97,29 +137,38 @@ void gameAfterReload()
     gameState->windowState.fullscreen = true;
     //gameState->windowState.hideCursor = true;
 
-    // Init framebuffers
-    init(&postProcessFramebuffer, 
-            gameState->windowState.width, 
-            gameState->windowState.height,
-            true, true, true, GL_RGBA);
+    // Render targets are created by the graph on the first frame
+    init(&renderGraph);
 
     // Init renderers
     init(&materialRenderer, &gameData->camera, gameAlloc);
+    MeshData sphereData;
+    createSphereMeshData(&sphereData, 32, 64, gameAlloc);
+    init(&lodSphere, &sphereData, gameAlloc);
+    shutdown(&sphereData);
+    init(&lodSphereInstance, &lodSphere);
     
     // Set default options
-    glClearColor(0, 0, 0, 0);
-    glFrontFace(GL_CCW);
-    glCullFace(GL_BACK);
+    setClearColor(vec4(0.0f));
+    setFrontFace(GL_CCW);
+    setCullFace(GL_BACK);
 
-    // Init textures
-    init(&testTexture, "test.bmp", gameAlloc);
+    // Init textures, they stream in during the next ticks
+    init(&workQueue);
+    init(&textureLoader, &workQueue, gameAlloc);
+    testTexture = load(&textureLoader, "test.bmp");
+    init(&atlas, gameAlloc);
+    createIcons();
 
     // Init shaders
     init(&imageShader, {"image.vert", "image.frag"}, gameAlloc);
     init(&colorShader, {"color.vert", "color.frag"}, gameAlloc);
     init(&skyShader, {"sky.vert", "sky.frag"}, gameAlloc);
     init(&postProcessShader, {"postProcess.vert", "postProcess.frag"}, gameAlloc);
+    init(&postFrameUniform, &postProcessShader, "frame");
+    init(&postDepthUniform, &postProcessShader, "depthMap");
     init(&testShader, {"test/test.vert", "test/test.frag"}, gameAlloc);
+    init(&spriteBatch, &atlas, gameAlloc);
 
     bindDefaultFramebuffer(gameState->windowState.width, gameState->windowState.height);
 }
@@ -129,29 +178,31 @@ void gameBeforeReload()
     //loggf("Before reload\n");
     //loggf("width %d, height %d\n", gameState->windowState.width, gameState->windowState.height);
     //loggf("viewportWidth %d, viewportHeight %d\n", renderState.viewportWidth, renderState.viewportHeight);
-    shutdown(&testTexture);
+    shutdown(&textureLoader);
+    shutdown(&workQueue);
+    shutdown(&spriteBatch);
+    shutdown(&atlas);
     shutdown(&imageShader);
     shutdown(&colorShader);
     shutdown(&skyShader);
     shutdown(&postProcessShader);
-    shutdown(&postProcessFramebuffer);
+    shutdown(&renderGraph);
     shutdown(&materialRenderer);
+    shutdown(&lodSphere);
     shutdown(&testShader);
 }
 
-void renderScene() 
+void scenePass(RenderGraph* /*g*/, int /*pass*/, void* /*userData*/)
 {
-#define Resolution gameState->windowState.width, gameState->windowState.height
-    //bind(&postProcessFramebuffer, Resolution);
-    //glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+    glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
     //// Draw sky
-    //glDisable(GL_DEPTH_TEST);
-    //glDisable(GL_CULL_FACE);
+    //setDepthTest(false);
+    //setCulling(false);
     //draw(&gameData->cubeMesh, &skyShader, vec3(0.0f));
 
     //// Draw meshes
 
-    //setUniform(&imageShader.program, "image", &testTexture);
+    //setUniform(&imageShader.program, "image", &testTexture->texture);
     //draw(&gameData->planeMesh, &imageShader, vec3(0.0f));
 
     ////draw(&gameData->cubeMesh, &imageShader, vec3(3.0f));
@@ -162,19 +213,63 @@ void renderScene()
     //draw(&materialRenderer, &gameData->cubeMesh, vec3(0));
     //render(&materialRenderer, gameState);
 
-    //bindDefaultFramebuffer(Resolution);
-    //glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
-    //setUniform(&postProcessShader, "frame", getColorTexture(&postProcessFramebuffer));
-    //setUniform(&postProcessShader, "depthMap", getDepthTexture(&postProcessFramebuffer));
-    //updateAutoUniforms(&postProcessShader);
-    //draw(&gameData->quadMesh, &postProcessShader);
-
     // Test shader
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
-    glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+    setDepthTest(true);
+    setCulling(true);
     updateAutoUniforms(&testShader);
     draw(&gameData->quadMesh, &testShader);
+
+    // The lod follows the projected size of the sphere
+    draw(&materialRenderer, &lodSphereInstance, vec3(0.0f, 0.0f, -4.0f));
+    render(&materialRenderer, gameState);
+}
+
+void postProcessPass(RenderGraph* g, int pass, void* /*userData*/)
+{
+    setDepthTest(false);
+    setCulling(false);
+    updateAutoUniforms(&postProcessShader);
+    setUniform(&postFrameUniform, getReadTexture(g, pass, 0));
+    setUniform(&postDepthUniform, getReadTexture(g, pass, 1));
+    draw(&gameData->quadMesh, &postProcessShader);
+}
+
+// One bind and draw per atlas page
+void uiPass(RenderGraph* /*g*/, int /*pass*/, void* /*userData*/)
+{
+    vec2 pos = vec2(10.0f);
+    for (int i = 0; i < ICON_COUNT; i++) {
+        if (pos.x + iconRegions[i].width > gameState->windowState.width) {
+            pos = vec2(10.0f, pos.y + 70.0f);
+        }
+        draw(&spriteBatch, iconRegions[i], pos);
+        pos.x += iconRegions[i].width + 4.0f;
+    }
+    render(&spriteBatch, gameState->windowState.width, gameState->windowState.height);
+}
+
+void renderScene() 
+{
+    RenderGraph* g = &renderGraph;
+    beginRenderGraph(g, gameState->windowState.width, gameState->windowState.height);
+    int backbuffer = importBackbuffer(g);
+    int sceneColor = createTexture(g, "sceneColor", GL_RGBA8);
+    int sceneDepth = createTexture(g, "sceneDepth", GL_DEPTH_COMPONENT24);
+
+    int scene = addPass(g, "scene", &scenePass, nullptr);
+    write(g, scene, sceneColor);
+    write(g, scene, sceneDepth);
+
+    int post = addPass(g, "postProcess", &postProcessPass, nullptr);
+    read(g, post, sceneColor);
+    read(g, post, sceneDepth);
+    write(g, post, backbuffer);
+
+    int ui = addPass(g, "ui", &uiPass, nullptr);
+    write(g, ui, backbuffer);
+
+    compile(g);
+    execute(g);
 }
 
 void gameTick() 
@@ -236,11 +331,17 @@ void gameTick()
     //loggf("width %d, height %d\n", gameState->windowState.width, gameState->windowState.height);
     //loggf("viewportWidth %d, viewportHeight %d\n", renderState.viewportWidth, renderState.viewportHeight);
 
+    updateShaderCompiles();
+    update(&textureLoader);
+    update(&atlas);
     renderScene();
 }
 
 void gameInit() 
 {
+    // Report which simd paths the math kernels will use on this machine
+    logKernelDispatch();
+
     // Create basic meshes 
     createCubeMesh(&gameData->cubeMesh, gameAlloc);
     createPlaneMesh(&gameData->planeMesh, gameAlloc);
@@ -0,0 +1,18 @@
+# Builds the headless game (No window, no gpu), run from the repository root:
+#   ./code/headless/build.sh && ./build/headless 120
+dir=$(pwd)
+ldir=${dir}/libs
+odir=${dir}/build
+cdir=${dir}/code/headless
+
+#Compiler arguments
+source="${cdir}/headlessMain.cpp"
+output=${odir}/headless
+# The allocator init functions set members before new(this) (To set the vtable on raw memory),
+# gcc would remove these stores without -fno-lifetime-dse
+flags="-std=c++17 -O2 -w -fno-lifetime-dse -pthread"
+includes="-I ${dir}/uppLib -I ${ldir}/stb -I ${ldir}/openGLExtensions"
+
+#Command
+mkdir -p ${odir}
+g++ $flags -o $output $source $includes
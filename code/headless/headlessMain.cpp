@@ -0,0 +1,455 @@
+// HEADLESS BUILD
+// Runs the game without window and gpu (E.g. on the linux ci machines).
+// All gl calls go to the recording backend in rendering/headlessGL.hpp,
+// after the last frame the gl statistics are printed.
+//
+// Usage: headless [frameCount] [-commands] [-textureStress n] [-reloadShaders] [-reloadShader path] [-renderGraph]
+//                 [-lightClusters] [-lods]
+//     -commands prints the command stream of the last frame
+//     -textureStress requests n async texture loads after init and reports the tick
+//      times until they are loaded, compared to loading them synchronously
+//     -reloadShaders triggers the file listener of every shader file after init (Like an edit)
+//      and reports the ticks until all are rebuilt and how often the game waited for the compiler
+//     -reloadShader does the same for one file, relative to ressources/shaders/ (E.g. common/frameUniforms.glsl)
+//     -renderGraph compiles a bloom like pass chain (Declared out of order, with an unused pass)
+//      and reports the execution order, culling and transient memory, then again after a resize
+//     -lightClusters assigns 1024 point and spot lights at every simd level, reports the time and
+//      compares the clusters with a brute force test of every light against every cluster
+//     -lods moves the camera away from the lod sphere and back, checks the lod switches and the hysteresis
+// Returns 1 if the backend detected invalid gl usage
+
+#include <cstring>
+#include <new>
+#include <initializer_list>
+#include <chrono>
+#include <thread>
+#include "uppLib.hpp"
+
+// Includes so that opengl types and enums are defined
+// (gl.h declares glActiveTexture and the compressed texture functions, which are function pointers here)
+#define glActiveTexture __system_glActiveTexture
+#define glCompressedTexImage2D __system_glCompressedTexImage2D
+#define glCompressedTexSubImage2D __system_glCompressedTexSubImage2D
+#include <GL/gl.h>
+#undef glActiveTexture
+#undef glCompressedTexImage2D
+#undef glCompressedTexSubImage2D
+#include <GL/glext.h>
+typedef int (*PFNWGLSWAPINTERVALEXTPROC)(int);
+typedef const char* (*PFNWGLGETEXTENSIONSSTRINGARBPROC)(void*);
+
+// The game hooks are shared with the windows build
+#define __declspec(x)
+#include "../platform.hpp"
+#include "../game.hpp"
+#include "../game.cpp"
+#include "../rendering/headlessGL.hpp"
+#include "../win32/win32_gameHooks.cpp"
+#include "posixFileMapping.cpp"
+#undef assert // stb_image includes <assert.h>, which hides the uppLib assert
+
+// File listeners are only recorded, there are no file changes without the -reload options
+#define HEADLESS_MAX_LISTENERS 64
+struct HeadlessListener
+{
+    bool alive;
+    char path[256];
+    listenerCallbackFunc callback;
+    void* userData;
+};
+HeadlessListener headlessListeners[HEADLESS_MAX_LISTENERS];
+
+ListenerToken headlessCreateFileListener(const char* path, listenerCallbackFunc callback, void* userData) 
+{
+    for (int i = 0; i < HEADLESS_MAX_LISTENERS; i++)
+    {
+        HeadlessListener& l = headlessListeners[i];
+        if (!l.alive) {
+            l.alive = true;
+            snprintf(l.path, sizeof(l.path), "%s", path);
+            l.callback = callback;
+            l.userData = userData;
+            return i;
+        }
+    }
+    invalid_path("Headless: Too many file listeners");
+    return -1;
+}
+
+void headlessDeleteFileListener(ListenerToken token) 
+{
+    if (token >= 0 && token < HEADLESS_MAX_LISTENERS) {
+        headlessListeners[token].alive = false;
+    }
+}
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Ticks are paced to 60 fps (Like vsync), otherwise the workers get no cpu time on small machines
+void runTextureStress(GameState* state, int textureCount, int maxFrames)
+{
+    auto syncStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < textureCount; i++) {
+        Texture t;
+        init(&t, "test.bmp", gameAlloc);
+        shutdown(&t);
+    }
+    double syncMs = msSince(syncStart);
+    headlessGLEndFrame();
+
+    for (int i = 0; i < textureCount; i++) {
+        load(&textureLoader, "test.bmp");
+    }
+    double minMs = 1e9, maxMs = 0, sumMs = 0;
+    int frames = 0;
+    double tslf = 1.0 / 60.0;
+    while (getPendingCount(&textureLoader) > 0 && frames < maxFrames)
+    {
+        auto start = std::chrono::steady_clock::now();
+        state->time.now += tslf;
+        state->time.tslf = tslf;
+        gameTick(state);
+        double ms = msSince(start);
+        headlessGLEndFrame();
+        minMs = min(minMs, ms);
+        maxMs = max(maxMs, ms);
+        sumMs += ms;
+        frames++;
+        std::this_thread::sleep_for(std::chrono::microseconds((int)(tslf * 1e6 - ms * 1e3)));
+    }
+
+    loggf("Texture stress: %d textures, synchronous load blocked %.1f ms\n", textureCount, syncMs);
+    loggf("Texture stress: async load took %d ticks, %d pending, tick ms min %.2f avg %.2f max %.2f\n",
+            frames, getPendingCount(&textureLoader), minMs, sumMs / max(frames, 1), maxMs);
+}
+
+// Calls the listeners like a change of the file (Or of every shader file if path is nullptr),
+// the sources did not change, so the program cache is bypassed.
+// Listeners are registered with the full path, path may be relative to SHADER_DIR
+void runShaderReload(GameState* state, const char* path, int maxFrames)
+{
+    char fullPath[SHADER_MAX_PATH];
+    if (path != nullptr && strncmp(path, SHADER_DIR, strlen(SHADER_DIR)) != 0) {
+        snprintf(fullPath, sizeof(fullPath), "%s%s", SHADER_DIR, path);
+        path = fullPath;
+    }
+    programCache.supported = false;
+    SCOPE_EXIT(programCache.supported = true);
+    u64 stallsBefore = headlessGL.total.compileStalls;
+    int submittedBefore = shaderCompiler.stats.submitted;
+    for (int i = 0; i < HEADLESS_MAX_LISTENERS; i++)
+    {
+        HeadlessListener& l = headlessListeners[i];
+        if (l.alive && l.callback == &onShaderFileChanged && (path == nullptr || strcmp(l.path, path) == 0)) {
+            l.callback(l.path, l.userData);
+        }
+    }
+
+    int frames = 0;
+    double tslf = 1.0 / 60.0;
+    while ((shaderCompiler.dirtyCount > 0 || shaderCompiler.pendingCount > 0) && frames < maxFrames)
+    {
+        state->time.now += tslf;
+        state->time.tslf = tslf;
+        gameTick(state);
+        headlessGLEndFrame();
+        frames++;
+    }
+    loggf("Shader reload: %d programs submitted, built after %d ticks, %d pending, %llu compile stalls\n",
+            shaderCompiler.stats.submitted - submittedBefore, frames, shaderCompiler.pendingCount, 
+            headlessGL.total.compileStalls - stallsBefore);
+}
+
+void clearPass(RenderGraph* /*g*/, int /*pass*/, void* /*userData*/) {
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void runRenderGraph(int width, int height)
+{
+    RenderGraph g;
+    init(&g);
+    for (int frame = 0; frame < 4; frame++)
+    {
+        if (frame == 2) {
+            width /= 2;
+            height /= 2;
+        }
+        beginRenderGraph(&g, width, height);
+        int backbuffer = importBackbuffer(&g);
+        int color = createTexture(&g, "color", GL_RGBA16F);
+        int depth = createTexture(&g, "depth", GL_DEPTH_COMPONENT24);
+        int bright = createTexture(&g, "bright", width / 2, height / 2, GL_RGBA16F);
+        int blurH = createTexture(&g, "blurH", width / 2, height / 2, GL_RGBA16F);
+        int blurV = createTexture(&g, "blurV", width / 2, height / 2, GL_RGBA16F);
+        int debug = createTexture(&g, "debug", GL_RGBA8);
+
+        int composite = addPass(&g, "composite", &clearPass, nullptr);
+        read(&g, composite, color);
+        read(&g, composite, blurV);
+        write(&g, composite, backbuffer);
+        int debugView = addPass(&g, "debugView", &clearPass, nullptr);
+        read(&g, debugView, depth);
+        write(&g, debugView, debug);
+        int v = addPass(&g, "blurV", &clearPass, nullptr);
+        read(&g, v, blurH);
+        write(&g, v, blurV);
+        int h = addPass(&g, "blurH", &clearPass, nullptr);
+        read(&g, h, bright);
+        write(&g, h, blurH);
+        int down = addPass(&g, "brightPass", &clearPass, nullptr);
+        read(&g, down, color);
+        write(&g, down, bright);
+        int scene = addPass(&g, "scene", &clearPass, nullptr);
+        write(&g, scene, color);
+        write(&g, scene, depth);
+
+        compile(&g);
+        execute(&g);
+        headlessGLEndFrame();
+        if (frame == 0 || frame == 2) {
+            loggf("Render graph %dx%d order:", width, height);
+            for (int i = 0; i < g.orderCount; i++) {
+                loggf(" %s", g.passes[g.order[i]].name);
+            }
+            loggf("\n");
+        }
+        print(&g.stats);
+    }
+    shutdown(&g);
+    headlessGLEndFrame();
+}
+
+float randomLightFloat(float min, float max) {
+    return min + (max - min) * ((float)rand() / RAND_MAX);
+}
+
+// Indices of the visible lights overlapping each cluster, tested without the slice and row steps
+bool matchesBruteForce(LightClusters* c, const mat4& view, const mat4& projection, int count, Light* lights)
+{
+    SCOPE_EXIT_ROLLBACK;
+    float* x = (float*) tmpAlloc.alloc(sizeof(float) * count);
+    float* y = (float*) tmpAlloc.alloc(sizeof(float) * count);
+    float* z = (float*) tmpAlloc.alloc(sizeof(float) * count);
+    float* r = (float*) tmpAlloc.alloc(sizeof(float) * count);
+    int* visible = (int*) tmpAlloc.alloc(sizeof(int) * count);
+    for (int i = 0; i < count; i++) {
+        BoundingSphere s = getLightBounds(lights[i], view);
+        x[i] = s.center.x;
+        y[i] = s.center.y;
+        z[i] = s.center.z;
+        r[i] = s.radius;
+    }
+    int visibleCount = cullSpheresScalar(extractFrustum(projection), count, x, y, z, r, visible);
+    for (int i = 0; i < visibleCount; i++) {
+        int l = visible[i];
+        x[i] = x[l];
+        y[i] = y[l];
+        z[i] = z[l];
+        r[i] = r[l];
+    }
+
+    int* overlap = (int*) tmpAlloc.alloc(sizeof(int) * (visibleCount + 1));
+    for (int cluster = 0; cluster < LIGHT_CLUSTER_COUNT; cluster++)
+    {
+        int overlapCount = overlapSpheresAABBScalar(c->clusterBounds[cluster], visibleCount, x, y, z, r, overlap);
+        u32* clusterIndices = c->indices + c->header->clusters[cluster][0];
+        if ((int)c->header->clusters[cluster][1] != overlapCount) {
+            return false;
+        }
+        for (int i = 0; i < overlapCount; i++) {
+            if (clusterIndices[i] != (u32)visible[overlap[i]]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void runLightClusters(int width, int height)
+{
+    srand(5);
+    const int lightCount = MAX_CLUSTER_LIGHTS;
+    Light* lights = (Light*) malloc(sizeof(Light) * lightCount);
+    SCOPE_EXIT(free(lights));
+    for (int i = 0; i < lightCount; i++)
+    {
+        vec3 pos = vec3(randomLightFloat(-60, 60), randomLightFloat(0, 10), randomLightFloat(-60, 60));
+        vec3 color = vec3(randomLightFloat(0, 1), randomLightFloat(0, 1), randomLightFloat(0, 1));
+        float range = randomLightFloat(1, 6);
+        if (i % 4 == 0) {
+            vec3 dir = vec3(randomLightFloat(-1, 1), -1, randomLightFloat(-1, 1));
+            float outer = randomLightFloat(0.2f, 1.2f);
+            lights[i] = spotLight(pos, dir, color, range * 2, outer * 0.8f, outer);
+        }
+        else {
+            lights[i] = pointLight(pos, color, range);
+        }
+    }
+    mat4 view = lookAt(vec3(0, 5, 20), vec3(0, 0, -20));
+    mat4 proj = projection(0.01f, 100.0f, d2r(90), (float)width / height);
+
+    SystemAllocator alloc;
+    LightClusters clusters;
+    init(&clusters, &alloc);
+    SimdLevel::ENUM supported = getSupportedSimdLevel(getCpuFeatures());
+    for (int level = 0; level <= supported; level++)
+    {
+        setMaxSimdLevel((SimdLevel::ENUM) level);
+        assignLights(&clusters, view, proj, lightCount, lights);
+        bool match = matchesBruteForce(&clusters, view, proj, lightCount, lights);
+
+        const int runs = 100;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < runs; i++) {
+            assignLights(&clusters, view, proj, lightCount, lights);
+        }
+        loggf("Light clusters at %s (overlapSpheresAABB uses %s): matches brute force should be 1: %d, %.3f ms\n",
+                toStr((SimdLevel::ENUM) level), toStr(overlapSpheresAABBKernel->selectedLevel), match, msSince(start) / runs);
+    }
+    setMaxSimdLevel(supported);
+    print(&clusters.stats);
+
+    // Upload path, the range must respect the storage buffer alignment
+    StreamBuffer stream;
+    int regionSize = getUploadSize(&clusters) + renderState.storageBufferAlignment;
+    init(&stream, GL_SHADER_STORAGE_BUFFER, regionSize * STREAM_BUFFER_FRAMES, &alloc);
+    for (int frame = 0; frame < 4; frame++) {
+        renderState.tickCounter++; // Next stream region, like gameTick
+        upload(&clusters, &stream);
+        headlessGLEndFrame();
+    }
+    shutdown(&stream);
+    shutdown(&clusters);
+    headlessGLEndFrame();
+}
+
+// Moves the camera away from the game's lod sphere and back. Lods must only get coarser on the way
+// out and finer on the way back, and the hysteresis switches back later than out
+void runLods(GameState* state)
+{
+    Camera3D* cam = &gameData->camera;
+    vec3 spherePos = vec3(0.0f, 0.0f, -4.0f);
+    const int steps = 200;
+    int lodsOut[steps];
+    bool monotonic = true;
+    int maxLod = 0;
+    int lagSteps = 0;
+    for (int pass = 0; pass < 2; pass++)
+    {
+        int previous = lodSphereInstance.lod;
+        for (int i = 0; i < steps; i++)
+        {
+            int step = pass == 0 ? i : steps - 1 - i;
+            cam->pos = spherePos + vec3(0.0f, 0.0f, 1.5f + step * 0.45f); // Inside the far plane
+            cam->view = lookInDir(cam->pos, vec3(0.0f, 0.0f, -1.0f));
+            renderState.tickCounter++; // Next stream region, like gameTick
+            draw(&materialRenderer, &lodSphereInstance, spherePos);
+            render(&materialRenderer, state);
+            headlessGLEndFrame();
+
+            int lod = lodSphereInstance.lod;
+            if (pass == 0) {
+                monotonic = monotonic && lod >= previous;
+                lodsOut[step] = lod;
+            }
+            else {
+                monotonic = monotonic && lod <= previous && lod >= lodsOut[step];
+                lagSteps += lod > lodsOut[step] ? 1 : 0;
+            }
+            previous = lod;
+            maxLod = max(maxLod, lod);
+        }
+    }
+    loggf("Lods: reached lod %d of %d, monotonic should be 1: %d, steps where the way back lags: %d\n",
+            maxLod, lodSphere.lodCount - 1, monotonic, lagSteps);
+}
+
+int main(int argc, char** argv)
+{
+    int frameCount = 60;
+    bool printCommandStream = false;
+    int stressTextures = 0;
+    bool reloadShaders = false;
+    const char* reloadShaderPath = nullptr;
+    bool renderGraphTest = false;
+    bool lightClustersTest = false;
+    bool lodTest = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-commands") == 0) printCommandStream = true;
+        else if (strcmp(argv[i], "-reloadShaders") == 0) reloadShaders = true;
+        else if (strcmp(argv[i], "-renderGraph") == 0) renderGraphTest = true;
+        else if (strcmp(argv[i], "-lightClusters") == 0) lightClustersTest = true;
+        else if (strcmp(argv[i], "-lods") == 0) lodTest = true;
+        else if (strcmp(argv[i], "-reloadShader") == 0 && i + 1 < argc) reloadShaderPath = argv[++i];
+        else if (strcmp(argv[i], "-textureStress") == 0 && i + 1 < argc) stressTextures = atoi(argv[++i]);
+        else frameCount = atoi(argv[i]);
+    }
+
+    SystemAllocator sysAlloc;
+    loadHeadlessGLFunctions(&sysAlloc);
+    SCOPE_EXIT(shutdownHeadlessGL());
+    _createFileListener = &headlessCreateFileListener;
+    _deleteFileListener = &headlessDeleteFileListener;
+    _mapFile = &posixMapFile;
+    _unmapFile = &posixUnmapFile;
+
+    // Game memory must be zeroed, like VirtualAlloc on windows
+    GameState state = GameState();
+    state.memory.size = 1024ull * 1024 * 512;
+    state.memory.data = calloc(1, state.memory.size);
+    assert(state.memory.data != nullptr, "Could not allocate game memory\n");
+    SCOPE_EXIT(free(state.memory.data));
+    state.windowState.width = 800;
+    state.windowState.height = 600;
+    state.windowState.inFocus = true;
+
+    gameInit(&state);
+    headlessGLEndFrame();
+    loggf("HeadlessGL init:\n");
+    printStats(&headlessGL.lastFrame);
+    if (stressTextures > 0) {
+        runTextureStress(&state, stressTextures, 10000);
+    }
+    if (reloadShaders || reloadShaderPath != nullptr) {
+        runShaderReload(&state, reloadShaderPath, 100);
+    }
+    if (renderGraphTest) {
+        runRenderGraph(state.windowState.width, state.windowState.height);
+    }
+    if (lightClustersTest) {
+        runLightClusters(state.windowState.width, state.windowState.height);
+    }
+    if (lodTest) {
+        runLods(&state);
+    }
+
+    double tslf = 1.0 / 60.0;
+    for (int i = 0; i < frameCount && !state.windowState.quit; i++)
+    {
+        state.time.now = i * tslf;
+        state.time.tslf = tslf;
+        state.windowState.wasResized = (i == 0);
+        gameTick(&state);
+        if (printCommandStream && i == frameCount - 1) {
+            printCommands();
+        }
+        headlessGLEndFrame();
+    }
+    print(&renderState.stats);
+    print(&programCache.stats);
+    print(&shaderCompiler.stats);
+    print(&shaderVariants.stats);
+    print(&vaoCache.stats);
+    print(&renderGraph.stats);
+    gameShutdown(&state);
+    headlessGLEndFrame();
+
+    loggf("HeadlessGL last frame:\n");
+    printStats(&headlessGL.lastFrame);
+    loggf("HeadlessGL total (%d frames):\n", headlessGL.frameCount);
+    printStats(&headlessGL.total);
+
+    return headlessGL.total.errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
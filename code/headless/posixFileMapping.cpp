@@ -0,0 +1,46 @@
+#ifndef __POSIX_FILEMAPPING_CPP__
+#define __POSIX_FILEMAPPING_CPP__
+
+// Read only file mapping with mmap, used by the headless build and the tools
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile posixMapFile(const char* path)
+{
+    MappedFile file;
+    memset(&file, 0, sizeof(MappedFile));
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        loggf("mapFile: Could not open %s\n", path);
+        return file;
+    }
+    SCOPE_EXIT(close(fd)); // The mapping keeps the file alive
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        loggf("mapFile: %s is empty or stat failed\n", path);
+        return file;
+    }
+    void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        loggf("mapFile: mmap failed on %s\n", path);
+        return file;
+    }
+    file.data = data;
+    file.size = (u64) info.st_size;
+    return file;
+}
+
+void posixUnmapFile(MappedFile* file)
+{
+    if (file->data != nullptr) {
+        munmap(file->data, file->size);
+    }
+    memset(file, 0, sizeof(MappedFile));
+}
+
+
+
+#endif
@@ -37,26 +37,59 @@ struct Lighting
 struct DrawRequest
 {
     DrawRequest() {}
-    DrawRequest(AutoMesh* m, const Transform& t) :
-        mesh(m), transform(t) {}
-    AutoMesh* mesh;
+    DrawRequest(AutoMesh* m, const Transform& t, Material* mat, LodInstance* lod = nullptr) :
+        mesh(m), transform(t), material(mat), lod(lod) {}
+    AutoMesh* mesh; // Lod of the last frame if lod is set, used for culling
     Transform transform;
+    Material* material;
+    LodInstance* lod;
 };
 
 struct MaterialRenderer
 {
-    AutoShaderProgram materialShader;
+    AutoShaderProgram* materialShader; // Shared variant, see acquireShaderVariant
+    UniformHandle<vec3> lightDirUniform;
+    UniformHandle<vec3> ambientUniform;
     Camera3D* camera;
     DynArr<DrawRequest> drawRequests;
+    RenderQueue queue;
     Lighting lighting;
+    DynArr<Light> lights; // Point and spot lights of the current frame, see addLight
+    LightClusters clusters;
+    StreamBuffer lightStream;
     Material defaultMaterial;
+    // Stats of the last render call (State change stats are in queue.stats)
+    int visibleCount;
+    int culledCount;
+    int lodCounts[MAX_LOD_COUNT]; // Visible lod draws per level
 };
 
+void bindMaterial(AutoShaderProgram* p, void* material)
+{
+    // The queue may draw with any program, the handle follows it
+    static UniformHandle<vec3> albedoUniform;
+    if (albedoUniform.program != &p->program) {
+        init(&albedoUniform, p, "u_albedo");
+    }
+    Material* m = (Material*) material;
+    setUniform(&albedoUniform, m->albedo);
+}
+
 void init(MaterialRenderer* r, Camera3D* camera, Allocator* alloc)
 {
-    init(&r->materialShader, {"material/phong.vert", "material/phong.frag"}, alloc);
+    r->materialShader = acquireShaderVariant({"material/phong.vert", "material/phong.frag"}, nullptr, alloc);
+    init(&r->lightDirUniform, r->materialShader, "u_lightDir");
+    init(&r->ambientUniform, r->materialShader, "u_ambient");
     r->drawRequests.init(alloc, 16);
+    init(&r->queue, &bindMaterial, alloc);
+    r->lights.init(alloc, 64);
+    init(&r->clusters, alloc);
+    init(&r->lightStream, GL_SHADER_STORAGE_BUFFER,
+            (sizeof(ClusterBufferHeader) + sizeof(u32) * LIGHT_CLUSTER_MAX_INDICES) * STREAM_BUFFER_FRAMES, alloc);
     r->camera = camera;
+    r->visibleCount = 0;
+    r->culledCount = 0;
+    memset(r->lodCounts, 0, sizeof(r->lodCounts));
 
     // Init lighting
     r->lighting.dirLight.dir = normalize(vec3(-0.2f, -0.8f, -0.4f));
@@ -69,12 +102,33 @@ void init(MaterialRenderer* r, Camera3D* camera, Allocator* alloc)
 }
 
 void shutdown(MaterialRenderer* r) {
-    shutdown(&r->materialShader);
+    releaseShaderVariant(r->materialShader);
     r->drawRequests.shutdown();
+    shutdown(&r->queue);
+    r->lights.shutdown();
+    shutdown(&r->clusters);
+    shutdown(&r->lightStream);
+}
+
+// Lights are used for the next render call only
+void addLight(MaterialRenderer* r, const Light& light) {
+    r->lights.push_back(light);
+}
+
+void draw(MaterialRenderer* r, AutoMesh* m, vec3 pos, Material* material = nullptr) {
+    if (material == nullptr) {
+        material = &r->defaultMaterial;
+    }
+    r->drawRequests.push_back(DrawRequest(m, Transform(pos), material));
 }
 
-void draw(MaterialRenderer* r, AutoMesh* m, vec3 pos) {
-    r->drawRequests.push_back(DrawRequest(m, Transform(pos)));
+// The lod is selected in render from the projected size of the mesh
+void draw(MaterialRenderer* r, LodInstance* lod, vec3 pos, Material* material = nullptr) {
+    if (material == nullptr) {
+        material = &r->defaultMaterial;
+    }
+    AutoMesh* m = &lod->mesh->lods[min(lod->lod, lod->mesh->lodCount - 1)];
+    r->drawRequests.push_back(DrawRequest(m, Transform(pos), material, lod));
 }
 
 void render(MaterialRenderer* r, GameState* gameState) 
@@ -82,13 +136,60 @@ void render(MaterialRenderer* r, GameState* gameState)
     vec2 mousePos = vec2((float)gameState->input.mouseX/gameState->windowState.width, 
             (float)gameState->input.mouseY/gameState->windowState.height);
 
-    bind(&r->materialShader);
-    setUniform(&r->materialShader, "u_lightDir", r->lighting.dirLight.dir);
-    setUniform(&r->materialShader, "u_ambient", r->lighting.ambientColor * r->lighting.ambientStrength);
-    setUniform(&r->materialShader, "u_albedo", r->defaultMaterial.albedo);
-    for (DrawRequest& request : r->drawRequests) {
-        draw(request.mesh, &r->materialShader, r->camera, mousePos, (float)gameState->time.now, request.transform);
+    bind(r->materialShader);
+    setUniform(&r->lightDirUniform, r->lighting.dirLight.dir);
+    setUniform(&r->ambientUniform, r->lighting.ambientColor * r->lighting.ambientStrength);
+
+    // Frustum culling with world space bounding spheres
+    SCOPE_EXIT_ROLLBACK;
+    int count = r->drawRequests.size();
+    float* x = (float*) tmpAlloc.alloc(sizeof(float) * count);
+    float* y = (float*) tmpAlloc.alloc(sizeof(float) * count);
+    float* z = (float*) tmpAlloc.alloc(sizeof(float) * count);
+    float* radius = (float*) tmpAlloc.alloc(sizeof(float) * count);
+    int* visible = (int*) tmpAlloc.alloc(sizeof(int) * count);
+    for (int i = 0; i < count; i++) 
+    {
+        DrawRequest& request = r->drawRequests[i];
+        BoundingSphere s = transform(request.mesh->boundingSphere, request.transform.toModelMat());
+        x[i] = s.center.x;
+        y[i] = s.center.y;
+        z[i] = s.center.z;
+        radius[i] = s.radius;
+    }
+    int visibleCount = cullSpheres(getFrustum(r->camera), count, x, y, z, radius, visible);
+    r->visibleCount = visibleCount;
+    r->culledCount = count - visibleCount;
+
+    // Lod selection, the projected diameter of the sphere over the screen height is radius * P[1][1] / distance
+    memset(r->lodCounts, 0, sizeof(r->lodCounts));
+    float projScale = r->camera->projection.columns[1].y;
+    for (int i = 0; i < visibleCount; i++)
+    {
+        int index = visible[i];
+        DrawRequest& request = r->drawRequests[index];
+        if (request.lod == nullptr) {
+            continue;
+        }
+        vec3 center = vec3(x[index], y[index], z[index]);
+        float dist = max(length(center - r->camera->pos), 0.0001f);
+        float screenSize = radius[index] * projScale / dist;
+        LodInstance* lod = request.lod;
+        lod->lod = selectLod(lod->mesh, screenSize, lod->lod);
+        request.mesh = &lod->mesh->lods[lod->lod];
+        r->lodCounts[lod->lod]++;
+    }
+
+    // Clustered lights, the grid is rebuilt if the projection changed
+    assignLights(&r->clusters, r->camera->view, r->camera->projection, r->lights.size(), (Light*) r->lights.data.data);
+    upload(&r->clusters, &r->lightStream);
+    r->lights.reset();
+
+    for (int i = 0; i < visibleCount; i++) {
+        DrawRequest& request = r->drawRequests[visible[i]];
+        submit(&r->queue, request.mesh, r->materialShader, request.transform, r->camera->pos, request.material);
     }
+    flush(&r->queue, r->camera, mousePos, (float)gameState->time.now);
     r->drawRequests.reset();
 }
 
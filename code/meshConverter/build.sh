@@ -0,0 +1,17 @@
+# Builds the obj to mesh file converter, run from the repository root:
+#   ./code/meshConverter/build.sh && ./build/meshConverter ressources/models/*.obj
+dir=$(pwd)
+ldir=${dir}/libs
+odir=${dir}/build
+cdir=${dir}/code/meshConverter
+
+#Compiler arguments
+source="${cdir}/meshConverterMain.cpp"
+output=${odir}/meshConverter
+# See headless/build.sh for -fno-lifetime-dse
+flags="-std=c++17 -O2 -w -fno-lifetime-dse -pthread"
+includes="-I ${dir}/uppLib -I ${ldir}/stb -I ${ldir}/openGLExtensions"
+
+#Command
+mkdir -p ${odir}
+g++ $flags -o $output $source $includes
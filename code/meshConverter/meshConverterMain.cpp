@@ -0,0 +1,351 @@
+// MESH CONVERTER
+// Converts OBJ files to mesh files (See utils/meshFile.hpp), which the game maps without parsing.
+// Every file is converted on a worker thread: Parse, weld, optimizeMesh, generateLods, write.
+//
+// Usage: meshConverter [-threads n] [-nolods] [-o outputDir] file.obj...
+//     The output has the name of the input with .mesh, next to it or in outputDir
+// Returns 1 if a file could not be converted
+//
+// OBJ support: v/vt/vn and polygonal f (Fan triangulated, negative indices allowed).
+// Objects, groups and materials are merged into one mesh. Missing normals are generated.
+
+#include "../tools/toolCommon.hpp"
+#include "../utils/meshFile.hpp"
+
+// One corner of a face, indices are 0 based, -1 if not given
+struct ObjCorner
+{
+    int pos;
+    int uv;
+    int normal;
+};
+
+struct ObjData
+{
+    DynArr<vec3> positions;
+    DynArr<vec2> uvs;
+    DynArr<vec3> normals;
+    DynArr<ObjCorner> corners; // 3 per triangle
+};
+
+void init(ObjData* o, Allocator* alloc)
+{
+    o->positions.init(alloc, 1024);
+    o->uvs.init(alloc, 1024);
+    o->normals.init(alloc, 1024);
+    o->corners.init(alloc, 4096);
+}
+
+void shutdown(ObjData* o)
+{
+    o->positions.shutdown();
+    o->uvs.shutdown();
+    o->normals.shutdown();
+    o->corners.shutdown();
+}
+
+const char* skipSpaces(const char* c) {
+    while (*c == ' ' || *c == '\t') c++;
+    return c;
+}
+
+const char* skipLine(const char* c) {
+    while (*c != '\0' && *c != '\n') c++;
+    return *c == '\n' ? c + 1 : c;
+}
+
+// Obj indices are 1 based, negative ones are relative to the end
+int resolveObjIndex(int index, int count) {
+    return index < 0 ? count + index : index - 1;
+}
+
+// Parses i, i/j, i//k or i/j/k, returns false at the end of the face
+bool parseObjCorner(const char** cursor, ObjData* o, ObjCorner* corner)
+{
+    const char* c = skipSpaces(*cursor);
+    char* end;
+    long pos = strtol(c, &end, 10);
+    if (end == c) {
+        return false;
+    }
+    corner->pos = resolveObjIndex((int)pos, o->positions.size());
+    corner->uv = -1;
+    corner->normal = -1;
+    c = end;
+    if (*c == '/') {
+        c++;
+        if (*c != '/') {
+            corner->uv = resolveObjIndex((int)strtol(c, &end, 10), o->uvs.size());
+            c = end;
+        }
+        if (*c == '/') {
+            c++;
+            corner->normal = resolveObjIndex((int)strtol(c, &end, 10), o->normals.size());
+            c = end;
+        }
+    }
+    *cursor = c;
+    return true;
+}
+
+// Returns false and logs if the file is malformed
+bool parseObj(ObjData* o, const char* text, const char* path)
+{
+    int line = 1;
+    for (const char* c = text; *c != '\0'; c = skipLine(c), line++)
+    {
+        c = skipSpaces(c);
+        char* end;
+        if (c[0] == 'v' && c[1] == ' ') {
+            vec3 p;
+            p.x = strtof(c + 2, &end);
+            p.y = strtof(end, &end);
+            p.z = strtof(end, &end);
+            o->positions.push_back(p);
+        }
+        else if (c[0] == 'v' && c[1] == 't' && c[2] == ' ') {
+            vec2 uv;
+            uv.x = strtof(c + 3, &end);
+            uv.y = strtof(end, &end);
+            o->uvs.push_back(uv);
+        }
+        else if (c[0] == 'v' && c[1] == 'n' && c[2] == ' ') {
+            vec3 n;
+            n.x = strtof(c + 3, &end);
+            n.y = strtof(end, &end);
+            n.z = strtof(end, &end);
+            o->normals.push_back(n);
+        }
+        else if (c[0] == 'f' && c[1] == ' ')
+        {
+            // Fan triangulated while parsing, so polygons can have any number of corners
+            const char* cursor = c + 2;
+            int count = 0;
+            ObjCorner first = {}, previous = {}, corner;
+            while (parseObjCorner(&cursor, o, &corner)) {
+                if (corner.pos < 0 || corner.pos >= o->positions.size() ||
+                    corner.uv >= o->uvs.size() || corner.normal >= o->normals.size()) {
+                    loggf("%s:%d: Face index out of range\n", path, line);
+                    return false;
+                }
+                if (count == 0) {
+                    first = corner;
+                }
+                else if (count >= 2) {
+                    o->corners.push_back(first);
+                    o->corners.push_back(previous);
+                    o->corners.push_back(corner);
+                }
+                previous = corner;
+                count++;
+            }
+            if (count < 3) {
+                loggf("%s:%d: Face with less than 3 vertices\n", path, line);
+                return false;
+            }
+        }
+        // Everything else (o, g, s, usemtl, mtllib, comments) is ignored
+    }
+    return true;
+}
+
+u64 hashCorner(const ObjCorner& c) {
+    u64 h = (u64)(u32)c.pos * 0x9E3779B97F4A7C15ull;
+    h ^= (u64)(u32)c.uv * 0xC2B2AE3D27D4EB4Full + (h << 6) + (h >> 2);
+    h ^= (u64)(u32)c.normal * 0x165667B19E3779F9ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+// Welds corners with the same pos/uv/normal into vertices and builds the MeshData
+void createMeshData(MeshData* m, ObjData* o, Allocator* alloc)
+{
+    int cornerCount = o->corners.size();
+    bool hasUvs = o->uvs.size() > 0;
+    bool hasNormals = o->normals.size() > 0;
+
+    // Open addressing table of corner index + 1 -> vertex
+    int tableSize = 1;
+    while (tableSize < cornerCount * 2) {
+        tableSize *= 2;
+    }
+    Blk tableBlk = alloc->alloc(sizeof(int) * tableSize * 2);
+    SCOPE_EXIT(alloc->dealloc(tableBlk););
+    int* tableCorner = (int*) tableBlk.data;
+    int* tableVertex = tableCorner + tableSize;
+    memset(tableCorner, 0, sizeof(int) * tableSize);
+
+    Blk indexBlk = alloc->alloc(sizeof(u32) * cornerCount);
+    Blk uniqueBlk = alloc->alloc(sizeof(int) * cornerCount); // First corner of each vertex
+    SCOPE_EXIT(alloc->dealloc(uniqueBlk););
+    u32* indices = (u32*) indexBlk.data;
+    int* unique = (int*) uniqueBlk.data;
+    int vertexCount = 0;
+    for (int i = 0; i < cornerCount; i++)
+    {
+        ObjCorner& c = o->corners[i];
+        int slot = (int)(hashCorner(c) & (tableSize - 1));
+        while (tableCorner[slot] != 0) {
+            ObjCorner& other = o->corners[tableCorner[slot] - 1];
+            if (other.pos == c.pos && other.uv == c.uv && other.normal == c.normal) {
+                break;
+            }
+            slot = (slot + 1) & (tableSize - 1);
+        }
+        if (tableCorner[slot] == 0) {
+            tableCorner[slot] = i + 1;
+            tableVertex[slot] = vertexCount;
+            unique[vertexCount++] = i;
+        }
+        indices[i] = tableVertex[slot];
+    }
+
+    init(m, alloc);
+    m->vertexCount = vertexCount;
+    m->indexCount = cornerCount;
+    m->indexData = indexBlk;
+
+    AttribBlk posBlk(MeshAttrib::POS3, alloc->alloc(sizeof(vec3) * vertexCount));
+    AttribBlk normalBlk(MeshAttrib::NORMAL, alloc->alloc(sizeof(vec3) * vertexCount));
+    vec3* pos = (vec3*) posBlk.blk.data;
+    vec3* normals = (vec3*) normalBlk.blk.data;
+    for (int v = 0; v < vertexCount; v++) {
+        ObjCorner& c = o->corners[unique[v]];
+        pos[v] = o->positions[c.pos];
+        normals[v] = c.normal != -1 ? o->normals[c.normal] : vec3(0.0f);
+    }
+    if (!hasNormals)
+    {
+        // Area weighted face normals, only smooth where the obj shares vertices
+        for (int i = 0; i < cornerCount; i += 3) {
+            vec3 n = cross(pos[indices[i + 1]] - pos[indices[i]], pos[indices[i + 2]] - pos[indices[i]]);
+            for (int k = 0; k < 3; k++) {
+                normals[indices[i + k]] = normals[indices[i + k]] + n;
+            }
+        }
+        for (int v = 0; v < vertexCount; v++) {
+            normals[v] = normalizeSafe(normals[v]);
+        }
+    }
+    m->attribBlks.push_back(posBlk);
+    m->attribBlks.push_back(normalBlk);
+
+    if (hasUvs) {
+        AttribBlk uvBlk(MeshAttrib::UV, alloc->alloc(sizeof(vec2) * vertexCount));
+        vec2* uvs = (vec2*) uvBlk.blk.data;
+        for (int v = 0; v < vertexCount; v++) {
+            ObjCorner& c = o->corners[unique[v]];
+            uvs[v] = c.uv != -1 ? o->uvs[c.uv] : vec2(0.0f);
+        }
+        m->attribBlks.push_back(uvBlk);
+    }
+}
+
+struct ConvertJob
+{
+    const char* inputPath;
+    char outputPath[1024];
+    bool success;
+    int triangleCounts[MAX_LOD_COUNT];
+    int lodCount;
+    double parseMs;
+    double totalMs;
+};
+
+void convert(ConvertJob* job, bool createLods)
+{
+    auto start = std::chrono::steady_clock::now();
+    SystemAllocator alloc;
+    job->success = false;
+
+    // Read the whole file, the text is null terminated for strtof
+    FILE* file = fopen(job->inputPath, "rb");
+    if (file == nullptr) {
+        loggf("Could not open %s\n", job->inputPath);
+        return;
+    }
+    fseek(file, 0, SEEK_END);
+    u64 fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    Blk text = alloc.alloc(fileSize + 1);
+    SCOPE_EXIT(alloc.dealloc(text););
+    u64 readSize = fread(text.data, 1, fileSize, file);
+    fclose(file);
+    if (readSize != fileSize) {
+        loggf("Could not read %s\n", job->inputPath);
+        return;
+    }
+    ((char*)text.data)[fileSize] = '\0';
+
+    ObjData obj;
+    init(&obj, &alloc);
+    SCOPE_EXIT(shutdown(&obj););
+    if (!parseObj(&obj, (char*)text.data, job->inputPath)) {
+        return;
+    }
+    if (obj.corners.size() == 0) {
+        loggf("%s has no faces\n", job->inputPath);
+        return;
+    }
+    job->parseMs = msSince(start);
+
+    MeshData lods[MAX_LOD_COUNT];
+    float errors[MAX_LOD_COUNT];
+    createMeshData(&lods[0], &obj, &alloc);
+    optimizeMesh(&lods[0], true, false);
+    errors[0] = 0.0f;
+    job->lodCount = 1;
+    if (createLods) {
+        job->lodCount += generateLods(&lods[1], &errors[1], MAX_LOD_COUNT - 1, &lods[0], &alloc);
+    }
+    for (int i = 0; i < job->lodCount; i++) {
+        job->triangleCounts[i] = lods[i].indexCount / 3;
+    }
+
+    job->success = writeMeshFile(job->outputPath, lods, errors, job->lodCount);
+    for (int i = 0; i < job->lodCount; i++) {
+        shutdown(&lods[i]);
+    }
+    job->totalMs = msSince(start);
+}
+
+int main(int argc, char** argv)
+{
+    bool createLods = true;
+    SystemAllocator alloc;
+    DynArr<ConvertJob> jobs;
+    jobs.init(&alloc, 16);
+    SCOPE_EXIT(jobs.shutdown(););
+    ToolArgs args;
+    bool hasInputs = parseToolArgs(argc, argv, ".mesh", &jobs, &args, [&](const char* flag) {
+        if (strcmp(flag, "-nolods") == 0) createLods = false;
+        else return false;
+        return true;
+    });
+    if (!hasInputs) {
+        loggf("Usage: meshConverter [-threads n] [-nolods] [-o outputDir] file.obj...\n");
+        return EXIT_FAILURE;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int threadCount = runToolJobs(&jobs, args.threadCount, [&](ConvertJob* job) {
+        convert(job, createLods);
+    });
+
+    int failed = 0;
+    for (ConvertJob& job : jobs)
+    {
+        if (!job.success) {
+            loggf("FAILED %s\n", job.inputPath);
+            failed++;
+            continue;
+        }
+        loggf("%s -> %s: %d triangles, lods:", job.inputPath, job.outputPath, job.triangleCounts[0]);
+        for (int i = 1; i < job.lodCount; i++) {
+            loggf(" %d", job.triangleCounts[i]);
+        }
+        loggf(" (parse %.1f ms, total %.1f ms)\n", job.parseMs, job.totalMs);
+    }
+    loggf("Converted %d/%d files with %d threads in %.1f ms\n", jobs.size() - failed, jobs.size(), threadCount, msSince(start));
+
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
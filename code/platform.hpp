@@ -13,6 +13,17 @@ typedef void (*listenerCallbackFunc)(const char* filename, void* userData);
 ListenerToken createFileListener(const char* path, listenerCallbackFunc callback, void* userData);
 void deleteFileListener(ListenerToken token);
 
+// Read only mapping of a whole file, data is nullptr if the file could not be mapped
+struct MappedFile
+{
+    void* data;
+    u64 size;
+    void* fileHandle; // Platform handles
+    void* mappingHandle;
+};
+MappedFile mapFile(const char* path);
+void unmapFile(MappedFile* file);
+
 // PLATFORM STRUCTS
 struct Input
 {
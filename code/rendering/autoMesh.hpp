@@ -1,32 +1,39 @@
 #ifndef __AUTO_MESH_HPP__
 #define __AUTO_MESH_HPP__
 
-#include "AutoShaderProgram.hpp"
+#include "autoShaderProgram.hpp"
 
 struct AutoMesh
 {
     MeshGPUBuffer buffer;
-    DynArr<MeshVao> meshVaos;
+    u64 bufferHash; // Vaos of the mesh are in the VaoCache under this hash
+    // Object space bounds, used for culling
+    AABB aabb;
+    BoundingSphere boundingSphere;
 };
 
 void print(AutoMesh* m) 
 {
     loggf("AutoMesh print!\n");
-    loggf("MeshVao count: %d\n", m->meshVaos.size());
-    for (MeshVao& mVao : m->meshVaos) {
-        loggf("\tvao: %d\n", mVao.vao);
-        loggf("\tAttribLoc count: %d\n", mVao.attribLocs.size());
-        for (AttribLocation& atrLoc : mVao.attribLocs) {
-            loggf("\t\tAttrib: %s\n", toStr(atrLoc.attrib));
-            loggf("\t\tLocation: %d\n", atrLoc.location);
-        }
+    loggf("Buffer hash: %016llx\n", (unsigned long long)m->bufferHash);
+    loggf("Attrib buffer count: %d\n", m->buffer.attribBuffers.size());
+    for (AttribGPUBuffer& a : m->buffer.attribBuffers) {
+        loggf("\tAttrib: %s, vbo: %d, offset: %d, stride: %d\n", toStr(a.attrib), a.vbo, a.offset, a.stride);
     }
 }
 
-void init(AutoMesh* mesh, MeshData* meshData, Allocator* alloc)
+// Bounds are given if they are already known (E.g. stored in a mesh file)
+void init(AutoMesh* mesh, MeshData* meshData, const AABB& aabb, const BoundingSphere& boundingSphere, 
+        Allocator* alloc, bool interleaved = true)
 {
-    init(&mesh->buffer, meshData, alloc); 
-    mesh->meshVaos.init(alloc, 4);
+    init(&mesh->buffer, meshData, alloc, interleaved); 
+    mesh->bufferHash = getMeshBufferHash(&mesh->buffer);
+    mesh->aabb = aabb;
+    mesh->boundingSphere = boundingSphere;
+}
+
+void init(AutoMesh* mesh, MeshData* meshData, Allocator* alloc) {
+    init(mesh, meshData, computeAABB(meshData), computeBoundingSphere(meshData), alloc);
 }
 
 void init(AutoMesh* mesh, int indexCount, void* indexData, 
@@ -43,50 +50,30 @@ void init(AutoMesh* mesh, int indexCount, void* indexData,
 
 void shutdown(AutoMesh* mesh)
 {
-    for (MeshVao& m : mesh->meshVaos) {
-        shutdown(&m);
-    }
-    mesh->meshVaos.shutdown();
+    releaseVaos(mesh->bufferHash);
     shutdown(&mesh->buffer);
 }
 
-bool isCompatible(MeshVao* meshVao, AutoShaderProgram* p)
+// Returns the vao of the mesh for the attribs of the program, on a miss it is created
+// and can be drawn right away. The pointer is only valid until the next vao is created
+MeshVao* getVao(AutoMesh* mesh, AutoShaderProgram* p)
 {
-    //loggf("Is compatible: meshVao->id: %d, meshVao->attribLocs.data.data: %p\n", 
-    //        meshVao->vao, meshVao->attribLocs.data.data);
-    // Check if vao has enough attribs
-    if (meshVao->attribLocs.size() < p->attribLocs.size())
-        return false;
-
-    // Loop over all shader attributes
-    int meshIndex = 0;
-    int shaderIndex = 0;
-    bool quit = false;
-    while (!quit) 
-    {
-        AttribLocation* meshLoc = &meshVao->attribLocs[meshIndex];
-        AttribLocation* shaderLoc = &p->attribLocs[shaderIndex];
-        // If it fits, advance both indices
-        if (meshLoc->location == shaderLoc->location &&
-                meshLoc->attrib == shaderLoc->attrib) {
-            meshIndex++;
-            shaderIndex++;
-        }
-        else { 
-            // Advance mesh index, because meshes can 
-            // have more data then the shader needs
-            meshIndex++; 
-        }
-        if (meshIndex == meshVao->attribLocs.size() ||
-                shaderIndex == p->attribLocs.size()) {
-            quit = true;
-        }
+    u64 key = getVaoCacheKey(mesh->bufferHash, p->attribSignature);
+    MeshVao* cached = findVao(key, mesh->bufferHash, p->attribSignature);
+    if (cached != nullptr) {
+        vaoCache.stats.hits++;
+        return cached;
     }
+    vaoCache.stats.misses++;
 
-    if (shaderIndex == p->attribLocs.size()) {
-        return true;
+    MeshVao meshVao;
+    init(&meshVao, &mesh->buffer, p->attribLocs.size(), 
+            (AttribLocation*)p->attribLocs.data.data, p->program.alloc);
+    if (isInstanced(p)) {
+        initInstanceAttribs(&meshVao, p->instanceAttribLocs.size(), 
+                (InstanceAttribLocation*)p->instanceAttribLocs.data.data);
     }
-    return false;
+    return insertVao(key, mesh->bufferHash, p->attribSignature, meshVao, p->program.alloc);
 }
 
 void draw(AutoMesh* mesh, AutoShaderProgram* p)
@@ -95,24 +82,19 @@ void draw(AutoMesh* mesh, AutoShaderProgram* p)
         return;
     }
     bind(p);
+    draw(getVao(mesh, p), mesh->buffer.indexBuffer.indexCount, mesh->buffer.indexBuffer.indexType);
+}
 
-    // Loop through vaos if one fits
-    for (MeshVao& meshVao : mesh->meshVaos)
-    {
-        if (isCompatible(&meshVao, p)) 
-        {
-            draw(&meshVao, mesh->buffer.indexBuffer.indexCount);
-            return;
-        }
+// Instance data must be laid out like the instance attribs of p (See writeInstanceData),
+// usually it is written into a range of a StreamBuffer
+void drawInstanced(AutoMesh* mesh, AutoShaderProgram* p, int instanceCount, GLuint instanceBuffer, int instanceOffset)
+{
+    if (p->program.id == 0 || instanceCount == 0) {
+        return;
     }
-
-    // Else create new vao
-    int attribLocCount = p->attribLocs.size();
-    AttribLocation* attribLocs = (AttribLocation*)p->attribLocs.data.data;
-
-    MeshVao meshVao;
-    init(&meshVao, &mesh->buffer, attribLocCount, attribLocs, p->program.alloc);
-    mesh->meshVaos.push_back(meshVao);
+    assert(isInstanced(p), "drawInstanced called with program without instance attribs\n");
+    bind(p);
+    drawInstanced(getVao(mesh, p), &mesh->buffer.indexBuffer, instanceCount, instanceBuffer, instanceOffset);
 }
 
 void draw(AutoMesh* m, AutoShaderProgram* p, Camera3D* cam, const vec2& mousePos, float time, const Transform& transform)
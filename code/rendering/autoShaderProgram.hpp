@@ -178,6 +178,32 @@ SupportedAutoAttrib supportedAutoAttribs[] =
     SupportedAutoAttrib("a_c", MeshAttrib::COLOR4, GL_FLOAT_VEC4),
 };
 
+struct SupportedInstanceAttrib
+{
+    SupportedInstanceAttrib() {}
+    SupportedInstanceAttrib(const char* name, InstanceAttrib::ENUM attrib, GLenum type)
+        : name(name), attrib(attrib), type(type) {}
+    const char* name;
+    InstanceAttrib::ENUM attrib;
+    GLenum type;
+};
+
+// Programs with one of these attribs are drawn instanced
+// All lowercase because search is case insensitive
+SupportedInstanceAttrib supportedInstanceAttribs[] =
+{
+    // Model matrix
+    SupportedInstanceAttrib("i_model", InstanceAttrib::MODEL_MATRIX, GL_FLOAT_MAT4),
+    SupportedInstanceAttrib("i_modelmat", InstanceAttrib::MODEL_MATRIX, GL_FLOAT_MAT4),
+    SupportedInstanceAttrib("i_modelmatrix", InstanceAttrib::MODEL_MATRIX, GL_FLOAT_MAT4),
+    SupportedInstanceAttrib("a_instancemodel", InstanceAttrib::MODEL_MATRIX, GL_FLOAT_MAT4),
+    // Normal matrix
+    SupportedInstanceAttrib("i_normal", InstanceAttrib::NORMAL_MATRIX, GL_FLOAT_MAT3),
+    SupportedInstanceAttrib("i_normalmat", InstanceAttrib::NORMAL_MATRIX, GL_FLOAT_MAT3),
+    SupportedInstanceAttrib("i_normalmatrix", InstanceAttrib::NORMAL_MATRIX, GL_FLOAT_MAT3),
+    SupportedInstanceAttrib("a_instancenormal", InstanceAttrib::NORMAL_MATRIX, GL_FLOAT_MAT3),
+};
+
 struct AutoShaderProgram
 {
     ShaderProgram program;
@@ -186,10 +212,17 @@ struct AutoShaderProgram
     DynArr<AutoUniform> perFrame;
     // Prepare stuff
     int lastUpdateFrame;
+    bool usesFrameBlock; // Per frame uniforms come from the frame uniform buffer
     // Automatic Attribs
     DynArr<AttribLocation> attribLocs; // Sorted by location
+    DynArr<InstanceAttribLocation> instanceAttribLocs; // Sorted by location, empty if not instanced
+    u64 attribSignature; // Of the attrib locations, part of the VaoCache key
 };
 
+bool isInstanced(AutoShaderProgram* p) {
+    return p->instanceAttribLocs.size() != 0;
+}
+
 void print(AutoShaderProgram* p)
 {
     loggf("AutoShaderProgram: \n");
@@ -200,6 +233,7 @@ void print(AutoShaderProgram* p)
         loggf("\t Type: %s, location=%d\n", toStr(u.type), u.location);
         i++;
     }
+    loggf("Uses frame uniform block: %s\n", p->usesFrameBlock ? "true" : "false");
     loggf("PerFrame: (count %d)\n", p->perFrame.size());
     i = 0;
     for (AutoUniform& u : p->perFrame) {
@@ -214,6 +248,13 @@ void print(AutoShaderProgram* p)
         loggf("\t Attrib: %s, location=%d\n", toStr(loc.attrib), loc.location);
         i++;
     }
+    loggf("Instance attrib locations: (count %d)\n", p->instanceAttribLocs.size());
+    i = 0;
+    for (InstanceAttribLocation& loc : p->instanceAttribLocs) {
+        loggf("  #%d\n", i);
+        loggf("\t Attrib: %s, location=%d\n", toStr(loc.attrib), loc.location);
+        i++;
+    }
 }
 
 void detectAutoUniforms(AutoShaderProgram* p)
@@ -224,6 +265,13 @@ void detectAutoUniforms(AutoShaderProgram* p)
     p->perFrame.reset();
     p->perModel.reset();
 
+    // Frame uniform block, bound to the fixed binding point of the frame uniform buffer
+    GLuint blockIndex = glGetUniformBlockIndex(p->program.id, FRAME_UNIFORM_BLOCK_NAME);
+    p->usesFrameBlock = blockIndex != GL_INVALID_INDEX;
+    if (p->usesFrameBlock) {
+        glUniformBlockBinding(p->program.id, blockIndex, FRAME_UNIFORM_BINDING);
+    }
+
     // Loop over all uniforms
     for (UniformInfo& info : p->program.uniformInfos) 
     {
@@ -281,15 +329,34 @@ void detectAutoAttribs(AutoShaderProgram* p)
                 break;
             }
         }
+        // Loop over all supported instance attributes
+        for (SupportedInstanceAttrib& instanceAttrib : supportedInstanceAttribs)
+        {
+            if (strcmp(instanceAttrib.name, attribName.c_str()) == 0 &&
+                       instanceAttrib.type == info.type)
+            {
+                p->instanceAttribLocs.push_back(InstanceAttribLocation(instanceAttrib.attrib, info.location));
+                break;
+            }
+        }
     }
 
     auto attribLocationCmp = [](AttribLocation* a, AttribLocation* b) {
         if (a->location < b->location) return -1;
         return 1;
     };
+    auto instanceAttribLocationCmp = [](InstanceAttribLocation* a, InstanceAttribLocation* b) {
+        if (a->location < b->location) return -1;
+        return 1;
+    };
 
     // Sort attribs
     p->attribLocs.sort(attribLocationCmp);
+    p->instanceAttribLocs.sort(instanceAttribLocationCmp);
+
+    p->attribSignature = getAttribSignature(
+            p->attribLocs.size(), (AttribLocation*)p->attribLocs.data.data,
+            p->instanceAttribLocs.size(), (InstanceAttribLocation*)p->instanceAttribLocs.data.data);
 }
 
 void onAutoShaderReload(ShaderProgram* sp)
@@ -299,23 +366,32 @@ void onAutoShaderReload(ShaderProgram* sp)
     p->perModel.reset();
     p->perFrame.reset();
     p->attribLocs.reset();
+    p->instanceAttribLocs.reset();
     if (p->program.id == 0) {
         return;
     }
 
+    // Vaos of the old attrib layout would only be freed with their meshes
+    u64 oldSignature = p->attribSignature;
     detectAutoUniforms(p);
     detectAutoAttribs(p);
+    if (oldSignature != 0 && oldSignature != p->attribSignature) {
+        releaseVaoSignature(oldSignature);
+    }
 }
 
 void init(AutoShaderProgram* p, 
         std::initializer_list<const char*> shaderFiles, 
-        Allocator* alloc)
+        Allocator* alloc, const char* defines = nullptr)
 {
-    init(&p->program, shaderFiles, alloc);
+    init(&p->program, shaderFiles, alloc, defines);
     p->perModel.init(alloc, 4);
     p->perFrame.init(alloc, 4);
     p->attribLocs.init(alloc, 4);
+    p->instanceAttribLocs.init(alloc, 2);
     p->lastUpdateFrame = -1;
+    p->usesFrameBlock = false;
+    p->attribSignature = 0;
     p->program.reloadCallbacks.push_back(&onAutoShaderReload);
 
     detectAutoUniforms(p);
@@ -328,12 +404,42 @@ void shutdown(AutoShaderProgram* p)
     p->perModel.shutdown();
     p->perFrame.shutdown();
     p->attribLocs.shutdown();
+    p->instanceAttribLocs.shutdown();
 }
 
 void bind(AutoShaderProgram* p) {
     bind(&p->program);
 }
 
+template<typename T>
+void init(UniformHandle<T>* h, AutoShaderProgram* p, const char* name) {
+    init(h, &p->program, name);
+}
+
+// Fills the frame uniform buffer, only the first call per frame uploads
+void updateFrameUniformBuffer(Camera3D* cam, const vec2& mousePos, float time)
+{
+    if (renderState.frameUboUpdateFrame == renderState.frameCounter) 
+        return;
+    renderState.frameUboUpdateFrame = renderState.frameCounter;
+
+    FrameUniformData data;
+    data.view = cam->view;
+    data.projection = cam->projection;
+    data.vp = cam->projection * cam->view;
+    mat3 inverseView = toMat3(inverseRigid(cam->view));
+    for (int i = 0; i < 3; i++) {
+        data.inverseView[i] = vec4(inverseView.columns[i], 0.0f);
+    }
+    data.cameraPos = cam->pos;
+    data.time = time;
+    data.resolution = vec2(renderState.viewportWidth, renderState.viewportHeight);
+    data.mousePos = mousePos;
+
+    bindBuffer(GL_UNIFORM_BUFFER, renderState.frameUbo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniformData), &data);
+}
+
 void updatePerFrameUniforms(AutoShaderProgram* program, Camera3D* cam, const vec2& mousePos, float time)
 {
     if (program->program.id == 0) {
@@ -341,15 +447,15 @@ void updatePerFrameUniforms(AutoShaderProgram* program, Camera3D* cam, const vec
     }
 
     bind(program);
+    if (program->usesFrameBlock) {
+        updateFrameUniformBuffer(cam, mousePos, time);
+    }
     if (program->lastUpdateFrame == renderState.frameCounter) 
         return;
     program->lastUpdateFrame = renderState.frameCounter;
 
     mat4 vp = cam->projection * cam->view;
-    mat3 inverseView = mat3(vec3(cam->view.columns[0].x, cam->view.columns[0].y, cam->view.columns[0].z),
-                            vec3(cam->view.columns[1].x, cam->view.columns[1].y, cam->view.columns[1].z),
-                            vec3(cam->view.columns[2].x, cam->view.columns[2].y, cam->view.columns[2].z));
-    inverseView = transpose(inverseView);
+    mat3 inverseView = toMat3(inverseRigid(cam->view));
     for (AutoUniform& u : program->perFrame) 
     {
         switch (u.type)
@@ -397,8 +503,7 @@ void updatePerModelUniforms(AutoShaderProgram* program, Camera3D* cam, const Tra
 
     mat4 model = transform.toModelMat();
     mat4 mvp = cam->projection * cam->view * model;
-    mat3 normalView = mat3(cam->view.getDataPtr()); // This is wrong, because it is wrong
-    mat3 normal = normalView * transform.toNormalMat();
+    mat3 normal = normalMatrix(model); // World space, like u_model
     for (AutoUniform& u : program->perModel) 
     {
         switch (u.type)
@@ -410,7 +515,6 @@ void updatePerModelUniforms(AutoShaderProgram* program, Camera3D* cam, const Tra
                 glUniformMatrix4fv(u.location, 1, GL_FALSE, (GLfloat*) &mvp);
                 break;
             case AutoUniformType::NORMAL_MATRIX:
-                invalid_path("Normal matrix not yet defined\n");
                 glUniformMatrix3fv(u.location, 1, GL_FALSE, (GLfloat*) &normal);
                 break;
             default:
@@ -420,6 +524,30 @@ void updatePerModelUniforms(AutoShaderProgram* program, Camera3D* cam, const Tra
     }
 }
 
+// Writes the per instance data of one instance (Instance stride bytes)
+void writeInstanceData(AutoShaderProgram* program, const Transform& transform, byte* dst)
+{
+    mat4 model = transform.toModelMat();
+    for (InstanceAttribLocation& loc : program->instanceAttribLocs)
+    {
+        switch (loc.attrib)
+        {
+            case InstanceAttrib::MODEL_MATRIX:
+                memcpy(dst, &model, sizeof(mat4));
+                break;
+            case InstanceAttrib::NORMAL_MATRIX: {
+                mat3 normal = normalMatrix(model);
+                memcpy(dst, &normal, sizeof(mat3));
+                break;
+            }
+            default:
+                invalid_path("ERROR");
+                break;
+        }
+        dst += instanceAttribInfoTable[loc.attrib].size;
+    }
+}
+
 void updateAutoUniforms(AutoShaderProgram* p, Camera3D* cam, const vec2& mousePos, float time, const Transform& transform)
 {
     updatePerFrameUniforms(p, cam, mousePos, time);
@@ -454,6 +582,101 @@ void setUniform(AutoShaderProgram* p, const char* name, const u32& f) {
     setUniform(&p->program, name, f);
 }
 
+// SHADER VARIANTS
+// Permutations of a program (Same files, different define sets) are built once and shared:
+// acquireShaderVariant returns the program of an existing variant if anyone already uses 
+// that define set, releaseShaderVariant drops one reference and frees the program with the last.
+// Define sets are normalized first, "A,B" and "B,A" are the same variant.
+// The key only speeds up the search, variants match if files and defines are equal.
+#define SHADER_MAX_VARIANTS 64
+
+struct ShaderVariant
+{
+    u64 key;
+    String files; // Stage files separated by '\n'
+    String defines; // Normalized
+    int refCount; // 0 if the slot is free
+    AutoShaderProgram program;
+};
+
+struct ShaderVariantStats
+{
+    int acquires;
+    int created;
+    int alive;
+};
+
+struct ShaderVariantCache
+{
+    ShaderVariant variants[SHADER_MAX_VARIANTS]; // Slots do not move, programs are used by pointer
+    ShaderVariantStats stats;
+};
+
+ShaderVariantCache shaderVariants;
+
+void print(ShaderVariantStats* s)
+{
+    loggf("ShaderVariants: %d acquires, %d created, %d alive\n", s->acquires, s->created, s->alive);
+}
+
+AutoShaderProgram* acquireShaderVariant(std::initializer_list<const char*> shaderFiles, 
+        const char* defines, Allocator* alloc)
+{
+    char normalized[SHADER_MAX_DEFINES_LENGTH];
+    normalizeDefines(defines, normalized);
+    char files[MAX_SHADER_COUNT * SHADER_MAX_PATH];
+    files[0] = 0;
+    for (const char* file : shaderFiles) {
+        assert(strlen(files) + strlen(file) + 2 <= sizeof(files), "Shader variant file list too long\n");
+        strcat(files, file);
+        strcat(files, "\n");
+    }
+    u64 key = hashString(normalized, hashString(files));
+
+    ShaderVariantStats& stats = shaderVariants.stats;
+    stats.acquires++;
+    ShaderVariant* freeVariant = nullptr;
+    for (ShaderVariant& v : shaderVariants.variants)
+    {
+        if (v.refCount == 0) {
+            freeVariant = freeVariant == nullptr ? &v : freeVariant;
+        }
+        else if (v.key == key && strcmp(v.files.c_str(), files) == 0 && strcmp(v.defines.c_str(), normalized) == 0) {
+            v.refCount++;
+            return &v.program;
+        }
+    }
+
+    assert(freeVariant != nullptr, "Too many shader variants\n");
+    freeVariant->key = key;
+    freeVariant->files.init(alloc, files);
+    freeVariant->defines.init(alloc, normalized);
+    freeVariant->refCount = 1;
+    init(&freeVariant->program, shaderFiles, alloc, normalized);
+    stats.created++;
+    stats.alive++;
+    return &freeVariant->program;
+}
+
+void releaseShaderVariant(AutoShaderProgram* p)
+{
+    for (ShaderVariant& v : shaderVariants.variants)
+    {
+        if (v.refCount == 0 || &v.program != p) {
+            continue;
+        }
+        v.refCount--;
+        if (v.refCount == 0) {
+            shutdown(&v.program);
+            v.files.shutdown();
+            v.defines.shutdown();
+            shaderVariants.stats.alive--;
+        }
+        return;
+    }
+    invalid_path("releaseShaderVariant: program is not a shader variant");
+}
+
 
 
 #endif
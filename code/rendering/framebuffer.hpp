@@ -99,7 +99,7 @@ void shutdown(Framebuffer* f)
     if (f->hasDepth) {
         shutdown(&f->depthTexture);
     }
-    glDeleteFramebuffers(1, &f->fbo);
+    deleteFbo(&f->fbo);
 }
 
 void bind(Framebuffer* f, int width, int height) 
@@ -0,0 +1,1949 @@
+#ifndef __HEADLESS_GL_HPP__
+#define __HEADLESS_GL_HPP__
+
+// ------------------
+// --- HEADLESS GL ---
+// ------------------
+// Implements all entry points of openGLFunctions.hpp without a gpu.
+// Calls are recorded into a compact command stream and the object
+// state (names, bindings, buffer sizes, shader interfaces) is tracked,
+// so the unmodified game code runs on machines without a gl driver.
+//
+//     loadHeadlessGLFunctions(&alloc); // Instead of loading the driver functions
+//     ... run frames, call headlessGLEndFrame() after each ...
+//     printStats(&headlessGL.total);
+//
+// Shader interfaces (uniforms, vertex inputs) are parsed from the glsl source,
+// so glGetActiveUniform/glGetAttribLocation behave like on a real driver
+// (Except that unused variables are reported as active).
+// Invalid usage (Unknown names, draws without program/vao) is logged and counted in errors.
+
+#include "openGLFunctions.hpp"
+
+namespace HeadlessCmd
+{
+    enum ENUM
+    {
+        CLEAR = 0,
+        DRAW_ARRAYS,
+        DRAW_ELEMENTS,
+        DRAW_ELEMENTS_INSTANCED,
+        USE_PROGRAM,
+        BIND_VAO,
+        BIND_BUFFER,
+        BIND_TEXTURE,
+        ACTIVE_TEXTURE,
+        BIND_FRAMEBUFFER,
+        BIND_RENDERBUFFER,
+        UNIFORM,
+        BUFFER_DATA,
+        TEX_IMAGE,
+        VERTEX_ATTRIB,
+        STATE, // Enable/Disable/Viewport/Blend..., args[0] is the function
+        CREATE_OBJECT,
+        DELETE_OBJECT,
+        COMPILE,
+        LINK,
+
+        COUNT // MUST STAY LAST
+    };
+};
+
+const char* toStr(HeadlessCmd::ENUM cmd)
+{
+    switch (cmd)
+    {
+    case HeadlessCmd::CLEAR: return "CLEAR";
+    case HeadlessCmd::DRAW_ARRAYS: return "DRAW_ARRAYS";
+    case HeadlessCmd::DRAW_ELEMENTS: return "DRAW_ELEMENTS";
+    case HeadlessCmd::DRAW_ELEMENTS_INSTANCED: return "DRAW_ELEMENTS_INSTANCED";
+    case HeadlessCmd::USE_PROGRAM: return "USE_PROGRAM";
+    case HeadlessCmd::BIND_VAO: return "BIND_VAO";
+    case HeadlessCmd::BIND_BUFFER: return "BIND_BUFFER";
+    case HeadlessCmd::BIND_TEXTURE: return "BIND_TEXTURE";
+    case HeadlessCmd::ACTIVE_TEXTURE: return "ACTIVE_TEXTURE";
+    case HeadlessCmd::BIND_FRAMEBUFFER: return "BIND_FRAMEBUFFER";
+    case HeadlessCmd::BIND_RENDERBUFFER: return "BIND_RENDERBUFFER";
+    case HeadlessCmd::UNIFORM: return "UNIFORM";
+    case HeadlessCmd::BUFFER_DATA: return "BUFFER_DATA";
+    case HeadlessCmd::TEX_IMAGE: return "TEX_IMAGE";
+    case HeadlessCmd::VERTEX_ATTRIB: return "VERTEX_ATTRIB";
+    case HeadlessCmd::STATE: return "STATE";
+    case HeadlessCmd::CREATE_OBJECT: return "CREATE_OBJECT";
+    case HeadlessCmd::DELETE_OBJECT: return "DELETE_OBJECT";
+    case HeadlessCmd::COMPILE: return "COMPILE";
+    case HeadlessCmd::LINK: return "LINK";
+    default: break;
+    }
+    return "INVALID";
+}
+
+// 16 bytes per command, meaning of args depends on the type
+struct HeadlessCommand
+{
+    u32 type;
+    u32 args[3];
+};
+
+namespace HeadlessObject
+{
+    enum ENUM
+    {
+        NONE = 0,
+        BUFFER,
+        VERTEX_ARRAY,
+        TEXTURE,
+        SHADER,
+        PROGRAM,
+        FRAMEBUFFER,
+        RENDERBUFFER,
+        SYNC,
+
+        COUNT // MUST STAY LAST
+    };
+};
+
+const char* toStr(HeadlessObject::ENUM type)
+{
+    switch (type)
+    {
+    case HeadlessObject::NONE: return "NONE";
+    case HeadlessObject::BUFFER: return "BUFFER";
+    case HeadlessObject::VERTEX_ARRAY: return "VERTEX_ARRAY";
+    case HeadlessObject::TEXTURE: return "TEXTURE";
+    case HeadlessObject::SHADER: return "SHADER";
+    case HeadlessObject::PROGRAM: return "PROGRAM";
+    case HeadlessObject::FRAMEBUFFER: return "FRAMEBUFFER";
+    case HeadlessObject::RENDERBUFFER: return "RENDERBUFFER";
+    case HeadlessObject::SYNC: return "SYNC";
+    default: break;
+    }
+    return "INVALID";
+}
+
+#define HEADLESS_MAX_ATTACHED_SHADERS 6
+#define HEADLESS_MAX_NAME_LENGTH 64
+struct HeadlessObjectInfo
+{
+    HeadlessObject::ENUM type;
+    bool alive;
+    GLenum shaderType;
+    u64 byteSize; // Buffer data or texture level 0
+    int width;
+    int height;
+    GLuint elementBuffer; // Vao only
+    GLuint attached[HEADLESS_MAX_ATTACHED_SHADERS]; // Program only
+    int attachedCount;
+    bool linkFailed; // Program only, set if glProgramBinary rejected the binary
+    int compileFrame; // Shader and program, frame of the last compile/link
+    // Buffer only, mapped buffers are backed by real memory
+    Blk storage;
+    bool immutable;
+    bool mapped;
+    int fenceFrame; // Sync only
+};
+
+// Uniform or vertex input of a shader/program
+struct HeadlessVariable
+{
+    GLuint owner;
+    bool isAttrib;
+    bool isBlock; // Uniform block, location is the binding point
+    bool inBlock; // Member of a uniform block, has no location
+    GLint blockIndex;
+    char name[HEADLESS_MAX_NAME_LENGTH];
+    GLenum type;
+    GLint size;
+    GLint location;
+};
+
+struct HeadlessGLStats
+{
+    u64 calls;
+    u64 drawCalls;
+    u64 verticesDrawn;
+    u64 instancedDrawCalls;
+    u64 instancesDrawn;
+    u64 clears;
+    u64 programBinds;
+    u64 redundantProgramBinds;
+    u64 vaoBinds;
+    u64 redundantVaoBinds;
+    u64 textureBinds;
+    u64 redundantTextureBinds;
+    u64 bufferBinds;
+    u64 framebufferBinds;
+    u64 uniformUploads;
+    u64 uniformBytes;
+    u64 bufferBytes;
+    u64 textureBytes;
+    u64 stateChanges;
+    u64 redundantStateChanges;
+    u64 objectsCreated;
+    u64 objectsDeleted;
+    u64 syncWaits; // Client waits on fences the gpu had not passed yet
+    u64 shaderCompiles;
+    u64 programLinks;
+    u64 programBinaryLoads;
+    u64 compileStalls; // Queries that had to wait for a compile or link
+    u64 errors;
+};
+
+#define HEADLESS_TEXTURE_UNITS 32
+#define HEADLESS_UNIFORM_BINDINGS 16
+#define HEADLESS_STORAGE_BINDINGS 8
+#define HEADLESS_STORAGE_OFFSET_ALIGNMENT 64
+// Frames the simulated gpu is behind, fences are signaled this many frames after creation
+#define HEADLESS_GPU_LATENCY 2
+// Frames a compile or link takes on the (simulated) compiler threads of the driver
+#define HEADLESS_COMPILE_LATENCY 2
+#define HEADLESS_MAX_CAPS 32
+struct HeadlessGL
+{
+    Allocator* alloc;
+    DynArr<HeadlessObjectInfo> objects; // Indexed by name, 0 is never used
+    DynArr<HeadlessVariable> variables;
+    DynArr<HeadlessCommand> commands; // Commands of the current frame
+    bool recordCommands;
+
+    // Bound state
+    GLuint program;
+    GLuint vao;
+    GLuint arrayBuffer;
+    GLuint uniformBuffer;
+    GLuint pixelUnpackBuffer;
+    GLuint storageBuffer;
+    GLuint uniformBindings[HEADLESS_UNIFORM_BINDINGS];
+    GLuint storageBindings[HEADLESS_STORAGE_BINDINGS];
+    GLuint framebuffer;
+    GLuint renderbuffer;
+    int activeUnit;
+    GLuint textures[HEADLESS_TEXTURE_UNITS];
+    GLenum caps[HEADLESS_MAX_CAPS];
+    bool capEnabled[HEADLESS_MAX_CAPS];
+    int capCount;
+    GLint viewport[4];
+    GLenum cullFace;
+    GLenum frontFace;
+    GLenum depthFunc;
+    GLboolean depthMask;
+    GLenum blendFunc[2];
+
+    // Statistics
+    HeadlessGLStats frame;
+    HeadlessGLStats lastFrame;
+    HeadlessGLStats total;
+    int frameCount;
+};
+
+HeadlessGL headlessGL;
+
+void printStats(const HeadlessGLStats* s)
+{
+    loggf("GL calls:         %llu\n", s->calls);
+    loggf("Draw calls:       %llu (%llu vertices)\n", s->drawCalls, s->verticesDrawn);
+    loggf("Instanced draws:  %llu (%llu instances)\n", s->instancedDrawCalls, s->instancesDrawn);
+    loggf("Clears:           %llu\n", s->clears);
+    loggf("Program binds:    %llu (%llu redundant)\n", s->programBinds, s->redundantProgramBinds);
+    loggf("Vao binds:        %llu (%llu redundant)\n", s->vaoBinds, s->redundantVaoBinds);
+    loggf("Texture binds:    %llu (%llu redundant)\n", s->textureBinds, s->redundantTextureBinds);
+    loggf("Buffer binds:     %llu\n", s->bufferBinds);
+    loggf("Framebuf binds:   %llu\n", s->framebufferBinds);
+    loggf("Uniform uploads:  %llu (%llu bytes)\n", s->uniformUploads, s->uniformBytes);
+    loggf("Buffer bytes:     %llu\n", s->bufferBytes);
+    loggf("Texture bytes:    %llu\n", s->textureBytes);
+    loggf("State changes:    %llu (%llu redundant)\n", s->stateChanges, s->redundantStateChanges);
+    loggf("Objects:          %llu created, %llu deleted\n", s->objectsCreated, s->objectsDeleted);
+    loggf("Sync waits:       %llu\n", s->syncWaits);
+    loggf("Shader compiles:  %llu (%llu links, %llu binary loads)\n", s->shaderCompiles, s->programLinks, s->programBinaryLoads);
+    loggf("Compile stalls:   %llu\n", s->compileStalls);
+    loggf("Errors:           %llu\n", s->errors);
+}
+
+void printCommands()
+{
+    loggf("Headless command stream (%d commands):\n", headlessGL.commands.size());
+    for (HeadlessCommand& c : headlessGL.commands) {
+        loggf("\t%-18s %u %u %u\n", toStr((HeadlessCmd::ENUM)c.type), c.args[0], c.args[1], c.args[2]);
+    }
+}
+
+// Accumulates the frame statistics and resets the command stream
+void headlessGLEndFrame()
+{
+    HeadlessGLStats& f = headlessGL.frame;
+    HeadlessGLStats& t = headlessGL.total;
+    u64* src = (u64*)&f;
+    u64* dst = (u64*)&t;
+    for (int i = 0; i < (int)(sizeof(HeadlessGLStats) / sizeof(u64)); i++) {
+        dst[i] += src[i];
+    }
+    headlessGL.lastFrame = f;
+    memset(&f, 0, sizeof(HeadlessGLStats));
+    headlessGL.commands.reset();
+    headlessGL.frameCount++;
+}
+
+
+
+// ---------------
+// --- HELPERS ---
+// ---------------
+void headlessRecord(HeadlessCmd::ENUM type, u32 a0 = 0, u32 a1 = 0, u32 a2 = 0)
+{
+    headlessGL.frame.calls++;
+    if (!headlessGL.recordCommands) return;
+    HeadlessCommand c;
+    c.type = (u32)type;
+    c.args[0] = a0;
+    c.args[1] = a1;
+    c.args[2] = a2;
+    headlessGL.commands.push_back(c);
+}
+
+void headlessError(const char* function, const char* msg, GLuint name)
+{
+    headlessGL.frame.errors++;
+    loggf("HeadlessGL error in %s: %s (name %u)\n", function, msg, name);
+}
+
+HeadlessObjectInfo* headlessGetObject(GLuint name, HeadlessObject::ENUM type)
+{
+    if (name == 0 || (int)name >= headlessGL.objects.size()) return nullptr;
+    HeadlessObjectInfo* o = &headlessGL.objects[name];
+    if (!o->alive || o->type != type) return nullptr;
+    return o;
+}
+
+GLuint headlessCreateObject(HeadlessObject::ENUM type)
+{
+    HeadlessObjectInfo info = HeadlessObjectInfo();
+    info.type = type;
+    info.alive = true;
+    info.compileFrame = headlessGL.frameCount - HEADLESS_COMPILE_LATENCY;
+    GLuint name = (GLuint)headlessGL.objects.size();
+    headlessGL.objects.push_back(info);
+    headlessGL.frame.objectsCreated++;
+    headlessRecord(HeadlessCmd::CREATE_OBJECT, type, name);
+    return name;
+}
+
+// Vao 0 is the default vertex array (Drivers accept element buffer bindings without a vao)
+HeadlessObjectInfo* headlessBoundVao()
+{
+    if (headlessGL.vao == 0) return &headlessGL.objects[0];
+    return headlessGetObject(headlessGL.vao, HeadlessObject::VERTEX_ARRAY);
+}
+
+void headlessRemoveVariables(GLuint owner)
+{
+    for (int i = headlessGL.variables.size() - 1; i >= 0; i--) {
+        if (headlessGL.variables[i].owner == owner) {
+            headlessGL.variables.swap_remove(i);
+        }
+    }
+}
+
+void headlessDeleteObject(GLuint name, HeadlessObject::ENUM type, const char* function)
+{
+    if (name == 0) return; // Deleting 0 is silently ignored
+    HeadlessObjectInfo* o = headlessGetObject(name, type);
+    if (o == nullptr) {
+        headlessError(function, "Object does not exist", name);
+        return;
+    }
+    o->alive = false;
+    if (o->storage.data != nullptr) {
+        headlessGL.alloc->dealloc(o->storage);
+        o->storage = Blk(nullptr, 0);
+    }
+    headlessRemoveVariables(name);
+    headlessGL.frame.objectsDeleted++;
+    headlessRecord(HeadlessCmd::DELETE_OBJECT, type, name);
+}
+
+void headlessGenObjects(GLsizei n, GLuint* names, HeadlessObject::ENUM type) {
+    for (int i = 0; i < n; i++) {
+        names[i] = headlessCreateObject(type);
+    }
+}
+
+void headlessDeleteObjects(GLsizei n, const GLuint* names, HeadlessObject::ENUM type, const char* function) {
+    for (int i = 0; i < n; i++) {
+        headlessDeleteObject(names[i], type, function);
+    }
+}
+
+// Returns the variable with the given name, "name" and "name[0]" are the same for arrays
+HeadlessVariable* headlessFindVariable(GLuint owner, bool isAttrib, const char* name)
+{
+    int len = (int)strlen(name);
+    if (len > 3 && strcmp(name + len - 3, "[0]") == 0) {
+        len -= 3;
+    }
+    for (HeadlessVariable& v : headlessGL.variables)
+    {
+        if (v.owner != owner || v.isAttrib != isAttrib || v.isBlock) continue;
+        if (strncmp(v.name, name, len) == 0 && (v.name[len] == 0 || strcmp(v.name + len, "[0]") == 0)) {
+            return &v;
+        }
+    }
+    return nullptr;
+}
+
+HeadlessVariable* headlessGetVariable(GLuint owner, bool isAttrib, int index)
+{
+    int i = 0;
+    for (HeadlessVariable& v : headlessGL.variables)
+    {
+        if (v.owner != owner || v.isAttrib != isAttrib || v.isBlock) continue;
+        if (i == index) return &v;
+        i++;
+    }
+    return nullptr;
+}
+
+int headlessCountVariables(GLuint owner, bool isAttrib)
+{
+    int count = 0;
+    for (HeadlessVariable& v : headlessGL.variables) {
+        if (v.owner == owner && v.isAttrib == isAttrib && !v.isBlock) count++;
+    }
+    return count;
+}
+
+HeadlessVariable* headlessFindBlock(GLuint owner, const char* name)
+{
+    for (HeadlessVariable& v : headlessGL.variables) {
+        if (v.owner == owner && v.isBlock && strcmp(v.name, name) == 0) return &v;
+    }
+    return nullptr;
+}
+
+HeadlessVariable* headlessGetBlock(GLuint owner, GLint blockIndex)
+{
+    for (HeadlessVariable& v : headlessGL.variables) {
+        if (v.owner == owner && v.isBlock && v.blockIndex == blockIndex) return &v;
+    }
+    return nullptr;
+}
+
+// Returns true if the state value changed, counts redundant changes
+template<typename T>
+bool headlessSetState(T* state, T value)
+{
+    headlessGL.frame.stateChanges++;
+    if (*state == value) {
+        headlessGL.frame.redundantStateChanges++;
+        return false;
+    }
+    *state = value;
+    return true;
+}
+
+void headlessSetCap(GLenum cap, bool enabled)
+{
+    headlessRecord(HeadlessCmd::STATE, enabled ? 1 : 0, cap);
+    for (int i = 0; i < headlessGL.capCount; i++) {
+        if (headlessGL.caps[i] == cap) {
+            headlessSetState(&headlessGL.capEnabled[i], enabled);
+            return;
+        }
+    }
+    assert(headlessGL.capCount < HEADLESS_MAX_CAPS, "HeadlessGL: Too many different caps\n");
+    headlessGL.caps[headlessGL.capCount] = cap;
+    headlessGL.capEnabled[headlessGL.capCount] = enabled;
+    headlessGL.capCount++;
+    headlessGL.frame.stateChanges++;
+}
+
+bool headlessIsEnabled(GLenum cap)
+{
+    for (int i = 0; i < headlessGL.capCount; i++) {
+        if (headlessGL.caps[i] == cap) return headlessGL.capEnabled[i];
+    }
+    return false;
+}
+
+int glFormatBytesPerPixel(GLenum format, GLenum type)
+{
+    int channels = 4;
+    switch (format)
+    {
+    case GL_RED: case GL_DEPTH_COMPONENT: case GL_STENCIL_INDEX: channels = 1; break;
+    case GL_RG: case GL_DEPTH_STENCIL: channels = 2; break;
+    case GL_RGB: case GL_BGR: channels = 3; break;
+    }
+    switch (type)
+    {
+    case GL_UNSIGNED_BYTE: case GL_BYTE: return channels;
+    case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: return channels * 2;
+    case GL_UNSIGNED_INT_24_8: return 4;
+    }
+    return channels * 4;
+}
+
+// Bytes per 4x4 block, 0 if the format is not a supported compressed format
+int glCompressedBlockBytes(GLenum internalFormat)
+{
+    switch (internalFormat)
+    {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RED_RGTC1:
+        return 8;
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_RG_RGTC2:
+        return 16;
+    }
+    return 0;
+}
+
+
+// ---------------------
+// --- GLSL PARSING ---
+// ---------------------
+// Only global declarations are parsed: [layout(location = N)] (uniform|in) [precision] type name[N], ...;
+// Function bodies, blocks and preprocessor lines are skipped.
+GLenum glslTypeToGLenum(const char* type)
+{
+    struct { const char* name; GLenum type; } types[] = {
+        {"float", GL_FLOAT}, {"vec2", GL_FLOAT_VEC2}, {"vec3", GL_FLOAT_VEC3}, {"vec4", GL_FLOAT_VEC4},
+        {"int", GL_INT}, {"ivec2", GL_INT_VEC2}, {"ivec3", GL_INT_VEC3}, {"ivec4", GL_INT_VEC4},
+        {"uint", GL_UNSIGNED_INT}, {"uvec2", GL_UNSIGNED_INT_VEC2}, {"uvec3", GL_UNSIGNED_INT_VEC3}, {"uvec4", GL_UNSIGNED_INT_VEC4},
+        {"bool", GL_BOOL}, {"bvec2", GL_BOOL_VEC2}, {"bvec3", GL_BOOL_VEC3}, {"bvec4", GL_BOOL_VEC4},
+        {"mat2", GL_FLOAT_MAT2}, {"mat3", GL_FLOAT_MAT3}, {"mat4", GL_FLOAT_MAT4},
+        {"mat2x3", GL_FLOAT_MAT2x3}, {"mat2x4", GL_FLOAT_MAT2x4}, {"mat3x2", GL_FLOAT_MAT3x2},
+        {"mat3x4", GL_FLOAT_MAT3x4}, {"mat4x2", GL_FLOAT_MAT4x2}, {"mat4x3", GL_FLOAT_MAT4x3},
+        {"sampler1D", GL_SAMPLER_1D}, {"sampler2D", GL_SAMPLER_2D}, {"sampler3D", GL_SAMPLER_3D},
+        {"samplerCube", GL_SAMPLER_CUBE}, {"sampler2DShadow", GL_SAMPLER_2D_SHADOW},
+        {"sampler2DArray", GL_SAMPLER_2D_ARRAY}, {"isampler2D", GL_INT_SAMPLER_2D},
+        {"usampler2D", GL_UNSIGNED_INT_SAMPLER_2D},
+    };
+    for (int i = 0; i < (int)(sizeof(types) / sizeof(types[0])); i++) {
+        if (strcmp(types[i].name, type) == 0) return types[i].type;
+    }
+    return 0;
+}
+
+// Number of locations a uniform/attrib of this type uses
+int glTypeLocationCount(GLenum type, bool isAttrib)
+{
+    if (!isAttrib) return 1;
+    switch (type)
+    {
+    case GL_FLOAT_MAT2: case GL_FLOAT_MAT2x3: case GL_FLOAT_MAT2x4: return 2;
+    case GL_FLOAT_MAT3: case GL_FLOAT_MAT3x2: case GL_FLOAT_MAT3x4: return 3;
+    case GL_FLOAT_MAT4: case GL_FLOAT_MAT4x2: case GL_FLOAT_MAT4x3: return 4;
+    }
+    return 1;
+}
+
+bool isGlslIdentChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Splits into tokens, parentheses, '=', ',', '[' and ']' are separate tokens
+int tokenizeGlsl(const char* stmt, char tokens[32][HEADLESS_MAX_NAME_LENGTH])
+{
+    int tokenCount = 0;
+    const char* c = stmt;
+    while (*c != 0 && tokenCount < 32)
+    {
+        if (*c == ' ' || *c == '\t' || *c == '\n' || *c == '\r') {
+            c++;
+            continue;
+        }
+        int len = 0;
+        if (isGlslIdentChar(*c)) {
+            while (isGlslIdentChar(c[len]) && len < HEADLESS_MAX_NAME_LENGTH - 1) len++;
+        }
+        else {
+            len = 1;
+        }
+        memcpy(tokens[tokenCount], c, len);
+        tokens[tokenCount][len] = 0;
+        tokenCount++;
+        c += len;
+    }
+    return tokenCount;
+}
+
+// Skips the layout qualifier, returns the value of the given layout parameter (-1 if not set)
+GLint parseGlslLayout(char tokens[32][HEADLESS_MAX_NAME_LENGTH], int tokenCount, int* i, const char* parameter)
+{
+    GLint value = -1;
+    if (*i < tokenCount && strcmp(tokens[*i], "layout") == 0)
+    {
+        while (*i < tokenCount && strcmp(tokens[*i], ")") != 0) {
+            if (strcmp(tokens[*i], parameter) == 0 && *i + 2 < tokenCount && strcmp(tokens[*i+1], "=") == 0) {
+                value = atoi(tokens[*i+2]);
+            }
+            (*i)++;
+        }
+        (*i)++;
+    }
+    return value;
+}
+
+// Parses the statement before a '{', returns true if it starts a uniform block
+bool parseGlslBlockHeader(GLuint shader, const char* stmt)
+{
+    char tokens[32][HEADLESS_MAX_NAME_LENGTH];
+    int tokenCount = tokenizeGlsl(stmt, tokens);
+    int i = 0;
+    GLint binding = parseGlslLayout(tokens, tokenCount, &i, "binding");
+    if (i + 1 >= tokenCount || strcmp(tokens[i], "uniform") != 0) {
+        return false;
+    }
+
+    HeadlessVariable v;
+    memset(&v, 0, sizeof(v));
+    v.owner = shader;
+    v.isBlock = true;
+    v.location = binding == -1 ? 0 : binding;
+    strncpy(v.name, tokens[i+1], HEADLESS_MAX_NAME_LENGTH - 1);
+    headlessGL.variables.push_back(v);
+    return true;
+}
+
+// Parses one declaration statement (Without the semicolon)
+void parseGlslDeclaration(GLuint shader, GLenum shaderType, const char* stmt, bool blockMember)
+{
+    char tokens[32][HEADLESS_MAX_NAME_LENGTH];
+    int tokenCount = tokenizeGlsl(stmt, tokens);
+
+    // Layout qualifier
+    int i = 0;
+    GLint explicitLocation = parseGlslLayout(tokens, tokenCount, &i, "location");
+
+    // Storage qualifier, only uniforms and vertex inputs are interesting
+    // Members of uniform blocks have none
+    bool isAttrib = false;
+    bool found = blockMember;
+    for (; i < tokenCount && !found; i++)
+    {
+        if (strcmp(tokens[i], "uniform") == 0) {
+            found = true;
+        }
+        else if (strcmp(tokens[i], "in") == 0 && shaderType == GL_VERTEX_SHADER) {
+            isAttrib = true;
+            found = true;
+        }
+        else if (!isGlslIdentChar(tokens[i][0])) {
+            return;
+        }
+    }
+    if (!found) return;
+
+    // Skip precision/interpolation qualifiers
+    while (i < tokenCount &&
+            (strcmp(tokens[i], "highp") == 0 || strcmp(tokens[i], "mediump") == 0 ||
+             strcmp(tokens[i], "lowp") == 0 || strcmp(tokens[i], "flat") == 0 ||
+             strcmp(tokens[i], "smooth") == 0 || strcmp(tokens[i], "noperspective") == 0)) {
+        i++;
+    }
+    if (i >= tokenCount) return;
+    GLenum type = glslTypeToGLenum(tokens[i]);
+    if (type == 0) return; // Structs and blocks are not supported
+    i++;
+
+    // Declarators: name [ '[' N ']' ] [',' ...]
+    while (i < tokenCount)
+    {
+        HeadlessVariable v;
+        memset(&v, 0, sizeof(v));
+        v.owner = shader;
+        v.isAttrib = isAttrib;
+        v.inBlock = blockMember;
+        v.type = type;
+        v.size = 1;
+        v.location = explicitLocation;
+        strncpy(v.name, tokens[i], HEADLESS_MAX_NAME_LENGTH - 4);
+        i++;
+        if (i + 2 < tokenCount && strcmp(tokens[i], "[") == 0) {
+            v.size = atoi(tokens[i+1]);
+            strcat(v.name, "[0]");
+            i += 3;
+        }
+        // Skip initializer
+        while (i < tokenCount && strcmp(tokens[i], ",") != 0) i++;
+        i++;
+        headlessGL.variables.push_back(v);
+        explicitLocation = -1;
+    }
+}
+
+void parseGlslSource(GLuint shader, GLenum shaderType, const char* src, int length)
+{
+    char stmt[1024];
+    int stmtLen = 0;
+    int depth = 0;
+    bool inUniformBlock = false;
+    bool lineStart = true;
+    for (int i = 0; i < length; i++)
+    {
+        char c = src[i];
+        // Comments
+        if (c == '/' && i + 1 < length && src[i+1] == '/') {
+            while (i < length && src[i] != '\n') i++;
+            lineStart = true;
+            continue;
+        }
+        if (c == '/' && i + 1 < length && src[i+1] == '*') {
+            i += 2;
+            while (i + 1 < length && !(src[i] == '*' && src[i+1] == '/')) i++;
+            i++;
+            continue;
+        }
+        // Preprocessor lines
+        if (lineStart && c == '#') {
+            while (i < length && src[i] != '\n') i++;
+            continue;
+        }
+        if (c == '\n') lineStart = true;
+        else if (c != ' ' && c != '\t') lineStart = false;
+
+        bool parseStmt = depth == 0 || (depth == 1 && inUniformBlock);
+        if (c == '{') {
+            stmt[stmtLen] = 0;
+            if (depth == 0) {
+                inUniformBlock = parseGlslBlockHeader(shader, stmt);
+            }
+            depth++;
+            stmtLen = 0;
+        }
+        else if (c == '}') {
+            depth--;
+            if (depth == 0) {
+                inUniformBlock = false;
+            }
+            stmtLen = 0;
+        }
+        else if (parseStmt && c == ';') {
+            stmt[stmtLen] = 0;
+            parseGlslDeclaration(shader, shaderType, stmt, depth == 1);
+            stmtLen = 0;
+        }
+        else if (parseStmt && stmtLen < 1023) {
+            stmt[stmtLen++] = c;
+        }
+    }
+}
+
+// Merges the shader interfaces and assigns locations
+void headlessLinkProgram(GLuint program, HeadlessObjectInfo* p)
+{
+    headlessRemoveVariables(program);
+    GLint nextUniformLocation = 0;
+    GLint nextAttribLocation = 0;
+    GLint nextBlockIndex = 0;
+    for (int s = 0; s < p->attachedCount; s++)
+    {
+        GLuint shader = p->attached[s];
+        for (int i = 0; i < headlessGL.variables.size(); i++)
+        {
+            HeadlessVariable v = headlessGL.variables[i];
+            if (v.owner != shader) continue;
+            // Declared in multiple stages
+            if (v.isBlock && headlessFindBlock(program, v.name) != nullptr) continue;
+            if (!v.isBlock && headlessFindVariable(program, v.isAttrib, v.name) != nullptr) continue;
+
+            v.owner = program;
+            if (v.isBlock) {
+                v.blockIndex = nextBlockIndex++;
+                headlessGL.variables.push_back(v);
+                continue;
+            }
+            if (v.inBlock) {
+                v.location = -1;
+                headlessGL.variables.push_back(v);
+                continue;
+            }
+            GLint* nextLocation = v.isAttrib ? &nextAttribLocation : &nextUniformLocation;
+            if (v.location == -1) {
+                v.location = *nextLocation;
+            }
+            int count = v.size * glTypeLocationCount(v.type, v.isAttrib);
+            if (v.location + count > *nextLocation) {
+                *nextLocation = v.location + count;
+            }
+            headlessGL.variables.push_back(v);
+        }
+    }
+}
+
+
+
+// -----------------------
+// --- GL ENTRY POINTS ---
+// -----------------------
+void APIENTRY headless_glDebugMessageCallback(GLDEBUGPROC /*callback*/, const void* /*userParam*/) {
+    headlessGL.frame.calls++;
+}
+
+// Objects
+void APIENTRY headless_glGenBuffers(GLsizei n, GLuint* buffers) {
+    headlessGenObjects(n, buffers, HeadlessObject::BUFFER);
+}
+void APIENTRY headless_glDeleteBuffers(GLsizei n, const GLuint* buffers) {
+    headlessDeleteObjects(n, buffers, HeadlessObject::BUFFER, "glDeleteBuffers");
+}
+void APIENTRY headless_glGenVertexArrays(GLsizei n, GLuint* arrays) {
+    headlessGenObjects(n, arrays, HeadlessObject::VERTEX_ARRAY);
+}
+void APIENTRY headless_glDeleteVertexArrays(GLsizei n, const GLuint* arrays) {
+    headlessDeleteObjects(n, arrays, HeadlessObject::VERTEX_ARRAY, "glDeleteVertexArrays");
+}
+void APIENTRY headless_glGenTextures(GLsizei n, GLuint* textures) {
+    headlessGenObjects(n, textures, HeadlessObject::TEXTURE);
+}
+void APIENTRY headless_glDeleteTextures(GLsizei n, const GLuint* textures) {
+    headlessDeleteObjects(n, textures, HeadlessObject::TEXTURE, "glDeleteTextures");
+}
+void APIENTRY headless_glGenFramebuffers(GLsizei n, GLuint* framebuffers) {
+    headlessGenObjects(n, framebuffers, HeadlessObject::FRAMEBUFFER);
+}
+void APIENTRY headless_glDeleteFramebuffers(GLsizei n, const GLuint* framebuffers) {
+    headlessDeleteObjects(n, framebuffers, HeadlessObject::FRAMEBUFFER, "glDeleteFramebuffers");
+}
+void APIENTRY headless_glGenRenderbuffers(GLsizei n, GLuint* renderbuffers) {
+    headlessGenObjects(n, renderbuffers, HeadlessObject::RENDERBUFFER);
+}
+void APIENTRY headless_glDeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers) {
+    headlessDeleteObjects(n, renderbuffers, HeadlessObject::RENDERBUFFER, "glDeleteRenderbuffers");
+}
+
+// Buffers
+void APIENTRY headless_glBindBuffer(GLenum target, GLuint buffer)
+{
+    headlessRecord(HeadlessCmd::BIND_BUFFER, target, buffer);
+    headlessGL.frame.bufferBinds++;
+    if (buffer != 0 && headlessGetObject(buffer, HeadlessObject::BUFFER) == nullptr) {
+        headlessError("glBindBuffer", "Buffer does not exist", buffer);
+        return;
+    }
+    if (target == GL_ELEMENT_ARRAY_BUFFER) {
+        headlessBoundVao()->elementBuffer = buffer;
+    }
+    else if (target == GL_ARRAY_BUFFER) {
+        headlessGL.arrayBuffer = buffer;
+    }
+    else if (target == GL_UNIFORM_BUFFER) {
+        headlessGL.uniformBuffer = buffer;
+    }
+    else if (target == GL_PIXEL_UNPACK_BUFFER) {
+        headlessGL.pixelUnpackBuffer = buffer;
+    }
+    else if (target == GL_SHADER_STORAGE_BUFFER) {
+        headlessGL.storageBuffer = buffer;
+    }
+}
+
+// Indexed binding of glBindBufferBase/Range, also binds the generic binding point
+bool headlessBindIndexed(const char* func, GLenum target, GLuint index, GLuint buffer)
+{
+    if (buffer != 0 && headlessGetObject(buffer, HeadlessObject::BUFFER) == nullptr) {
+        headlessError(func, "Buffer does not exist", buffer);
+        return false;
+    }
+    if (target == GL_UNIFORM_BUFFER && index < HEADLESS_UNIFORM_BINDINGS) {
+        headlessGL.uniformBindings[index] = buffer;
+        headlessGL.uniformBuffer = buffer;
+        return true;
+    }
+    if (target == GL_SHADER_STORAGE_BUFFER && index < HEADLESS_STORAGE_BINDINGS) {
+        headlessGL.storageBindings[index] = buffer;
+        headlessGL.storageBuffer = buffer;
+        return true;
+    }
+    headlessError(func, "Only uniform and shader storage bindings are supported", index);
+    return false;
+}
+
+void APIENTRY headless_glBindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    headlessRecord(HeadlessCmd::BIND_BUFFER, target, buffer, index);
+    headlessGL.frame.bufferBinds++;
+    headlessBindIndexed("glBindBufferBase", target, index, buffer);
+}
+
+void APIENTRY headless_glBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+    headlessRecord(HeadlessCmd::BIND_BUFFER, target, buffer, index);
+    headlessGL.frame.bufferBinds++;
+    if (!headlessBindIndexed("glBindBufferRange", target, index, buffer)) {
+        return;
+    }
+    HeadlessObjectInfo* b = headlessGetObject(buffer, HeadlessObject::BUFFER);
+    if (b == nullptr || size <= 0 || (u64)(offset + size) > b->byteSize) {
+        headlessError("glBindBufferRange", "Range outside of buffer", (u32)offset);
+    }
+    else if (target == GL_SHADER_STORAGE_BUFFER && offset % HEADLESS_STORAGE_OFFSET_ALIGNMENT != 0) {
+        headlessError("glBindBufferRange", "Offset not aligned to GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT", (u32)offset);
+    }
+}
+
+GLuint headlessBoundBuffer(GLenum target)
+{
+    switch (target)
+    {
+    case GL_ELEMENT_ARRAY_BUFFER: return headlessBoundVao()->elementBuffer;
+    case GL_UNIFORM_BUFFER: return headlessGL.uniformBuffer;
+    case GL_PIXEL_UNPACK_BUFFER: return headlessGL.pixelUnpackBuffer;
+    case GL_SHADER_STORAGE_BUFFER: return headlessGL.storageBuffer;
+    }
+    return headlessGL.arrayBuffer;
+}
+
+void APIENTRY headless_glBufferData(GLenum target, GLsizeiptr size, const void* /*data*/, GLenum /*usage*/)
+{
+    headlessRecord(HeadlessCmd::BUFFER_DATA, target, (u32)size);
+    GLuint buffer = headlessBoundBuffer(target);
+    HeadlessObjectInfo* b = headlessGetObject(buffer, HeadlessObject::BUFFER);
+    if (b == nullptr) {
+        headlessError("glBufferData", "No buffer bound to target", target);
+        return;
+    }
+    if (b->immutable) {
+        headlessError("glBufferData", "Buffer has immutable storage", buffer);
+        return;
+    }
+    b->byteSize = (u64)size;
+    headlessGL.frame.bufferBytes += (u64)size;
+}
+
+void APIENTRY headless_glBufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield /*flags*/)
+{
+    headlessRecord(HeadlessCmd::BUFFER_DATA, target, (u32)size);
+    GLuint buffer = headlessBoundBuffer(target);
+    HeadlessObjectInfo* b = headlessGetObject(buffer, HeadlessObject::BUFFER);
+    if (b == nullptr || b->immutable) {
+        headlessError("glBufferStorage", "No buffer bound or storage already immutable", buffer);
+        return;
+    }
+    b->immutable = true;
+    b->byteSize = (u64)size;
+    b->storage = headlessGL.alloc->alloc((u64)size);
+    if (data != nullptr) {
+        memcpy(b->storage.data, data, size);
+    }
+    headlessGL.frame.bufferBytes += (u64)size;
+}
+
+void* APIENTRY headless_glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield /*access*/)
+{
+    headlessGL.frame.calls++;
+    GLuint buffer = headlessBoundBuffer(target);
+    HeadlessObjectInfo* b = headlessGetObject(buffer, HeadlessObject::BUFFER);
+    if (b == nullptr || b->mapped || (u64)(offset + length) > b->byteSize) {
+        headlessError("glMapBufferRange", "No buffer bound, already mapped or range outside of storage", buffer);
+        return nullptr;
+    }
+    if (b->storage.data == nullptr) {
+        b->storage = headlessGL.alloc->alloc(b->byteSize);
+    }
+    b->mapped = true;
+    return (byte*)b->storage.data + offset;
+}
+
+GLboolean APIENTRY headless_glUnmapBuffer(GLenum target)
+{
+    headlessGL.frame.calls++;
+    HeadlessObjectInfo* b = headlessGetObject(headlessBoundBuffer(target), HeadlessObject::BUFFER);
+    if (b == nullptr || !b->mapped) {
+        headlessError("glUnmapBuffer", "Buffer is not mapped", target);
+        return GL_FALSE;
+    }
+    b->mapped = false;
+    return GL_TRUE;
+}
+
+void APIENTRY headless_glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* /*data*/)
+{
+    headlessRecord(HeadlessCmd::BUFFER_DATA, target, (u32)size, (u32)offset);
+    HeadlessObjectInfo* b = headlessGetObject(headlessBoundBuffer(target), HeadlessObject::BUFFER);
+    if (b == nullptr) {
+        headlessError("glBufferSubData", "No buffer bound to target", target);
+        return;
+    }
+    if ((u64)(offset + size) > b->byteSize) {
+        headlessError("glBufferSubData", "Range outside of buffer storage", (u32)(offset + size));
+        return;
+    }
+    headlessGL.frame.bufferBytes += (u64)size;
+}
+
+// Sync objects
+GLsync APIENTRY headless_glFenceSync(GLenum /*condition*/, GLbitfield /*flags*/)
+{
+    GLuint name = headlessCreateObject(HeadlessObject::SYNC);
+    headlessGL.objects[name].fenceFrame = headlessGL.frameCount;
+    return (GLsync)(u64)name;
+}
+
+GLenum APIENTRY headless_glClientWaitSync(GLsync sync, GLbitfield /*flags*/, GLuint64 timeout)
+{
+    headlessGL.frame.calls++;
+    HeadlessObjectInfo* o = headlessGetObject((GLuint)(u64)sync, HeadlessObject::SYNC);
+    if (o == nullptr) {
+        headlessError("glClientWaitSync", "Sync does not exist", (u32)(u64)sync);
+        return GL_WAIT_FAILED;
+    }
+    if (headlessGL.frameCount - o->fenceFrame >= HEADLESS_GPU_LATENCY) {
+        return GL_ALREADY_SIGNALED;
+    }
+    if (timeout == 0) {
+        return GL_TIMEOUT_EXPIRED;
+    }
+    headlessGL.frame.syncWaits++;
+    return GL_CONDITION_SATISFIED; // The simulated wait always finishes
+}
+
+void APIENTRY headless_glDeleteSync(GLsync sync) {
+    headlessDeleteObject((GLuint)(u64)sync, HeadlessObject::SYNC, "glDeleteSync");
+}
+
+// Vertex arrays
+void APIENTRY headless_glBindVertexArray(GLuint array)
+{
+    headlessRecord(HeadlessCmd::BIND_VAO, array);
+    headlessGL.frame.vaoBinds++;
+    if (array != 0 && headlessGetObject(array, HeadlessObject::VERTEX_ARRAY) == nullptr) {
+        headlessError("glBindVertexArray", "Vertex array does not exist", array);
+        return;
+    }
+    if (headlessGL.vao == array) {
+        headlessGL.frame.redundantVaoBinds++;
+    }
+    headlessGL.vao = array;
+}
+
+void APIENTRY headless_glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean /*normalized*/, GLsizei /*stride*/, const void* /*pointer*/)
+{
+    headlessRecord(HeadlessCmd::VERTEX_ATTRIB, index, size, type);
+    if (headlessGL.vao == 0 || headlessGL.arrayBuffer == 0) {
+        headlessError("glVertexAttribPointer", "No vao or array buffer bound", index);
+    }
+}
+
+void APIENTRY headless_glEnableVertexAttribArray(GLuint index)
+{
+    headlessRecord(HeadlessCmd::VERTEX_ATTRIB, index);
+    if (headlessGL.vao == 0) {
+        headlessError("glEnableVertexAttribArray", "No vao bound", index);
+    }
+}
+
+void APIENTRY headless_glBindVertexBuffer(GLuint bindingindex, GLuint buffer, GLintptr /*offset*/, GLsizei /*stride*/)
+{
+    headlessRecord(HeadlessCmd::BIND_BUFFER, GL_VERTEX_BINDING_BUFFER, buffer, bindingindex);
+    headlessGL.frame.bufferBinds++;
+    if (headlessGL.vao == 0) {
+        headlessError("glBindVertexBuffer", "No vao bound", bindingindex);
+    }
+    if (buffer != 0 && headlessGetObject(buffer, HeadlessObject::BUFFER) == nullptr) {
+        headlessError("glBindVertexBuffer", "Buffer does not exist", buffer);
+    }
+}
+
+void APIENTRY headless_glVertexAttribFormat(GLuint attribindex, GLint size, GLenum type, GLboolean /*normalized*/, GLuint /*relativeoffset*/)
+{
+    headlessRecord(HeadlessCmd::VERTEX_ATTRIB, attribindex, size, type);
+    if (headlessGL.vao == 0) {
+        headlessError("glVertexAttribFormat", "No vao bound", attribindex);
+    }
+}
+
+void APIENTRY headless_glVertexAttribBinding(GLuint attribindex, GLuint bindingindex)
+{
+    headlessRecord(HeadlessCmd::VERTEX_ATTRIB, attribindex, bindingindex);
+    if (headlessGL.vao == 0) {
+        headlessError("glVertexAttribBinding", "No vao bound", attribindex);
+    }
+}
+
+void APIENTRY headless_glVertexBindingDivisor(GLuint bindingindex, GLuint divisor)
+{
+    headlessRecord(HeadlessCmd::VERTEX_ATTRIB, bindingindex, divisor);
+    if (headlessGL.vao == 0) {
+        headlessError("glVertexBindingDivisor", "No vao bound", bindingindex);
+    }
+}
+
+void APIENTRY headless_glVertexAttribDivisor(GLuint index, GLuint divisor)
+{
+    headlessRecord(HeadlessCmd::VERTEX_ATTRIB, index, divisor);
+    if (headlessGL.vao == 0) {
+        headlessError("glVertexAttribDivisor", "No vao bound", index);
+    }
+}
+
+// Program binaries hold the linked interface of the program, so a program
+// restored with glProgramBinary behaves like the linked one
+#define HEADLESS_PROGRAM_BINARY_FORMAT 0x4844
+#define HEADLESS_PROGRAM_BINARY_MAGIC 0x42504c48 // "HLPB"
+struct HeadlessProgramBinaryHeader
+{
+    u32 magic;
+    u32 variableCount;
+};
+
+u64 headlessProgramBinarySize(GLuint program) {
+    int count = 0;
+    for (HeadlessVariable& v : headlessGL.variables) {
+        if (v.owner == program) count++;
+    }
+    return sizeof(HeadlessProgramBinaryHeader) + count * sizeof(HeadlessVariable);
+}
+
+// Shaders
+GLuint APIENTRY headless_glCreateShader(GLenum type)
+{
+    GLuint name = headlessCreateObject(HeadlessObject::SHADER);
+    headlessGL.objects[name].shaderType = type;
+    return name;
+}
+
+void APIENTRY headless_glDeleteShader(GLuint shader) {
+    headlessDeleteObject(shader, HeadlessObject::SHADER, "glDeleteShader");
+}
+
+void APIENTRY headless_glShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length)
+{
+    headlessGL.frame.calls++;
+    HeadlessObjectInfo* s = headlessGetObject(shader, HeadlessObject::SHADER);
+    if (s == nullptr) {
+        headlessError("glShaderSource", "Shader does not exist", shader);
+        return;
+    }
+    headlessRemoveVariables(shader);
+    for (int i = 0; i < count; i++) {
+        int len = (length == nullptr || length[i] < 0) ? (int)strlen(string[i]) : length[i];
+        parseGlslSource(shader, s->shaderType, string[i], len);
+    }
+}
+
+void APIENTRY headless_glCompileShader(GLuint shader) 
+{
+    headlessRecord(HeadlessCmd::COMPILE, shader);
+    headlessGL.frame.shaderCompiles++;
+    HeadlessObjectInfo* s = headlessGetObject(shader, HeadlessObject::SHADER);
+    if (s != nullptr) {
+        s->compileFrame = headlessGL.frameCount;
+    }
+}
+
+// Compiles and links run in the background like with GL_KHR_parallel_shader_compile,
+// every other query of an unfinished object waits for it
+bool headlessIsCompileDone(HeadlessObjectInfo* o) {
+    return o == nullptr || headlessGL.frameCount - o->compileFrame >= HEADLESS_COMPILE_LATENCY;
+}
+
+void headlessWaitForCompile(HeadlessObjectInfo* o)
+{
+    if (!headlessIsCompileDone(o)) {
+        headlessGL.frame.compileStalls++;
+        o->compileFrame = headlessGL.frameCount - HEADLESS_COMPILE_LATENCY;
+    }
+}
+
+void APIENTRY headless_glGetShaderiv(GLuint shader, GLenum pname, GLint* params)
+{
+    headlessGL.frame.calls++;
+    HeadlessObjectInfo* s = headlessGetObject(shader, HeadlessObject::SHADER);
+    if (pname == GL_COMPLETION_STATUS_KHR) {
+        *params = headlessIsCompileDone(s) ? GL_TRUE : GL_FALSE;
+        return;
+    }
+    headlessWaitForCompile(s);
+    switch (pname)
+    {
+    case GL_COMPILE_STATUS: *params = s != nullptr ? GL_TRUE : GL_FALSE; break;
+    case GL_SHADER_TYPE: *params = s != nullptr ? s->shaderType : 0; break;
+    case GL_DELETE_STATUS: *params = s == nullptr ? GL_TRUE : GL_FALSE; break;
+    default: *params = 1; break; // Info log length (Just the terminator)
+    }
+}
+
+void APIENTRY headless_glGetShaderInfoLog(GLuint /*shader*/, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
+{
+    headlessGL.frame.calls++;
+    if (length != nullptr) *length = 0;
+    if (bufSize > 0) infoLog[0] = 0;
+}
+
+// Programs
+GLuint APIENTRY headless_glCreateProgram() {
+    return headlessCreateObject(HeadlessObject::PROGRAM);
+}
+
+void APIENTRY headless_glDeleteProgram(GLuint program) {
+    headlessDeleteObject(program, HeadlessObject::PROGRAM, "glDeleteProgram");
+}
+
+void APIENTRY headless_glAttachShader(GLuint program, GLuint shader)
+{
+    headlessGL.frame.calls++;
+    HeadlessObjectInfo* p = headlessGetObject(program, HeadlessObject::PROGRAM);
+    if (p == nullptr || headlessGetObject(shader, HeadlessObject::SHADER) == nullptr) {
+        headlessError("glAttachShader", "Program or shader does not exist", program);
+        return;
+    }
+    assert(p->attachedCount < HEADLESS_MAX_ATTACHED_SHADERS, "HeadlessGL: Too many attached shaders\n");
+    p->attached[p->attachedCount++] = shader;
+}
+
+void APIENTRY headless_glDetachShader(GLuint program, GLuint shader)
+{
+    headlessGL.frame.calls++;
+    HeadlessObjectInfo* p = headlessGetObject(program, HeadlessObject::PROGRAM);
+    if (p == nullptr) {
+        headlessError("glDetachShader", "Program does not exist", program);
+        return;
+    }
+    for (int i = 0; i < p->attachedCount; i++) {
+        if (p->attached[i] == shader) {
+            p->attached[i] = p->attached[--p->attachedCount];
+            return;
+        }
+    }
+    headlessError("glDetachShader", "Shader was not attached", shader);
+}
+
+void APIENTRY headless_glLinkProgram(GLuint program)
+{
+    headlessRecord(HeadlessCmd::LINK, program);
+    HeadlessObjectInfo* p = headlessGetObject(program, HeadlessObject::PROGRAM);
+    if (p == nullptr) {
+        headlessError("glLinkProgram", "Program does not exist", program);
+        return;
+    }
+    headlessGL.frame.programLinks++;
+    p->linkFailed = false;
+    p->compileFrame = headlessGL.frameCount;
+    headlessLinkProgram(program, p);
+}
+
+void APIENTRY headless_glGetProgramiv(GLuint program, GLenum pname, GLint* params)
+{
+    headlessGL.frame.calls++;
+    HeadlessObjectInfo* p = headlessGetObject(program, HeadlessObject::PROGRAM);
+    if (pname == GL_COMPLETION_STATUS_KHR) {
+        *params = headlessIsCompileDone(p) ? GL_TRUE : GL_FALSE;
+        return;
+    }
+    headlessWaitForCompile(p);
+    switch (pname)
+    {
+    case GL_LINK_STATUS: *params = (p != nullptr && !p->linkFailed) ? GL_TRUE : GL_FALSE; break;
+    case GL_PROGRAM_BINARY_LENGTH: *params = (GLint)headlessProgramBinarySize(program); break;
+    case GL_ACTIVE_UNIFORMS: *params = headlessCountVariables(program, false); break;
+    case GL_ACTIVE_ATTRIBUTES: *params = headlessCountVariables(program, true); break;
+    case GL_ACTIVE_UNIFORM_MAX_LENGTH:
+    case GL_ACTIVE_ATTRIBUTE_MAX_LENGTH: *params = HEADLESS_MAX_NAME_LENGTH; break;
+    case GL_ATTACHED_SHADERS: *params = p != nullptr ? p->attachedCount : 0; break;
+    default: *params = 1; break; // Info log length (Just the terminator)
+    }
+}
+
+void APIENTRY headless_glGetProgramInfoLog(GLuint /*program*/, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
+{
+    headlessGL.frame.calls++;
+    if (length != nullptr) *length = 0;
+    if (bufSize > 0) infoLog[0] = 0;
+}
+
+void APIENTRY headless_glUseProgram(GLuint program)
+{
+    headlessRecord(HeadlessCmd::USE_PROGRAM, program);
+    headlessGL.frame.programBinds++;
+    if (program != 0 && headlessGetObject(program, HeadlessObject::PROGRAM) == nullptr) {
+        headlessError("glUseProgram", "Program does not exist", program);
+        return;
+    }
+    headlessWaitForCompile(headlessGetObject(program, HeadlessObject::PROGRAM));
+    if (headlessGL.program == program) {
+        headlessGL.frame.redundantProgramBinds++;
+    }
+    headlessGL.program = program;
+}
+
+void headlessGetActiveVariable(GLuint program, bool isAttrib, GLuint index, GLsizei bufSize,
+        GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+{
+    headlessGL.frame.calls++;
+    HeadlessVariable* v = headlessGetVariable(program, isAttrib, (int)index);
+    if (v == nullptr) {
+        headlessError(isAttrib ? "glGetActiveAttrib" : "glGetActiveUniform", "Index out of range", index);
+        return;
+    }
+    *size = v->size;
+    *type = v->type;
+    if (bufSize > 0) {
+        strncpy(name, v->name, bufSize);
+        name[bufSize - 1] = 0;
+    }
+    if (length != nullptr) *length = (GLsizei)strlen(name);
+}
+
+void APIENTRY headless_glGetActiveUniform(GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name) {
+    headlessGetActiveVariable(program, false, index, bufSize, length, size, type, name);
+}
+void APIENTRY headless_glGetActiveAttrib(GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name) {
+    headlessGetActiveVariable(program, true, index, bufSize, length, size, type, name);
+}
+
+GLint APIENTRY headless_glGetUniformLocation(GLuint program, const GLchar* name)
+{
+    headlessGL.frame.calls++;
+    HeadlessVariable* v = headlessFindVariable(program, false, name);
+    return v != nullptr ? v->location : -1;
+}
+
+GLint APIENTRY headless_glGetAttribLocation(GLuint program, const GLchar* name)
+{
+    headlessGL.frame.calls++;
+    HeadlessVariable* v = headlessFindVariable(program, true, name);
+    return v != nullptr ? v->location : -1;
+}
+
+GLuint APIENTRY headless_glGetUniformBlockIndex(GLuint program, const GLchar* uniformBlockName)
+{
+    headlessGL.frame.calls++;
+    HeadlessVariable* v = headlessFindBlock(program, uniformBlockName);
+    return v != nullptr ? (GLuint)v->blockIndex : GL_INVALID_INDEX;
+}
+
+void APIENTRY headless_glUniformBlockBinding(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding)
+{
+    headlessGL.frame.calls++;
+    HeadlessVariable* v = headlessGetBlock(program, (GLint)uniformBlockIndex);
+    if (v == nullptr || uniformBlockBinding >= HEADLESS_UNIFORM_BINDINGS) {
+        headlessError("glUniformBlockBinding", "Invalid block index or binding", uniformBlockIndex);
+        return;
+    }
+    v->location = (GLint)uniformBlockBinding;
+}
+
+// Uniforms
+void headlessUniform(GLint location, u64 bytes)
+{
+    headlessRecord(HeadlessCmd::UNIFORM, headlessGL.program, (u32)location, (u32)bytes);
+    if (location == -1) return; // Ignored like on a real driver
+    if (headlessGL.program == 0) {
+        headlessError("glUniform", "No program bound", (GLuint)location);
+        return;
+    }
+    // Catches locations of other programs (E.g. Kept over a hot reload)
+    bool found = false;
+    for (HeadlessVariable& v : headlessGL.variables) {
+        if (v.owner == headlessGL.program && !v.isAttrib && !v.isBlock && !v.inBlock &&
+            location >= v.location && location < v.location + v.size) {
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        headlessError("glUniform", "Location is not a uniform of the bound program", (GLuint)location);
+        return;
+    }
+    headlessGL.frame.uniformUploads++;
+    headlessGL.frame.uniformBytes += bytes;
+}
+
+#define HEADLESS_UNIFORM_VECTOR(func, type, components) \
+    void APIENTRY headless_##func(GLint location, GLsizei count, const type* /*value*/) { \
+        headlessUniform(location, count * components * sizeof(type)); \
+    }
+#define HEADLESS_UNIFORM_MATRIX(func, components) \
+    void APIENTRY headless_##func(GLint location, GLsizei count, GLboolean /*transpose*/, const GLfloat* /*value*/) { \
+        headlessUniform(location, count * components * sizeof(GLfloat)); \
+    }
+
+void APIENTRY headless_glUniform1f(GLint l, GLfloat /*v0*/) { headlessUniform(l, 4); }
+void APIENTRY headless_glUniform2f(GLint l, GLfloat /*v0*/, GLfloat /*v1*/) { headlessUniform(l, 8); }
+void APIENTRY headless_glUniform3f(GLint l, GLfloat /*v0*/, GLfloat /*v1*/, GLfloat /*v2*/) { headlessUniform(l, 12); }
+void APIENTRY headless_glUniform4f(GLint l, GLfloat /*v0*/, GLfloat /*v1*/, GLfloat /*v2*/, GLfloat /*v3*/) { headlessUniform(l, 16); }
+void APIENTRY headless_glUniform1i(GLint l, GLint /*v0*/) { headlessUniform(l, 4); }
+void APIENTRY headless_glUniform2i(GLint l, GLint /*v0*/, GLint /*v1*/) { headlessUniform(l, 8); }
+void APIENTRY headless_glUniform3i(GLint l, GLint /*v0*/, GLint /*v1*/, GLint /*v2*/) { headlessUniform(l, 12); }
+void APIENTRY headless_glUniform4i(GLint l, GLint /*v0*/, GLint /*v1*/, GLint /*v2*/, GLint /*v3*/) { headlessUniform(l, 16); }
+void APIENTRY headless_glUniform1ui(GLint l, GLuint /*v0*/) { headlessUniform(l, 4); }
+void APIENTRY headless_glUniform2ui(GLint l, GLuint /*v0*/, GLuint /*v1*/) { headlessUniform(l, 8); }
+void APIENTRY headless_glUniform3ui(GLint l, GLuint /*v0*/, GLuint /*v1*/, GLuint /*v2*/) { headlessUniform(l, 12); }
+void APIENTRY headless_glUniform4ui(GLint l, GLuint /*v0*/, GLuint /*v1*/, GLuint /*v2*/, GLuint /*v3*/) { headlessUniform(l, 16); }
+HEADLESS_UNIFORM_VECTOR(glUniform1fv, GLfloat, 1)
+HEADLESS_UNIFORM_VECTOR(glUniform2fv, GLfloat, 2)
+HEADLESS_UNIFORM_VECTOR(glUniform3fv, GLfloat, 3)
+HEADLESS_UNIFORM_VECTOR(glUniform4fv, GLfloat, 4)
+HEADLESS_UNIFORM_VECTOR(glUniform1iv, GLint, 1)
+HEADLESS_UNIFORM_VECTOR(glUniform2iv, GLint, 2)
+HEADLESS_UNIFORM_VECTOR(glUniform3iv, GLint, 3)
+HEADLESS_UNIFORM_VECTOR(glUniform4iv, GLint, 4)
+HEADLESS_UNIFORM_VECTOR(glUniform1uiv, GLuint, 1)
+HEADLESS_UNIFORM_VECTOR(glUniform2uiv, GLuint, 2)
+HEADLESS_UNIFORM_VECTOR(glUniform3uiv, GLuint, 3)
+HEADLESS_UNIFORM_VECTOR(glUniform4uiv, GLuint, 4)
+HEADLESS_UNIFORM_MATRIX(glUniformMatrix2fv, 4)
+HEADLESS_UNIFORM_MATRIX(glUniformMatrix3fv, 9)
+HEADLESS_UNIFORM_MATRIX(glUniformMatrix4fv, 16)
+HEADLESS_UNIFORM_MATRIX(glUniformMatrix2x3fv, 6)
+HEADLESS_UNIFORM_MATRIX(glUniformMatrix3x2fv, 6)
+HEADLESS_UNIFORM_MATRIX(glUniformMatrix2x4fv, 8)
+HEADLESS_UNIFORM_MATRIX(glUniformMatrix4x2fv, 8)
+HEADLESS_UNIFORM_MATRIX(glUniformMatrix3x4fv, 12)
+HEADLESS_UNIFORM_MATRIX(glUniformMatrix4x3fv, 12)
+
+// Textures
+void APIENTRY headless_glActiveTexture(GLenum texture)
+{
+    headlessRecord(HeadlessCmd::ACTIVE_TEXTURE, texture - GL_TEXTURE0);
+    int unit = (int)(texture - GL_TEXTURE0);
+    if (unit < 0 || unit >= HEADLESS_TEXTURE_UNITS) {
+        headlessError("glActiveTexture", "Invalid texture unit", (GLuint)unit);
+        return;
+    }
+    headlessSetState(&headlessGL.activeUnit, unit);
+}
+
+void APIENTRY headless_glBindTexture(GLenum /*target*/, GLuint texture)
+{
+    headlessRecord(HeadlessCmd::BIND_TEXTURE, headlessGL.activeUnit, texture);
+    headlessGL.frame.textureBinds++;
+    if (texture != 0 && headlessGetObject(texture, HeadlessObject::TEXTURE) == nullptr) {
+        headlessError("glBindTexture", "Texture does not exist", texture);
+        return;
+    }
+    if (headlessGL.textures[headlessGL.activeUnit] == texture) {
+        headlessGL.frame.redundantTextureBinds++;
+    }
+    headlessGL.textures[headlessGL.activeUnit] = texture;
+}
+
+HeadlessObjectInfo* headlessBoundTexture(const char* function)
+{
+    GLuint texture = headlessGL.textures[headlessGL.activeUnit];
+    HeadlessObjectInfo* t = headlessGetObject(texture, HeadlessObject::TEXTURE);
+    if (t == nullptr) {
+        headlessError(function, "No texture bound", texture);
+    }
+    return t;
+}
+
+// With a pixel unpack buffer bound the pixel pointer is an offset into the buffer
+void headlessCheckUnpack(const char* func, const void* pixels, u64 bytes)
+{
+    if (headlessGL.pixelUnpackBuffer == 0) return;
+    HeadlessObjectInfo* b = headlessGetObject(headlessGL.pixelUnpackBuffer, HeadlessObject::BUFFER);
+    if (b != nullptr && (u64)pixels + bytes > b->byteSize) {
+        headlessError(func, "Range outside of the pixel unpack buffer", (u32)((u64)pixels + bytes));
+    }
+}
+
+void APIENTRY headless_glTexImage2D(GLenum /*target*/, GLint level, GLint /*internalformat*/, GLsizei width, GLsizei height, GLint /*border*/, GLenum format, GLenum type, const void* pixels)
+{
+    u64 bytes = (u64)width * height * glFormatBytesPerPixel(format, type);
+    headlessRecord(HeadlessCmd::TEX_IMAGE, headlessGL.textures[headlessGL.activeUnit], level, (u32)bytes);
+    HeadlessObjectInfo* t = headlessBoundTexture("glTexImage2D");
+    if (t == nullptr) return;
+    headlessCheckUnpack("glTexImage2D", pixels, bytes);
+    if (level == 0) {
+        t->width = width;
+        t->height = height;
+        t->byteSize = bytes;
+    }
+    headlessGL.frame.textureBytes += bytes;
+}
+
+void APIENTRY headless_glTexSubImage2D(GLenum /*target*/, GLint level, GLint /*xoffset*/, GLint /*yoffset*/, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+{
+    u64 bytes = (u64)width * height * glFormatBytesPerPixel(format, type);
+    headlessRecord(HeadlessCmd::TEX_IMAGE, headlessGL.textures[headlessGL.activeUnit], level, (u32)bytes);
+    if (headlessBoundTexture("glTexSubImage2D") == nullptr) return;
+    headlessCheckUnpack("glTexSubImage2D", pixels, bytes);
+    headlessGL.frame.textureBytes += bytes;
+}
+
+void APIENTRY headless_glCompressedTexImage2D(GLenum /*target*/, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint /*border*/, GLsizei imageSize, const void* data)
+{
+    headlessRecord(HeadlessCmd::TEX_IMAGE, headlessGL.textures[headlessGL.activeUnit], level, (u32)imageSize);
+    HeadlessObjectInfo* t = headlessBoundTexture("glCompressedTexImage2D");
+    if (t == nullptr) return;
+    int blockBytes = glCompressedBlockBytes(internalformat);
+    if (blockBytes == 0) {
+        headlessError("glCompressedTexImage2D", "Unknown compressed format", internalformat);
+        return;
+    }
+    u64 expected = (u64)((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+    if ((u64)imageSize != expected) {
+        headlessError("glCompressedTexImage2D", "imageSize does not match the block count", imageSize);
+        return;
+    }
+    headlessCheckUnpack("glCompressedTexImage2D", data, imageSize);
+    if (level == 0) {
+        t->width = width;
+        t->height = height;
+        t->byteSize = imageSize;
+    }
+    headlessGL.frame.textureBytes += imageSize;
+}
+
+void APIENTRY headless_glCompressedTexSubImage2D(GLenum /*target*/, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void* data)
+{
+    headlessRecord(HeadlessCmd::TEX_IMAGE, headlessGL.textures[headlessGL.activeUnit], level, (u32)imageSize);
+    if (headlessBoundTexture("glCompressedTexSubImage2D") == nullptr) return;
+    if ((xoffset % 4) != 0 || (yoffset % 4) != 0) {
+        headlessError("glCompressedTexSubImage2D", "Offset is not a multiple of the block size", yoffset);
+        return;
+    }
+    u64 expected = (u64)((width + 3) / 4) * ((height + 3) / 4) * glCompressedBlockBytes(format);
+    if (expected == 0 || (u64)imageSize != expected) {
+        headlessError("glCompressedTexSubImage2D", "imageSize does not match the block count", imageSize);
+        return;
+    }
+    headlessCheckUnpack("glCompressedTexSubImage2D", data, imageSize);
+    headlessGL.frame.textureBytes += imageSize;
+}
+
+void APIENTRY headless_glTexParameteri(GLenum /*target*/, GLenum pname, GLint param)
+{
+    headlessRecord(HeadlessCmd::STATE, pname, (u32)param);
+    headlessGL.frame.stateChanges++;
+    headlessBoundTexture("glTexParameteri");
+}
+
+void APIENTRY headless_glGenerateMipmap(GLenum /*target*/)
+{
+    headlessRecord(HeadlessCmd::TEX_IMAGE, headlessGL.textures[headlessGL.activeUnit], 1);
+    HeadlessObjectInfo* t = headlessBoundTexture("glGenerateMipmap");
+    if (t == nullptr) return;
+    headlessGL.frame.textureBytes += t->byteSize / 3; // Mip chain is a third of level 0
+}
+
+void APIENTRY headless_glPixelStorei(GLenum pname, GLint param) {
+    headlessRecord(HeadlessCmd::STATE, pname, (u32)param);
+    headlessGL.frame.stateChanges++;
+}
+
+// Framebuffers
+void APIENTRY headless_glBindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    headlessRecord(HeadlessCmd::BIND_FRAMEBUFFER, target, framebuffer);
+    headlessGL.frame.framebufferBinds++;
+    if (framebuffer != 0 && headlessGetObject(framebuffer, HeadlessObject::FRAMEBUFFER) == nullptr) {
+        headlessError("glBindFramebuffer", "Framebuffer does not exist", framebuffer);
+        return;
+    }
+    headlessGL.framebuffer = framebuffer;
+}
+
+GLenum APIENTRY headless_glCheckFramebufferStatus(GLenum /*target*/) {
+    headlessGL.frame.calls++;
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+void APIENTRY headless_glFramebufferTexture2D(GLenum /*target*/, GLenum attachment, GLenum /*textarget*/, GLuint texture, GLint /*level*/)
+{
+    headlessRecord(HeadlessCmd::STATE, attachment, texture);
+    if (headlessGL.framebuffer == 0 || headlessGetObject(texture, HeadlessObject::TEXTURE) == nullptr) {
+        headlessError("glFramebufferTexture2D", "No framebuffer bound or texture does not exist", texture);
+    }
+}
+
+void APIENTRY headless_glFramebufferRenderbuffer(GLenum /*target*/, GLenum attachment, GLenum /*renderbuffertarget*/, GLuint renderbuffer)
+{
+    headlessRecord(HeadlessCmd::STATE, attachment, renderbuffer);
+    if (headlessGL.framebuffer == 0 || headlessGetObject(renderbuffer, HeadlessObject::RENDERBUFFER) == nullptr) {
+        headlessError("glFramebufferRenderbuffer", "No framebuffer bound or renderbuffer does not exist", renderbuffer);
+    }
+}
+
+void APIENTRY headless_glBindRenderbuffer(GLenum /*target*/, GLuint renderbuffer)
+{
+    headlessRecord(HeadlessCmd::BIND_RENDERBUFFER, renderbuffer);
+    if (renderbuffer != 0 && headlessGetObject(renderbuffer, HeadlessObject::RENDERBUFFER) == nullptr) {
+        headlessError("glBindRenderbuffer", "Renderbuffer does not exist", renderbuffer);
+        return;
+    }
+    headlessGL.renderbuffer = renderbuffer;
+}
+
+void APIENTRY headless_glRenderbufferStorage(GLenum /*target*/, GLenum internalformat, GLsizei width, GLsizei height)
+{
+    headlessRecord(HeadlessCmd::STATE, internalformat, width, height);
+    HeadlessObjectInfo* r = headlessGetObject(headlessGL.renderbuffer, HeadlessObject::RENDERBUFFER);
+    if (r == nullptr) {
+        headlessError("glRenderbufferStorage", "No renderbuffer bound", 0);
+        return;
+    }
+    r->width = width;
+    r->height = height;
+    r->byteSize = (u64)width * height * 4;
+}
+
+// Fixed function state
+void APIENTRY headless_glEnable(GLenum cap) { headlessSetCap(cap, true); }
+void APIENTRY headless_glDisable(GLenum cap) { headlessSetCap(cap, false); }
+void APIENTRY headless_glClearColor(GLfloat /*r*/, GLfloat /*g*/, GLfloat /*b*/, GLfloat /*a*/) {
+    headlessRecord(HeadlessCmd::STATE, 0);
+    headlessGL.frame.stateChanges++;
+}
+void APIENTRY headless_glCullFace(GLenum mode) {
+    headlessRecord(HeadlessCmd::STATE, GL_CULL_FACE_MODE, mode);
+    headlessSetState(&headlessGL.cullFace, mode);
+}
+void APIENTRY headless_glFrontFace(GLenum mode) {
+    headlessRecord(HeadlessCmd::STATE, GL_FRONT_FACE, mode);
+    headlessSetState(&headlessGL.frontFace, mode);
+}
+void APIENTRY headless_glDepthFunc(GLenum func) {
+    headlessRecord(HeadlessCmd::STATE, GL_DEPTH_FUNC, func);
+    headlessSetState(&headlessGL.depthFunc, func);
+}
+void APIENTRY headless_glDepthMask(GLboolean flag) {
+    headlessRecord(HeadlessCmd::STATE, GL_DEPTH_WRITEMASK, flag);
+    headlessSetState(&headlessGL.depthMask, flag);
+}
+void APIENTRY headless_glBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+    headlessRecord(HeadlessCmd::STATE, GL_BLEND_SRC, sfactor, dfactor);
+    headlessGL.frame.stateChanges++;
+    if (headlessGL.blendFunc[0] == sfactor && headlessGL.blendFunc[1] == dfactor) {
+        headlessGL.frame.redundantStateChanges++;
+    }
+    headlessGL.blendFunc[0] = sfactor;
+    headlessGL.blendFunc[1] = dfactor;
+}
+void APIENTRY headless_glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    headlessRecord(HeadlessCmd::STATE, GL_VIEWPORT, width, height);
+    headlessGL.frame.stateChanges++;
+    GLint* v = headlessGL.viewport;
+    if (v[0] == x && v[1] == y && v[2] == width && v[3] == height) {
+        headlessGL.frame.redundantStateChanges++;
+    }
+    v[0] = x; v[1] = y; v[2] = width; v[3] = height;
+}
+
+// Drawing
+int glIndexTypeSize(GLenum type)
+{
+    switch (type)
+    {
+    case GL_UNSIGNED_BYTE: return 1;
+    case GL_UNSIGNED_SHORT: return 2;
+    }
+    return 4;
+}
+
+// indexBytes is the size of the indices read by an indexed draw
+void headlessValidateDraw(const char* function, bool indexed, u64 indexBytes = 0)
+{
+    HeadlessObjectInfo* vao = headlessGetObject(headlessGL.vao, HeadlessObject::VERTEX_ARRAY);
+    if (headlessGL.program == 0) {
+        headlessError(function, "Draw without program", 0);
+    }
+    if (vao == nullptr) {
+        headlessError(function, "Draw without vao", 0);
+    }
+    else if (indexed && vao->elementBuffer == 0) {
+        headlessError(function, "Indexed draw without element buffer", headlessGL.vao);
+    }
+    else if (indexed) {
+        HeadlessObjectInfo* ebo = headlessGetObject(vao->elementBuffer, HeadlessObject::BUFFER);
+        if (ebo != nullptr && indexBytes > ebo->byteSize) {
+            headlessError(function, "Draw reads past the end of the element buffer", (u32)indexBytes);
+        }
+    }
+    for (HeadlessVariable& v : headlessGL.variables) {
+        if (v.owner == headlessGL.program && v.isBlock && headlessGL.uniformBindings[v.location] == 0) {
+            headlessError(function, "No buffer bound to binding of uniform block", v.location);
+        }
+    }
+}
+
+void APIENTRY headless_glClear(GLbitfield mask) {
+    headlessRecord(HeadlessCmd::CLEAR, mask, headlessGL.framebuffer);
+    headlessGL.frame.clears++;
+}
+
+void APIENTRY headless_glDrawArrays(GLenum /*mode*/, GLint /*first*/, GLsizei count)
+{
+    headlessRecord(HeadlessCmd::DRAW_ARRAYS, headlessGL.program, headlessGL.vao, count);
+    headlessValidateDraw("glDrawArrays", false);
+    headlessGL.frame.drawCalls++;
+    headlessGL.frame.verticesDrawn += count;
+}
+
+void APIENTRY headless_glDrawElements(GLenum /*mode*/, GLsizei count, GLenum type, const void* /*indices*/)
+{
+    headlessRecord(HeadlessCmd::DRAW_ELEMENTS, headlessGL.program, headlessGL.vao, count);
+    headlessValidateDraw("glDrawElements", true, (u64)count * glIndexTypeSize(type));
+    headlessGL.frame.drawCalls++;
+    headlessGL.frame.verticesDrawn += count;
+}
+
+void APIENTRY headless_glDrawElementsInstanced(GLenum /*mode*/, GLsizei count, GLenum type, const void* /*indices*/, GLsizei instancecount)
+{
+    headlessRecord(HeadlessCmd::DRAW_ELEMENTS_INSTANCED, headlessGL.program, headlessGL.vao, instancecount);
+    headlessValidateDraw("glDrawElementsInstanced", true, (u64)count * glIndexTypeSize(type));
+    headlessGL.frame.drawCalls++;
+    headlessGL.frame.instancedDrawCalls++;
+    headlessGL.frame.instancesDrawn += instancecount;
+    headlessGL.frame.verticesDrawn += (u64)count * instancecount;
+}
+
+// Queries
+const char* headlessExtensions[] = {
+    "GL_KHR_parallel_shader_compile",
+};
+
+const GLubyte* APIENTRY headless_glGetStringi(GLenum name, GLuint index) 
+{
+    headlessGL.frame.calls++;
+    if (name != GL_EXTENSIONS || index >= sizeof(headlessExtensions) / sizeof(headlessExtensions[0])) {
+        headlessError("glGetStringi", "Invalid name or index", index);
+        return nullptr;
+    }
+    return (const GLubyte*)headlessExtensions[index];
+}
+
+const GLubyte* APIENTRY headless_glGetString(GLenum name)
+{
+    headlessGL.frame.calls++;
+    switch (name)
+    {
+    case GL_VENDOR: return (const GLubyte*)"upp";
+    case GL_RENDERER: return (const GLubyte*)"HeadlessGL";
+    case GL_VERSION: return (const GLubyte*)"4.5 headless";
+    case GL_SHADING_LANGUAGE_VERSION: return (const GLubyte*)"4.50";
+    }
+    headlessError("glGetString", "Unknown name", name);
+    return nullptr;
+}
+
+void APIENTRY headless_glGetIntegerv(GLenum pname, GLint* data)
+{
+    headlessGL.frame.calls++;
+    switch (pname)
+    {
+    case GL_NUM_EXTENSIONS: *data = (GLint)(sizeof(headlessExtensions) / sizeof(headlessExtensions[0])); break;
+    case GL_NUM_PROGRAM_BINARY_FORMATS: *data = 1; break;
+    case GL_PROGRAM_BINARY_FORMATS: *data = HEADLESS_PROGRAM_BINARY_FORMAT; break;
+    case GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS: *data = HEADLESS_TEXTURE_UNITS; break;
+    case GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT: *data = HEADLESS_STORAGE_OFFSET_ALIGNMENT; break;
+    default: headlessError("glGetIntegerv", "Unknown pname", pname); *data = 0; break;
+    }
+}
+
+void APIENTRY headless_glProgramParameteri(GLuint program, GLenum /*pname*/, GLint /*value*/)
+{
+    headlessGL.frame.calls++;
+    if (headlessGetObject(program, HeadlessObject::PROGRAM) == nullptr) {
+        headlessError("glProgramParameteri", "Program does not exist", program);
+    }
+}
+
+void APIENTRY headless_glGetProgramBinary(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary)
+{
+    headlessGL.frame.calls++;
+    u64 size = headlessProgramBinarySize(program);
+    if (headlessGetObject(program, HeadlessObject::PROGRAM) == nullptr || (u64)bufSize < size) {
+        headlessError("glGetProgramBinary", "Program does not exist or buffer too small", program);
+        return;
+    }
+    HeadlessProgramBinaryHeader* header = (HeadlessProgramBinaryHeader*) binary;
+    header->magic = HEADLESS_PROGRAM_BINARY_MAGIC;
+    header->variableCount = 0;
+    HeadlessVariable* dst = (HeadlessVariable*)(header + 1);
+    for (HeadlessVariable& v : headlessGL.variables) {
+        if (v.owner == program) {
+            dst[header->variableCount++] = v;
+        }
+    }
+    if (length != nullptr) *length = (GLsizei)size;
+    *binaryFormat = HEADLESS_PROGRAM_BINARY_FORMAT;
+}
+
+// Like a driver, a binary that does not match only fails the link status
+void APIENTRY headless_glProgramBinary(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length)
+{
+    headlessGL.frame.calls++;
+    HeadlessObjectInfo* p = headlessGetObject(program, HeadlessObject::PROGRAM);
+    if (p == nullptr) {
+        headlessError("glProgramBinary", "Program does not exist", program);
+        return;
+    }
+    headlessRemoveVariables(program);
+    const HeadlessProgramBinaryHeader* header = (const HeadlessProgramBinaryHeader*) binary;
+    p->linkFailed = binaryFormat != HEADLESS_PROGRAM_BINARY_FORMAT ||
+        length < (GLsizei)sizeof(HeadlessProgramBinaryHeader) ||
+        header->magic != HEADLESS_PROGRAM_BINARY_MAGIC ||
+        (u64)length != sizeof(HeadlessProgramBinaryHeader) + header->variableCount * sizeof(HeadlessVariable);
+    if (p->linkFailed) {
+        return;
+    }
+    headlessGL.frame.programBinaryLoads++;
+    const HeadlessVariable* src = (const HeadlessVariable*)(header + 1);
+    for (u32 i = 0; i < header->variableCount; i++) {
+        HeadlessVariable v = src[i];
+        v.owner = program;
+        headlessGL.variables.push_back(v);
+    }
+}
+
+
+
+// -----------------
+// --- INTERFACE ---
+// -----------------
+// Sets all function pointers of openGLFunctions.hpp to the headless implementation
+void loadHeadlessGLFunctions(Allocator* alloc)
+{
+    headlessGL = HeadlessGL();
+    headlessGL.alloc = alloc;
+    headlessGL.objects.init(alloc, 256);
+    HeadlessObjectInfo nullObject = {};
+    headlessGL.objects.push_back(nullObject); // Name 0 is never used
+    headlessGL.variables.init(alloc, 256);
+    headlessGL.commands.init(alloc, 1024);
+    headlessGL.recordCommands = true;
+    headlessGL.cullFace = GL_BACK;
+    headlessGL.frontFace = GL_CCW;
+    headlessGL.depthFunc = GL_LESS;
+    headlessGL.depthMask = GL_TRUE;
+    headlessGL.blendFunc[0] = GL_ONE;
+    headlessGL.blendFunc[1] = GL_ZERO;
+
+    glDebugMessageCallback = &headless_glDebugMessageCallback;
+    glGenBuffers = &headless_glGenBuffers;
+    glBindBuffer = &headless_glBindBuffer;
+    glBufferData = &headless_glBufferData;
+    glVertexAttribPointer = &headless_glVertexAttribPointer;
+    glEnableVertexAttribArray = &headless_glEnableVertexAttribArray;
+    glCreateShader = &headless_glCreateShader;
+    glShaderSource = &headless_glShaderSource;
+    glCompileShader = &headless_glCompileShader;
+    glDeleteShader = &headless_glDeleteShader;
+    glCreateProgram = &headless_glCreateProgram;
+    glDeleteProgram = &headless_glDeleteProgram;
+    glAttachShader = &headless_glAttachShader;
+    glDetachShader = &headless_glDetachShader;
+    glLinkProgram = &headless_glLinkProgram;
+    glGetShaderiv = &headless_glGetShaderiv;
+    glGetShaderInfoLog = &headless_glGetShaderInfoLog;
+    glGetProgramiv = &headless_glGetProgramiv;
+    glGetProgramInfoLog = &headless_glGetProgramInfoLog;
+    glGenVertexArrays = &headless_glGenVertexArrays;
+    glBindVertexArray = &headless_glBindVertexArray;
+    glUseProgram = &headless_glUseProgram;
+    glGetActiveUniform = &headless_glGetActiveUniform;
+    glGetUniformLocation = &headless_glGetUniformLocation;
+    glUniform1f = &headless_glUniform1f;
+    glUniform2f = &headless_glUniform2f;
+    glUniform3f = &headless_glUniform3f;
+    glUniform4f = &headless_glUniform4f;
+    glUniform1i = &headless_glUniform1i;
+    glUniform2i = &headless_glUniform2i;
+    glUniform3i = &headless_glUniform3i;
+    glUniform4i = &headless_glUniform4i;
+    glUniform1ui = &headless_glUniform1ui;
+    glUniform2ui = &headless_glUniform2ui;
+    glUniform3ui = &headless_glUniform3ui;
+    glUniform4ui = &headless_glUniform4ui;
+    glUniform1fv = &headless_glUniform1fv;
+    glUniform2fv = &headless_glUniform2fv;
+    glUniform3fv = &headless_glUniform3fv;
+    glUniform4fv = &headless_glUniform4fv;
+    glUniform1iv = &headless_glUniform1iv;
+    glUniform2iv = &headless_glUniform2iv;
+    glUniform3iv = &headless_glUniform3iv;
+    glUniform4iv = &headless_glUniform4iv;
+    glUniform1uiv = &headless_glUniform1uiv;
+    glUniform2uiv = &headless_glUniform2uiv;
+    glUniform3uiv = &headless_glUniform3uiv;
+    glUniform4uiv = &headless_glUniform4uiv;
+    glUniformMatrix2fv = &headless_glUniformMatrix2fv;
+    glUniformMatrix3fv = &headless_glUniformMatrix3fv;
+    glUniformMatrix4fv = &headless_glUniformMatrix4fv;
+    glUniformMatrix2x3fv = &headless_glUniformMatrix2x3fv;
+    glUniformMatrix3x2fv = &headless_glUniformMatrix3x2fv;
+    glUniformMatrix2x4fv = &headless_glUniformMatrix2x4fv;
+    glUniformMatrix4x2fv = &headless_glUniformMatrix4x2fv;
+    glUniformMatrix3x4fv = &headless_glUniformMatrix3x4fv;
+    glUniformMatrix4x3fv = &headless_glUniformMatrix4x3fv;
+    glGetStringi = &headless_glGetStringi;
+    glDeleteBuffers = &headless_glDeleteBuffers;
+    glDeleteVertexArrays = &headless_glDeleteVertexArrays;
+    glGetActiveAttrib = &headless_glGetActiveAttrib;
+    glGetAttribLocation = &headless_glGetAttribLocation;
+    glGenerateMipmap = &headless_glGenerateMipmap;
+    glActiveTexture = &headless_glActiveTexture;
+    glGenFramebuffers = &headless_glGenFramebuffers;
+    glBindFramebuffer = &headless_glBindFramebuffer;
+    glDeleteFramebuffers = &headless_glDeleteFramebuffers;
+    glCheckFramebufferStatus = &headless_glCheckFramebufferStatus;
+    glFramebufferTexture2D = &headless_glFramebufferTexture2D;
+    glFramebufferRenderbuffer = &headless_glFramebufferRenderbuffer;
+    glGenRenderbuffers = &headless_glGenRenderbuffers;
+    glDeleteRenderbuffers = &headless_glDeleteRenderbuffers;
+    glBindRenderbuffer = &headless_glBindRenderbuffer;
+    glRenderbufferStorage = &headless_glRenderbufferStorage;
+    glClear = &headless_glClear;
+    glClearColor = &headless_glClearColor;
+    glEnable = &headless_glEnable;
+    glDisable = &headless_glDisable;
+    glCullFace = &headless_glCullFace;
+    glFrontFace = &headless_glFrontFace;
+    glDepthFunc = &headless_glDepthFunc;
+    glDepthMask = &headless_glDepthMask;
+    glBlendFunc = &headless_glBlendFunc;
+    glViewport = &headless_glViewport;
+    glDrawArrays = &headless_glDrawArrays;
+    glDrawElements = &headless_glDrawElements;
+    glGenTextures = &headless_glGenTextures;
+    glDeleteTextures = &headless_glDeleteTextures;
+    glBindTexture = &headless_glBindTexture;
+    glTexImage2D = &headless_glTexImage2D;
+    glTexSubImage2D = &headless_glTexSubImage2D;
+    glTexParameteri = &headless_glTexParameteri;
+    glPixelStorei = &headless_glPixelStorei;
+    glVertexAttribDivisor = &headless_glVertexAttribDivisor;
+    glDrawElementsInstanced = &headless_glDrawElementsInstanced;
+    glGetUniformBlockIndex = &headless_glGetUniformBlockIndex;
+    glUniformBlockBinding = &headless_glUniformBlockBinding;
+    glBindBufferBase = &headless_glBindBufferBase;
+    glBufferSubData = &headless_glBufferSubData;
+    glBufferStorage = &headless_glBufferStorage;
+    glMapBufferRange = &headless_glMapBufferRange;
+    glUnmapBuffer = &headless_glUnmapBuffer;
+    glFenceSync = &headless_glFenceSync;
+    glClientWaitSync = &headless_glClientWaitSync;
+    glDeleteSync = &headless_glDeleteSync;
+    glBindVertexBuffer = &headless_glBindVertexBuffer;
+    glVertexAttribFormat = &headless_glVertexAttribFormat;
+    glVertexAttribBinding = &headless_glVertexAttribBinding;
+    glVertexBindingDivisor = &headless_glVertexBindingDivisor;
+    glCompressedTexImage2D = &headless_glCompressedTexImage2D;
+    glCompressedTexSubImage2D = &headless_glCompressedTexSubImage2D;
+    glGetString = &headless_glGetString;
+    glGetIntegerv = &headless_glGetIntegerv;
+    glProgramParameteri = &headless_glProgramParameteri;
+    glGetProgramBinary = &headless_glGetProgramBinary;
+    glProgramBinary = &headless_glProgramBinary;
+    glBindBufferRange = &headless_glBindBufferRange;
+}
+
+void shutdownHeadlessGL()
+{
+    for (HeadlessObjectInfo& o : headlessGL.objects) {
+        if (o.storage.data != nullptr) {
+            headlessGL.alloc->dealloc(o.storage);
+        }
+    }
+    headlessGL.objects.shutdown();
+    headlessGL.variables.shutdown();
+    headlessGL.commands.shutdown();
+}
+
+#endif
@@ -0,0 +1,404 @@
+#ifndef __LIGHT_CLUSTERS_HPP__
+#define __LIGHT_CLUSTERS_HPP__
+
+// ----------------------
+// --- LIGHT CLUSTERS ---
+// ----------------------
+// Point and spot lights are assigned on the cpu to a grid of view space clusters
+// (LIGHT_CLUSTER_X * LIGHT_CLUSTER_Y screen tiles, LIGHT_CLUSTER_Z depth slices with exponential
+// spacing between the near and far plane), shaders only loop over the lights of their cluster.
+//
+// assignLights works on bounding spheres of the lights in view space:
+//  1. Frustum culling (cullSpheres)
+//  2. Each light goes into the depth slices its sphere covers
+//  3. Per slice the lights are tested against the bounds of each tile row,
+//     per row against each cluster (overlapSpheresAABB, 4 or 8 lights per test)
+// The result is laid out like the gpu buffer (ClusterBufferHeader followed by the light indices)
+// and does not touch gl, upload copies it into a range of a stream buffer and binds it to
+// LIGHT_CLUSTER_BINDING for ressources/shaders/common/clusteredLights.glsl.
+//
+// The cluster grid only depends on the projection, it is rebuilt when the projection changes.
+
+#define LIGHT_CLUSTER_X 16
+#define LIGHT_CLUSTER_Y 9
+#define LIGHT_CLUSTER_Z 24
+#define LIGHT_CLUSTER_COUNT (LIGHT_CLUSTER_X * LIGHT_CLUSTER_Y * LIGHT_CLUSTER_Z)
+#define MAX_CLUSTER_LIGHTS 1024
+#define LIGHT_CLUSTER_MAX_INDICES (1 << 17)
+#define LIGHT_CLUSTER_BINDING 1
+
+namespace LightType
+{
+    enum ENUM
+    {
+        POINT = 0,
+        SPOT,
+
+        COUNT // MUST STAY LAST
+    };
+};
+
+struct Light
+{
+    LightType::ENUM type;
+    vec3 pos;
+    vec3 color; // Premultiplied with the intensity
+    float range; // Falls off to zero at this distance
+    // Spot lights
+    vec3 dir;
+    float innerAngle; // Half angles in radians, full intensity inside the inner cone
+    float outerAngle;
+};
+
+Light pointLight(const vec3& pos, const vec3& color, float range)
+{
+    Light l;
+    l.type = LightType::POINT;
+    l.pos = pos;
+    l.color = color;
+    l.range = range;
+    l.dir = vec3(0, 0, -1);
+    l.innerAngle = PI;
+    l.outerAngle = PI;
+    return l;
+}
+
+Light spotLight(const vec3& pos, const vec3& dir, const vec3& color, float range, float innerAngle, float outerAngle)
+{
+    Light l;
+    l.type = LightType::SPOT;
+    l.pos = pos;
+    l.color = color;
+    l.range = range;
+    l.dir = normalize(dir);
+    l.innerAngle = innerAngle;
+    l.outerAngle = outerAngle;
+    return l;
+}
+
+// std430 layout, point lights have cosOuter -2 so the spot factor is always 1
+struct GPULight
+{
+    vec4 posRange;
+    vec4 colorCosInner;
+    vec4 dirCosOuter;
+};
+
+struct ClusterBufferHeader
+{
+    vec4 depthParams; // Slice = log(viewDepth) * x + y
+    u32 grid[4]; // Cluster counts x, y, z and the light count
+    GPULight lights[MAX_CLUSTER_LIGHTS];
+    u32 clusters[LIGHT_CLUSTER_COUNT][2]; // Offset and count in the index list (Follows the header)
+};
+static_assert(sizeof(ClusterBufferHeader) == 32 + 48 * MAX_CLUSTER_LIGHTS + 8 * LIGHT_CLUSTER_COUNT,
+        "ClusterBufferHeader must match std430 layout");
+
+struct LightClusterStats
+{
+    int lights;
+    int visibleLights;
+    int sliceEntries; // Lights summed over the slices they cover
+    int tests; // Sphere box tests
+    int indices;
+    int droppedLights; // Over MAX_CLUSTER_LIGHTS
+    int droppedIndices; // Over LIGHT_CLUSTER_MAX_INDICES
+    int maxClusterLights;
+};
+
+struct LightClusters
+{
+    // Grid in view space
+    mat4 projection;
+    float nearPlane;
+    float farPlane;
+    AABB* clusterBounds; // Index x + LIGHT_CLUSTER_X * (y + LIGHT_CLUSTER_Y * z)
+    AABB* rowBounds; // Union of the clusters of a row, index y + LIGHT_CLUSTER_Y * z
+    // Result of assignLights, laid out like the gpu buffer
+    Blk resultBlk;
+    ClusterBufferHeader* header;
+    u32* indices;
+    Allocator* alloc;
+    LightClusterStats stats; // Of the last assignLights
+};
+
+void print(LightClusterStats* s)
+{
+    loggf("LightClusters: %d lights (%d visible, %d dropped), %d slice entries, %d tests, %d indices (%d dropped), max %d per cluster\n",
+            s->lights, s->visibleLights, s->droppedLights, s->sliceEntries, s->tests,
+            s->indices, s->droppedIndices, s->maxClusterLights);
+}
+
+void init(LightClusters* c, Allocator* alloc)
+{
+    *c = LightClusters();
+    c->alloc = alloc;
+    c->resultBlk = alloc->alloc(sizeof(ClusterBufferHeader) + sizeof(u32) * LIGHT_CLUSTER_MAX_INDICES
+            + sizeof(AABB) * (LIGHT_CLUSTER_COUNT + LIGHT_CLUSTER_Y * LIGHT_CLUSTER_Z));
+    c->header = (ClusterBufferHeader*) c->resultBlk.data;
+    c->indices = (u32*) (c->header + 1);
+    c->clusterBounds = (AABB*) (c->indices + LIGHT_CLUSTER_MAX_INDICES);
+    c->rowBounds = c->clusterBounds + LIGHT_CLUSTER_COUNT;
+    new(c->header) ClusterBufferHeader();
+    c->header->grid[0] = LIGHT_CLUSTER_X;
+    c->header->grid[1] = LIGHT_CLUSTER_Y;
+    c->header->grid[2] = LIGHT_CLUSTER_Z;
+}
+
+void shutdown(LightClusters* c) {
+    c->alloc->dealloc(c->resultBlk);
+}
+
+void extend(AABB* b, const vec3& p)
+{
+    b->min = vec3(min(b->min.x, p.x), min(b->min.y, p.y), min(b->min.z, p.z));
+    b->max = vec3(max(b->max.x, p.x), max(b->max.y, p.y), max(b->max.z, p.z));
+}
+
+void extend(AABB* b, const AABB& other) {
+    extend(b, other.min);
+    extend(b, other.max);
+}
+
+// View depth (Positive) of the start of a slice
+float getSliceDepth(LightClusters* c, int slice) {
+    return c->nearPlane * powf(c->farPlane / c->nearPlane, (float)slice / LIGHT_CLUSTER_Z);
+}
+
+int getSlice(LightClusters* c, float depth)
+{
+    if (depth <= c->nearPlane) {
+        return 0;
+    }
+    int slice = (int)(logf(depth) * c->header->depthParams.x + c->header->depthParams.y);
+    return clamp(slice, 0, LIGHT_CLUSTER_Z - 1);
+}
+
+// Perspective projection with OpenGL clip space (See projection() in matrices.hpp)
+void buildClusterGrid(LightClusters* c, const mat4& projection)
+{
+    c->projection = projection;
+    float p22 = projection.columns[2].z;
+    float p32 = projection.columns[3].z;
+    c->nearPlane = p32 / (p22 - 1.0f);
+    c->farPlane = p32 / (p22 + 1.0f);
+    float logRatio = logf(c->farPlane / c->nearPlane);
+    c->header->depthParams = vec4(LIGHT_CLUSTER_Z / logRatio, -LIGHT_CLUSTER_Z * logf(c->nearPlane) / logRatio, 0, 0);
+
+    // View rays through the tile corners, scaled to depth 1
+    mat4 invProjection = inverse(projection);
+    vec3 rays[LIGHT_CLUSTER_Y + 1][LIGHT_CLUSTER_X + 1];
+    for (int y = 0; y <= LIGHT_CLUSTER_Y; y++) {
+        for (int x = 0; x <= LIGHT_CLUSTER_X; x++) {
+            vec4 ndc = vec4(-1.0f + 2.0f * x / LIGHT_CLUSTER_X, -1.0f + 2.0f * y / LIGHT_CLUSTER_Y, -1.0f, 1.0f);
+            vec4 p = invProjection * ndc;
+            rays[y][x] = vec3(p.x, p.y, p.z) / -p.z;
+        }
+    }
+
+    for (int z = 0; z < LIGHT_CLUSTER_Z; z++)
+    {
+        float depths[2] = {getSliceDepth(c, z), getSliceDepth(c, z + 1)};
+        for (int y = 0; y < LIGHT_CLUSTER_Y; y++)
+        {
+            AABB& row = c->rowBounds[y + LIGHT_CLUSTER_Y * z];
+            for (int x = 0; x < LIGHT_CLUSTER_X; x++)
+            {
+                AABB& b = c->clusterBounds[x + LIGHT_CLUSTER_X * (y + LIGHT_CLUSTER_Y * z)];
+                b = AABB(rays[y][x] * depths[0], rays[y][x] * depths[0]);
+                for (int d = 0; d < 2; d++) {
+                    extend(&b, rays[y][x] * depths[d]);
+                    extend(&b, rays[y][x + 1] * depths[d]);
+                    extend(&b, rays[y + 1][x] * depths[d]);
+                    extend(&b, rays[y + 1][x + 1] * depths[d]);
+                }
+                if (x == 0) {
+                    row = b;
+                }
+                extend(&row, b);
+            }
+        }
+    }
+}
+
+// Bounding sphere of the lit volume in view space. Spot cones use the smallest sphere
+// around the cone, for wide cones that is the sphere around the cap
+BoundingSphere getLightBounds(const Light& l, const mat4& view)
+{
+    if (l.type == LightType::POINT || l.outerAngle >= PI / 2) {
+        return BoundingSphere(view * l.pos, l.range);
+    }
+    float cosAngle = cosf(l.outerAngle);
+    if (l.outerAngle <= PI / 4) {
+        float radius = l.range / (2.0f * cosAngle);
+        return BoundingSphere(view * (l.pos + l.dir * radius), radius);
+    }
+    return BoundingSphere(view * (l.pos + l.dir * (l.range * cosAngle)), l.range * sinf(l.outerAngle));
+}
+
+GPULight toGPULight(const Light& l)
+{
+    GPULight g;
+    g.posRange = vec4(l.pos, l.range);
+    bool spot = l.type == LightType::SPOT;
+    g.colorCosInner = vec4(l.color, spot ? cosf(l.innerAngle) : -1.0f);
+    g.dirCosOuter = vec4(l.dir, spot ? cosf(l.outerAngle) : -2.0f);
+    return g;
+}
+
+// Sphere arrays of the candidate lights, SoA for the batch tests
+struct LightCandidates
+{
+    float* x;
+    float* y;
+    float* z;
+    float* r;
+    u32* light;
+};
+
+void allocate(LightCandidates* c, int count)
+{
+    c->x = (float*) tmpAlloc.alloc(sizeof(float) * count);
+    c->y = (float*) tmpAlloc.alloc(sizeof(float) * count);
+    c->z = (float*) tmpAlloc.alloc(sizeof(float) * count);
+    c->r = (float*) tmpAlloc.alloc(sizeof(float) * count);
+    c->light = (u32*) tmpAlloc.alloc(sizeof(u32) * count);
+}
+
+void copyCandidate(LightCandidates* dst, int dstIndex, LightCandidates* src, int srcIndex)
+{
+    dst->x[dstIndex] = src->x[srcIndex];
+    dst->y[dstIndex] = src->y[srcIndex];
+    dst->z[dstIndex] = src->z[srcIndex];
+    dst->r[dstIndex] = src->r[srcIndex];
+    dst->light[dstIndex] = src->light[srcIndex];
+}
+
+// Cpu only, fills header and indices. Lights over MAX_CLUSTER_LIGHTS are dropped
+void assignLights(LightClusters* c, const mat4& view, const mat4& projection, int lightCount, Light* lights)
+{
+    LightClusterStats& s = c->stats;
+    memset(&s, 0, sizeof(LightClusterStats));
+    if (memcmp(&c->projection, &projection, sizeof(mat4)) != 0) {
+        buildClusterGrid(c, projection);
+    }
+    s.lights = lightCount;
+    s.droppedLights = max(lightCount - MAX_CLUSTER_LIGHTS, 0);
+    lightCount -= s.droppedLights;
+    c->header->grid[3] = lightCount;
+    memset(c->header->clusters, 0, sizeof(c->header->clusters));
+
+    // View space spheres
+    SCOPE_EXIT_ROLLBACK;
+    LightCandidates all;
+    allocate(&all, lightCount);
+    for (int i = 0; i < lightCount; i++)
+    {
+        c->header->lights[i] = toGPULight(lights[i]);
+        BoundingSphere b = getLightBounds(lights[i], view);
+        all.x[i] = b.center.x;
+        all.y[i] = b.center.y;
+        all.z[i] = b.center.z;
+        all.r[i] = b.radius;
+        all.light[i] = i;
+    }
+    int* visible = (int*) tmpAlloc.alloc(sizeof(int) * lightCount);
+    int visibleCount = cullSpheres(extractFrustum(projection), lightCount, all.x, all.y, all.z, all.r, visible);
+    s.visibleLights = visibleCount;
+
+    // Bucket the lights into the slices they cover (Counting sort, keeps the light order)
+    int sliceStart[LIGHT_CLUSTER_Z + 1];
+    memset(sliceStart, 0, sizeof(sliceStart));
+    int* sliceRange = (int*) tmpAlloc.alloc(sizeof(int) * 2 * visibleCount);
+    for (int i = 0; i < visibleCount; i++)
+    {
+        // Slightly widened, the cluster test decides and must not miss a slice to rounding
+        int l = visible[i];
+        float depth = -all.z[l];
+        sliceRange[i * 2] = getSlice(c, (depth - all.r[l]) * 0.999f);
+        sliceRange[i * 2 + 1] = getSlice(c, (depth + all.r[l]) * 1.001f);
+        for (int z = sliceRange[i * 2]; z <= sliceRange[i * 2 + 1]; z++) {
+            sliceStart[z + 1]++;
+        }
+    }
+    for (int z = 0; z < LIGHT_CLUSTER_Z; z++) {
+        sliceStart[z + 1] += sliceStart[z];
+    }
+    s.sliceEntries = sliceStart[LIGHT_CLUSTER_Z];
+    int sliceHead[LIGHT_CLUSTER_Z];
+    memcpy(sliceHead, sliceStart, sizeof(sliceHead));
+    LightCandidates slices;
+    allocate(&slices, s.sliceEntries);
+    for (int i = 0; i < visibleCount; i++) {
+        for (int z = sliceRange[i * 2]; z <= sliceRange[i * 2 + 1]; z++) {
+            copyCandidate(&slices, sliceHead[z]++, &all, visible[i]);
+        }
+    }
+
+    // Slice -> row -> cluster
+    int maxSliceCount = 0;
+    for (int z = 0; z < LIGHT_CLUSTER_Z; z++) {
+        maxSliceCount = max(maxSliceCount, sliceStart[z + 1] - sliceStart[z]);
+    }
+    LightCandidates row;
+    allocate(&row, maxSliceCount);
+    int* hits = (int*) tmpAlloc.alloc(sizeof(int) * max(maxSliceCount, 1));
+    int indexCount = 0;
+    for (int z = 0; z < LIGHT_CLUSTER_Z; z++)
+    {
+        int sliceCount = sliceStart[z + 1] - sliceStart[z];
+        if (sliceCount == 0) {
+            continue;
+        }
+        int o = sliceStart[z];
+        for (int y = 0; y < LIGHT_CLUSTER_Y; y++)
+        {
+            int rowCount = overlapSpheresAABB(c->rowBounds[y + LIGHT_CLUSTER_Y * z], sliceCount,
+                    slices.x + o, slices.y + o, slices.z + o, slices.r + o, hits);
+            s.tests += sliceCount;
+            for (int i = 0; i < rowCount; i++) {
+                copyCandidate(&row, i, &slices, o + hits[i]);
+            }
+            if (rowCount == 0) {
+                continue;
+            }
+
+            for (int x = 0; x < LIGHT_CLUSTER_X; x++)
+            {
+                int cluster = x + LIGHT_CLUSTER_X * (y + LIGHT_CLUSTER_Y * z);
+                int count = overlapSpheresAABB(c->clusterBounds[cluster], rowCount,
+                        row.x, row.y, row.z, row.r, hits);
+                s.tests += rowCount;
+                if (indexCount + count > LIGHT_CLUSTER_MAX_INDICES) {
+                    s.droppedIndices += indexCount + count - LIGHT_CLUSTER_MAX_INDICES;
+                    count = LIGHT_CLUSTER_MAX_INDICES - indexCount;
+                }
+                c->header->clusters[cluster][0] = indexCount;
+                c->header->clusters[cluster][1] = count;
+                for (int i = 0; i < count; i++) {
+                    c->indices[indexCount++] = row.light[hits[i]];
+                }
+                s.maxClusterLights = max(s.maxClusterLights, count);
+            }
+        }
+    }
+    s.indices = indexCount;
+}
+
+int getUploadSize(LightClusters* c) {
+    return (int)(sizeof(ClusterBufferHeader) + sizeof(u32) * max(c->stats.indices, 1));
+}
+
+// Copies the result of assignLights into the stream buffer and binds the range
+void upload(LightClusters* c, StreamBuffer* stream)
+{
+    int size = getUploadSize(c);
+    StreamRange range = allocate(stream, size, renderState.storageBufferAlignment);
+    memcpy(range.data, c->header, size);
+    commit(stream, range);
+    bindStorageBufferRange(LIGHT_CLUSTER_BINDING, range.buffer, range.offset, range.size);
+}
+
+
+
+#endif
@@ -60,6 +60,41 @@ const MeshAttribInfo meshAttribInfoTable[] =
     MeshAttribInfo(sizeof(vec4), GL_FLOAT, 4, 5),    
 };
 
+// Per instance attributes, streamed into the instance buffer of a vao for instanced draws
+namespace InstanceAttrib
+{
+    enum ENUM
+    {
+        MODEL_MATRIX = 0,
+        NORMAL_MATRIX = 1,
+
+        // This must always stay last
+        COUNT
+    };
+};
+
+const char* toStr(InstanceAttrib::ENUM attrib)
+{
+    using namespace InstanceAttrib;
+    switch(attrib)
+    {
+        case MODEL_MATRIX:
+            return "MODEL_MATRIX";
+        case NORMAL_MATRIX:
+            return "NORMAL_MATRIX";
+        default:
+            break;
+    }
+    return "INVALID_INSTANCE_ATTRIB";
+}
+
+// Matrices take one attrib location per column, count is the number of columns and rows
+const MeshAttribInfo instanceAttribInfoTable[] = 
+{
+    MeshAttribInfo(sizeof(mat4), GL_FLOAT, 4, 0),
+    MeshAttribInfo(sizeof(mat3), GL_FLOAT, 3, 1),
+};
+
 
 
 // MESH DATA
@@ -79,6 +114,7 @@ struct MeshData
     DynArr<AttribBlk> attribBlks;
     Blk indexData;
     Allocator* alloc;
+    bool ownsData; // False if the blks point into foreign memory (E.g. a mapped mesh file)
 };
 
 void init(MeshData* m, Allocator* alloc) 
@@ -86,17 +122,20 @@ void init(MeshData* m, Allocator* alloc)
     memset(m, 0, sizeof(MeshData));
     m->alloc = alloc;
     m->attribBlks.init(alloc, 8);
+    m->ownsData = true;
 }
 
 void shutdown (MeshData* m) 
 {
     // Dealloc all attribs
-    for (AttribBlk& b : m->attribBlks) {
-        m->alloc->dealloc(b.blk);
+    if (m->ownsData) {
+        for (AttribBlk& b : m->attribBlks) {
+            m->alloc->dealloc(b.blk);
+        }
     }
     m->attribBlks.shutdown();
     // Dealloc indices
-    if (m->indexData.data != nullptr) {
+    if (m->ownsData && m->indexData.data != nullptr) {
         m->alloc->dealloc(m->indexData);
     }
 }
@@ -112,7 +151,7 @@ int findAttribIndex(MeshData* m, MeshAttrib::ENUM attrib)
     return -1;
 }
 
-void setAttribs(MeshData* m, int count, void* data, std::initializer_list<MeshAttrib::ENUM> attribs)
+void setAttribs(MeshData* m, int count, const void* data, std::initializer_list<MeshAttrib::ENUM> attribs)
 {
     // Calculate stride
     u32 stride = 0;
@@ -136,7 +175,7 @@ void setAttribs(MeshData* m, int count, void* data, std::initializer_list<MeshAt
 
         // Copy data into new buffers vertex by vertex
         byte* to = (byte*) a.blk.data;
-        byte* from = (byte*) data;
+        const byte* from = (const byte*) data;
         for (int i = 0; i < count; i++) {
             memcpy(&(to[i*size]), &(from[i*stride + offset]), size);
         }
@@ -157,7 +196,7 @@ void setAttribs(MeshData* m, int count, void* data, std::initializer_list<MeshAt
     }
 }
 
-void setIndices(MeshData* m, int count, void* data)
+void setIndices(MeshData* m, int count, const void* data)
 {
     assert(m->indexCount == 0, "Indices were already set for this mesth\n!");
     m->indexCount = count;
@@ -165,15 +204,70 @@ void setIndices(MeshData* m, int count, void* data)
     memcpy(m->indexData.data, data, sizeof(u32) * count);
 }
 
+// Bounds of the position attribute (POS3, or POS2 with z = 0)
+AABB computeAABB(MeshData* m)
+{
+    int posIndex = findAttribIndex(m, MeshAttrib::POS3);
+    bool is2D = false;
+    if (posIndex == -1) {
+        posIndex = findAttribIndex(m, MeshAttrib::POS2);
+        is2D = true;
+    }
+    assert(posIndex != -1, "computeAABB called on mesh without positions\n");
+    if (m->vertexCount == 0) {
+        return AABB(vec3(0.0f), vec3(0.0f));
+    }
+
+    float* data = (float*) m->attribBlks[posIndex].blk.data;
+    int stride = is2D ? 2 : 3;
+    vec3 minPos = vec3(data[0], data[1], is2D ? 0.0f : data[2]);
+    vec3 maxPos = minPos;
+    for (int i = 1; i < m->vertexCount; i++)
+    {
+        float* p = &data[i * stride];
+        vec3 pos = vec3(p[0], p[1], is2D ? 0.0f : p[2]);
+        minPos = vec3(min(minPos.x, pos.x), min(minPos.y, pos.y), min(minPos.z, pos.z));
+        maxPos = vec3(max(maxPos.x, pos.x), max(maxPos.y, pos.y), max(maxPos.z, pos.z));
+    }
+    return AABB(minPos, maxPos);
+}
+
+// Sphere around the aabb center, not minimal but cheap and good enough for culling
+BoundingSphere computeBoundingSphere(MeshData* m)
+{
+    AABB box = computeAABB(m);
+    vec3 center = getCenter(box);
+
+    int posIndex = findAttribIndex(m, MeshAttrib::POS3);
+    bool is2D = false;
+    if (posIndex == -1) {
+        posIndex = findAttribIndex(m, MeshAttrib::POS2);
+        is2D = true;
+    }
+    float* data = (float*) m->attribBlks[posIndex].blk.data;
+    int stride = is2D ? 2 : 3;
+    float maxDistSq = 0.0f;
+    for (int i = 0; i < m->vertexCount; i++)
+    {
+        float* p = &data[i * stride];
+        vec3 pos = vec3(p[0], p[1], is2D ? 0.0f : p[2]);
+        maxDistSq = max(maxDistSq, distSq(pos, center));
+    }
+    return BoundingSphere(center, sqrtf(maxDistSq));
+}
+
 
 
 
 // MESH GPU BUFFER
+// Interleaved meshes share one vbo for all attribs, each attrib has an offset into the vertex
 struct AttribGPUBuffer
 {
     MeshAttrib::ENUM attrib;
     GLuint vbo;
     int vertexCount;
+    int offset;
+    int stride;
 };
 
 void init(AttribGPUBuffer* a, MeshAttrib::ENUM attrib, 
@@ -182,6 +276,8 @@ void init(AttribGPUBuffer* a, MeshAttrib::ENUM attrib,
     // Set members
     a->attrib = attrib;
     a->vertexCount = vertexCount;
+    a->offset = 0;
+    a->stride = meshAttribInfoTable[attrib].size;
     
     // Gen buffer
     glGenBuffers(1, &a->vbo);
@@ -189,28 +285,31 @@ void init(AttribGPUBuffer* a, MeshAttrib::ENUM attrib,
 
     // Init GPU memory
     MeshAttribInfo info = meshAttribInfoTable[attrib];
-    glBindBuffer(GL_ARRAY_BUFFER, a->vbo);
+    bindBuffer(GL_ARRAY_BUFFER, a->vbo);
     glBufferData(GL_ARRAY_BUFFER, info.size * vertexCount, 
             data, GL_STATIC_DRAW);
     
     // Unbind to make sure nothing messes with our data
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    bindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 void shutdown(AttribGPUBuffer* a) {
-    glDeleteBuffers(1, &a->vbo);
+    deleteBuffer(&a->vbo);
 }
 
 struct IndexGPUBuffer
 {
     GLuint ebo;
     int indexCount;
+    GLenum indexType; // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
 };
 
-void init(IndexGPUBuffer* i, void* data, int indexCount)
+// Indices are stored as u16 if all vertices can be adressed with 16 bits
+void init(IndexGPUBuffer* i, u32* data, int indexCount, int vertexCount)
 {
     // Init members
     i->indexCount = indexCount;
+    i->indexType = vertexCount < 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
 
     // Generate buffer
     glGenBuffers(1, &i->ebo);
@@ -219,47 +318,116 @@ void init(IndexGPUBuffer* i, void* data, int indexCount)
     // Copy data to buffer
     bindVao(0); // So that binding the element buffer does not screw stuff up
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, i->ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(u32) * indexCount, 
-            data, GL_STATIC_DRAW);
+    if (i->indexType == GL_UNSIGNED_SHORT) 
+    {
+        SCOPE_EXIT_ROLLBACK;
+        u16* shortIndices = (u16*) tmpAlloc.alloc(sizeof(u16) * indexCount);
+        for (int j = 0; j < indexCount; j++) {
+            shortIndices[j] = (u16) data[j];
+        }
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(u16) * indexCount, 
+                shortIndices, GL_STATIC_DRAW);
+    }
+    else {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(u32) * indexCount, 
+                data, GL_STATIC_DRAW);
+    }
     
     // Unbind to make sure nothing messes with our data
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 void shutdown(IndexGPUBuffer* i) {
-    glDeleteBuffers(1, &i->ebo);
+    deleteBuffer(&i->ebo);
 }
 
 struct MeshGPUBuffer
 {
     DynArr<AttribGPUBuffer> attribBuffers;
     IndexGPUBuffer indexBuffer;
+    bool interleaved; // All attribBuffers use the same vbo
 };
 
-void init(MeshGPUBuffer* g, MeshData* meshData, Allocator* alloc)
+// Interleaves the attribs of meshData into a single vbo, stride is the sum of the attrib sizes
+void initInterleaved(MeshGPUBuffer* g, MeshData* meshData, Allocator* alloc)
+{
+    int stride = 0;
+    for (AttribBlk& attribBlk : meshData->attribBlks) {
+        stride += meshAttribInfoTable[attribBlk.attrib].size;
+    }
+
+    GLuint vbo;
+    glGenBuffers(1, &vbo);
+    assert(vbo != 0, "glGenBuffers failed!\n");
+
+    // Interleave vertex by vertex
+    int vertexCount = meshData->vertexCount;
+    Blk interleavedBlk = alloc->alloc(stride * vertexCount);
+    SCOPE_EXIT(alloc->dealloc(interleavedBlk));
+    byte* to = (byte*) interleavedBlk.data;
+    int offset = 0;
+    for (AttribBlk& attribBlk : meshData->attribBlks) 
+    {
+        int size = meshAttribInfoTable[attribBlk.attrib].size;
+        const byte* from = (const byte*) attribBlk.blk.data;
+        for (int i = 0; i < vertexCount; i++) {
+            memcpy(&to[i*stride + offset], &from[i*size], size);
+        }
+
+        AttribGPUBuffer buffer;
+        buffer.attrib = attribBlk.attrib;
+        buffer.vbo = vbo;
+        buffer.vertexCount = vertexCount;
+        buffer.offset = offset;
+        buffer.stride = stride;
+        g->attribBuffers.push_back(buffer);
+        offset += size;
+    }
+
+    bindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, stride * vertexCount, interleavedBlk.data, GL_STATIC_DRAW);
+    bindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Interleaved uses one vbo for all attribs, otherwise each attrib gets its own vbo
+// (E.g. if single attribs are updated later)
+void init(MeshGPUBuffer* g, MeshData* meshData, Allocator* alloc, bool interleaved = true)
 {
     // Safety initializsations
     memset(g, 0, sizeof(MeshGPUBuffer));
 
     // Init members
     g->attribBuffers.init(alloc, 4);
+    g->interleaved = interleaved && meshData->attribBlks.size() > 0;
 
     // Create vbos
-    for (AttribBlk& attribBlk : meshData->attribBlks) 
+    if (g->interleaved) {
+        initInterleaved(g, meshData, alloc);
+    }
+    else 
     {
-        AttribGPUBuffer buffer;
-        init(&buffer, attribBlk.attrib, attribBlk.blk.data, meshData->vertexCount);
-        g->attribBuffers.push_back(buffer);
+        for (AttribBlk& attribBlk : meshData->attribBlks) 
+        {
+            AttribGPUBuffer buffer;
+            init(&buffer, attribBlk.attrib, attribBlk.blk.data, meshData->vertexCount);
+            g->attribBuffers.push_back(buffer);
+        }
     }
 
     // Create ebo
-    init(&g->indexBuffer, meshData->indexData.data, meshData->indexCount);
+    init(&g->indexBuffer, (u32*) meshData->indexData.data, meshData->indexCount, meshData->vertexCount);
 }
 
 void shutdown(MeshGPUBuffer* g) 
 {
-    for (AttribGPUBuffer& attribBuffer : g->attribBuffers) {
-        shutdown(&attribBuffer);
+    if (g->interleaved) {
+        shutdown(&g->attribBuffers[0]); // Shared vbo
+    }
+    else 
+    {
+        for (AttribGPUBuffer& attribBuffer : g->attribBuffers) {
+            shutdown(&attribBuffer);
+        }
     }
     g->attribBuffers.shutdown();
     shutdown(&g->indexBuffer);
@@ -289,12 +457,38 @@ struct AttribLocation
     GLuint location;
 };
 
+struct InstanceAttribLocation
+{
+    InstanceAttribLocation() {}
+    InstanceAttribLocation(InstanceAttrib::ENUM attrib, GLuint location)
+        :attrib(attrib), location(location) {};
+    InstanceAttrib::ENUM attrib;
+    GLuint location;
+};
+
+// Size of one instance in the instance buffer, attribs are interleaved in the given order
+int getInstanceStride(int instanceAttribCount, InstanceAttribLocation* instanceAttribs)
+{
+    int stride = 0;
+    for (int i = 0; i < instanceAttribCount; i++) {
+        stride += instanceAttribInfoTable[instanceAttribs[i].attrib].size;
+    }
+    return stride;
+}
+
 struct MeshVao
 {
     GLuint vao;
     DynArr<AttribLocation> attribLocs; // Always sorted
+    // Instancing, instance attribs read from the buffer bound to INSTANCE_BUFFER_BINDING
+    int instanceStride; // 0 if vao has no instance attribs
+    DynArr<InstanceAttribLocation> instanceAttribLocs;
 };
 
+// Vertex buffer binding of the instance data, high so it does not collide with the
+// bindings of glVertexAttribPointer (Which uses the attrib location as binding)
+#define INSTANCE_BUFFER_BINDING 15
+
 
 
 void init(MeshVao* m, MeshGPUBuffer* buffer, 
@@ -303,6 +497,8 @@ void init(MeshVao* m, MeshGPUBuffer* buffer,
     // Init members
     m->vao = 0;
     m->attribLocs.init(alloc, 4);
+    m->instanceStride = 0;
+    m->instanceAttribLocs.init(alloc, 2);
 
     // Create vao
     glGenVertexArrays(1, &m->vao);
@@ -317,12 +513,12 @@ void init(MeshVao* m, MeshGPUBuffer* buffer,
         assert(index != -1, "Init meshVao called with attrib not in buffer\n");
 
         // Bind vbo
-        GLint vbo = buffer->attribBuffers[index].vbo;
+        AttribGPUBuffer& attribBuffer = buffer->attribBuffers[index];
         const MeshAttribInfo& info = meshAttribInfoTable[attribLoc.attrib];
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        bindBuffer(GL_ARRAY_BUFFER, attribBuffer.vbo);
         // Set Attrib pointer
         glVertexAttribPointer(attribLoc.location, info.count, 
-                info.type, GL_FALSE, info.size, 0);
+                info.type, GL_FALSE, attribBuffer.stride, (void*)(u64)attribBuffer.offset);
         glEnableVertexAttribArray(attribLoc.location);
 
         m->attribLocs.push_back(attribLoc);
@@ -358,18 +554,58 @@ void init(MeshVao* m, MeshGPUBuffer* buffer,
 }
 
 
+// Sets up the per instance attrib formats (divisor 1), the buffer is bound per draw
+void initInstanceAttribs(MeshVao* m, int instanceAttribCount, InstanceAttribLocation* instanceAttribs)
+{
+    assert(m->instanceStride == 0, "Instance attribs of vao were already initialized\n");
+    m->instanceStride = getInstanceStride(instanceAttribCount, instanceAttribs);
+
+    bindVao(m->vao);
+    int offset = 0;
+    for (int i = 0; i < instanceAttribCount; i++)
+    {
+        InstanceAttribLocation loc = instanceAttribs[i];
+        const MeshAttribInfo& info = instanceAttribInfoTable[loc.attrib];
+        int columnSize = info.size / info.count;
+        for (int c = 0; c < info.count; c++) {
+            glVertexAttribFormat(loc.location + c, info.count, info.type, GL_FALSE, offset + c * columnSize);
+            glVertexAttribBinding(loc.location + c, INSTANCE_BUFFER_BINDING);
+            glEnableVertexAttribArray(loc.location + c);
+        }
+        offset += info.size;
+        m->instanceAttribLocs.push_back(loc);
+    }
+    glVertexBindingDivisor(INSTANCE_BUFFER_BINDING, 1);
+    bindVao(0);
+}
+
 void shutdown(MeshVao* mesh) {
-    glDeleteVertexArrays(1, &mesh->vao);
+    deleteVao(&mesh->vao);
     mesh->attribLocs.shutdown();
+    mesh->instanceAttribLocs.shutdown();
 }
 
 void bind(MeshVao* m) {
     bindVao(m->vao);
 }
 
-void draw(MeshVao* v, int indexCount) {
+void draw(MeshVao* v, int indexCount, GLenum indexType) {
     bind(v);
-    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (void*)0);
+    glDrawElements(GL_TRIANGLES, indexCount, indexType, (void*)0);
+}
+
+// Instance data at instanceOffset of instanceBuffer must be laid out like the instance attribs of the vao
+void drawInstanced(GLuint vao, int indexCount, GLenum indexType, int instanceCount, 
+        GLuint instanceBuffer, int instanceOffset, int instanceStride)
+{
+    bindVao(vao);
+    glBindVertexBuffer(INSTANCE_BUFFER_BINDING, instanceBuffer, instanceOffset, instanceStride);
+    glDrawElementsInstanced(GL_TRIANGLES, indexCount, indexType, (void*)0, instanceCount);
+}
+
+void drawInstanced(MeshVao* v, IndexGPUBuffer* indices, int instanceCount, GLuint instanceBuffer, int instanceOffset) {
+    drawInstanced(v->vao, indices->indexCount, indices->indexType, instanceCount, 
+            instanceBuffer, instanceOffset, v->instanceStride);
 }
 
 
@@ -397,7 +633,7 @@ void bind(Mesh* m) {
 }
 
 void draw(Mesh* m) {
-    draw(&m->meshVao, m->buffer.indexBuffer.indexCount);
+    draw(&m->meshVao, m->buffer.indexBuffer.indexCount, m->buffer.indexBuffer.indexType);
 }
 
 
@@ -1,6 +1,76 @@
 #ifndef __OPENGL_FUNCTIONS_HPP__
 #define __OPENGL_FUNCTIONS_HPP__
 // FUNCTION POINTERS
+// All functions the game uses are pointers that are handed over by the platform,
+// so the platform can swap the whole table (E.g. headlessGL.hpp for tests without a gpu).
+// Must be included after GL/gl.h and GL/glext.h
+
+// GL 1.1 functions
+// opengl32.dll exports these directly, the macros redirect them to pointers with an upp_ prefix
+#ifndef __gl_glcorearb_h_
+typedef void (APIENTRYP PFNGLCLEARPROC) (GLbitfield mask);
+typedef void (APIENTRYP PFNGLCLEARCOLORPROC) (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+typedef void (APIENTRYP PFNGLENABLEPROC) (GLenum cap);
+typedef void (APIENTRYP PFNGLDISABLEPROC) (GLenum cap);
+typedef void (APIENTRYP PFNGLCULLFACEPROC) (GLenum mode);
+typedef void (APIENTRYP PFNGLFRONTFACEPROC) (GLenum mode);
+typedef void (APIENTRYP PFNGLDEPTHFUNCPROC) (GLenum func);
+typedef void (APIENTRYP PFNGLDEPTHMASKPROC) (GLboolean flag);
+typedef void (APIENTRYP PFNGLBLENDFUNCPROC) (GLenum sfactor, GLenum dfactor);
+typedef void (APIENTRYP PFNGLVIEWPORTPROC) (GLint x, GLint y, GLsizei width, GLsizei height);
+typedef void (APIENTRYP PFNGLDRAWARRAYSPROC) (GLenum mode, GLint first, GLsizei count);
+typedef void (APIENTRYP PFNGLDRAWELEMENTSPROC) (GLenum mode, GLsizei count, GLenum type, const void *indices);
+typedef void (APIENTRYP PFNGLGENTEXTURESPROC) (GLsizei n, GLuint *textures);
+typedef void (APIENTRYP PFNGLDELETETEXTURESPROC) (GLsizei n, const GLuint *textures);
+typedef void (APIENTRYP PFNGLBINDTEXTUREPROC) (GLenum target, GLuint texture);
+typedef void (APIENTRYP PFNGLTEXIMAGE2DPROC) (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels);
+typedef void (APIENTRYP PFNGLTEXSUBIMAGE2DPROC) (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels);
+typedef void (APIENTRYP PFNGLTEXPARAMETERIPROC) (GLenum target, GLenum pname, GLint param);
+typedef void (APIENTRYP PFNGLPIXELSTOREIPROC) (GLenum pname, GLint param);
+typedef const GLubyte *(APIENTRYP PFNGLGETSTRINGPROC) (GLenum name);
+typedef void (APIENTRYP PFNGLGETINTEGERVPROC) (GLenum pname, GLint *data);
+#endif
+#define glClear upp_glClear
+#define glClearColor upp_glClearColor
+#define glEnable upp_glEnable
+#define glDisable upp_glDisable
+#define glCullFace upp_glCullFace
+#define glFrontFace upp_glFrontFace
+#define glDepthFunc upp_glDepthFunc
+#define glDepthMask upp_glDepthMask
+#define glBlendFunc upp_glBlendFunc
+#define glViewport upp_glViewport
+#define glDrawArrays upp_glDrawArrays
+#define glDrawElements upp_glDrawElements
+#define glGenTextures upp_glGenTextures
+#define glDeleteTextures upp_glDeleteTextures
+#define glBindTexture upp_glBindTexture
+#define glTexImage2D upp_glTexImage2D
+#define glTexSubImage2D upp_glTexSubImage2D
+#define glTexParameteri upp_glTexParameteri
+#define glPixelStorei upp_glPixelStorei
+#define glGetString upp_glGetString
+#define glGetIntegerv upp_glGetIntegerv
+PFNGLCLEARPROC glClear;
+PFNGLCLEARCOLORPROC glClearColor;
+PFNGLENABLEPROC glEnable;
+PFNGLDISABLEPROC glDisable;
+PFNGLCULLFACEPROC glCullFace;
+PFNGLFRONTFACEPROC glFrontFace;
+PFNGLDEPTHFUNCPROC glDepthFunc;
+PFNGLDEPTHMASKPROC glDepthMask;
+PFNGLBLENDFUNCPROC glBlendFunc;
+PFNGLVIEWPORTPROC glViewport;
+PFNGLDRAWARRAYSPROC glDrawArrays;
+PFNGLDRAWELEMENTSPROC glDrawElements;
+PFNGLGENTEXTURESPROC glGenTextures;
+PFNGLDELETETEXTURESPROC glDeleteTextures;
+PFNGLBINDTEXTUREPROC glBindTexture;
+PFNGLTEXIMAGE2DPROC glTexImage2D;
+PFNGLTEXSUBIMAGE2DPROC glTexSubImage2D;
+PFNGLTEXPARAMETERIPROC glTexParameteri;
+PFNGLPIXELSTOREIPROC glPixelStorei;
+
 // Debug functions
 PFNGLDEBUGMESSAGECALLBACKPROC glDebugMessageCallback;
 
@@ -13,9 +83,6 @@ PFNGLBUFFERDATAPROC glBufferData;
 PFNGLVERTEXATTRIBPOINTERPROC glVertexAttribPointer;
 PFNGLENABLEVERTEXATTRIBARRAYPROC glEnableVertexAttribArray;
 PFNGLUSEPROGRAMPROC glUseProgram;
-// Drawing 
-//PFNGLDRAWARRAYSPROC glDrawArrays;
-//PFNGLDRAWELEMENTSPROC glDrawElements;
 // Shader creation
 PFNGLCREATESHADERPROC glCreateShader;
 PFNGLSHADERSOURCEPROC glShaderSource;
@@ -26,7 +93,6 @@ PFNGLDELETEPROGRAMPROC glDeleteProgram;
 PFNGLATTACHSHADERPROC glAttachShader;
 PFNGLDETACHSHADERPROC glDetachShader;
 PFNGLLINKPROGRAMPROC glLinkProgram;
-//PFNGLVIEWPORTPROC glViewport;
 // Get infos
 PFNGLGETSHADERIVPROC glGetShaderiv;
 PFNGLGETSHADERINFOLOGPROC glGetShaderInfoLog;
@@ -91,6 +157,38 @@ PFNGLGENRENDERBUFFERSPROC glGenRenderbuffers;
 PFNGLDELETERENDERBUFFERSPROC glDeleteRenderbuffers;
 PFNGLBINDRENDERBUFFERPROC glBindRenderbuffer;
 PFNGLRENDERBUFFERSTORAGEPROC glRenderbufferStorage;
+// Instancing
+PFNGLVERTEXATTRIBDIVISORPROC glVertexAttribDivisor;
+PFNGLDRAWELEMENTSINSTANCEDPROC glDrawElementsInstanced;
+// Uniform buffers
+PFNGLGETUNIFORMBLOCKINDEXPROC glGetUniformBlockIndex;
+PFNGLUNIFORMBLOCKBINDINGPROC glUniformBlockBinding;
+PFNGLBINDBUFFERBASEPROC glBindBufferBase;
+PFNGLBUFFERSUBDATAPROC glBufferSubData;
+// Streaming buffers (glBufferStorage is optional, NULL below GL 4.4)
+PFNGLBUFFERSTORAGEPROC glBufferStorage;
+PFNGLMAPBUFFERRANGEPROC glMapBufferRange;
+PFNGLUNMAPBUFFERPROC glUnmapBuffer;
+PFNGLFENCESYNCPROC glFenceSync;
+PFNGLCLIENTWAITSYNCPROC glClientWaitSync;
+PFNGLDELETESYNCPROC glDeleteSync;
+// Vertex attrib bindings
+PFNGLBINDVERTEXBUFFERPROC glBindVertexBuffer;
+PFNGLVERTEXATTRIBFORMATPROC glVertexAttribFormat;
+PFNGLVERTEXATTRIBBINDINGPROC glVertexAttribBinding;
+PFNGLVERTEXBINDINGDIVISORPROC glVertexBindingDivisor;
+// Compressed textures
+PFNGLCOMPRESSEDTEXIMAGE2DPROC glCompressedTexImage2D;
+PFNGLCOMPRESSEDTEXSUBIMAGE2DPROC glCompressedTexSubImage2D;
+// Queries
+PFNGLGETSTRINGPROC glGetString;
+PFNGLGETINTEGERVPROC glGetIntegerv;
+// Program binaries
+PFNGLPROGRAMPARAMETERIPROC glProgramParameteri;
+PFNGLGETPROGRAMBINARYPROC glGetProgramBinary;
+PFNGLPROGRAMBINARYPROC glProgramBinary;
+// Shader storage buffers
+PFNGLBINDBUFFERRANGEPROC glBindBufferRange;
 
 
 #endif
@@ -0,0 +1,184 @@
+#ifndef __PROGRAM_CACHE_HPP__
+#define __PROGRAM_CACHE_HPP__
+
+// ----------------------------
+// --- PROGRAM BINARY CACHE ---
+// ----------------------------
+// Linked programs are stored with glGetProgramBinary in PROGRAM_CACHE_DIR, one file per program.
+// The key hashes the driver (Vendor, renderer, version) and every stage exactly as it is handed
+// to glShaderSource, so anything that ends up in the source (Includes, defines) is part of it.
+// beginProgramBuild (shaderprogram.hpp) tries the cache before compiling, so warm starts
+// and dll reloads do not compile anything. Binaries the driver rejects (Driver update, corrupt file)
+// fail the link status of glProgramBinary, then the program is compiled from source and the
+// entry is replaced.
+//
+// Layout: ProgramCacheHeader | binary
+
+#include "uppLib.hpp"
+#include "../utils/fileIO.hpp"
+
+#define PROGRAM_CACHE_DIR "shaderCache/"
+#define PROGRAM_CACHE_MAGIC 0x42505055 // "UPPB"
+#define PROGRAM_CACHE_VERSION 1
+#define PROGRAM_CACHE_MAX_PATH 64
+
+struct ProgramCacheHeader
+{
+    u32 magic;
+    u32 version;
+    u64 key;
+    u32 binaryFormat;
+    u32 binarySize;
+};
+
+struct ProgramCacheStats
+{
+    int hits;
+    int misses;
+    int rejected; // Entry existed, but the driver did not accept the binary
+    int stored;
+};
+
+struct ProgramCache
+{
+    bool initialized;
+    bool supported; // Driver has at least one binary format
+    u64 driverHash;
+    ProgramCacheStats stats;
+};
+
+ProgramCache programCache;
+
+// FNV-1a
+#define HASH_SEED 0xcbf29ce484222325ull
+u64 hashBytes(const void* data, u64 size, u64 hash = HASH_SEED)
+{
+    const byte* bytes = (const byte*) data;
+    for (u64 i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+u64 hashString(const char* str, u64 hash = HASH_SEED) {
+    return hashBytes(str, strlen(str) + 1, hash); // Terminator separates neighbouring strings
+}
+
+void print(ProgramCacheStats* s)
+{
+    loggf("ProgramCache: %d hits, %d misses, %d rejected, %d stored\n",
+            s->hits, s->misses, s->rejected, s->stored);
+}
+
+// Lazy, the context must exist
+void initProgramCache()
+{
+    if (programCache.initialized) {
+        return;
+    }
+    memset(&programCache, 0, sizeof(ProgramCache));
+    programCache.initialized = true;
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    programCache.supported = formatCount > 0;
+    u64 hash = HASH_SEED;
+    GLenum names[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    for (GLenum name : names) {
+        const char* str = (const char*) glGetString(name);
+        hash = hashString(str != nullptr ? str : "", hash);
+    }
+    programCache.driverHash = hash;
+}
+
+u64 getProgramCacheKey(int stageCount, const GLenum* types, const char** sources)
+{
+    initProgramCache();
+    u64 key = hashBytes(&stageCount, sizeof(int), programCache.driverHash);
+    for (int i = 0; i < stageCount; i++) {
+        key = hashBytes(&types[i], sizeof(GLenum), key);
+        key = hashString(sources[i], key);
+    }
+    return key;
+}
+
+void getProgramCachePath(char* buffer, u64 key) {
+    snprintf(buffer, PROGRAM_CACHE_MAX_PATH, PROGRAM_CACHE_DIR "%016llx.bin", (unsigned long long)key);
+}
+
+// Returns a linked program or 0 if there is no usable entry
+GLuint loadCachedProgram(u64 key)
+{
+    initProgramCache();
+    char path[PROGRAM_CACHE_MAX_PATH];
+    getProgramCachePath(path, key);
+    if (!programCache.supported || !file_exists(path)) {
+        programCache.stats.misses++;
+        return 0;
+    }
+
+    SCOPE_EXIT_ROLLBACK;
+    Blk file = load_file_tmp(path);
+    ProgramCacheHeader* header = (ProgramCacheHeader*) file.data;
+    if (file.size < sizeof(ProgramCacheHeader) ||
+        header->magic != PROGRAM_CACHE_MAGIC || header->version != PROGRAM_CACHE_VERSION ||
+        header->key != key || file.size != sizeof(ProgramCacheHeader) + header->binarySize)
+    {
+        loggf("Program cache entry %s is invalid, compiling from source\n", path);
+        programCache.stats.rejected++;
+        return 0;
+    }
+
+    GLuint id = glCreateProgram();
+    assert(id != 0, "glCreateProgram failed\n");
+    glProgramBinary(id, header->binaryFormat, header + 1, header->binarySize);
+    GLint isLinked = 0;
+    glGetProgramiv(id, GL_LINK_STATUS, &isLinked);
+    if (isLinked == GL_FALSE) {
+        loggf("Driver rejected program cache entry %s, compiling from source\n", path);
+        glDeleteProgram(id);
+        programCache.stats.rejected++;
+        return 0;
+    }
+    programCache.stats.hits++;
+    return id;
+}
+
+// The program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+void storeCachedProgram(u64 key, GLuint program)
+{
+    if (!programCache.supported) {
+        return;
+    }
+    GLint binarySize = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+    if (binarySize <= 0) {
+        return;
+    }
+
+    SCOPE_EXIT_ROLLBACK;
+    u64 fileSize = sizeof(ProgramCacheHeader) + binarySize;
+    ProgramCacheHeader* header = (ProgramCacheHeader*) tmpAlloc.alloc(fileSize);
+    header->magic = PROGRAM_CACHE_MAGIC;
+    header->version = PROGRAM_CACHE_VERSION;
+    header->key = key;
+    GLenum binaryFormat = 0;
+    GLsizei length = 0;
+    glGetProgramBinary(program, binarySize, &length, &binaryFormat, header + 1);
+    header->binaryFormat = binaryFormat;
+    header->binarySize = length;
+
+    char path[PROGRAM_CACHE_MAX_PATH];
+    getProgramCachePath(path, key);
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) {
+        loggf("Could not write program cache entry %s (Does %s exist?)\n", path, PROGRAM_CACHE_DIR);
+        return;
+    }
+    SCOPE_EXIT(fclose(file));
+    fwrite(header, 1, sizeof(ProgramCacheHeader) + length, file);
+    programCache.stats.stored++;
+}
+
+
+
+#endif
@@ -0,0 +1,486 @@
+#ifndef __RENDER_GRAPH_HPP__
+#define __RENDER_GRAPH_HPP__
+
+// --------------------
+// --- RENDER GRAPH ---
+// --------------------
+// Passes of a frame declare which textures they read and write, the graph decides what runs:
+//  - Passes are ordered so that every pass runs after the writers of its inputs,
+//    passes writing the same texture keep their declaration order.
+//  - Passes that contribute nothing to an imported resource (The backbuffer) are culled.
+//  - Transient textures only live from their first to their last use. Transients with the same
+//    size and format whose lifetimes do not overlap share one physical texture, so the memory
+//    scales with the textures alive at the same time and not with the number of passes.
+//
+// The graph is declared every frame (beginRenderGraph, createTexture/addPass/read/write),
+// then compile and execute. Physical textures and their fbos are pooled between frames,
+// with the same declarations nothing is created after the first frame. Physical textures
+// that no transient used in the last compile are deleted (E.g. After a resize).
+//
+// A pass writes at most one color and one depth texture, or the backbuffer. Execute binds its fbo
+// and viewport before the callback, clearing is up to the pass.
+
+#define RENDER_GRAPH_MAX_PASSES 32
+#define RENDER_GRAPH_MAX_RESOURCES 32
+#define RENDER_GRAPH_MAX_PASS_RESOURCES 8
+#define RENDER_GRAPH_MAX_TEXTURES 32
+#define RENDER_GRAPH_MAX_FBOS 32
+
+struct RenderGraph;
+typedef void (*RenderGraphPassFunc)(RenderGraph* g, int pass, void* userData);
+
+struct RenderGraphResource
+{
+    const char* name;
+    bool imported; // Backbuffer, not owned by the graph
+    int width;
+    int height;
+    GLenum internalFormat;
+    // Set by compile
+    bool needed;
+    int firstUse; // Index into order, -1 if unused
+    int lastUse;
+    int physical; // Index into textures, -1 if not assigned
+};
+
+struct RenderGraphPass
+{
+    const char* name;
+    RenderGraphPassFunc func;
+    void* userData;
+    int reads[RENDER_GRAPH_MAX_PASS_RESOURCES];
+    int readCount;
+    int writes[RENDER_GRAPH_MAX_PASS_RESOURCES];
+    int writeCount;
+    // Set by compile
+    bool alive;
+    GLuint fbo;
+    int width;
+    int height;
+};
+
+struct RenderGraphTexture
+{
+    Texture texture;
+    int busyUntil; // Last use of the transient it holds in the current compile, -1 if free
+    bool used; // Assigned in the current compile
+};
+
+struct RenderGraphFbo
+{
+    GLuint fbo;
+    GLuint color;
+    GLuint depth;
+};
+
+struct RenderGraphStats
+{
+    int passes;
+    int culledPasses;
+    int transients;
+    int physicalTextures;
+    u64 transientBytes; // Of the physical textures
+    u64 unaliasedBytes; // If every transient had its own texture
+    int texturesCreated;
+    int fbosCreated;
+};
+
+struct RenderGraph
+{
+    // Declared per frame
+    RenderGraphResource resources[RENDER_GRAPH_MAX_RESOURCES];
+    int resourceCount;
+    RenderGraphPass passes[RENDER_GRAPH_MAX_PASSES];
+    int passCount;
+    int width; // Of the backbuffer
+    int height;
+    // Set by compile
+    int order[RENDER_GRAPH_MAX_PASSES]; // Alive passes in execution order
+    int orderCount;
+    bool compiled;
+    // Pooled between frames
+    RenderGraphTexture textures[RENDER_GRAPH_MAX_TEXTURES];
+    int textureCount;
+    RenderGraphFbo fbos[RENDER_GRAPH_MAX_FBOS];
+    int fboCount;
+    RenderGraphStats stats; // Of the last compile, created counts are totals
+};
+
+void print(RenderGraphStats* s)
+{
+    loggf("RenderGraph: %d passes (%d culled), %d transients in %d textures, %llu KB (%llu KB unaliased), %d textures and %d fbos created\n",
+            s->passes, s->culledPasses, s->transients, s->physicalTextures,
+            s->transientBytes / 1024, s->unaliasedBytes / 1024, s->texturesCreated, s->fbosCreated);
+}
+
+// Only sized formats, the driver picks the size of unsized ones
+u64 getTexelSize(GLenum internalFormat)
+{
+    switch (internalFormat)
+    {
+        case GL_R8: return 1;
+        case GL_RG8: return 2;
+        case GL_RGB8: return 3;
+        case GL_RGBA8: return 4;
+        case GL_R16F: return 2;
+        case GL_RG16F: return 4;
+        case GL_RGB16F: return 6;
+        case GL_RGBA16F: return 8;
+        case GL_R32F: return 4;
+        case GL_RG32F: return 8;
+        case GL_RGB32F: return 12;
+        case GL_RGBA32F: return 16;
+        case GL_DEPTH_COMPONENT24: return 4; // Padded to 32 bits
+    }
+    invalid_path("Internal format not supported!\n");
+    return 0;
+}
+
+bool isDepthFormat(GLenum internalFormat) {
+    return internalFormat == GL_DEPTH_COMPONENT24;
+}
+
+void init(RenderGraph* g) {
+    *g = RenderGraph();
+}
+
+void deleteGraphTexture(RenderGraph* g, int index)
+{
+    GLuint id = g->textures[index].texture.id;
+    for (int i = 0; i < g->fboCount; i++)
+    {
+        if (g->fbos[i].color == id || g->fbos[i].depth == id) {
+            deleteFbo(&g->fbos[i].fbo);
+            g->fbos[i--] = g->fbos[--g->fboCount];
+        }
+    }
+    shutdown(&g->textures[index].texture);
+    g->textures[index] = g->textures[--g->textureCount];
+}
+
+void shutdown(RenderGraph* g)
+{
+    bindFbo(0);
+    while (g->textureCount > 0) {
+        deleteGraphTexture(g, g->textureCount - 1);
+    }
+}
+
+// Starts the declarations of a frame
+void beginRenderGraph(RenderGraph* g, int width, int height)
+{
+    g->resourceCount = 0;
+    g->passCount = 0;
+    g->orderCount = 0;
+    g->compiled = false;
+    g->width = width;
+    g->height = height;
+}
+
+int addResource(RenderGraph* g, const char* name, bool imported, int width, int height, GLenum internalFormat)
+{
+    assert(g->resourceCount < RENDER_GRAPH_MAX_RESOURCES, "Too many render graph resources\n");
+    RenderGraphResource& r = g->resources[g->resourceCount];
+    memset(&r, 0, sizeof(RenderGraphResource));
+    r.name = name;
+    r.imported = imported;
+    r.width = width;
+    r.height = height;
+    r.internalFormat = internalFormat;
+    return g->resourceCount++;
+}
+
+int createTexture(RenderGraph* g, const char* name, int width, int height, GLenum internalFormat)
+{
+    getTexelSize(internalFormat); // Checks the format
+    return addResource(g, name, false, width, height, internalFormat);
+}
+
+// Backbuffer sized
+int createTexture(RenderGraph* g, const char* name, GLenum internalFormat) {
+    return createTexture(g, name, g->width, g->height, internalFormat);
+}
+
+int importBackbuffer(RenderGraph* g) {
+    return addResource(g, "backbuffer", true, g->width, g->height, GL_RGBA8);
+}
+
+int addPass(RenderGraph* g, const char* name, RenderGraphPassFunc func, void* userData)
+{
+    assert(g->passCount < RENDER_GRAPH_MAX_PASSES, "Too many render graph passes\n");
+    RenderGraphPass& p = g->passes[g->passCount];
+    memset(&p, 0, sizeof(RenderGraphPass));
+    p.name = name;
+    p.func = func;
+    p.userData = userData;
+    return g->passCount++;
+}
+
+void read(RenderGraph* g, int pass, int resource)
+{
+    RenderGraphPass& p = g->passes[pass];
+    assert(resource >= 0 && resource < g->resourceCount, "Invalid render graph resource\n");
+    assert(p.readCount < RENDER_GRAPH_MAX_PASS_RESOURCES, "Too many reads in render graph pass\n");
+    p.reads[p.readCount++] = resource;
+}
+
+void write(RenderGraph* g, int pass, int resource)
+{
+    RenderGraphPass& p = g->passes[pass];
+    assert(resource >= 0 && resource < g->resourceCount, "Invalid render graph resource\n");
+    assert(p.writeCount < RENDER_GRAPH_MAX_PASS_RESOURCES, "Too many writes in render graph pass\n");
+    p.writes[p.writeCount++] = resource;
+}
+
+bool readsResource(RenderGraphPass* p, int resource) {
+    for (int i = 0; i < p->readCount; i++) {
+        if (p->reads[i] == resource) return true;
+    }
+    return false;
+}
+
+bool writesResource(RenderGraphPass* p, int resource) {
+    for (int i = 0; i < p->writeCount; i++) {
+        if (p->writes[i] == resource) return true;
+    }
+    return false;
+}
+
+// True if a has to run before b
+bool dependsOn(RenderGraph* g, int b, int a)
+{
+    RenderGraphPass* pa = &g->passes[a];
+    RenderGraphPass* pb = &g->passes[b];
+    for (int i = 0; i < pa->writeCount; i++) {
+        int r = pa->writes[i];
+        if (readsResource(pb, r) && !writesResource(pb, r)) return true; // Read after write
+        if (writesResource(pb, r) && a < b) return true; // Writers keep declaration order
+    }
+    return false;
+}
+
+// Kahn's algorithm, among the ready passes the first declared runs first
+void sortPasses(RenderGraph* g, int* sorted)
+{
+    int inDegree[RENDER_GRAPH_MAX_PASSES];
+    bool done[RENDER_GRAPH_MAX_PASSES];
+    for (int b = 0; b < g->passCount; b++) {
+        inDegree[b] = 0;
+        done[b] = false;
+        for (int a = 0; a < g->passCount; a++) {
+            if (a != b && dependsOn(g, b, a)) inDegree[b]++;
+        }
+    }
+    for (int i = 0; i < g->passCount; i++)
+    {
+        int next = -1;
+        for (int p = 0; p < g->passCount && next == -1; p++) {
+            if (!done[p] && inDegree[p] == 0) next = p;
+        }
+        assert(next != -1, "Render graph has a cycle\n");
+        done[next] = true;
+        sorted[i] = next;
+        for (int b = 0; b < g->passCount; b++) {
+            if (!done[b] && dependsOn(g, b, next)) inDegree[b]--;
+        }
+    }
+}
+
+GLuint getGraphFbo(RenderGraph* g, GLuint color, GLuint depth)
+{
+    for (int i = 0; i < g->fboCount; i++) {
+        if (g->fbos[i].color == color && g->fbos[i].depth == depth) {
+            return g->fbos[i].fbo;
+        }
+    }
+
+    assert(g->fboCount < RENDER_GRAPH_MAX_FBOS, "Too many render graph fbos\n");
+    RenderGraphFbo& f = g->fbos[g->fboCount++];
+    f.color = color;
+    f.depth = depth;
+    glGenFramebuffers(1, &f.fbo);
+    assert(f.fbo != 0, "glGenFramebuffer failed!\n");
+    bindFbo(f.fbo);
+    if (color != 0) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+    }
+    if (depth != 0) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+    }
+    assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "Render graph fbo not complete\n");
+    bindFbo(0);
+    g->stats.fbosCreated++;
+    return f.fbo;
+}
+
+// Returns a pooled texture that is free at the first use of the resource, creates one if none is
+int acquireGraphTexture(RenderGraph* g, RenderGraphResource* r)
+{
+    for (int i = 0; i < g->textureCount; i++)
+    {
+        RenderGraphTexture& t = g->textures[i];
+        if (t.busyUntil < r->firstUse && t.texture.width == r->width && t.texture.height == r->height &&
+                t.texture.internalFormat == (GLint)r->internalFormat) {
+            return i;
+        }
+    }
+
+    assert(g->textureCount < RENDER_GRAPH_MAX_TEXTURES, "Too many render graph textures\n");
+    RenderGraphTexture& t = g->textures[g->textureCount];
+    init(&t.texture, r->width, r->height, r->internalFormat,
+            TextureFilterMode(GL_NEAREST, GL_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE));
+    t.busyUntil = -1;
+    t.used = false;
+    g->stats.texturesCreated++;
+    return g->textureCount++;
+}
+
+void compile(RenderGraph* g)
+{
+    RenderGraphStats& s = g->stats;
+    s.passes = g->passCount;
+    s.culledPasses = 0;
+    s.transients = 0;
+    s.physicalTextures = 0;
+    s.transientBytes = 0;
+    s.unaliasedBytes = 0;
+
+    int sorted[RENDER_GRAPH_MAX_PASSES];
+    sortPasses(g, sorted);
+
+    // Cull, readers come after their writers, so walking backwards sees them first
+    for (int i = g->passCount - 1; i >= 0; i--)
+    {
+        RenderGraphPass& p = g->passes[sorted[i]];
+        p.alive = false;
+        for (int w = 0; w < p.writeCount; w++) {
+            RenderGraphResource& r = g->resources[p.writes[w]];
+            p.alive |= r.imported || r.needed;
+        }
+        if (!p.alive) {
+            s.culledPasses++;
+            continue;
+        }
+        for (int rd = 0; rd < p.readCount; rd++) {
+            g->resources[p.reads[rd]].needed = true;
+        }
+    }
+
+    // Lifetimes in execution order
+    g->orderCount = 0;
+    for (int i = 0; i < g->passCount; i++) {
+        if (g->passes[sorted[i]].alive) {
+            g->order[g->orderCount++] = sorted[i];
+        }
+    }
+    for (int i = 0; i < g->resourceCount; i++) {
+        g->resources[i].firstUse = -1;
+        g->resources[i].lastUse = -1;
+        g->resources[i].physical = -1;
+    }
+    for (int i = 0; i < g->orderCount; i++)
+    {
+        RenderGraphPass& p = g->passes[g->order[i]];
+        for (int j = 0; j < p.readCount + p.writeCount; j++) {
+            RenderGraphResource& r = g->resources[j < p.readCount ? p.reads[j] : p.writes[j - p.readCount]];
+            if (r.firstUse == -1) r.firstUse = i;
+            r.lastUse = i;
+        }
+    }
+
+    // Alias, transients are assigned in order of their first use
+    for (int i = 0; i < g->textureCount; i++) {
+        g->textures[i].busyUntil = -1;
+        g->textures[i].used = false;
+    }
+    for (int i = 0; i < g->orderCount; i++)
+    {
+        for (int j = 0; j < g->resourceCount; j++)
+        {
+            RenderGraphResource& r = g->resources[j];
+            if (r.imported || r.firstUse != i) {
+                continue;
+            }
+            r.physical = acquireGraphTexture(g, &r);
+            g->textures[r.physical].busyUntil = r.lastUse;
+            g->textures[r.physical].used = true;
+            s.transients++;
+            s.unaliasedBytes += r.width * r.height * getTexelSize(r.internalFormat);
+        }
+    }
+    for (int i = g->textureCount - 1; i >= 0; i--)
+    {
+        if (!g->textures[i].used) {
+            // Moves the last texture into i, fix the assignments of this compile
+            int last = g->textureCount - 1;
+            deleteGraphTexture(g, i);
+            for (int j = 0; j < g->resourceCount; j++) {
+                if (g->resources[j].physical == last) g->resources[j].physical = i;
+            }
+            continue;
+        }
+        Texture& t = g->textures[i].texture;
+        s.physicalTextures++;
+        s.transientBytes += t.width * t.height * getTexelSize(t.internalFormat);
+    }
+
+    // Render targets
+    for (int i = 0; i < g->orderCount; i++)
+    {
+        RenderGraphPass& p = g->passes[g->order[i]];
+        GLuint color = 0;
+        GLuint depth = 0;
+        bool backbuffer = false;
+        p.width = g->width;
+        p.height = g->height;
+        for (int w = 0; w < p.writeCount; w++)
+        {
+            RenderGraphResource& r = g->resources[p.writes[w]];
+            if (r.imported) {
+                backbuffer = true;
+                continue;
+            }
+            Texture& t = g->textures[r.physical].texture;
+            GLuint& attachment = isDepthFormat(r.internalFormat) ? depth : color;
+            assert(attachment == 0, "Render graph pass writes more than one color or depth texture\n");
+            attachment = t.id;
+            p.width = t.width;
+            p.height = t.height;
+        }
+        assert(!backbuffer || (color == 0 && depth == 0), "Render graph pass writes the backbuffer and a texture\n");
+        p.fbo = backbuffer ? 0 : getGraphFbo(g, color, depth);
+    }
+    g->compiled = true;
+}
+
+// The physical texture of a resource, only valid during execute
+Texture* getTexture(RenderGraph* g, int resource)
+{
+    RenderGraphResource& r = g->resources[resource];
+    assert(!r.imported && r.physical != -1, "Render graph resource has no texture\n");
+    return &g->textures[r.physical].texture;
+}
+
+// Texture of the index-th read of the pass
+Texture* getReadTexture(RenderGraph* g, int pass, int index)
+{
+    assert(index < g->passes[pass].readCount, "Render graph pass has no such read\n");
+    return getTexture(g, g->passes[pass].reads[index]);
+}
+
+void execute(RenderGraph* g)
+{
+    assert(g->compiled, "Render graph executed without compile\n");
+    for (int i = 0; i < g->orderCount; i++)
+    {
+        RenderGraphPass& p = g->passes[g->order[i]];
+        setViewport(p.width, p.height);
+        bindFbo(p.fbo);
+        p.func(g, g->order[i], p.userData);
+    }
+    bindDefaultFramebuffer(g->width, g->height);
+}
+
+
+
+#endif
@@ -0,0 +1,297 @@
+#ifndef __RENDER_QUEUE_HPP__
+#define __RENDER_QUEUE_HPP__
+
+// --------------------
+// --- RENDER QUEUE ---
+// --------------------
+// Draws are submitted with a 64 bit sort key, on flush the keys are radix sorted
+// and walked in order, so program/material/vao only change between neighbours
+// that differ. Layout of the key (Most significant first):
+//
+//     OPAQUE:       pass(4) | program(12) | material(12) | vao(16) | depth(20)
+//     TRANSPARENT:  pass(4) | inverted depth(20) | program(12) | material(12) | vao(16)
+//
+// Opaque draws are grouped by state and front to back inside a group,
+// transparent draws are sorted back to front.
+// Program and vao are the gl names, material is derived from the pointer,
+// ids that do not fit only cost grouping, not correctness.
+//
+// Neighbouring draws of an instanced program (See isInstanced) with the same material
+// and vao are merged into one instanced draw, the instance data goes to a stream buffer.
+
+#include "autoMesh.hpp"
+
+namespace RenderPass
+{
+    enum ENUM
+    {
+        OPAQUE_PASS = 0,
+        TRANSPARENT_PASS,
+        OVERLAY_PASS, // Drawn last, sorted like opaque
+
+        COUNT // MUST STAY LAST
+    };
+};
+
+const char* toStr(RenderPass::ENUM pass)
+{
+    switch (pass)
+    {
+    case RenderPass::OPAQUE_PASS: return "OPAQUE_PASS";
+    case RenderPass::TRANSPARENT_PASS: return "TRANSPARENT_PASS";
+    case RenderPass::OVERLAY_PASS: return "OVERLAY_PASS";
+    default: break;
+    }
+    return "INVALID";
+}
+
+// Sets material uniforms, called when the material changes between two draws
+typedef void (*BindMaterialFunc)(AutoShaderProgram* p, void* material);
+
+struct RenderCommand
+{
+    AutoShaderProgram* program;
+    GLuint vao;
+    int instanceStride; // 0 if the program is not instanced
+    int indexCount;
+    GLenum indexType;
+    void* material;
+    Transform transform;
+};
+
+struct RenderQueueStats
+{
+    int draws;
+    int instancedDraws;
+    int instances; // Commands merged into instanced draws
+    int programBinds;
+    int programBindsSaved;
+    int materialBinds;
+    int materialBindsSaved;
+    int vaoBinds;
+    int vaoBindsSaved;
+};
+
+struct RenderQueue
+{
+    DynArr<RenderCommand> commands;
+    DynArr<u64> keys;
+    BindMaterialFunc bindMaterial;
+    StreamBuffer instanceStream;
+    float maxDepth; // Depth is quantized in [0, maxDepth]
+    RenderQueueStats stats; // Of the last flush
+};
+
+#define RENDER_QUEUE_INSTANCE_STREAM_SIZE (4 * 1024 * 1024)
+void init(RenderQueue* q, BindMaterialFunc bindMaterial, Allocator* alloc)
+{
+    q->commands.init(alloc, 64);
+    q->keys.init(alloc, 64);
+    q->bindMaterial = bindMaterial;
+    init(&q->instanceStream, GL_ARRAY_BUFFER, RENDER_QUEUE_INSTANCE_STREAM_SIZE, alloc);
+    q->maxDepth = 100.0f;
+    memset(&q->stats, 0, sizeof(RenderQueueStats));
+}
+
+void shutdown(RenderQueue* q)
+{
+    q->commands.shutdown();
+    q->keys.shutdown();
+    shutdown(&q->instanceStream);
+}
+
+void print(RenderQueueStats* s)
+{
+    loggf("RenderQueue: %d draws\n", s->draws);
+    loggf("\tinstanced:      %d (%d instances)\n", s->instancedDraws, s->instances);
+    loggf("\tprogram binds:  %d (%d saved)\n", s->programBinds, s->programBindsSaved);
+    loggf("\tmaterial binds: %d (%d saved)\n", s->materialBinds, s->materialBindsSaved);
+    loggf("\tvao binds:      %d (%d saved)\n", s->vaoBinds, s->vaoBindsSaved);
+}
+
+#define RENDER_KEY_DEPTH_BITS 20
+#define RENDER_KEY_VAO_BITS 16
+#define RENDER_KEY_MATERIAL_BITS 12
+#define RENDER_KEY_PROGRAM_BITS 12
+u64 createRenderKey(RenderPass::ENUM pass, GLuint program, void* material, GLuint vao, float depth, float maxDepth)
+{
+    u64 depthMax = (1 << RENDER_KEY_DEPTH_BITS) - 1;
+    u64 d = (u64)(clamp(depth / maxDepth, 0.0f, 1.0f) * depthMax);
+    u64 p = program & ((1 << RENDER_KEY_PROGRAM_BITS) - 1);
+    u64 m = ((u64)material >> 4) & ((1 << RENDER_KEY_MATERIAL_BITS) - 1);
+    u64 v = vao & ((1 << RENDER_KEY_VAO_BITS) - 1);
+
+    u64 key = (u64)pass;
+    if (pass == RenderPass::TRANSPARENT_PASS) {
+        key = (key << RENDER_KEY_DEPTH_BITS) | (depthMax - d);
+        key = (key << RENDER_KEY_PROGRAM_BITS) | p;
+        key = (key << RENDER_KEY_MATERIAL_BITS) | m;
+        key = (key << RENDER_KEY_VAO_BITS) | v;
+    }
+    else {
+        key = (key << RENDER_KEY_PROGRAM_BITS) | p;
+        key = (key << RENDER_KEY_MATERIAL_BITS) | m;
+        key = (key << RENDER_KEY_VAO_BITS) | v;
+        key = (key << RENDER_KEY_DEPTH_BITS) | d;
+    }
+    return key;
+}
+
+void submit(RenderQueue* q, AutoMesh* mesh, AutoShaderProgram* p, const Transform& transform,
+        const vec3& camPos, void* material = nullptr, RenderPass::ENUM pass = RenderPass::OPAQUE_PASS)
+{
+    if (p->program.id == 0) {
+        return;
+    }
+    RenderCommand cmd;
+    cmd.program = p;
+    MeshVao* vao = getVao(mesh, p);
+    cmd.vao = vao->vao;
+    cmd.instanceStride = vao->instanceStride;
+    cmd.indexCount = mesh->buffer.indexBuffer.indexCount;
+    cmd.indexType = mesh->buffer.indexBuffer.indexType;
+    cmd.material = material;
+    cmd.transform = transform;
+    q->commands.push_back(cmd);
+
+    float depth = length(transform.pos - camPos);
+    q->keys.push_back(createRenderKey(pass, p->program.id, material, vao->vao, depth, q->maxDepth));
+}
+
+// LSD radix sort of the keys (8 bits per pass), values are sorted along.
+// Passes where all keys have the same byte are skipped (E.g. the unused high bits of ids).
+// The passes ping-pong between the buffers, returns the one that holds the sorted values
+u32* radixSort(u64* keys, u32* values, int count, u64* tmpKeys, u32* tmpValues)
+{
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        int histogram[256];
+        memset(histogram, 0, sizeof(histogram));
+        for (int i = 0; i < count; i++) {
+            histogram[(keys[i] >> shift) & 0xFF]++;
+        }
+        if (histogram[(keys[0] >> shift) & 0xFF] == count) {
+            continue;
+        }
+
+        int offset = 0;
+        for (int i = 0; i < 256; i++) {
+            int c = histogram[i];
+            histogram[i] = offset;
+            offset += c;
+        }
+        for (int i = 0; i < count; i++) {
+            int dst = histogram[(keys[i] >> shift) & 0xFF]++;
+            tmpKeys[dst] = keys[i];
+            tmpValues[dst] = values[i];
+        }
+
+        u64* k = keys; keys = tmpKeys; tmpKeys = k;
+        u32* v = values; values = tmpValues; tmpValues = v;
+    }
+    return values;
+}
+
+// Sorts and draws all submitted commands, afterwards the queue is empty
+void flush(RenderQueue* q, Camera3D* cam, const vec2& mousePos, float time)
+{
+    RenderQueueStats& s = q->stats;
+    memset(&s, 0, sizeof(RenderQueueStats));
+    int count = q->commands.size();
+    if (count == 0) {
+        return;
+    }
+
+    // Sort
+    SCOPE_EXIT_ROLLBACK;
+    u64* keys = (u64*) tmpAlloc.alloc(sizeof(u64) * count);
+    u32* order = (u32*) tmpAlloc.alloc(sizeof(u32) * count);
+    u64* tmpKeys = (u64*) tmpAlloc.alloc(sizeof(u64) * count);
+    u32* tmpOrder = (u32*) tmpAlloc.alloc(sizeof(u32) * count);
+    memcpy(keys, q->keys.data.data, sizeof(u64) * count);
+    for (int i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    order = radixSort(keys, order, count, tmpKeys, tmpOrder);
+
+    // Walk commands in key order, only change state between neighbours
+    AutoShaderProgram* program = nullptr;
+    void* material = nullptr;
+    bool materialBound = false;
+    GLuint vao = 0;
+    for (int i = 0; i < count; i++)
+    {
+        RenderCommand& cmd = q->commands[order[i]];
+        if (cmd.program != program) {
+            program = cmd.program;
+            updatePerFrameUniforms(program, cam, mousePos, time); // Binds the program
+            materialBound = false;
+            s.programBinds++;
+        }
+        else {
+            s.programBindsSaved++;
+        }
+
+        if (!materialBound || cmd.material != material) {
+            material = cmd.material;
+            materialBound = true;
+            if (q->bindMaterial != nullptr) {
+                q->bindMaterial(program, material);
+            }
+            s.materialBinds++;
+        }
+        else {
+            s.materialBindsSaved++;
+        }
+
+        if (cmd.vao != vao) {
+            vao = cmd.vao;
+            bindVao(vao);
+            s.vaoBinds++;
+        }
+        else {
+            s.vaoBindsSaved++;
+        }
+
+        if (cmd.instanceStride == 0) {
+            updatePerModelUniforms(program, cam, cmd.transform);
+            glDrawElements(GL_TRIANGLES, cmd.indexCount, cmd.indexType, (void*)0);
+            s.draws++;
+            continue;
+        }
+
+        // Merge run of neighbours with same state into one instanced draw
+        int runEnd = i + 1;
+        while (runEnd < count) {
+            RenderCommand& next = q->commands[order[runEnd]];
+            if (next.program != cmd.program || next.material != cmd.material || next.vao != cmd.vao) {
+                break;
+            }
+            runEnd++;
+        }
+        int instanceCount = runEnd - i;
+        StreamRange range = allocate(&q->instanceStream, cmd.instanceStride * instanceCount);
+        byte* instanceData = (byte*) range.data;
+        for (int j = 0; j < instanceCount; j++) {
+            RenderCommand& instance = q->commands[order[i + j]];
+            writeInstanceData(program, instance.transform, &instanceData[j * cmd.instanceStride]);
+        }
+        commit(&q->instanceStream, range);
+        drawInstanced(cmd.vao, cmd.indexCount, cmd.indexType, instanceCount, range.buffer, range.offset, cmd.instanceStride);
+        s.draws++;
+        s.instancedDraws++;
+        s.instances += instanceCount;
+        // Merged commands count as saved binds
+        s.programBindsSaved += instanceCount - 1;
+        s.materialBindsSaved += instanceCount - 1;
+        s.vaoBindsSaved += instanceCount - 1;
+        i = runEnd - 1;
+    }
+
+    q->commands.reset();
+    q->keys.reset();
+}
+
+
+
+#endif
@@ -4,23 +4,161 @@
 // Includes
 #include "openGLFunctions.hpp"
 
+// Per frame auto uniforms in one std140 uniform buffer, filled once per frame.
+// Shaders opt in with #include "common/frameUniforms.glsl" or by declaring the block 
+// (Members in this order, names are free):
+//
+//     layout(std140, binding = 0) uniform FrameUniforms
+//     {
+//         mat4 u_view;
+//         mat4 u_projection;
+//         mat4 u_vp;
+//         mat3 u_invView;
+//         vec3 u_camPos;
+//         float u_time;
+//         vec2 u_resolution;
+//         vec2 u_mouse;
+//     };
+#define FRAME_UNIFORM_BLOCK_NAME "FrameUniforms"
+#define FRAME_UNIFORM_BINDING 0
+struct FrameUniformData
+{
+    mat4 view;
+    mat4 projection;
+    mat4 vp;
+    vec4 inverseView[3]; // std140 pads mat3 columns to vec4
+    vec3 cameraPos;
+    float time;
+    vec2 resolution;
+    vec2 mousePos;
+};
+static_assert(sizeof(FrameUniformData) == 272, "FrameUniformData must match std140 layout");
+
 #define TEXTURE_UNIT_COUNT 16
+#define UNIFORM_BUFFER_BINDING_COUNT 16
+
+// Capabilities toggled with glEnable/glDisable that are cached
+namespace RenderCap
+{
+    enum ENUM
+    {
+        DEPTH_TEST,
+        CULL_FACE,
+        BLEND,
+        COUNT // MUST STAY LAST
+    };
+};
+
+const GLenum renderCapGLEnum[RenderCap::COUNT] = {
+    GL_DEPTH_TEST,
+    GL_CULL_FACE,
+    GL_BLEND,
+};
+
+// Buffer targets that are cached, GL_ELEMENT_ARRAY_BUFFER is vao state and always goes to gl
+namespace BufferTarget
+{
+    enum ENUM
+    {
+        ARRAY,
+        UNIFORM,
+        PIXEL_UNPACK,
+        SHADER_STORAGE,
+        COUNT // MUST STAY LAST
+    };
+};
+
+const GLenum bufferTargetGLEnum[BufferTarget::COUNT] = {
+    GL_ARRAY_BUFFER,
+    GL_UNIFORM_BUFFER,
+    GL_PIXEL_UNPACK_BUFFER,
+    GL_SHADER_STORAGE_BUFFER,
+};
+
+struct RenderStateStats
+{
+    int calls; // State calls that went to gl
+    int skipped; // Redundant state calls that were filtered out
+    int textureBinds;
+    int textureBindsSkipped; // Texture was still bound to a unit
+    int textureEvictions; // Least recently used texture unit got a new texture
+};
+
 struct RenderState
 {
     GLuint vao;
     GLuint program;
     GLuint fbo;
+    // Texture units, least recently used unit gets the next texture
     GLuint textureUnit[TEXTURE_UNIT_COUNT];
-    int nextTextureUnit;
+    u32 textureUnitLastUse[TEXTURE_UNIT_COUNT];
+    u32 textureUseCounter;
+    int activeTextureUnit;
+    // Fixed function
+    bool caps[RenderCap::COUNT];
+    GLenum depthFunc;
+    bool depthMask;
+    GLenum cullFace;
+    GLenum frontFace;
+    GLenum blendSrc;
+    GLenum blendDst;
+    vec4 clearColor;
+    int unpackAlignment;
+    int viewportX;
+    int viewportY;
     int viewportWidth;
     int viewportHeight;
+    // Buffers
+    GLuint buffers[BufferTarget::COUNT];
+    GLuint uniformBuffers[UNIFORM_BUFFER_BINDING_COUNT]; // glBindBufferBase
+    int storageBufferAlignment; // Of glBindBufferRange offsets
+    // Counters
     int frameCounter;
+    int tickCounter; // Once per game tick, frameCounter also counts framebuffer binds
+    RenderStateStats stats; // Of the current tick
+    RenderStateStats lastTick;
+    int statsTick;
+    // Frame uniform buffer
+    GLuint frameUbo;
+    int frameUboUpdateFrame;
 };
 
 RenderState renderState;
+
+void print(RenderStateStats* s)
+{
+    loggf("RenderState: %d state calls, %d skipped\n", s->calls, s->skipped);
+    loggf("\ttexture binds: %d (%d skipped, %d evictions)\n", s->textureBinds, s->textureBindsSkipped, s->textureEvictions);
+}
+
+RenderStateStats* getStats()
+{
+    if (renderState.statsTick != renderState.tickCounter) {
+        renderState.lastTick = renderState.stats;
+        memset(&renderState.stats, 0, sizeof(RenderStateStats));
+        renderState.statsTick = renderState.tickCounter;
+    }
+    return &renderState.stats;
+}
+
+// Returns true if the call has to go to gl
+bool changeState(bool changed)
+{
+    RenderStateStats* s = getStats();
+    if (changed) {
+        s->calls++;
+    }
+    else {
+        s->skipped++;
+    }
+    return changed;
+}
+
+// The cache starts out in a known state, everything is set explicitly because after a
+// dll reload the context still holds the state of the old dll
 void initRenderer() 
 {
-    memset(&renderState, 0, sizeof(RenderState));
+    renderState = RenderState();
     glBindVertexArray(0);
     glUseProgram(0);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -28,58 +166,308 @@ void initRenderer()
         glActiveTexture(GL_TEXTURE0 + i);
         glBindTexture(GL_TEXTURE_2D, 0);
     }
+    glActiveTexture(GL_TEXTURE0);
+
+    for (int i = 0; i < RenderCap::COUNT; i++) {
+        glDisable(renderCapGLEnum[i]);
+    }
+    renderState.depthFunc = GL_LESS;
+    glDepthFunc(GL_LESS);
+    renderState.depthMask = true;
+    glDepthMask(GL_TRUE);
+    renderState.cullFace = GL_BACK;
+    glCullFace(GL_BACK);
+    renderState.frontFace = GL_CCW;
+    glFrontFace(GL_CCW);
+    renderState.blendSrc = GL_ONE;
+    renderState.blendDst = GL_ZERO;
+    glBlendFunc(GL_ONE, GL_ZERO);
+    renderState.clearColor = vec4(0.0f);
+    glClearColor(0, 0, 0, 0);
+    renderState.unpackAlignment = 4;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (int i = 0; i < BufferTarget::COUNT; i++) {
+        glBindBuffer(bufferTargetGLEnum[i], 0);
+    }
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &renderState.storageBufferAlignment);
+    renderState.statsTick = renderState.tickCounter;
+
+    glGenBuffers(1, &renderState.frameUbo);
+    assert(renderState.frameUbo != 0, "glGenBuffers failed on frame uniform buffer\n");
+    glBindBuffer(GL_UNIFORM_BUFFER, renderState.frameUbo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniformData), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, renderState.frameUbo);
+    renderState.buffers[BufferTarget::UNIFORM] = renderState.frameUbo;
+    renderState.uniformBuffers[FRAME_UNIFORM_BINDING] = renderState.frameUbo;
+    renderState.frameUboUpdateFrame = -1;
 }
 
-void setViewport(int width, int height) 
+// --- Fixed function state ---
+void setCap(RenderCap::ENUM cap, bool enabled)
 {
-    if (renderState.viewportWidth != width || 
-        renderState.viewportHeight != height) 
+    if (changeState(renderState.caps[cap] != enabled))
     {
+        renderState.caps[cap] = enabled;
+        if (enabled) {
+            glEnable(renderCapGLEnum[cap]);
+        }
+        else {
+            glDisable(renderCapGLEnum[cap]);
+        }
+    }
+}
+
+void setDepthTest(bool enabled) {
+    setCap(RenderCap::DEPTH_TEST, enabled);
+}
+
+void setCulling(bool enabled) {
+    setCap(RenderCap::CULL_FACE, enabled);
+}
+
+void setBlending(bool enabled) {
+    setCap(RenderCap::BLEND, enabled);
+}
+
+void setDepthFunc(GLenum func) {
+    if (changeState(renderState.depthFunc != func)) {
+        renderState.depthFunc = func;
+        glDepthFunc(func);
+    }
+}
+
+void setDepthMask(bool write) {
+    if (changeState(renderState.depthMask != write)) {
+        renderState.depthMask = write;
+        glDepthMask(write ? GL_TRUE : GL_FALSE);
+    }
+}
+
+void setCullFace(GLenum face) {
+    if (changeState(renderState.cullFace != face)) {
+        renderState.cullFace = face;
+        glCullFace(face);
+    }
+}
+
+void setFrontFace(GLenum mode) {
+    if (changeState(renderState.frontFace != mode)) {
+        renderState.frontFace = mode;
+        glFrontFace(mode);
+    }
+}
+
+void setBlendFunc(GLenum src, GLenum dst) {
+    if (changeState(renderState.blendSrc != src || renderState.blendDst != dst)) {
+        renderState.blendSrc = src;
+        renderState.blendDst = dst;
+        glBlendFunc(src, dst);
+    }
+}
+
+void setClearColor(const vec4& color) {
+    vec4& c = renderState.clearColor;
+    if (changeState(c.x != color.x || c.y != color.y || c.z != color.z || c.w != color.w)) {
+        renderState.clearColor = color;
+        glClearColor(color.x, color.y, color.z, color.w);
+    }
+}
+
+void setUnpackAlignment(int alignment) {
+    if (changeState(renderState.unpackAlignment != alignment)) {
+        renderState.unpackAlignment = alignment;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+    }
+}
+
+void setViewport(int x, int y, int width, int height) 
+{
+    if (changeState(renderState.viewportX != x ||
+        renderState.viewportY != y ||
+        renderState.viewportWidth != width || 
+        renderState.viewportHeight != height))
+    {
+        renderState.viewportX = x;
+        renderState.viewportY = y;
         renderState.viewportWidth = width;
         renderState.viewportHeight = height;
-        glViewport(0, 0, width, height);
+        glViewport(x, y, width, height);
     }
 }
 
+void setViewport(int width, int height) {
+    setViewport(0, 0, width, height);
+}
+
+// --- Bindings ---
 void bindVao(GLuint vao) {
-    if (renderState.vao != vao) {
+    if (changeState(renderState.vao != vao)) {
         glBindVertexArray(vao);
         renderState.vao = vao;
     }
 }
 
 void bindProgram(GLuint id) {
-    if (renderState.program != id) {
+    if (changeState(renderState.program != id)) {
         glUseProgram(id);
         renderState.program = id;
     }
 }
 
 void bindFbo(GLuint fbo) {
-    if (renderState.fbo != fbo) {
+    if (changeState(renderState.fbo != fbo)) {
         glBindFramebuffer(GL_FRAMEBUFFER, fbo);
         renderState.fbo = fbo;
         renderState.frameCounter++;
     }
 }
 
-// Returns bound texture unit
+int getBufferTargetIndex(GLenum target)
+{
+    for (int i = 0; i < BufferTarget::COUNT; i++) {
+        if (bufferTargetGLEnum[i] == target) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void bindBuffer(GLenum target, GLuint buffer)
+{
+    int index = getBufferTargetIndex(target);
+    if (index == -1) {
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if (changeState(renderState.buffers[index] != buffer)) {
+        glBindBuffer(target, buffer);
+        renderState.buffers[index] = buffer;
+    }
+}
+
+// Also binds the generic GL_UNIFORM_BUFFER target, like gl does
+void bindUniformBuffer(GLuint binding, GLuint buffer)
+{
+    assert(binding < UNIFORM_BUFFER_BINDING_COUNT, "Uniform buffer binding %d out of range\n", binding);
+    if (changeState(renderState.uniformBuffers[binding] != buffer))
+    {
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+        renderState.uniformBuffers[binding] = buffer;
+        renderState.buffers[BufferTarget::UNIFORM] = buffer;
+    }
+}
+
+// Ranges are not cached, they usually point into a stream buffer and change every tick.
+// The offset must be a multiple of renderState.storageBufferAlignment
+void bindStorageBufferRange(GLuint binding, GLuint buffer, int offset, int size)
+{
+    assert(offset % renderState.storageBufferAlignment == 0, "Storage buffer range offset is not aligned\n");
+    changeState(true);
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, buffer, offset, size);
+    renderState.buffers[BufferTarget::SHADER_STORAGE] = buffer;
+}
+
+void setActiveTextureUnit(int unit) {
+    if (changeState(renderState.activeTextureUnit != unit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        renderState.activeTextureUnit = unit;
+    }
+}
+
+// Returns bound texture unit, which is also the active unit afterwards (So the texture can be modified).
+// If the texture is not bound, the least recently used unit is replaced. The units of the
+// textures a draw uses are the most recently used ones, so they never evict each other.
 GLint bindTexture2D(GLuint id) 
 {
-    // Check if it is already bound
-    for (int i = 0; i < TEXTURE_UNIT_COUNT; i++) {
+    RenderStateStats* s = getStats();
+    u32 use = ++renderState.textureUseCounter;
+    GLint lru = 0;
+    for (int i = 0; i < TEXTURE_UNIT_COUNT; i++)
+    {
         if (renderState.textureUnit[i] == id) {
+            renderState.textureUnitLastUse[i] = use;
+            s->textureBindsSkipped++;
+            setActiveTextureUnit(i);
             return i;
         }
+        if (renderState.textureUnitLastUse[i] < renderState.textureUnitLastUse[lru]) {
+            lru = i;
+        }
     }
 
-    // Bind to unit
-    GLint unit = renderState.nextTextureUnit;
-    renderState.nextTextureUnit = (renderState.nextTextureUnit + 1) % TEXTURE_UNIT_COUNT;
-    glActiveTexture(GL_TEXTURE0 + unit);
+    if (renderState.textureUnit[lru] != 0) {
+        s->textureEvictions++;
+    }
+    s->textureBinds++;
+    setActiveTextureUnit(lru);
     glBindTexture(GL_TEXTURE_2D, id);
+    renderState.textureUnit[lru] = id;
+    renderState.textureUnitLastUse[lru] = use;
+    return lru;
+}
+
+// --- Deletion ---
+// Objects the cache may still reference must be deleted through these, gl reuses names
+// and a new object with the same name would look like it is already bound
+void deleteTexture(GLuint* id)
+{
+    for (int i = 0; i < TEXTURE_UNIT_COUNT; i++) {
+        if (renderState.textureUnit[i] == *id) {
+            renderState.textureUnit[i] = 0;
+            renderState.textureUnitLastUse[i] = 0;
+        }
+    }
+    glDeleteTextures(1, id);
+    *id = 0;
+}
 
-    return unit;
+void deleteBuffer(GLuint* id)
+{
+    for (int i = 0; i < BufferTarget::COUNT; i++) {
+        if (renderState.buffers[i] == *id) {
+            renderState.buffers[i] = 0;
+        }
+    }
+    for (int i = 0; i < UNIFORM_BUFFER_BINDING_COUNT; i++) {
+        if (renderState.uniformBuffers[i] == *id) {
+            renderState.uniformBuffers[i] = 0;
+        }
+    }
+    glDeleteBuffers(1, id);
+    *id = 0;
+}
+
+void deleteVao(GLuint* id)
+{
+    if (renderState.vao == *id) {
+        renderState.vao = 0;
+    }
+    glDeleteVertexArrays(1, id);
+    *id = 0;
+}
+
+void deleteProgram(GLuint* id)
+{
+    if (renderState.program == *id) {
+        renderState.program = 0;
+    }
+    glDeleteProgram(*id);
+    *id = 0;
+}
+
+void deleteFbo(GLuint* id)
+{
+    if (renderState.fbo == *id) {
+        renderState.fbo = 0;
+    }
+    glDeleteFramebuffers(1, id);
+    *id = 0;
+}
+
+// Frees what initRenderer created, called before reloading and on shutdown
+void shutdownRenderer()
+{
+    deleteBuffer(&renderState.frameUbo);
 }
 
 #endif
@@ -7,12 +7,20 @@
 
 // Render includes
 #include "renderState.hpp"
+#include "streamBuffer.hpp"
 #include "mesh.hpp"
-#include "shaderProgram.hpp"
+#include "shaderprogram.hpp"
+#include "vaoCache.hpp"
 #include "autoShaderProgram.hpp"
 #include "autoMesh.hpp"
+#include "renderQueue.hpp"
+#include "lightClusters.hpp"
 #include "texture.hpp"
+#include "textureLoader.hpp"
+#include "textureAtlas.hpp"
+#include "spriteBatch.hpp"
 #include "framebuffer.hpp"
+#include "renderGraph.hpp"
 
 // Next steps:
 //  - Mesh creation in new file
@@ -0,0 +1,254 @@
+#ifndef __SHADER_PREPROCESSOR_HPP__
+#define __SHADER_PREPROCESSOR_HPP__
+
+// ---------------------------
+// --- SHADER PREPROCESSOR ---
+// ---------------------------
+// Runs on every stage before it is handed to glShaderSource:
+//  - #include "file" is replaced by the file (Path relative to SHADER_DIR). Every file is
+//    included once per stage, repeated includes are dropped, so includes need no guards.
+//  - The define set of the program is injected after #version, one #define per entry.
+// #line directives keep line numbers of compile errors intact, the source number is
+// 0 for the stage file and the index in ShaderIncludes (Starting at 1) for includes.
+//
+// Define sets are comma separated, values follow a '=': "NORMAL_MAP,LIGHT_COUNT=4".
+// normalizeDefines sorts the entries, so the order does not create new variants.
+
+#include "../utils/string_utils.hpp"
+#include "../utils/fileIO.hpp"
+
+#define SHADER_DIR "ressources/shaders/"
+#define SHADER_MAX_PATH 128
+#define SHADER_MAX_INCLUDES 16
+#define SHADER_MAX_INCLUDE_DEPTH 8
+#define SHADER_MAX_DEFINES 32
+#define SHADER_MAX_DEFINES_LENGTH 512
+
+// Files pulled in by #include, in order of first inclusion
+struct ShaderIncludes
+{
+    char paths[SHADER_MAX_INCLUDES][SHADER_MAX_PATH];
+    int count;
+};
+
+// Returns false if the path was already in the list
+bool addInclude(ShaderIncludes* includes, const char* path)
+{
+    for (int i = 0; i < includes->count; i++) {
+        if (strcmp(includes->paths[i], path) == 0) {
+            return false;
+        }
+    }
+    assert(includes->count < SHADER_MAX_INCLUDES, "Too many shader includes\n");
+    strcpy(includes->paths[includes->count++], path);
+    return true;
+}
+
+// Growing output buffer in tmpAlloc memory
+struct ShaderSourceBuilder
+{
+    char* data;
+    int size;
+    int capacity;
+};
+
+void append(ShaderSourceBuilder* b, const char* str, int length)
+{
+    if (b->size + length + 1 > b->capacity)
+    {
+        int capacity = max(b->capacity * 2, b->size + length + 1);
+        char* data = (char*) tmpAlloc.alloc(capacity);
+        memcpy(data, b->data, b->size);
+        b->data = data;
+        b->capacity = capacity;
+    }
+    memcpy(b->data + b->size, str, length);
+    b->size += length;
+    b->data[b->size] = 0;
+}
+
+void appendf(ShaderSourceBuilder* b, const char* format, ...)
+{
+    char buffer[SHADER_MAX_PATH + 64];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    append(b, buffer, min(length, (int)sizeof(buffer) - 1));
+}
+
+// Sorts the entries and removes whitespace and empty entries
+void normalizeDefines(const char* defines, char* out)
+{
+    out[0] = 0;
+    if (defines == nullptr) {
+        return;
+    }
+
+    SCOPE_EXIT_ROLLBACK;
+    int length = (int) strlen(defines);
+    assert(length < SHADER_MAX_DEFINES_LENGTH, "Shader define set too long\n");
+    char* copy = (char*) tmpAlloc.alloc(length + 1);
+    memcpy(copy, defines, length + 1);
+
+    // Split
+    char* entries[SHADER_MAX_DEFINES];
+    int count = 0;
+    char* entry = copy;
+    for (int i = 0; i <= length; i++)
+    {
+        if (copy[i] != ',' && copy[i] != 0) {
+            continue;
+        }
+        copy[i] = 0;
+        while (*entry == ' ' || *entry == '\t') entry++;
+        char* end = entry + strlen(entry);
+        while (end > entry && (end[-1] == ' ' || end[-1] == '\t')) *--end = 0;
+        if (*entry != 0) {
+            assert(count < SHADER_MAX_DEFINES, "Too many shader defines\n");
+            entries[count++] = entry;
+        }
+        entry = &copy[i + 1];
+    }
+
+    // Insertion sort, define sets are short
+    for (int i = 1; i < count; i++) {
+        for (int j = i; j > 0 && strcmp(entries[j - 1], entries[j]) > 0; j--) {
+            char* swap = entries[j];
+            entries[j] = entries[j - 1];
+            entries[j - 1] = swap;
+        }
+    }
+
+    int outLength = 0;
+    for (int i = 0; i < count; i++) {
+        outLength += sprintf(out + outLength, i == 0 ? "%s" : ",%s", entries[i]);
+    }
+}
+
+// Defines must be normalized
+void appendDefines(ShaderSourceBuilder* b, const char* defines)
+{
+    const char* entry = defines;
+    while (*entry != 0)
+    {
+        const char* end = strchr(entry, ',');
+        if (end == nullptr) {
+            end = entry + strlen(entry);
+        }
+        const char* equals = (const char*) memchr(entry, '=', end - entry);
+        append(b, "#define ", 8);
+        if (equals != nullptr) {
+            append(b, entry, (int)(equals - entry));
+            append(b, " ", 1);
+            append(b, equals + 1, (int)(end - equals - 1));
+        }
+        else {
+            append(b, entry, (int)(end - entry));
+        }
+        append(b, "\n", 1);
+        entry = *end == ',' ? end + 1 : end;
+    }
+}
+
+bool isDirective(const char* line, const char* directive, const char** rest)
+{
+    while (*line == ' ' || *line == '\t') line++;
+    int length = (int) strlen(directive);
+    if (strncmp(line, directive, length) != 0) {
+        return false;
+    }
+    *rest = line + length;
+    return true;
+}
+
+// Source number of the file for #line, 0 for the stage file
+bool appendShaderFile(ShaderSourceBuilder* b, const char* path, int sourceNumber,
+        const char* defines, ShaderIncludes* includes, int depth)
+{
+    if (!file_exists(path)) {
+        loggf("Shader preprocessor: could not open %s\n", path);
+        return false;
+    }
+    if (depth > SHADER_MAX_INCLUDE_DEPTH) {
+        loggf("Shader preprocessor: includes nested too deep in %s\n", path);
+        return false;
+    }
+
+    char* text = load_text_file_tmp(path);
+    bool definesPending = sourceNumber == 0 && defines[0] != 0;
+    int lineNumber = 1;
+    char* line = text;
+    while (*line != 0)
+    {
+        char* lineEnd = strchr(line, '\n');
+        if (lineEnd == nullptr) {
+            lineEnd = line + strlen(line);
+        }
+        char* next = *lineEnd == '\n' ? lineEnd + 1 : lineEnd;
+
+        const char* rest;
+        if (isDirective(line, "#include", &rest))
+        {
+            const char* nameStart = strchr(rest, '"');
+            const char* nameEnd = nameStart != nullptr ? strchr(nameStart + 1, '"') : nullptr;
+            if (nameEnd == nullptr || nameEnd > lineEnd) {
+                loggf("Shader preprocessor: invalid #include in %s line %d\n", path, lineNumber);
+                return false;
+            }
+            char includePath[SHADER_MAX_PATH];
+            snprintf(includePath, SHADER_MAX_PATH, SHADER_DIR "%.*s", (int)(nameEnd - nameStart - 1), nameStart + 1);
+
+            if (!addInclude(includes, includePath)) {
+                append(b, "\n", 1); // Already included, keeps the line numbers
+            }
+            else
+            {
+                int includeNumber = includes->count;
+                appendf(b, "#line 1 %d\n", includeNumber);
+                if (!appendShaderFile(b, includePath, includeNumber, defines, includes, depth + 1)) {
+                    return false;
+                }
+                appendf(b, "\n#line %d %d\n", lineNumber + 1, sourceNumber);
+            }
+        }
+        else
+        {
+            append(b, line, (int)(next - line));
+            if (definesPending && isDirective(line, "#version", &rest)) {
+                if (*lineEnd != '\n') {
+                    append(b, "\n", 1);
+                }
+                appendDefines(b, defines);
+                appendf(b, "#line %d 0\n", lineNumber + 1);
+                definesPending = false;
+            }
+        }
+        line = next;
+        lineNumber++;
+    }
+
+    if (definesPending) {
+        loggf("Shader preprocessor: %s has no #version, defines were not injected\n", path);
+    }
+    return true;
+}
+
+// Returns the preprocessed source in tmpAlloc memory or nullptr on error.
+// Defines must be normalized, includes receives all included files.
+char* preprocessShader(const char* path, const char* defines, ShaderIncludes* includes)
+{
+    ShaderSourceBuilder b;
+    b.capacity = 4096;
+    b.size = 0;
+    b.data = (char*) tmpAlloc.alloc(b.capacity);
+    b.data[0] = 0;
+    if (!appendShaderFile(&b, path, 0, defines, includes, 0)) {
+        return nullptr;
+    }
+    return b.data;
+}
+
+
+
+#endif
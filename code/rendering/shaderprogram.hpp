@@ -3,19 +3,13 @@
 
 // Includes
 #include "../utils/string_utils.hpp"
+#include "programCache.hpp"
+#include "shaderPreprocessor.hpp"
 
 // OpenGL untils
-GLuint createShaderFromSource(const char* source, GLenum type)
+// Logs the info log if compilation failed, waits for the compile to finish
+bool checkCompileStatus(GLuint id)
 {
-    // Create shader id
-    GLuint id = glCreateShader(type);
-    assert(id != 0, "glCreateShader failed!\n");
-
-    // Compile
-    glShaderSource(id, 1, &source, NULL);
-    glCompileShader(id);
-
-    // Check if compilation worked
     GLint isCompiled = 0;
     glGetShaderiv(id, GL_COMPILE_STATUS, &isCompiled);
     if (isCompiled == GL_FALSE)
@@ -27,6 +21,42 @@ GLuint createShaderFromSource(const char* source, GLenum type)
         glGetShaderInfoLog(id, maxLength, &maxLength, (char*)errorMsg);
         loggf("ERROR COMPILING SHADER:\n");
         loggf("Could not compile shader, error msg: \n %s\n", errorMsg.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Logs the info log if linking failed, waits for the link to finish
+bool checkLinkStatus(GLuint id)
+{
+    GLint isLinked = 0;
+    glGetProgramiv(id, GL_LINK_STATUS, &isLinked);
+    if (isLinked == GL_FALSE)
+    {
+        GLint maxLength = 0;
+        glGetProgramiv(id, GL_INFO_LOG_LENGTH, &maxLength);
+
+        TmpStr errorMsg(maxLength);
+        glGetProgramInfoLog(id, maxLength, &maxLength, (GLchar*) errorMsg.c_str());
+        loggf("PROGRAM LINKING FAILED!\n");
+        loggf("Could not link program, error msg: \n %s\n", errorMsg.c_str());
+        return false;
+    }
+    return true;
+}
+
+GLuint createShaderFromSource(const char* source, GLenum type)
+{
+    // Create shader id
+    GLuint id = glCreateShader(type);
+    assert(id != 0, "glCreateShader failed!\n");
+
+    // Compile
+    glShaderSource(id, 1, &source, NULL);
+    glCompileShader(id);
+
+    // Check if compilation worked
+    if (!checkCompileStatus(id)) {
         glDeleteShader(id);
         id = 0;
     }
@@ -34,26 +64,31 @@ GLuint createShaderFromSource(const char* source, GLenum type)
     return id;
 }
 
-GLuint createShaderFromFile(const char* filepath)
+// Supported extensions are .frag, .vert, .geom, .tese and .tesc, returns 0 otherwise
+GLenum getShaderType(const char* filepath)
 {
-    // Check extension (Supported extensions are .frag, .vert)
-    GLenum shaderType = 0;
     if (endsWith(filepath, ".frag")) {
-        shaderType = GL_FRAGMENT_SHADER;
+        return GL_FRAGMENT_SHADER;
     }
     else if (endsWith(filepath, ".vert")) {
-        shaderType = GL_VERTEX_SHADER;
+        return GL_VERTEX_SHADER;
     } 
     else if (endsWith(filepath, ".geom")) {
-        shaderType = GL_GEOMETRY_SHADER;
+        return GL_GEOMETRY_SHADER;
     } 
     else if (endsWith(filepath, ".tese")) {
-        shaderType = GL_TESS_EVALUATION_SHADER;
+        return GL_TESS_EVALUATION_SHADER;
     } 
     else if (endsWith(filepath, ".tesc")) {
-        shaderType = GL_TESS_CONTROL_SHADER;
+        return GL_TESS_CONTROL_SHADER;
     } 
-    else {
+    return 0;
+}
+
+GLuint createShaderFromFile(const char* filepath)
+{
+    GLenum shaderType = getShaderType(filepath);
+    if (shaderType == 0) {
         loggf("CreateShaderFromFile: could not get shadertype from filepath: %s\n", filepath);
         invalid_path("CreateShaderFromFile");
         return 0;
@@ -70,69 +105,132 @@ GLuint createShaderFromFile(const char* filepath)
 }
 
 #define MAX_SHADER_COUNT 6 
-GLuint createShaderProgram(int fileCount, const char** filepaths)
+// A program on its way from the sources to a linked program. beginProgramBuild issues
+// all compiles and the link without asking for any status, so the driver can work on them
+// while the caller goes on (Or submits more programs), endProgramBuild then checks the result.
+struct ProgramBuild
+{
+    GLuint program;
+    GLuint shaders[MAX_SHADER_COUNT];
+    int shaderCount; // 0 if the program came from the program cache
+    u64 cacheKey;
+};
+
+// Loads the program from the program binary cache (See programCache.hpp) or submits compiling
+// and linking it. Returns false if the sources could not be loaded or preprocessed.
+// Defines must be normalized (See shaderPreprocessor.hpp), includes receives the
+// included files of all stages and may be nullptr.
+bool beginProgramBuild(ProgramBuild* b, int fileCount, const char** filepaths, 
+        const char* defines, ShaderIncludes* includes)
 {
     assert(fileCount < MAX_SHADER_COUNT, "CreateShaderProgram called with more than max shaders\n");
+    memset(b, 0, sizeof(ProgramBuild));
+    if (includes != nullptr) {
+        includes->count = 0;
+    }
 
-    // Compile all shaders
-    int shaderCount = fileCount;
-    int shaderIDs[MAX_SHADER_COUNT];
-    memset(shaderIDs, 0, sizeof(int) * MAX_SHADER_COUNT);
-    bool success = true;
-    for (int i = 0; i < shaderCount; i++)
+    // Preprocess all sources, they are the cache key
+    SCOPE_EXIT_ROLLBACK;
+    GLenum types[MAX_SHADER_COUNT];
+    const char* sources[MAX_SHADER_COUNT];
+    for (int i = 0; i < fileCount; i++)
     {
-        shaderIDs[i] = createShaderFromFile(filepaths[i]);
-        if (shaderIDs[i] == 0) {
-            loggf("Create shader program failed, could not compile file %s", filepaths[i]);
-            success = false;
-            break;
+        types[i] = getShaderType(filepaths[i]);
+        if (types[i] == 0) {
+            loggf("CreateShaderProgram: could not get shadertype from filepath: %s\n", filepaths[i]);
+            invalid_path("CreateShaderProgram");
+            return false;
+        }
+        ShaderIncludes stageIncludes;
+        stageIncludes.count = 0;
+        sources[i] = preprocessShader(filepaths[i], defines, &stageIncludes);
+        for (int j = 0; includes != nullptr && j < stageIncludes.count; j++) {
+            addInclude(includes, stageIncludes.paths[j]);
         }
+        if (sources[i] == nullptr) {
+            loggf("CreateShaderProgram: preprocessing %s failed\n", filepaths[i]);
+            return false;
+        }
+    }
+    b->cacheKey = getProgramCacheKey(fileCount, types, sources);
+    b->program = loadCachedProgram(b->cacheKey);
+    if (b->program != 0) {
+        return true;
     }
 
-    // Rollback if error occured
-    if (!success) 
+    // Submit all compiles, then the link
+    b->program = glCreateProgram();
+    assert(b->program != 0, "glCreateProgram failed\n");
+    glProgramParameteri(b->program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    b->shaderCount = fileCount;
+    for (int i = 0; i < fileCount; i++)
     {
-        for (int i = 0; i < shaderCount; i++) {
-            if (shaderIDs[i] != 0) {
-                glDeleteShader(shaderIDs[i]);
-            }
-        }
-        return 0;
+        b->shaders[i] = glCreateShader(types[i]);
+        assert(b->shaders[i] != 0, "glCreateShader failed!\n");
+        glShaderSource(b->shaders[i], 1, &sources[i], NULL);
+        glCompileShader(b->shaders[i]);
+        glAttachShader(b->program, b->shaders[i]);
     }
+    glLinkProgram(b->program);
 
-    // Create program
-    GLuint id = glCreateProgram();
-    assert(id != 0, "glCreateProgram failed\n");
+    return true;
+}
 
-    // Attach all shaders
-    for (int i = 0; i < shaderCount; i++) {
-        glAttachShader(id, shaderIDs[i]);
+// Deletes everything of the build, including the program
+void cancelProgramBuild(ProgramBuild* b)
+{
+    for (int i = 0; i < b->shaderCount; i++) {
+        glDetachShader(b->program, b->shaders[i]);
+        glDeleteShader(b->shaders[i]);
     }
+    glDeleteProgram(b->program);
+    memset(b, 0, sizeof(ProgramBuild));
+}
 
-    // Link shaders to program and check if errors occured
-    glLinkProgram(id);
-    int isLinked = 0;
-    glGetProgramiv(id, GL_LINK_STATUS, &isLinked);
-    if (isLinked == GL_FALSE)
-    {
-        GLint maxLength = 0;
-        glGetProgramiv(id, GL_INFO_LOG_LENGTH, &maxLength);
+// Waits for the build if the driver is not done yet, returns the linked program or 0 
+// if compiling or linking failed (Errors are logged).
+GLuint endProgramBuild(ProgramBuild* b, const char** filepaths)
+{
+    GLuint id = b->program;
+    if (b->shaderCount == 0) {
+        return id;
+    }
 
-        TmpStr errorMsg(maxLength);
-        glGetProgramInfoLog(id, maxLength, &maxLength, (GLchar*) errorMsg.c_str());
-        loggf("PROGRAM LINKING FAILED!\n");
-        loggf("Could not link program, error msg: \n %s\n", errorMsg.c_str());
+    if (!checkLinkStatus(id))
+    {
+        // Compile errors only show up as link error, the shader logs tell what went wrong
+        for (int i = 0; i < b->shaderCount; i++) {
+            if (!checkCompileStatus(b->shaders[i])) {
+                loggf("Create shader program failed, could not compile file %s\n", filepaths[i]);
+            }
+        }
+        cancelProgramBuild(b);
+        return 0;
     }
+    storeCachedProgram(b->cacheKey, id);
 
     // Cleanup shaders
-    for (int i = 0; i < shaderCount; i++) {
-        glDetachShader(id, shaderIDs[i]);
-        glDeleteShader(shaderIDs[i]);
+    for (int i = 0; i < b->shaderCount; i++) {
+        glDetachShader(id, b->shaders[i]);
+        glDeleteShader(b->shaders[i]);
     }
+    memset(b, 0, sizeof(ProgramBuild));
 
     return id;
 }
 
+// Links the program from the sources (Blocking), or loads it from the program binary cache 
+GLuint createShaderProgram(int fileCount, const char** filepaths, const char* defines = nullptr)
+{
+    char normalized[SHADER_MAX_DEFINES_LENGTH];
+    normalizeDefines(defines, normalized);
+    ProgramBuild build;
+    if (!beginProgramBuild(&build, fileCount, filepaths, normalized, nullptr)) {
+        return 0;
+    }
+    return endProgramBuild(&build, filepaths);
+}
+
 
 // SHADER PROGRAM
 struct AttribInfo
@@ -144,10 +242,16 @@ struct AttribInfo
     Blk nameBlk;
 };
 
+// FNV-1a, constexpr so literal names can be hashed at compile time
+constexpr u32 hashUniformName(const char* str, u32 hash = 2166136261u) {
+    return *str == 0 ? hash : hashUniformName(str + 1, (hash ^ (u32)(u8)*str) * 16777619u);
+}
+
 struct UniformInfo
 {
     GLint location;
     char* name;
+    u32 nameHash; // hashUniformName
     GLenum type;
     GLint size;
     Blk nameBlk;
@@ -157,9 +261,10 @@ struct ShaderProgram; // Forward declaration
 typedef void (*ShaderProgramReloadCallback)(ShaderProgram*);
 struct ShaderProgram
 {
-    int id;
-    // Hot reloading
-    DynArr<ListenerToken> tokens;
+    GLuint id;
+    u32 generation; // Changes with every new id, see UniformHandle
+    String defines; // Normalized define set, see shaderPreprocessor.hpp
+    // Hot reloading (File listeners are in shaderFiles)
     DynArr<ShaderProgramReloadCallback> reloadCallbacks;
     DynArr<String> filepaths;
     // Infos
@@ -172,10 +277,7 @@ struct ShaderProgram
 void print(ShaderProgram* p)
 {
     loggf("Program id: \t%d\n", p->id);
-    loggf("Listener tokens: (size %d)\n", p->tokens.size());
-    for (ListenerToken& t : p->tokens) {
-        loggf("\t%d\n", t);
-    }
+    loggf("Defines: \t%s\n", p->defines.c_str());
     loggf("Filepaths: (size %d)\n", p->filepaths.size());
     for (String& str : p->filepaths) {
         loggf("\t%s\n", str.c_str());
@@ -259,119 +361,423 @@ void loadUniformInfos(ShaderProgram* p)
         glGetActiveUniform(p->id, (GLuint) i, 256, NULL, 
                 &info.size, &info.type, (GLchar*) nameBuffer);
 
+        // Members of uniform blocks have no location
         info.location = glGetUniformLocation(p->id, nameBuffer);
-        assert(info.location != -1, 
-                "glGetUniformLocation failed with string: %s\n", nameBuffer);
+        if (info.location == -1) {
+            continue;
+        }
 
         // Copy uniform name
         info.nameBlk = p->alloc->alloc(strlen(nameBuffer)+1);
         info.name = (char*) info.nameBlk;
         strcpy(info.name, nameBuffer);
+        info.nameHash = hashUniformName(info.name);
 
         // Put uniform data in dynamic array
         p->uniformInfos.push_back(info);
     }
 }
 
-void onShaderFileChanged(const char* filename, void* userData)
+void clearProgramInfos(ShaderProgram* p)
 {
-    ShaderProgram* p = (ShaderProgram*) userData;
-    loggf("On shader file changed: %s\n", filename);
+    for (UniformInfo& info : p->uniformInfos) {
+        p->alloc->dealloc(info.nameBlk);       
+    }
     p->uniformInfos.reset();
+    for (AttribInfo& info : p->attribInfos) {
+        p->alloc->dealloc(info.nameBlk);       
+    }
     p->attribInfos.reset();
+}
 
-    // Recompile program
-    glDeleteProgram(p->id);
-    p->id = 0;
-    // Create 
-    SCOPE_EXIT_ROLLBACK;
-    char** filepaths = (char**) tmpAlloc.alloc(p->filepaths.size() * sizeof(char**));
-    for(int i = 0; i < p->filepaths.size(); i++) {
-        filepaths[i] = p->filepaths[i].c_str();
-    }
-    p->id = createShaderProgram(p->filepaths.size(), (const char**)filepaths);
-    
-    // Reload program infos
-    if (p->id == 0) {
-        return;
+// Global, so a handle never matches a different program at the same address
+u32 programGenerationCounter = 0;
+
+// Replaces the program, reloads the infos and calls the reload callbacks
+void setProgram(ShaderProgram* p, GLuint id)
+{
+    if (p->id != 0) {
+        deleteProgram(&p->id);
     }
+    clearProgramInfos(p);
+    p->id = id;
+    p->generation = ++programGenerationCounter;
     loadUniformInfos(p);
     loadAttribInfos(p);
 
-    // Call reload callbacks
-    loggf("Custom callback coutn: %d\n", p->reloadCallbacks.size());
     for (ShaderProgramReloadCallback callback : p->reloadCallbacks) {
         callback(p);
     }
 }
 
+// PARALLEL COMPILATION
+// ShaderPrograms are not built inside init or the file listener, they only submit a 
+// ProgramBuild and updateShaderCompiles (Once per tick) hands finished programs over.
+// With GL_KHR_parallel_shader_compile the driver compiles on its own threads 
+// (As many as it likes, which is the default of glMaxShaderCompilerThreadsKHR) and 
+// GL_COMPLETION_STATUS_KHR tells without waiting whether a build is done. Without the 
+// extension a build is checked one tick after it was submitted, the status query may wait there,
+// but all programs submitted in one tick are compiled back to back before the first wait.
+// The previous program stays bound until the new one linked, if the new one fails
+// (E.g. Typo during hot reload) the previous one is kept.
+// Programs that have not finished yet have id 0, draws using them are skipped.
+// File listeners only mark their programs dirty, updateShaderCompiles submits every dirty
+// program once, even if several of its files changed in the same tick.
+#define SHADER_COMPILER_MAX_BUILDS 32
+#define SHADER_COMPILER_MAX_DIRTY 64
+
+struct PendingProgram
+{
+    ShaderProgram* target;
+    ProgramBuild build;
+    u64 submitTick;
+};
+
+struct ShaderCompilerStats
+{
+    int submitted;
+    int cached; // Came from the program cache, no build needed
+    int finished;
+    int failed;
+    int maxPendingTicks; // Longest time from submit to finish
+};
+
+struct ShaderCompiler
+{
+    bool initialized;
+    bool parallel; // GL_KHR_parallel_shader_compile or GL_ARB_parallel_shader_compile
+    PendingProgram pending[SHADER_COMPILER_MAX_BUILDS];
+    int pendingCount;
+    ShaderProgram* dirty[SHADER_COMPILER_MAX_DIRTY]; // Submitted in the next updateShaderCompiles
+    int dirtyCount;
+    u64 tick;
+    ShaderCompilerStats stats;
+};
+
+ShaderCompiler shaderCompiler;
+
+void print(ShaderCompilerStats* s)
+{
+    loggf("ShaderCompiler: %d submitted, %d from cache, %d finished, %d failed, max %d ticks pending\n",
+            s->submitted, s->cached, s->finished, s->failed, s->maxPendingTicks);
+}
+
+// Lazy, the context must exist
+void initShaderCompiler()
+{
+    if (shaderCompiler.initialized) {
+        return;
+    }
+    memset(&shaderCompiler, 0, sizeof(ShaderCompiler));
+    shaderCompiler.initialized = true;
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (int i = 0; i < extensionCount; i++)
+    {
+        const char* extension = (const char*) glGetStringi(GL_EXTENSIONS, (GLuint)i);
+        if (strcmp(extension, "GL_KHR_parallel_shader_compile") == 0 ||
+            strcmp(extension, "GL_ARB_parallel_shader_compile") == 0) {
+            shaderCompiler.parallel = true;
+        }
+    }
+    loggf("Parallel shader compile: %s\n", shaderCompiler.parallel ? "TRUE" : "FALSE");
+}
+
+void finishPendingProgram(int index)
+{
+    PendingProgram* pending = &shaderCompiler.pending[index];
+    ShaderCompilerStats& stats = shaderCompiler.stats;
+    ShaderProgram* p = pending->target;
+    stats.maxPendingTicks = max(stats.maxPendingTicks, (int)(shaderCompiler.tick - pending->submitTick));
+
+    SCOPE_EXIT_ROLLBACK;
+    const char** filepaths = (const char**) tmpAlloc.alloc(p->filepaths.size() * sizeof(char*));
+    for (int i = 0; i < p->filepaths.size(); i++) {
+        filepaths[i] = p->filepaths[i].c_str();
+    }
+    GLuint id = endProgramBuild(&pending->build, filepaths);
+    if (id != 0) {
+        setProgram(p, id);
+        stats.finished++;
+    }
+    else {
+        loggf("Building program %s failed, keeping the previous program\n", filepaths[0]);
+        stats.failed++;
+    }
+    shaderCompiler.pending[index] = shaderCompiler.pending[--shaderCompiler.pendingCount];
+}
+
+// SHADER FILE DEPENDENCIES
+// Every file a program reads (Stages and includes) has one file listener, shared by all programs
+// that read it. A change resubmits exactly these programs, so editing a shared include only 
+// rebuilds the programs (And variants) using it. The dependencies are updated on every submit,
+// edits can add or remove includes.
+#define SHADER_MAX_FILES 128
+#define SHADER_FILE_MAX_USERS 64
+
+struct ShaderFile
+{
+    char path[SHADER_MAX_PATH]; // Empty if the slot is free
+    ListenerToken token;
+    ShaderProgram* users[SHADER_FILE_MAX_USERS];
+    int userCount;
+};
+
+ShaderFile shaderFiles[SHADER_MAX_FILES]; // Slots do not move, they are the listener user data
+
+void onShaderFileChanged(const char* filename, void* userData);
+
+bool isShaderFileUser(ShaderFile* f, ShaderProgram* p)
+{
+    for (int i = 0; i < f->userCount; i++) {
+        if (f->users[i] == p) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void addShaderFileUser(const char* path, ShaderProgram* p)
+{
+    ShaderFile* freeFile = nullptr;
+    for (ShaderFile& f : shaderFiles)
+    {
+        if (f.path[0] == 0) {
+            freeFile = freeFile == nullptr ? &f : freeFile;
+        }
+        else if (strcmp(f.path, path) == 0) {
+            if (!isShaderFileUser(&f, p)) {
+                assert(f.userCount < SHADER_FILE_MAX_USERS, "Too many programs use %s\n", path);
+                f.users[f.userCount++] = p;
+            }
+            return;
+        }
+    }
+    assert(freeFile != nullptr, "Too many shader files\n");
+    strcpy(freeFile->path, path);
+    freeFile->users[0] = p;
+    freeFile->userCount = 1;
+    freeFile->token = createFileListener(freeFile->path, &onShaderFileChanged, freeFile);
+}
+
+// Removes the program from all files that are not in keep (May be nullptr), 
+// listeners of files without users are deleted
+void removeShaderFileUser(ShaderProgram* p, const char** keep, int keepCount)
+{
+    for (ShaderFile& f : shaderFiles)
+    {
+        if (f.path[0] == 0 || !isShaderFileUser(&f, p)) {
+            continue;
+        }
+        bool kept = false;
+        for (int i = 0; i < keepCount; i++) {
+            kept = kept || strcmp(f.path, keep[i]) == 0;
+        }
+        if (kept) {
+            continue;
+        }
+        for (int i = 0; i < f.userCount; i++) {
+            if (f.users[i] == p) {
+                f.users[i] = f.users[--f.userCount];
+                break;
+            }
+        }
+        if (f.userCount == 0) {
+            deleteFileListener(f.token);
+            f.path[0] = 0;
+        }
+    }
+}
+
+// New files are added before old ones are removed, so the listener that triggered 
+// the submit is never deleted while it runs
+void setShaderFileUsers(ShaderProgram* p, int fileCount, const char** filepaths, ShaderIncludes* includes)
+{
+    const char* keep[MAX_SHADER_COUNT + SHADER_MAX_INCLUDES];
+    int keepCount = 0;
+    for (int i = 0; i < fileCount; i++) {
+        keep[keepCount++] = filepaths[i];
+    }
+    for (int i = 0; i < includes->count; i++) {
+        if (file_exists(includes->paths[i])) { // Missing includes are reported by the preprocessor
+            keep[keepCount++] = includes->paths[i];
+        }
+    }
+    for (int i = 0; i < keepCount; i++) {
+        addShaderFileUser(keep[i], p);
+    }
+    removeShaderFileUser(p, keep, keepCount);
+}
+
+// Drops the build of the program without finishing it
+void cancelShaderProgram(ShaderProgram* p)
+{
+    ShaderCompiler& c = shaderCompiler;
+    for (int i = 0; i < c.dirtyCount; i++) {
+        if (c.dirty[i] == p) {
+            c.dirty[i] = c.dirty[--c.dirtyCount];
+            break;
+        }
+    }
+    for (int i = 0; i < c.pendingCount; i++) {
+        if (c.pending[i].target == p) {
+            cancelProgramBuild(&c.pending[i].build);
+            c.pending[i] = c.pending[--c.pendingCount];
+            return;
+        }
+    }
+}
+
+// Builds the program from its files, the current program is used until the new one is done.
+// Returns false if the files could not be loaded
+bool submitShaderProgram(ShaderProgram* p)
+{
+    initShaderCompiler();
+    ShaderCompiler& c = shaderCompiler;
+    cancelShaderProgram(p); // A newer submit replaces a build that is still running
+
+    SCOPE_EXIT_ROLLBACK;
+    const char** filepaths = (const char**) tmpAlloc.alloc(p->filepaths.size() * sizeof(char*));
+    for (int i = 0; i < p->filepaths.size(); i++) {
+        filepaths[i] = p->filepaths[i].c_str();
+    }
+    ProgramBuild build;
+    ShaderIncludes includes;
+    bool submitted = beginProgramBuild(&build, p->filepaths.size(), filepaths, p->defines.c_str(), &includes);
+    setShaderFileUsers(p, p->filepaths.size(), filepaths, &includes);
+    if (!submitted) {
+        return false;
+    }
+    c.stats.submitted++;
+    if (build.shaderCount == 0) {
+        c.stats.cached++;
+        setProgram(p, build.program);
+        return true;
+    }
+
+    if (c.pendingCount == SHADER_COMPILER_MAX_BUILDS) {
+        finishPendingProgram(0);
+    }
+    PendingProgram& pending = c.pending[c.pendingCount++];
+    pending.target = p;
+    pending.build = build;
+    pending.submitTick = c.tick;
+    return true;
+}
+
+// Submits the program in the next updateShaderCompiles, once no matter how often it is marked
+void markShaderProgramDirty(ShaderProgram* p)
+{
+    initShaderCompiler();
+    ShaderCompiler& c = shaderCompiler;
+    for (int i = 0; i < c.dirtyCount; i++) {
+        if (c.dirty[i] == p) {
+            return;
+        }
+    }
+    if (c.dirtyCount == SHADER_COMPILER_MAX_DIRTY) {
+        submitShaderProgram(p);
+        return;
+    }
+    c.dirty[c.dirtyCount++] = p;
+}
+
+// Submits the dirty programs and hands over all builds the driver has finished, call once per tick
+void updateShaderCompiles()
+{
+    ShaderCompiler& c = shaderCompiler;
+    c.tick++;
+    // Submitting does not mark programs, the list can be walked directly
+    int dirtyCount = c.dirtyCount;
+    ShaderProgram* dirty[SHADER_COMPILER_MAX_DIRTY];
+    memcpy(dirty, c.dirty, sizeof(ShaderProgram*) * dirtyCount);
+    c.dirtyCount = 0;
+    for (int i = 0; i < dirtyCount; i++) {
+        submitShaderProgram(dirty[i]);
+    }
+    for (int i = c.pendingCount - 1; i >= 0; i--)
+    {
+        PendingProgram* pending = &c.pending[i];
+        if (c.parallel) {
+            GLint isDone = GL_FALSE;
+            glGetProgramiv(pending->build.program, GL_COMPLETION_STATUS_KHR, &isDone);
+            if (isDone == GL_FALSE) {
+                continue;
+            }
+        }
+        else if (pending->submitTick == c.tick) {
+            continue;
+        }
+        finishPendingProgram(i);
+    }
+}
+
+// Waits for all builds (E.g. If the programs are needed right away)
+void finishShaderCompiles()
+{
+    while (shaderCompiler.pendingCount > 0) {
+        finishPendingProgram(shaderCompiler.pendingCount - 1);
+    }
+}
+
+void onShaderFileChanged(const char* filename, void* userData)
+{
+    ShaderFile* f = (ShaderFile*) userData;
+    loggf("On shader file changed: %s (%d programs)\n", filename, f->userCount);
+
+    for (int i = 0; i < f->userCount; i++) {
+        markShaderProgramDirty(f->users[i]);
+    }
+}
+
+// The program is built in the background (See PARALLEL COMPILATION), id stays 0 until 
+// updateShaderCompiles finished it, unless it was in the program cache.
+// Defines are injected into every stage (See shaderPreprocessor.hpp), 
+// returns false if the shader files are invalid.
 bool init(ShaderProgram* p, std::initializer_list<const char*> filenames, 
-        Allocator* allocator)
+        Allocator* allocator, const char* defines = nullptr)
 {
     assert(filenames.size() < MAX_SHADER_COUNT, "Max shader count!\n");
 
     // Init members
-    p->tokens.init(allocator, (int)filenames.size());
+    p->id = 0;
+    p->generation = ++programGenerationCounter;
+    char normalized[SHADER_MAX_DEFINES_LENGTH];
+    normalizeDefines(defines, normalized);
+    p->defines.init(allocator, normalized);
     p->reloadCallbacks.init(allocator, 0);
     p->uniformInfos.init(allocator, 0);
     p->attribInfos.init(allocator, 0);
     p->filepaths.init(allocator, 0);
     p->alloc = allocator;
     
-    // Add file listeners
     for (const char* filename : filenames)
     {
         String filepath;
-        filepath.init(p->alloc, "ressources/shaders/");
+        filepath.init(p->alloc, SHADER_DIR);
         filepath.cat(filename);
         p->filepaths.push_back(filepath);
-        ListenerToken token = 
-            createFileListener(filepath.c_str(), &onShaderFileChanged, p);
-        p->tokens.push_back(token);
-    }
-
-    // Compile program
-    SCOPE_EXIT_ROLLBACK;
-    char** filepaths = (char**)tmpAlloc.alloc(p->filepaths.size() * sizeof(char**));
-    for(int i = 0; i < p->filepaths.size(); i++) {
-        filepaths[i] = p->filepaths[i].c_str();
-    }
-    p->id = createShaderProgram(p->filepaths.size(), (const char**)filepaths);
-
-    // Load infos if compilation was succesfull
-    if (p->id == 0) {
-        return false;
     }
-    loadUniformInfos(p);
-    loadAttribInfos(p);
 
-    return true;
+    return submitShaderProgram(p);
 }
 
 void shutdown(ShaderProgram* p)
 {
+    cancelShaderProgram(p);
     if (p->id != 0) {
-        glDeleteProgram(p->id);
-    }
-    // Remove file listeners
-    for (ListenerToken& t : p->tokens) {
-        deleteFileListener(t);
+        deleteProgram(&p->id);
     }
-    p->tokens.shutdown();
+    removeShaderFileUser(p, nullptr, 0);
+    p->defines.shutdown();
     // Dealloc filenames
     for (String& str : p->filepaths) {
         str.shutdown();
     }
     p->filepaths.shutdown();
-    // Dealloc uniform infos
-    for (UniformInfo& info : p->uniformInfos) {
-        p->alloc->dealloc(info.nameBlk);       
-    }
+    // Dealloc infos
+    clearProgramInfos(p);
     p->uniformInfos.shutdown();
-    // Dealloc attribute infos
-    for (AttribInfo& info : p->attribInfos) {
-        p->alloc->dealloc(info.nameBlk);       
-    }
     p->attribInfos.shutdown();
     p->reloadCallbacks.shutdown();
 }
@@ -396,10 +802,10 @@ GLuint getAttribLocation(ShaderProgram* p, const char* name)
     return 0;
 }
 
-UniformInfo* getUniformInfo(ShaderProgram* p, const char* name)
+UniformInfo* getUniformInfo(ShaderProgram* p, u32 nameHash, const char* name)
 {
     for (UniformInfo& info : p->uniformInfos) {
-        if (strcmp(info.name, name) == 0) {
+        if (info.nameHash == nameHash && strcmp(info.name, name) == 0) {
             return &info;
         }
     }
@@ -407,6 +813,10 @@ UniformInfo* getUniformInfo(ShaderProgram* p, const char* name)
     return nullptr;
 }
 
+UniformInfo* getUniformInfo(ShaderProgram* p, const char* name) {
+    return getUniformInfo(p, hashUniformName(name), name);
+}
+
 #define GEN_UNIFORM_SETTER(dataType, glType, setter) \
     void setUniform(ShaderProgram* p, const char* name, dataType t) \
 { \
@@ -434,6 +844,93 @@ GEN_UNIFORM_SETTER(const mat4&, GL_FLOAT_MAT4, glUniformMatrix4fv(info->location
 
 #undef GEN_UNIFORM_SETTER
 
+// UNIFORM HANDLES
+// setUniform by name searches the uniform infos on every call, a UniformHandle looks the uniform up
+// once and keeps the location together with the generation of the program. New programs 
+// (Hot reload, async build finished) get a new generation, the next set then resolves again.
+// Steady state sets do no string work, just the generation compare and the glUniform call.
+//
+//     UniformHandle<vec3> albedo;
+//     init(&albedo, &program, "u_albedo"); // Once, name must stay valid (Literal)
+//     setUniform(&albedo, color);           // Every draw
+//
+// The type is checked when resolving, handles of uniforms the program does not have do nothing.
+template<typename T> struct UniformGLType;
+
+#define GEN_UNIFORM_UPLOAD(dataType, glType, setter) \
+template<> struct UniformGLType<dataType> { static const GLenum value = glType; }; \
+void uploadUniform(GLint location, const dataType& t) { setter; }
+
+GEN_UNIFORM_UPLOAD(int, GL_INT, glUniform1i(location, t));
+GEN_UNIFORM_UPLOAD(u32, GL_UNSIGNED_INT, glUniform1ui(location, t));
+GEN_UNIFORM_UPLOAD(float, GL_FLOAT, glUniform1f(location, t));
+GEN_UNIFORM_UPLOAD(vec2, GL_FLOAT_VEC2, glUniform2fv(location, 1, (GLfloat*) &t));
+GEN_UNIFORM_UPLOAD(vec3, GL_FLOAT_VEC3, glUniform3fv(location, 1, (GLfloat*) &t));
+GEN_UNIFORM_UPLOAD(vec4, GL_FLOAT_VEC4, glUniform4fv(location, 1, (GLfloat*) &t));
+GEN_UNIFORM_UPLOAD(mat2, GL_FLOAT_MAT2, glUniformMatrix2fv(location, 1, GL_FALSE, (GLfloat*) &t));
+GEN_UNIFORM_UPLOAD(mat3, GL_FLOAT_MAT3, glUniformMatrix3fv(location, 1, GL_FALSE, (GLfloat*) &t));
+GEN_UNIFORM_UPLOAD(mat4, GL_FLOAT_MAT4, glUniformMatrix4fv(location, 1, GL_FALSE, (GLfloat*) &t));
+
+#undef GEN_UNIFORM_UPLOAD
+
+template<typename T>
+struct UniformHandle
+{
+    ShaderProgram* program;
+    const char* name;
+    u32 nameHash;
+    u32 generation; // Of the program when location was resolved
+    GLint location; // -1 if the program has no such uniform
+    GLenum type;
+};
+
+template<typename T>
+void resolveUniform(UniformHandle<T>* h)
+{
+    h->generation = h->program->generation;
+    h->location = -1;
+    UniformInfo* info = getUniformInfo(h->program, h->nameHash, h->name);
+    if (info == nullptr) {
+        return;
+    }
+    // Samplers (Value 0) are checked against the texture when set
+    if (UniformGLType<T>::value != 0 && info->type != UniformGLType<T>::value) {
+        loggf("Uniform \"%s\" type did not match\n", h->name);
+        return;
+    }
+    h->location = info->location;
+    h->type = info->type;
+}
+
+template<typename T>
+void init(UniformHandle<T>* h, ShaderProgram* p, const char* name)
+{
+    h->program = p;
+    h->name = name;
+    h->nameHash = hashUniformName(name);
+    resolveUniform(h);
+}
+
+// Returns false if the program has no such uniform (Yet)
+template<typename T>
+bool isValid(UniformHandle<T>* h)
+{
+    if (h->generation != h->program->generation) {
+        resolveUniform(h);
+    }
+    return h->location != -1;
+}
+
+template<typename T>
+void setUniform(UniformHandle<T>* h, const T& value)
+{
+    if (!isValid(h)) {
+        return;
+    }
+    bindProgram(h->program->id);
+    uploadUniform(h->location, value);
+}
+
 
 
 
@@ -0,0 +1,192 @@
+#ifndef __SPRITE_BATCH_HPP__
+#define __SPRITE_BATCH_HPP__
+
+// --------------------
+// --- SPRITE BATCH ---
+// --------------------
+// Screen space quads (Sprites, ui) textured from a TextureAtlas. draw() only records
+// the quad, render() writes all quads of the tick into a StreamBuffer grouped by atlas page
+// and issues one texture bind and one glDrawArrays per page, independent of the number
+// of different images. Positions are in pixels, (0, 0) is the bottom left corner.
+//
+// Uses ressources/shaders/sprite.vert/.frag, drawn with alpha blending and without depth test,
+// both are left disabled afterwards.
+
+#include "textureAtlas.hpp"
+#include "streamBuffer.hpp"
+
+#define SPRITE_BATCH_MAX_SPRITES 8192
+#define SPRITE_VERTEX_BINDING 0
+
+struct SpriteVertex
+{
+    vec2 pos;
+    vec2 uv;
+    vec4 color;
+};
+
+struct Sprite
+{
+    vec2 min;
+    vec2 max;
+    vec2 uvMin;
+    vec2 uvMax;
+    vec4 color;
+    int page;
+};
+
+struct SpriteBatchStats
+{
+    int sprites;
+    int draws;
+    int textureBinds;
+    int dropped; // Sprites over SPRITE_BATCH_MAX_SPRITES
+};
+
+struct SpriteBatch
+{
+    ShaderProgram program;
+    UniformHandle<vec2> screenSizeUniform;
+    UniformHandle<Texture*> atlasUniform;
+    GLuint vao;
+    StreamBuffer vertexStream;
+    DynArr<Sprite> sprites;
+    TextureAtlas* atlas;
+    SpriteBatchStats stats; // Of the last render
+    int dropped; // Of the current tick
+};
+
+void print(SpriteBatchStats* s)
+{
+    loggf("SpriteBatch: %d sprites, %d draws, %d texture binds, %d dropped\n",
+            s->sprites, s->draws, s->textureBinds, s->dropped);
+}
+
+void init(SpriteBatch* b, TextureAtlas* atlas, Allocator* alloc)
+{
+    memset(&b->stats, 0, sizeof(SpriteBatchStats));
+    b->atlas = atlas;
+    b->dropped = 0;
+    b->sprites.init(alloc, 256);
+    init(&b->program, {"sprite.vert", "sprite.frag"}, alloc);
+    init(&b->screenSizeUniform, &b->program, "u_screenSize");
+    init(&b->atlasUniform, &b->program, "atlas");
+    init(&b->vertexStream, GL_ARRAY_BUFFER,
+            SPRITE_BATCH_MAX_SPRITES * 6 * sizeof(SpriteVertex) * STREAM_BUFFER_FRAMES, alloc);
+
+    // Vertex format only, the buffer range is bound in render
+    glGenVertexArrays(1, &b->vao);
+    assert(b->vao != 0, "glGenVertexArrays failed!\n");
+    bindVao(b->vao);
+    glVertexAttribFormat(0, 2, GL_FLOAT, GL_FALSE, offsetof(SpriteVertex, pos));
+    glVertexAttribFormat(1, 2, GL_FLOAT, GL_FALSE, offsetof(SpriteVertex, uv));
+    glVertexAttribFormat(2, 4, GL_FLOAT, GL_FALSE, offsetof(SpriteVertex, color));
+    for (int i = 0; i < 3; i++) {
+        glVertexAttribBinding(i, SPRITE_VERTEX_BINDING);
+        glEnableVertexAttribArray(i);
+    }
+    bindVao(0);
+}
+
+void shutdown(SpriteBatch* b)
+{
+    deleteVao(&b->vao);
+    shutdown(&b->vertexStream);
+    shutdown(&b->program);
+    b->sprites.shutdown();
+}
+
+void draw(SpriteBatch* b, const AtlasRegion& region, const vec2& pos, const vec2& size, const vec4& color = vec4(1.0f))
+{
+    if (b->sprites.size() == SPRITE_BATCH_MAX_SPRITES) {
+        b->dropped++;
+        return;
+    }
+    Sprite s;
+    s.min = pos;
+    s.max = pos + size;
+    s.uvMin = region.uvMin;
+    s.uvMax = region.uvMax;
+    s.color = color;
+    s.page = region.page;
+    b->sprites.push_back(s);
+}
+
+// Draws the image with its pixel size
+void draw(SpriteBatch* b, const AtlasRegion& region, const vec2& pos, const vec4& color = vec4(1.0f)) {
+    draw(b, region, pos, vec2((float)region.width, (float)region.height), color);
+}
+
+void writeSpriteVertices(Sprite* s, SpriteVertex* v)
+{
+    vec2 corners[6] = {
+        vec2(0, 0), vec2(1, 0), vec2(1, 1),
+        vec2(0, 0), vec2(1, 1), vec2(0, 1)
+    };
+    for (int i = 0; i < 6; i++) {
+        vec2 c = corners[i];
+        v[i].pos = vec2(lerp(s->min.x, s->max.x, c.x), lerp(s->min.y, s->max.y, c.y));
+        v[i].uv = vec2(lerp(s->uvMin.x, s->uvMax.x, c.x), lerp(s->uvMin.y, s->uvMax.y, c.y));
+        v[i].color = s->color;
+    }
+}
+
+// Draws and clears all recorded sprites
+void render(SpriteBatch* b, int screenWidth, int screenHeight)
+{
+    SpriteBatchStats& stats = b->stats;
+    memset(&stats, 0, sizeof(SpriteBatchStats));
+    stats.dropped = b->dropped;
+    b->dropped = 0;
+    int count = b->sprites.size();
+    if (count == 0 || b->program.id == 0) { // Program may still be compiling
+        b->sprites.reset();
+        return;
+    }
+    stats.sprites = count;
+
+    // Counting sort by page, straight into the stream buffer
+    int pageStart[TEXTURE_ATLAS_MAX_PAGES + 1];
+    memset(pageStart, 0, sizeof(pageStart));
+    for (Sprite& s : b->sprites) {
+        pageStart[s.page + 1]++;
+    }
+    for (int i = 0; i < TEXTURE_ATLAS_MAX_PAGES; i++) {
+        pageStart[i + 1] += pageStart[i];
+    }
+    int pageHead[TEXTURE_ATLAS_MAX_PAGES];
+    memcpy(pageHead, pageStart, sizeof(pageHead));
+
+    StreamRange range = allocate(&b->vertexStream, count * 6 * sizeof(SpriteVertex), sizeof(SpriteVertex));
+    SpriteVertex* vertices = (SpriteVertex*) range.data;
+    for (Sprite& s : b->sprites) {
+        writeSpriteVertices(&s, &vertices[pageHead[s.page]++ * 6]);
+    }
+    commit(&b->vertexStream, range);
+
+    setDepthTest(false);
+    setBlending(true);
+    setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    bind(&b->program);
+    bindVao(b->vao);
+    setUniform(&b->screenSizeUniform, vec2((float)screenWidth, (float)screenHeight));
+    glBindVertexBuffer(SPRITE_VERTEX_BINDING, range.buffer, range.offset, sizeof(SpriteVertex));
+    for (int page = 0; page < TEXTURE_ATLAS_MAX_PAGES; page++)
+    {
+        int pageCount = pageStart[page + 1] - pageStart[page];
+        if (pageCount == 0) {
+            continue;
+        }
+        setUniform(&b->atlasUniform, getPageTexture(b->atlas, page));
+        glDrawArrays(GL_TRIANGLES, pageStart[page] * 6, pageCount * 6);
+        stats.textureBinds++;
+        stats.draws++;
+    }
+    setBlending(false);
+
+    b->sprites.reset();
+}
+
+
+
+#endif
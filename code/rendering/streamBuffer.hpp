@@ -0,0 +1,228 @@
+#ifndef __STREAM_BUFFER_HPP__
+#define __STREAM_BUFFER_HPP__
+
+// ---------------------
+// --- STREAM BUFFER ---
+// ---------------------
+// Ring buffer for data that changes every frame (Instance data, debug lines, particles...).
+// The buffer is split into STREAM_BUFFER_FRAMES regions, each game tick writes into the
+// next region. A fence per region makes sure the gpu is done reading it before it gets
+// overwritten, if the cpu has to wait for it this is counted as a stall.
+//
+// If glBufferStorage is available the buffer is persistently and coherently mapped and
+// allocations are written in place. Otherwise allocations point into a cpu copy and
+// commit uploads them with glBufferSubData.
+//
+// If a tick needs more than one region, the buffer is replaced by one with larger regions
+// (See growStreamBuffer), so the size passed to init is a starting point, not a limit.
+// Ranges must be committed before the next allocate.
+
+#include "renderState.hpp"
+
+#define STREAM_BUFFER_FRAMES 3
+
+struct StreamBufferStats
+{
+    int allocations;
+    int bytes;
+    int stalls;
+    int grows;
+};
+
+// Sub range of the stream buffer, valid until the end of the tick
+struct StreamRange
+{
+    GLuint buffer;
+    int offset;
+    int size;
+    void* data; // Write here, then commit
+};
+
+struct StreamBuffer
+{
+    GLuint buffer;
+    GLenum target;
+    int size;
+    int regionSize;
+    bool persistent;
+    byte* data; // Persistent mapping or cpu copy
+    Blk cpuCopy;
+    // Ring state
+    int region;
+    int head; // Offset inside the current region
+    int tick; // Tick of the current region
+    GLsync fences[STREAM_BUFFER_FRAMES];
+    // Stats
+    StreamBufferStats stats; // Of the current tick
+    StreamBufferStats lastTick;
+    int totalStalls;
+    Allocator* alloc;
+};
+
+void print(StreamBufferStats* s)
+{
+    loggf("StreamBuffer: %d allocations, %d bytes, %d stalls, %d grows\n", 
+            s->allocations, s->bytes, s->stalls, s->grows);
+}
+
+void createStreamStorage(StreamBuffer* s, int regionSize)
+{
+    s->regionSize = regionSize;
+    s->size = regionSize * STREAM_BUFFER_FRAMES;
+    s->region = 0;
+    s->head = 0;
+
+    glGenBuffers(1, &s->buffer);
+    assert(s->buffer != 0, "glGenBuffers failed on stream buffer\n");
+    bindBuffer(s->target, s->buffer);
+    if (s->persistent)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(s->target, s->size, nullptr, flags);
+        s->data = (byte*) glMapBufferRange(s->target, 0, s->size, flags);
+        assert(s->data != nullptr, "Persistent mapping of stream buffer failed\n");
+    }
+    else
+    {
+        glBufferData(s->target, s->size, nullptr, GL_STREAM_DRAW);
+        s->cpuCopy = s->alloc->alloc(s->size);
+        s->data = (byte*) s->cpuCopy.data;
+    }
+    bindBuffer(s->target, 0);
+}
+
+void init(StreamBuffer* s, GLenum target, int size, Allocator* alloc)
+{
+    *s = StreamBuffer();
+    s->target = target;
+    s->persistent = glBufferStorage != NULL;
+    s->tick = -1;
+    s->alloc = alloc;
+    createStreamStorage(s, size / STREAM_BUFFER_FRAMES);
+}
+
+void shutdown(StreamBuffer* s)
+{
+    for (int i = 0; i < STREAM_BUFFER_FRAMES; i++) {
+        if (s->fences[i] != nullptr) {
+            glDeleteSync(s->fences[i]);
+            s->fences[i] = nullptr;
+        }
+    }
+    if (s->persistent) {
+        bindBuffer(s->target, s->buffer);
+        glUnmapBuffer(s->target);
+        bindBuffer(s->target, 0);
+    }
+    else {
+        s->alloc->dealloc(s->cpuCopy);
+    }
+    deleteBuffer(&s->buffer);
+}
+
+// Fences the finished region and waits until the gpu is done with the next one
+void advanceRegion(StreamBuffer* s)
+{
+    s->lastTick = s->stats;
+    memset(&s->stats, 0, sizeof(StreamBufferStats));
+    s->tick = renderState.tickCounter;
+    if (!s->persistent) {
+        s->head = 0; // glBufferSubData is synchronized by the driver
+        return;
+    }
+
+    s->fences[s->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    s->region = (s->region + 1) % STREAM_BUFFER_FRAMES;
+    s->head = 0;
+
+    GLsync fence = s->fences[s->region];
+    if (fence == nullptr) {
+        return;
+    }
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED)
+    {
+        // Cpu is STREAM_BUFFER_FRAMES ticks ahead of the gpu
+        s->stats.stalls++;
+        s->totalStalls++;
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+    }
+    assert(result != GL_WAIT_FAILED, "glClientWaitSync failed on stream buffer fence\n");
+    glDeleteSync(fence);
+    s->fences[s->region] = nullptr;
+}
+
+// Replaces the buffer with one whose regions hold at least minRegionSize bytes, the current
+// tick continues in its first region. Draws that were already issued keep reading the old
+// buffer, gl deletes it once they are done.
+void growStreamBuffer(StreamBuffer* s, int minRegionSize)
+{
+    int regionSize = max(s->regionSize, 1024);
+    while (regionSize < minRegionSize) {
+        assert(regionSize < (1 << 28), "Stream buffer too large\n");
+        regionSize *= 2;
+    }
+    StreamBufferStats stats = s->stats;
+    shutdown(s);
+    createStreamStorage(s, regionSize);
+    s->stats = stats;
+    s->stats.grows++;
+}
+
+// Returns a range of size bytes, the offset is a multiple of alignment (Need not be a power of 2)
+StreamRange allocate(StreamBuffer* s, int size, int alignment = 16)
+{
+    if (s->tick != renderState.tickCounter) {
+        advanceRegion(s);
+    }
+
+    int regionStart = s->region * s->regionSize;
+    int offset = regionStart + s->head;
+    offset = ((offset + alignment - 1) / alignment) * alignment;
+    if (offset + size > regionStart + s->regionSize)
+    {
+        // Sized for everything this tick allocated so far, so the next ticks fit in one region
+        growStreamBuffer(s, 2 * (s->head + size + alignment));
+        regionStart = 0;
+        offset = 0;
+    }
+    s->head = offset + size - regionStart;
+    s->stats.allocations++;
+    s->stats.bytes += size;
+
+    StreamRange range;
+    range.buffer = s->buffer;
+    range.offset = offset;
+    range.size = size;
+    range.data = s->data + offset;
+    return range;
+}
+
+// Bytes that can still be allocated this tick
+int getFreeBytes(StreamBuffer* s, int alignment = 16)
+{
+    if (s->tick != renderState.tickCounter) {
+        return s->regionSize;
+    }
+    int regionStart = s->region * s->regionSize;
+    int offset = ((regionStart + s->head + alignment - 1) / alignment) * alignment;
+    return max(0, regionStart + s->regionSize - offset);
+}
+
+// Makes the written data of the range visible to gl, nothing to do if persistently mapped
+void commit(StreamBuffer* s, const StreamRange& range)
+{
+    if (s->persistent) {
+        return;
+    }
+    bindBuffer(s->target, s->buffer);
+    glBufferSubData(s->target, range.offset, range.size, range.data);
+    // A bound unpack buffer would redirect all later texture uploads
+    if (s->target == GL_PIXEL_UNPACK_BUFFER) {
+        bindBuffer(s->target, 0);
+    }
+}
+
+
+
+#endif
@@ -2,6 +2,7 @@
 #define __TEXTURE_HPP__
 
 #include "renderer.hpp"
+#include "textureFile.hpp"
 #include "stb_image.h"
 
 // -------------------
@@ -102,8 +103,9 @@ void setFilterMode(Texture* tex, const TextureFilterMode& mode)
 
 // Multiple ways exist to create a texture:
 //  1. Initialize it with TextureData (May be generated by the cpu)
-//  2. Call with a filename, which loads the texture from ressources/textures/
-//  3. Call with just width height and format, which initializes an empty texture (E.g. for framebuffers)
+//  2. Initialize it with a cooked TextureFile (Mip chain is uploaded from the file mapping)
+//  3. Call with a filename, which loads the texture from ressources/textures/ (Cooked if available)
+//  4. Call with just width height and format, which initializes an empty texture (E.g. for framebuffers)
 
 // Calls with texData
 void init(Texture* tex, TextureData* texData, const TextureFilterMode& filterMode) 
@@ -163,9 +165,73 @@ void init(Texture* tex, TextureData* texData) {
     init(tex, texData, TextureFilterMode(GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_REPEAT, GL_REPEAT));
 }
 
-// Calls with filename
+// Calls with a cooked file, the file may be shut down afterwards
+void init(Texture* tex, TextureFile* file, const TextureFilterMode& filterMode)
+{
+    TextureFileHeader* h = file->header;
+    const TextureFormatInfo& info = textureFormatInfoTable[h->format];
+    tex->width = h->width;
+    tex->height = h->height;
+    tex->internalFormat = (h->srgb && TEXTURE_SRGB_SAMPLING) ? info.srgbInternalFormat : info.internalFormat;
+    tex->format = info.format;
+    tex->samplerType = GL_SAMPLER_2D;
+
+    glGenTextures(1, &tex->id);
+    assert(tex->id != 0, "glGenTextures failed!\n");
+    bindTexture2D(tex->id);
+
+    // Rows of small levels are not 4 byte aligned
+    setUnpackAlignment(1);
+    for (u32 i = 0; i < h->levelCount; i++)
+    {
+        TextureFileLevel& level = h->levels[i];
+        if (info.blockBytes != 0) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, i, tex->internalFormat,
+                    level.width, level.height, 0, (GLsizei)level.size, getLevelData(file, i));
+        }
+        else {
+            glTexImage2D(GL_TEXTURE_2D, i, tex->internalFormat,
+                    level.width, level.height, 0, tex->format, GL_UNSIGNED_BYTE, getLevelData(file, i));
+        }
+    }
+    setUnpackAlignment(4);
+
+    // A file without a full chain must not sample the missing levels
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, h->levelCount - 1);
+    tex->mipmapped = true;
+    setFilterMode(tex, filterMode);
+}
+
+#define TEXTURE_MAX_PATH 256
+
+// ressources/textures/name with the extension replaced by .tex
+void getCookedTexturePath(char* buffer, const char* name)
+{
+    snprintf(buffer, TEXTURE_MAX_PATH, "ressources/textures/%s", name);
+    char* dot = strrchr(buffer, '.');
+    if (dot != nullptr && strchr(dot, '/') == nullptr) {
+        *dot = '\0';
+    }
+    assert(strlen(buffer) + 4 < TEXTURE_MAX_PATH, "Texture path too long: %s\n", name);
+    strcat(buffer, ".tex");
+}
+
+// Calls with filename, prefers the cooked file (Run code/textureCooker on the ressources)
 void init(Texture* texture, const char* filepath, const TextureFilterMode& filterMode, Allocator* alloc) 
 {
+    char cookedPath[TEXTURE_MAX_PATH];
+    getCookedTexturePath(cookedPath, filepath);
+    if (file_exists(cookedPath))
+    {
+        TextureFile file;
+        if (load(&file, cookedPath)) {
+            SCOPE_EXIT(shutdown(&file););
+            init(texture, &file, filterMode);
+            return;
+        }
+    }
+    loggf("Texture %s is not cooked, decoding it with stb_image\n", filepath);
+
     // Load image from filepath
     TextureData tmpTexData;
     init(&tmpTexData, filepath, alloc);
@@ -196,10 +262,14 @@ void init(Texture* tex, int width, int height, GLenum internalFormat, const Text
     switch (tex->internalFormat)
     {
         // Fall-through
-        case GL_R:
+        case GL_RED:
         case GL_RG:
         case GL_RGB:
         case GL_RGBA:
+        case GL_R8:
+        case GL_RG8:
+        case GL_RGB8:
+        case GL_RGBA8:
         case GL_R16F:
         case GL_RG16F:
         case GL_RGB16F:
@@ -211,6 +281,7 @@ void init(Texture* tex, int width, int height, GLenum internalFormat, const Text
             format = GL_RGBA;
             break;
         case GL_DEPTH_COMPONENT:
+        case GL_DEPTH_COMPONENT24:
             format = GL_DEPTH_COMPONENT;
             break;
         case GL_DEPTH_STENCIL:
@@ -259,7 +330,7 @@ void resize(Texture* texture, int width, int height)
 }
 
 void shutdown(Texture* tex) {
-    glDeleteTextures(1, &tex->id);
+    deleteTexture(&tex->id);
 }
 
 void setUniform(ShaderProgram* p, const char* name, Texture* t)
@@ -280,5 +351,21 @@ void setUniform(AutoShaderProgram* p, const char* name, Texture* t) {
     setUniform(&p->program, name, t);
 }
 
+// The sampler type depends on the texture, it is checked in setUniform
+template<> struct UniformGLType<Texture*> { static const GLenum value = 0; };
+
+void setUniform(UniformHandle<Texture*>* h, Texture* t)
+{
+    if (!isValid(h)) {
+        return;
+    }
+    if (h->type != t->samplerType) {
+        loggf("Uniform \"%s\" type did not match\n", h->name);
+        return;
+    }
+    bindProgram(h->program->id);
+    glUniform1i(h->location, bind(t));
+}
+
 
 #endif
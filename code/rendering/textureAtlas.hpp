@@ -0,0 +1,373 @@
+#ifndef __TEXTURE_ATLAS_HPP__
+#define __TEXTURE_ATLAS_HPP__
+
+// ---------------------
+// --- TEXTURE ATLAS ---
+// ---------------------
+// Packs many small images (Sprites, icons, glyphs...) into a few large RGBA pages, so
+// drawing them needs one texture bind per page instead of one per image (See spriteBatch.hpp).
+//
+// Pages are packed with a bottom-left skyline: the skyline stores the top edge of the
+// already placed rects as horizontal segments, a new rect goes to the position where
+// its top ends lowest. Images can be inserted at any time, a new page is created
+// if no existing page has room. Call update() once per tick to rebuild the mips
+// of the pages that changed.
+//
+// Mip safe gutters: rects are aligned to 2^(mipLevels-1) texels and surrounded by a gutter
+// of the same size, filled with the replicated edge pixels of the image. So up to
+// the last mip level texels never mix two images and bilinear filtering at the border
+// only sees the image itself. Levels above that are disabled with GL_TEXTURE_MAX_LEVEL.
+
+#include "texture.hpp"
+#include "renderQueue.hpp"
+
+#define TEXTURE_ATLAS_MAX_PAGES 16
+#define TEXTURE_ATLAS_DEFAULT_PAGE_SIZE 1024
+#define TEXTURE_ATLAS_DEFAULT_MIP_LEVELS 4
+
+// Horizontal segment of the skyline, segments are sorted by x and cover the whole page width
+struct SkylineNode
+{
+    int x;
+    int y;
+    int width;
+};
+
+struct AtlasPage
+{
+    Texture texture;
+    DynArr<SkylineNode> skyline;
+    int usedArea; // Including gutters
+    bool dirty; // Mips are out of date
+};
+
+// Where an inserted image ended up, the rects exclude the gutter
+struct AtlasRegion
+{
+    int page;
+    int x;
+    int y;
+    int width;
+    int height;
+    vec2 uvMin;
+    vec2 uvMax;
+};
+
+struct TextureAtlasStats
+{
+    int images;
+    int uploadedBytes;
+    int mipRebuilds;
+    int failed; // Images that did not fit into a page
+};
+
+struct TextureAtlas
+{
+    AtlasPage pages[TEXTURE_ATLAS_MAX_PAGES]; // Fixed, so page textures do not move
+    int pageCount;
+    int pageSize;
+    int mipLevels;
+    int gutter; // Also the alignment of rects
+    TextureFilterMode filterMode;
+    TextureAtlasStats stats;
+    Allocator* alloc;
+};
+
+void init(TextureAtlas* a, int pageSize, int mipLevels, Allocator* alloc)
+{
+    assert(mipLevels >= 1 && (1 << (mipLevels - 1)) < pageSize, "Invalid atlas mip level count %d\n", mipLevels);
+    *a = TextureAtlas();
+    a->pageSize = pageSize;
+    a->mipLevels = mipLevels;
+    a->gutter = 1 << (mipLevels - 1);
+    a->alloc = alloc;
+    // Clamped, the gutter takes care of the borders
+    GLint minFilter = mipLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR;
+    a->filterMode = TextureFilterMode(minFilter, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+}
+
+void init(TextureAtlas* a, Allocator* alloc) {
+    init(a, TEXTURE_ATLAS_DEFAULT_PAGE_SIZE, TEXTURE_ATLAS_DEFAULT_MIP_LEVELS, alloc);
+}
+
+void shutdown(TextureAtlas* a)
+{
+    for (int i = 0; i < a->pageCount; i++) {
+        shutdown(&a->pages[i].texture);
+        a->pages[i].skyline.shutdown();
+    }
+    a->pageCount = 0;
+}
+
+Texture* getPageTexture(TextureAtlas* a, int page) {
+    assert(page >= 0 && page < a->pageCount, "Atlas page %d does not exist\n", page);
+    return &a->pages[page].texture;
+}
+
+// Used area of all pages in [0, 1]
+float getOccupancy(TextureAtlas* a)
+{
+    if (a->pageCount == 0) {
+        return 0.0f;
+    }
+    u64 used = 0;
+    for (int i = 0; i < a->pageCount; i++) {
+        used += a->pages[i].usedArea;
+    }
+    return (float)used / ((u64)a->pageSize * a->pageSize * a->pageCount);
+}
+
+void print(TextureAtlas* a)
+{
+    loggf("TextureAtlas: %d images on %d pages (%dx%d), %.1f%% used, %d failed\n",
+            a->stats.images, a->pageCount, a->pageSize, a->pageSize,
+            getOccupancy(a) * 100.0f, a->stats.failed);
+}
+
+AtlasPage* addPage(TextureAtlas* a)
+{
+    if (a->pageCount == TEXTURE_ATLAS_MAX_PAGES) {
+        return nullptr;
+    }
+    AtlasPage* page = &a->pages[a->pageCount++];
+    *page = AtlasPage();
+    page->skyline.init(a->alloc, 16);
+    SkylineNode root = {0, 0, a->pageSize};
+    page->skyline.push_back(root);
+
+    init(&page->texture, a->pageSize, a->pageSize, GL_RGBA, a->filterMode);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, a->mipLevels - 1);
+    return page;
+}
+
+// Returns the y where a rect of width starting at node index would sit, -1 if it does not fit
+int fitSkyline(AtlasPage* page, int index, int width, int height, int pageSize)
+{
+    DynArr<SkylineNode>& skyline = page->skyline;
+    int x = skyline[index].x;
+    if (x + width > pageSize) {
+        return -1;
+    }
+    int y = 0;
+    int widthLeft = width;
+    for (int i = index; widthLeft > 0; i++) {
+        y = max(y, skyline[i].y);
+        widthLeft -= skyline[i].width;
+    }
+    if (y + height > pageSize) {
+        return -1;
+    }
+    return y;
+}
+
+// Lowest top edge wins, ties go to the narrower segment (Less wasted space below the rect)
+bool findSkylinePosition(AtlasPage* page, int width, int height, int pageSize, int* outIndex, int* outX, int* outY)
+{
+    int bestTop = pageSize + 1;
+    int bestWidth = pageSize + 1;
+    int bestIndex = -1;
+    DynArr<SkylineNode>& skyline = page->skyline;
+    for (int i = 0; i < skyline.size(); i++)
+    {
+        int y = fitSkyline(page, i, width, height, pageSize);
+        if (y < 0) {
+            continue;
+        }
+        int top = y + height;
+        if (top < bestTop || (top == bestTop && skyline[i].width < bestWidth)) {
+            bestTop = top;
+            bestWidth = skyline[i].width;
+            bestIndex = i;
+        }
+    }
+    if (bestIndex < 0) {
+        return false;
+    }
+    *outIndex = bestIndex;
+    *outX = skyline[bestIndex].x;
+    *outY = bestTop - height;
+    return true;
+}
+
+// Raises the skyline under the placed rect
+void addSkylineLevel(AtlasPage* page, int index, int x, int y, int width, int height)
+{
+    DynArr<SkylineNode>& skyline = page->skyline;
+
+    // Insert the new segment at index
+    SkylineNode node = {x, y + height, width};
+    skyline.push_back(node);
+    for (int i = skyline.size() - 1; i > index; i--) {
+        skyline[i] = skyline[i - 1];
+    }
+    skyline[index] = node;
+
+    // Cut the segments that are now below the rect
+    int i = index + 1;
+    while (i < skyline.size())
+    {
+        SkylineNode& prev = skyline[i - 1];
+        SkylineNode& n = skyline[i];
+        int shrink = prev.x + prev.width - n.x;
+        if (shrink <= 0) {
+            break;
+        }
+        n.x += shrink;
+        n.width -= shrink;
+        if (n.width > 0) {
+            break;
+        }
+        for (int j = i; j < skyline.size() - 1; j++) {
+            skyline[j] = skyline[j + 1];
+        }
+        skyline.count--;
+    }
+
+    // Merge neighbours of the same height
+    for (int j = 0; j < skyline.size() - 1;)
+    {
+        if (skyline[j].y == skyline[j + 1].y) {
+            skyline[j].width += skyline[j + 1].width;
+            for (int k = j + 1; k < skyline.size() - 1; k++) {
+                skyline[k] = skyline[k + 1];
+            }
+            skyline.count--;
+        }
+        else {
+            j++;
+        }
+    }
+}
+
+// Expands the image to RGBA and fills the gutter with the clamped edge pixels.
+// 1 channel images are treated as luminance, 2 channel images as luminance + alpha
+void writeGutteredImage(TextureData* image, byte* dst, int rectWidth, int rectHeight, int gutter)
+{
+    for (int y = 0; y < rectHeight; y++)
+    {
+        int srcY = clamp(y - gutter, 0, image->height - 1);
+        for (int x = 0; x < rectWidth; x++)
+        {
+            int srcX = clamp(x - gutter, 0, image->width - 1);
+            byte* src = image->data + (srcY * image->width + srcX) * image->numChannels;
+            byte* d = dst + (y * rectWidth + x) * 4;
+            switch (image->numChannels)
+            {
+            case 1: d[0] = src[0]; d[1] = src[0]; d[2] = src[0]; d[3] = 255; break;
+            case 2: d[0] = src[0]; d[1] = src[0]; d[2] = src[0]; d[3] = src[1]; break;
+            case 3: d[0] = src[0]; d[1] = src[1]; d[2] = src[2]; d[3] = 255; break;
+            case 4: d[0] = src[0]; d[1] = src[1]; d[2] = src[2]; d[3] = src[3]; break;
+            default: invalid_path("Num channels not valid!\n");
+            }
+        }
+    }
+}
+
+// Packs and uploads the image, returns false (And logs) if it can never fit or all pages are full
+bool insert(TextureAtlas* a, TextureData* image, AtlasRegion* region)
+{
+    int g = a->gutter;
+    int rectWidth = ((image->width + 2 * g + g - 1) / g) * g;
+    int rectHeight = ((image->height + 2 * g + g - 1) / g) * g;
+    if (rectWidth > a->pageSize || rectHeight > a->pageSize) {
+        loggf("Image %dx%d does not fit into atlas pages of %dx%d\n",
+                image->width, image->height, a->pageSize, a->pageSize);
+        a->stats.failed++;
+        return false;
+    }
+
+    // First page with room, new page otherwise
+    int pageIndex = -1;
+    int nodeIndex, x, y;
+    for (int i = 0; i < a->pageCount && pageIndex < 0; i++) {
+        if (findSkylinePosition(&a->pages[i], rectWidth, rectHeight, a->pageSize, &nodeIndex, &x, &y)) {
+            pageIndex = i;
+        }
+    }
+    if (pageIndex < 0)
+    {
+        AtlasPage* page = addPage(a);
+        if (page == nullptr) {
+            loggf("Texture atlas full (%d pages)\n", TEXTURE_ATLAS_MAX_PAGES);
+            a->stats.failed++;
+            return false;
+        }
+        pageIndex = a->pageCount - 1;
+        bool fits = findSkylinePosition(page, rectWidth, rectHeight, a->pageSize, &nodeIndex, &x, &y);
+        assert(fits, "Rect must fit into an empty page\n");
+    }
+    AtlasPage* page = &a->pages[pageIndex];
+    addSkylineLevel(page, nodeIndex, x, y, rectWidth, rectHeight);
+    page->usedArea += rectWidth * rectHeight;
+    page->dirty = true;
+
+    // Upload rect with gutter
+    SCOPE_EXIT_ROLLBACK;
+    int bytes = rectWidth * rectHeight * 4;
+    byte* pixels = (byte*) tmpAlloc.alloc(bytes);
+    writeGutteredImage(image, pixels, rectWidth, rectHeight, g);
+    bind(&page->texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, rectWidth, rectHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    a->stats.uploadedBytes += bytes;
+    a->stats.images++;
+
+    region->page = pageIndex;
+    region->x = x + g;
+    region->y = y + g;
+    region->width = image->width;
+    region->height = image->height;
+    float invSize = 1.0f / a->pageSize;
+    region->uvMin = vec2(region->x * invSize, region->y * invSize);
+    region->uvMax = vec2((region->x + region->width) * invSize, (region->y + region->height) * invSize);
+    return true;
+}
+
+// Inserts tallest first, which packs the skyline a lot tighter than insertion order.
+// regions[i] belongs to images[i], returns the number of images that did not fit
+int insert(TextureAtlas* a, TextureData* images, int count, AtlasRegion* regions)
+{
+    if (count == 0) {
+        return 0;
+    }
+    SCOPE_EXIT_ROLLBACK;
+    u64* keys = (u64*) tmpAlloc.alloc(sizeof(u64) * count);
+    u64* tmpKeys = (u64*) tmpAlloc.alloc(sizeof(u64) * count);
+    u32* order = (u32*) tmpAlloc.alloc(sizeof(u32) * count);
+    u32* tmpOrder = (u32*) tmpAlloc.alloc(sizeof(u32) * count);
+    for (int i = 0; i < count; i++) {
+        keys[i] = ~(u64)images[i].height;
+        order[i] = i;
+    }
+    order = radixSort(keys, order, count, tmpKeys, tmpOrder);
+
+    int failed = 0;
+    for (int i = 0; i < count; i++) {
+        if (!insert(a, &images[order[i]], &regions[order[i]])) {
+            failed++;
+        }
+    }
+    return failed;
+}
+
+// Rebuilds the mips of changed pages, once per tick instead of once per insert
+void update(TextureAtlas* a)
+{
+    if (a->mipLevels == 1) {
+        return;
+    }
+    for (int i = 0; i < a->pageCount; i++)
+    {
+        AtlasPage* page = &a->pages[i];
+        if (!page->dirty) {
+            continue;
+        }
+        bind(&page->texture);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        page->dirty = false;
+        a->stats.mipRebuilds++;
+    }
+}
+
+
+
+#endif
@@ -0,0 +1,231 @@
+#ifndef __TEXTURE_FILE_HPP__
+#define __TEXTURE_FILE_HPP__
+
+// --------------------
+// --- TEXTURE FILE ---
+// --------------------
+// Cooked texture container (.tex), written by the textureCooker tool (code/textureCooker).
+// The whole mip chain is computed offline and stored in the final upload format
+// (Raw bytes or BCn blocks), so loading maps the file and hands every level to
+// glTexImage2D/glCompressedTexImage2D. No decode, no glGenerateMipmap.
+//
+// Layout: TextureFileHeader | level 0 | level 1 | ...
+// Levels start at a multiple of TEXTURE_FILE_ALIGNMENT, offsets are from the start of the file.
+// Uncompressed rows are tightly packed (GL_UNPACK_ALIGNMENT 1), rows are bottom to top
+// like the stb_image path (Flipped on load).
+
+#include "uppLib.hpp"
+
+#define TEXTURE_FILE_MAGIC 0x20584554 // "TEX "
+#define TEXTURE_FILE_VERSION 1
+#define TEXTURE_FILE_ALIGNMENT 16
+#define TEXTURE_FILE_MAX_LEVELS 16
+#define TEXTURE_FILE_MAX_SIZE 65536 // Above any GL_MAX_TEXTURE_SIZE, keeps sizes in int and level sizes far from overflowing
+
+// sRGB textures are still uploaded with linear internal formats, like the stb_image path.
+// Enable together with gamma correction of the framebuffer, then sampling returns linear values.
+#define TEXTURE_SRGB_SAMPLING 0
+
+namespace TextureFileFormat
+{
+    enum ENUM
+    {
+        R8,
+        RG8,
+        RGB8,
+        RGBA8,
+        BC1, // RGB
+        BC3, // RGBA
+        BC4, // R
+        BC5, // RG
+        COUNT
+    };
+};
+
+const char* toStr(TextureFileFormat::ENUM format)
+{
+    switch (format)
+    {
+    case TextureFileFormat::R8: return "R8";
+    case TextureFileFormat::RG8: return "RG8";
+    case TextureFileFormat::RGB8: return "RGB8";
+    case TextureFileFormat::RGBA8: return "RGBA8";
+    case TextureFileFormat::BC1: return "BC1";
+    case TextureFileFormat::BC3: return "BC3";
+    case TextureFileFormat::BC4: return "BC4";
+    case TextureFileFormat::BC5: return "BC5";
+    default: invalid_path("Unknown texture file format\n");
+    }
+    return "INVALID";
+}
+
+struct TextureFormatInfo
+{
+    GLint internalFormat;
+    GLint srgbInternalFormat; // Same as internalFormat if there is no sRGB variant
+    GLenum format;
+    int channels;
+    int blockBytes; // Bytes per 4x4 block, 0 if uncompressed
+};
+
+TextureFormatInfo textureFormatInfoTable[TextureFileFormat::COUNT] = {
+    {GL_RED, GL_RED, GL_RED, 1, 0},
+    {GL_RG, GL_RG, GL_RG, 2, 0},
+    {GL_RGB, GL_SRGB8, GL_RGB, 3, 0},
+    {GL_RGBA, GL_SRGB8_ALPHA8, GL_RGBA, 4, 0},
+    {GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_COMPRESSED_SRGB_S3TC_DXT1_EXT, GL_RGB, 3, 8},
+    {GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, GL_RGBA, 4, 16},
+    {GL_COMPRESSED_RED_RGTC1, GL_COMPRESSED_RED_RGTC1, GL_RED, 1, 8},
+    {GL_COMPRESSED_RG_RGTC2, GL_COMPRESSED_RG_RGTC2, GL_RG, 2, 16},
+};
+
+u64 getTextureLevelSize(TextureFileFormat::ENUM format, u32 width, u32 height)
+{
+    const TextureFormatInfo& info = textureFormatInfoTable[format];
+    if (info.blockBytes != 0) {
+        return (((u64)width + 3) / 4) * (((u64)height + 3) / 4) * info.blockBytes;
+    }
+    return (u64)width * height * info.channels;
+}
+
+struct TextureFileLevel
+{
+    u32 width;
+    u32 height;
+    u64 offset;
+    u64 size;
+};
+
+struct TextureFileHeader
+{
+    u32 magic;
+    u32 version;
+    u32 format; // TextureFileFormat::ENUM
+    u32 srgb; // Color channels are sRGB encoded, alpha is always linear
+    u32 width;
+    u32 height;
+    u32 levelCount;
+    u32 padding;
+    TextureFileLevel levels[TEXTURE_FILE_MAX_LEVELS];
+};
+static_assert(sizeof(TextureFileHeader) == 416, "TextureFileHeader layout changed, increase TEXTURE_FILE_VERSION");
+
+struct TextureFile
+{
+    MappedFile file;
+    TextureFileHeader* header;
+};
+
+u64 alignTextureFileOffset(u64 offset) {
+    return (offset + TEXTURE_FILE_ALIGNMENT - 1) & ~((u64)TEXTURE_FILE_ALIGNMENT - 1);
+}
+
+// Maps the file and checks the header, returns false (And logs why) if the file is not usable
+bool load(TextureFile* f, const char* path)
+{
+    memset(f, 0, sizeof(TextureFile));
+    f->file = mapFile(path);
+    if (f->file.data == nullptr) {
+        return false;
+    }
+    f->header = (TextureFileHeader*) f->file.data;
+
+    TextureFileHeader* h = f->header;
+    const char* error = nullptr;
+    if (f->file.size < sizeof(TextureFileHeader) || h->magic != TEXTURE_FILE_MAGIC) {
+        error = "Not a texture file";
+    }
+    else if (h->version != TEXTURE_FILE_VERSION) {
+        error = "Wrong version, cook it again";
+    }
+    else if (h->format >= TextureFileFormat::COUNT) {
+        error = "Unknown format";
+    }
+    else if (h->levelCount == 0 || h->levelCount > TEXTURE_FILE_MAX_LEVELS || h->width == 0 || h->height == 0 ||
+            h->width > TEXTURE_FILE_MAX_SIZE || h->height > TEXTURE_FILE_MAX_SIZE) {
+        error = "Invalid size or level count";
+    }
+    for (u32 i = 0; error == nullptr && i < h->levelCount; i++)
+    {
+        TextureFileLevel& level = h->levels[i];
+        if (level.width != max(1u, h->width >> i) || level.height != max(1u, h->height >> i)) {
+            error = "Level size does not halve";
+        }
+        else if (level.size != getTextureLevelSize((TextureFileFormat::ENUM)h->format, level.width, level.height)) {
+            error = "Level byte size does not match the format";
+        }
+        else if (level.offset < sizeof(TextureFileHeader) || level.offset > f->file.size || level.size > f->file.size - level.offset) {
+            error = "Level outside of file";
+        }
+    }
+
+    if (error != nullptr) {
+        loggf("Texture file %s: %s\n", path, error);
+        unmapFile(&f->file);
+        f->header = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void shutdown(TextureFile* f) {
+    unmapFile(&f->file);
+    f->header = nullptr;
+}
+
+const void* getLevelData(TextureFile* f, int level) {
+    return (byte*) f->file.data + f->header->levels[level].offset;
+}
+
+// Writes a mip chain, levels[i] holds getTextureLevelSize bytes of level i (Size halves every level)
+bool writeTextureFile(const char* path, TextureFileFormat::ENUM format, bool srgb,
+        int width, int height, const void** levels, int levelCount)
+{
+    assert(levelCount > 0 && levelCount <= TEXTURE_FILE_MAX_LEVELS, "Invalid level count %d\n", levelCount);
+    assert(width > 0 && height > 0 && width <= TEXTURE_FILE_MAX_SIZE && height <= TEXTURE_FILE_MAX_SIZE,
+            "Invalid texture size %dx%d\n", width, height);
+    TextureFileHeader header;
+    memset(&header, 0, sizeof(TextureFileHeader));
+    header.magic = TEXTURE_FILE_MAGIC;
+    header.version = TEXTURE_FILE_VERSION;
+    header.format = format;
+    header.srgb = srgb ? 1 : 0;
+    header.width = width;
+    header.height = height;
+    header.levelCount = levelCount;
+
+    u64 offset = alignTextureFileOffset(sizeof(TextureFileHeader));
+    for (int i = 0; i < levelCount; i++)
+    {
+        TextureFileLevel& level = header.levels[i];
+        level.width = max(1, width >> i);
+        level.height = max(1, height >> i);
+        level.size = getTextureLevelSize(format, level.width, level.height);
+        level.offset = offset;
+        offset = alignTextureFileOffset(offset + level.size);
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) {
+        loggf("Could not open %s for writing\n", path);
+        return false;
+    }
+    SCOPE_EXIT(fclose(file));
+
+    static const byte padding[TEXTURE_FILE_ALIGNMENT] = {};
+    u64 written = fwrite(&header, 1, sizeof(TextureFileHeader), file);
+    for (int i = 0; i < levelCount; i++) {
+        written += fwrite(padding, 1, header.levels[i].offset - written, file);
+        written += fwrite(levels[i], 1, header.levels[i].size, file);
+    }
+
+    if (ferror(file)) {
+        loggf("Writing %s failed\n", path);
+        return false;
+    }
+    return true;
+}
+
+
+
+#endif
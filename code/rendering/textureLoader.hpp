@@ -0,0 +1,374 @@
+#ifndef __TEXTURE_LOADER_HPP__
+#define __TEXTURE_LOADER_HPP__
+
+// ----------------------
+// --- TEXTURE LOADER ---
+// ----------------------
+// Asynchronous texture loading. load() returns an AsyncTexture right away, its texture
+// is a shared placeholder until the real one is complete, so it can be bound immediately.
+//
+//  1. A worker thread maps the cooked file (See textureFile.hpp) or decodes the image with stb_image
+//  2. update() (Once per tick) uploads decoded textures through a pixel unpack StreamBuffer,
+//     at most TEXTURE_LOADER_UPLOAD_BUDGET bytes per tick. Levels are split into row chunks,
+//     so large textures spread over multiple ticks.
+//  3. After the last chunk the texture replaces the placeholder and the state is DONE
+//
+// Failed loads log, keep the placeholder and end in FAILED.
+// All textures are owned by the loader and deleted in shutdown.
+
+#include <atomic>
+#include "texture.hpp"
+#include "streamBuffer.hpp"
+#include "../utils/workQueue.hpp"
+
+#define TEXTURE_LOADER_UPLOAD_BUDGET (4 * 1024 * 1024)
+
+namespace TextureLoadState
+{
+    enum ENUM
+    {
+        QUEUED, // Waiting for/running on a worker
+        DECODED,
+        UPLOADING,
+        DONE,
+        FAILED,
+        COUNT
+    };
+};
+
+const char* toStr(TextureLoadState::ENUM state)
+{
+    switch (state)
+    {
+    case TextureLoadState::QUEUED: return "QUEUED";
+    case TextureLoadState::DECODED: return "DECODED";
+    case TextureLoadState::UPLOADING: return "UPLOADING";
+    case TextureLoadState::DONE: return "DONE";
+    case TextureLoadState::FAILED: return "FAILED";
+    default: invalid_path("Unknown texture load state\n");
+    }
+    return "INVALID";
+}
+
+struct AsyncTexture
+{
+    Texture texture; // Placeholder until DONE
+    std::atomic<int> state; // TextureLoadState, written by the worker until DECODED
+    char path[TEXTURE_MAX_PATH];
+    char cookedPath[TEXTURE_MAX_PATH];
+    TextureFilterMode filterMode;
+
+    // Source, set by the worker
+    bool cooked;
+    TextureFile file;
+    byte* pixels; // stb_image data if not cooked
+    TextureFileFormat::ENUM format;
+    int width;
+    int height;
+    int levelCount;
+
+    // Upload progress, the texture under construction is not visible yet
+    Texture uploading;
+    int uploadLevel;
+    int uploadRow; // In blocks for compressed formats
+    bool finished; // Main thread only, DONE or FAILED has been handled
+};
+
+struct TextureLoaderStats
+{
+    int chunks;
+    int bytes;
+    int completed;
+};
+
+struct TextureLoader
+{
+    WorkQueue* queue;
+    StreamBuffer uploadBuffer;
+    Texture placeholder;
+    DynArr<AsyncTexture*> textures;
+    int pendingCount;
+    TextureLoaderStats stats; // Of the current tick
+    TextureLoaderStats lastTick;
+    int statsTick;
+    Allocator* alloc;
+};
+
+void print(TextureLoaderStats* s)
+{
+    loggf("TextureLoader: %d chunks, %d bytes, %d completed\n", s->chunks, s->bytes, s->completed);
+}
+
+void init(TextureLoader* l, WorkQueue* queue, Allocator* alloc)
+{
+    l->queue = queue;
+    l->alloc = alloc;
+    l->pendingCount = 0;
+    l->statsTick = -1;
+    memset(&l->stats, 0, sizeof(TextureLoaderStats));
+    memset(&l->lastTick, 0, sizeof(TextureLoaderStats));
+    l->textures.init(alloc, 32);
+    init(&l->uploadBuffer, GL_PIXEL_UNPACK_BUFFER, TEXTURE_LOADER_UPLOAD_BUDGET * STREAM_BUFFER_FRAMES, alloc);
+
+    // Grey 1x1
+    byte grey[4] = {128, 128, 128, 255};
+    TextureData data;
+    data.width = 1;
+    data.height = 1;
+    data.numChannels = 4;
+    data.data = grey;
+    init(&l->placeholder, &data, TextureFilterMode(GL_NEAREST, GL_NEAREST, GL_REPEAT, GL_REPEAT));
+
+    // Workers call stbi_load, the flag is global
+    stbi_set_flip_vertically_on_load(true);
+}
+
+void freeSource(AsyncTexture* t)
+{
+    if (t->cooked) {
+        shutdown(&t->file);
+    }
+    else if (t->pixels != nullptr) {
+        stbi_image_free(t->pixels);
+    }
+    t->pixels = nullptr;
+    t->cooked = false;
+}
+
+// Waits for the workers, unfinished uploads are dropped
+void shutdown(TextureLoader* l)
+{
+    completeAllWork(l->queue);
+    for (AsyncTexture* t : l->textures)
+    {
+        freeSource(t);
+        if (t->texture.id != l->placeholder.id) {
+            shutdown(&t->texture);
+        }
+        if (t->state == TextureLoadState::UPLOADING) {
+            shutdown(&t->uploading);
+        }
+        t->~AsyncTexture();
+        l->alloc->dealloc(Blk(t, sizeof(AsyncTexture)));
+    }
+    l->textures.shutdown();
+    shutdown(&l->uploadBuffer);
+    shutdown(&l->placeholder);
+}
+
+// Runs on a worker: Only file io and decoding, no gl and no shared allocators
+void decodeTextureWork(void* userData)
+{
+    AsyncTexture* t = (AsyncTexture*) userData;
+    if (file_exists(t->cookedPath) && load(&t->file, t->cookedPath))
+    {
+        TextureFileHeader* h = t->file.header;
+        t->cooked = true;
+        t->format = (TextureFileFormat::ENUM) h->format;
+        t->width = h->width;
+        t->height = h->height;
+        t->levelCount = h->levelCount;
+
+        // Fault the pages in here, not during the upload on the main thread
+        volatile byte sum = 0;
+        for (u64 i = 0; i < t->file.file.size; i += 4096) {
+            sum += ((byte*)t->file.file.data)[i];
+        }
+        t->state = TextureLoadState::DECODED;
+        return;
+    }
+
+    int channels;
+    t->pixels = stbi_load(t->path, &t->width, &t->height, &channels, 0);
+    if (t->pixels == nullptr || channels < 1 || channels > 4) {
+        loggf("TextureLoader: Could not decode %s\n", t->path);
+        t->state = TextureLoadState::FAILED;
+        return;
+    }
+    TextureFileFormat::ENUM formats[] = {TextureFileFormat::R8, TextureFileFormat::RG8, TextureFileFormat::RGB8, TextureFileFormat::RGBA8};
+    t->format = formats[channels - 1];
+    t->levelCount = 1; // Mipmaps are generated on upload
+    t->state = TextureLoadState::DECODED;
+}
+
+// Returns immediately, name is relative to ressources/textures/ like init(Texture*, name, ...)
+AsyncTexture* load(TextureLoader* l, const char* name, const TextureFilterMode& filterMode)
+{
+    Blk blk = l->alloc->alloc(sizeof(AsyncTexture));
+    memset(blk.data, 0, sizeof(AsyncTexture));
+    AsyncTexture* t = new (blk.data) AsyncTexture;
+    t->texture = l->placeholder;
+    t->state = TextureLoadState::QUEUED;
+    t->filterMode = filterMode;
+    snprintf(t->path, TEXTURE_MAX_PATH, "ressources/textures/%s", name);
+    getCookedTexturePath(t->cookedPath, name);
+
+    l->textures.push_back(t);
+    l->pendingCount++;
+    addWork(l->queue, &decodeTextureWork, t);
+    return t;
+}
+
+AsyncTexture* load(TextureLoader* l, const char* name)
+{
+    return load(l, name, TextureFilterMode(GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_REPEAT, GL_REPEAT));
+}
+
+bool isLoaded(AsyncTexture* t) {
+    return t->state == TextureLoadState::DONE;
+}
+
+bool isFinished(AsyncTexture* t) {
+    return t->state == TextureLoadState::DONE || t->state == TextureLoadState::FAILED;
+}
+
+// Number of textures that are still loading (FAILED ones count until the next update)
+int getPendingCount(TextureLoader* l) {
+    return l->pendingCount;
+}
+
+const byte* getLevelSource(AsyncTexture* t, int level) {
+    return t->cooked ? (const byte*) getLevelData(&t->file, level) : t->pixels;
+}
+
+// Allocates the storage of all levels (Without pixel unpack buffer bound)
+void beginUpload(AsyncTexture* t)
+{
+    const TextureFormatInfo& info = textureFormatInfoTable[t->format];
+    Texture* tex = &t->uploading;
+    *tex = Texture();
+    tex->width = t->width;
+    tex->height = t->height;
+    bool srgb = t->cooked && t->file.header->srgb;
+    tex->internalFormat = (srgb && TEXTURE_SRGB_SAMPLING) ? info.srgbInternalFormat : info.internalFormat;
+    tex->format = info.format;
+    tex->samplerType = GL_SAMPLER_2D;
+
+    glGenTextures(1, &tex->id);
+    assert(tex->id != 0, "glGenTextures failed!\n");
+    bindTexture2D(tex->id);
+    for (int i = 0; i < t->levelCount; i++)
+    {
+        int w = max(1, t->width >> i);
+        int h = max(1, t->height >> i);
+        if (info.blockBytes != 0) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, i, tex->internalFormat, w, h, 0,
+                    (GLsizei)getTextureLevelSize(t->format, w, h), nullptr);
+        }
+        else {
+            glTexImage2D(GL_TEXTURE_2D, i, tex->internalFormat, w, h, 0, tex->format, GL_UNSIGNED_BYTE, nullptr);
+        }
+    }
+    if (t->cooked) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, t->levelCount - 1);
+    }
+    t->uploadLevel = 0;
+    t->uploadRow = 0;
+    t->state = TextureLoadState::UPLOADING;
+}
+
+// Uploads rows of the current level until the budget is used, returns true once all levels are uploaded
+bool uploadChunks(TextureLoader* l, AsyncTexture* t)
+{
+    const TextureFormatInfo& info = textureFormatInfoTable[t->format];
+    bool compressed = info.blockBytes != 0;
+    bindTexture2D(t->uploading.id);
+    setUnpackAlignment(1);
+    SCOPE_EXIT(setUnpackAlignment(4););
+
+    while (t->uploadLevel < t->levelCount)
+    {
+        int w = max(1, t->width >> t->uploadLevel);
+        int h = max(1, t->height >> t->uploadLevel);
+        int rowCount = compressed ? (h + 3) / 4 : h;
+        int rowBytes = compressed ? ((w + 3) / 4) * info.blockBytes : w * info.channels;
+        assert(rowBytes <= l->uploadBuffer.regionSize, "Texture row larger than the upload budget\n");
+
+        int rows = min(rowCount - t->uploadRow, getFreeBytes(&l->uploadBuffer) / rowBytes);
+        if (rows <= 0) {
+            return false; // Budget of this tick is used up
+        }
+        StreamRange range = allocate(&l->uploadBuffer, rows * rowBytes);
+        memcpy(range.data, getLevelSource(t, t->uploadLevel) + (u64)t->uploadRow * rowBytes, range.size);
+        commit(&l->uploadBuffer, range);
+
+        // The pixel pointer is an offset into the bound unpack buffer
+        bindBuffer(GL_PIXEL_UNPACK_BUFFER, range.buffer);
+        const void* offset = (const void*)(u64)range.offset;
+        if (compressed) {
+            int y = t->uploadRow * 4;
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, t->uploadLevel, 0, y, w, min(rows * 4, h - y),
+                    t->uploading.internalFormat, range.size, offset);
+        }
+        else {
+            glTexSubImage2D(GL_TEXTURE_2D, t->uploadLevel, 0, t->uploadRow, w, rows,
+                    t->uploading.format, GL_UNSIGNED_BYTE, offset);
+        }
+        bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        l->stats.chunks++;
+        l->stats.bytes += range.size;
+
+        t->uploadRow += rows;
+        if (t->uploadRow == rowCount) {
+            t->uploadLevel++;
+            t->uploadRow = 0;
+        }
+    }
+    return true;
+}
+
+void finishUpload(TextureLoader* l, AsyncTexture* t)
+{
+    // Decoded images have one level, setFilterMode generates the mipmaps
+    Texture* tex = &t->uploading;
+    tex->mipmapped = t->cooked;
+    setFilterMode(tex, t->filterMode);
+    t->texture = *tex;
+    freeSource(t);
+    t->state = TextureLoadState::DONE;
+    t->finished = true;
+    l->pendingCount--;
+    l->stats.completed++;
+}
+
+// Uploads decoded textures within the budget, call once per tick
+void update(TextureLoader* l)
+{
+    if (l->statsTick != renderState.tickCounter) {
+        l->lastTick = l->stats;
+        memset(&l->stats, 0, sizeof(TextureLoaderStats));
+        l->statsTick = renderState.tickCounter;
+    }
+    if (l->pendingCount == 0) {
+        return;
+    }
+
+    // Oldest first, a texture still decoding does not block the ones after it
+    for (AsyncTexture* t : l->textures)
+    {
+        if (t->finished) {
+            continue;
+        }
+        int state = t->state;
+        if (state == TextureLoadState::FAILED) {
+            freeSource(t);
+            t->finished = true;
+            l->pendingCount--;
+            continue;
+        }
+        if (state != TextureLoadState::DECODED && state != TextureLoadState::UPLOADING) {
+            continue;
+        }
+        if (state == TextureLoadState::DECODED) {
+            beginUpload(t);
+        }
+        if (!uploadChunks(l, t)) {
+            return;
+        }
+        finishUpload(l, t);
+    }
+}
+
+
+
+#endif
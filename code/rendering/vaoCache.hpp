@@ -0,0 +1,224 @@
+#ifndef __VAO_CACHE_HPP__
+#define __VAO_CACHE_HPP__
+
+// -----------------
+// --- VAO CACHE ---
+// -----------------
+// One global table of all vaos created for AutoMesh draws, keyed by the buffer set of the mesh
+// and the attribute signature of the program. Programs with the same attribute locations share
+// the vao, a lookup is one hash probe instead of a compatibility check against every vao of the mesh.
+//
+// The buffer hash covers the ebo and every attrib buffer (vbo, offset, stride), it is computed
+// once when the mesh is created. The attribute signature covers the sorted (attrib, location)
+// pairs of the vertex and instance attribs and is recomputed whenever the attribs are detected
+// (Init and shader reload), so moved locations produce a new key instead of a stale vao.
+// Entries of a mesh are deleted with releaseVaos when the mesh is shut down, before the
+// buffer names can be reused. When a program is rebuilt with other attrib locations, the
+// entries of its old signature are deleted with releaseVaoSignature (Programs sharing the
+// signature recreate their vaos on the next draw).
+// Lookups compare buffer hash and signature as well, a collision of the combined key is a miss.
+//
+// Open addressing with linear probing, the table grows at 50% load. Key 0 marks empty slots.
+
+#define VAO_CACHE_MIN_CAPACITY 64
+
+struct VaoCacheEntry
+{
+    u64 key; // 0 if empty
+    u64 bufferHash;
+    u64 attribSignature;
+    MeshVao meshVao;
+};
+
+struct VaoCacheStats
+{
+    int hits;
+    int misses;
+    int released;
+    int entries;
+};
+
+struct VaoCache
+{
+    Allocator* alloc;
+    Blk blk;
+    VaoCacheEntry* entries;
+    int capacity; // Power of 2
+    int count;
+    VaoCacheStats stats;
+};
+
+VaoCache vaoCache;
+
+void print(VaoCacheStats* s)
+{
+    loggf("VaoCache: %d hits, %d misses, %d released, %d entries\n",
+            s->hits, s->misses, s->released, s->entries);
+}
+
+u64 getMeshBufferHash(MeshGPUBuffer* buffer)
+{
+    u64 hash = hashBytes(&buffer->indexBuffer.ebo, sizeof(GLuint));
+    for (AttribGPUBuffer& a : buffer->attribBuffers) {
+        hash = hashBytes(&a.attrib, sizeof(a.attrib), hash);
+        hash = hashBytes(&a.vbo, sizeof(a.vbo), hash);
+        hash = hashBytes(&a.offset, sizeof(a.offset), hash);
+        hash = hashBytes(&a.stride, sizeof(a.stride), hash);
+    }
+    return hash;
+}
+
+// Locations must be sorted
+u64 getAttribSignature(int attribLocCount, AttribLocation* attribLocs,
+        int instanceAttribLocCount, InstanceAttribLocation* instanceAttribLocs)
+{
+    u64 hash = hashBytes(&attribLocCount, sizeof(int));
+    hash = hashBytes(attribLocs, sizeof(AttribLocation) * attribLocCount, hash);
+    hash = hashBytes(&instanceAttribLocCount, sizeof(int), hash);
+    return hashBytes(instanceAttribLocs, sizeof(InstanceAttribLocation) * instanceAttribLocCount, hash);
+}
+
+u64 getVaoCacheKey(u64 bufferHash, u64 attribSignature)
+{
+    u64 key = hashBytes(&attribSignature, sizeof(u64), bufferHash);
+    return key != 0 ? key : 1;
+}
+
+int getVaoCacheSlot(u64 key) {
+    return (int)((key ^ (key >> 32)) & (u64)(vaoCache.capacity - 1));
+}
+
+// Returns nullptr on a miss, the pointer is valid until the next insert or release
+MeshVao* findVao(u64 key, u64 bufferHash, u64 attribSignature)
+{
+    if (vaoCache.count == 0) {
+        return nullptr;
+    }
+    int mask = vaoCache.capacity - 1;
+    for (int i = getVaoCacheSlot(key); vaoCache.entries[i].key != 0; i = (i + 1) & mask) {
+        VaoCacheEntry& e = vaoCache.entries[i];
+        if (e.key == key && e.bufferHash == bufferHash && e.attribSignature == attribSignature) {
+            return &e.meshVao;
+        }
+    }
+    return nullptr;
+}
+
+VaoCacheEntry* insertEntry(const VaoCacheEntry& entry)
+{
+    int mask = vaoCache.capacity - 1;
+    int i = getVaoCacheSlot(entry.key);
+    while (vaoCache.entries[i].key != 0) {
+        i = (i + 1) & mask;
+    }
+    vaoCache.entries[i] = entry;
+    vaoCache.count++;
+    return &vaoCache.entries[i];
+}
+
+void growVaoCache(Allocator* alloc)
+{
+    if (vaoCache.alloc == nullptr) {
+        vaoCache.alloc = alloc;
+    }
+    Blk oldBlk = vaoCache.blk;
+    VaoCacheEntry* oldEntries = vaoCache.entries;
+    int oldCapacity = vaoCache.capacity;
+
+    vaoCache.capacity = max(oldCapacity * 2, VAO_CACHE_MIN_CAPACITY);
+    vaoCache.blk = vaoCache.alloc->alloc(sizeof(VaoCacheEntry) * vaoCache.capacity);
+    vaoCache.entries = (VaoCacheEntry*) vaoCache.blk.data;
+    for (int i = 0; i < vaoCache.capacity; i++) {
+        vaoCache.entries[i] = VaoCacheEntry();
+    }
+    vaoCache.count = 0;
+    for (int i = 0; i < oldCapacity; i++) {
+        if (oldEntries[i].key != 0) {
+            insertEntry(oldEntries[i]);
+        }
+    }
+    if (oldEntries != nullptr) {
+        vaoCache.alloc->dealloc(oldBlk);
+    }
+}
+
+// The cache takes ownership of the vao, alloc is used for the table on first use
+MeshVao* insertVao(u64 key, u64 bufferHash, u64 attribSignature, const MeshVao& meshVao, Allocator* alloc)
+{
+    assert(findVao(key, bufferHash, attribSignature) == nullptr, "Vao is already in the cache\n");
+    if ((vaoCache.count + 1) * 2 > vaoCache.capacity) {
+        growVaoCache(alloc);
+    }
+    VaoCacheEntry entry;
+    entry.key = key;
+    entry.bufferHash = bufferHash;
+    entry.attribSignature = attribSignature;
+    entry.meshVao = meshVao;
+    vaoCache.stats.entries = vaoCache.count + 1;
+    return &insertEntry(entry)->meshVao;
+}
+
+// Backward shift deletion, keeps probe sequences intact without tombstones
+void removeEntry(int index)
+{
+    int mask = vaoCache.capacity - 1;
+    int hole = index;
+    for (int i = (index + 1) & mask; vaoCache.entries[i].key != 0; i = (i + 1) & mask)
+    {
+        int home = getVaoCacheSlot(vaoCache.entries[i].key);
+        // Move the entry into the hole if its home slot is not between the hole and i
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            vaoCache.entries[hole] = vaoCache.entries[i];
+            hole = i;
+        }
+    }
+    vaoCache.entries[hole].key = 0;
+    vaoCache.count--;
+}
+
+// Deletes the vaos whose buffer hash (Or attrib signature) equals value
+void releaseVaoEntries(u64 value, bool matchSignature)
+{
+    int i = 0;
+    while (i < vaoCache.capacity)
+    {
+        VaoCacheEntry& e = vaoCache.entries[i];
+        if (e.key != 0 && (matchSignature ? e.attribSignature : e.bufferHash) == value) {
+            shutdown(&e.meshVao);
+            removeEntry(i); // May shift the next entry into i, check it again
+            vaoCache.stats.released++;
+            continue;
+        }
+        i++;
+    }
+    vaoCache.stats.entries = vaoCache.count;
+}
+
+// Deletes all vaos created for the buffer set
+void releaseVaos(u64 bufferHash) {
+    releaseVaoEntries(bufferHash, false);
+}
+
+// Deletes all vaos created for the attrib layout (E.g. The old layout of a reloaded program)
+void releaseVaoSignature(u64 attribSignature) {
+    releaseVaoEntries(attribSignature, true);
+}
+
+// Deletes all vaos, the cache is usable again afterwards.
+// Called before the dll is reset, the meshes outlive it and recreate their vaos on the next draw.
+void shutdownVaoCache()
+{
+    for (int i = 0; i < vaoCache.capacity; i++) {
+        if (vaoCache.entries[i].key != 0) {
+            shutdown(&vaoCache.entries[i].meshVao);
+        }
+    }
+    if (vaoCache.entries != nullptr) {
+        vaoCache.alloc->dealloc(vaoCache.blk);
+    }
+    vaoCache = VaoCache();
+}
+
+
+
+#endif
@@ -0,0 +1,17 @@
+# Builds the texture cooker, run from the repository root:
+#   ./code/textureCooker/build.sh && ./build/textureCooker ressources/textures/*.bmp
+dir=$(pwd)
+ldir=${dir}/libs
+odir=${dir}/build
+cdir=${dir}/code/textureCooker
+
+#Compiler arguments
+source="${cdir}/textureCookerMain.cpp"
+output=${odir}/textureCooker
+# See headless/build.sh for -fno-lifetime-dse
+flags="-std=c++17 -O2 -w -fno-lifetime-dse -pthread"
+includes="-I ${dir}/uppLib -I ${ldir}/stb -I ${ldir}/openGLExtensions"
+
+#Command
+mkdir -p ${odir}
+g++ $flags -o $output $source $includes
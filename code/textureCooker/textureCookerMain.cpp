@@ -0,0 +1,455 @@
+// TEXTURE COOKER
+// Cooks images (Everything stb_image reads) to texture files (See rendering/textureFile.hpp),
+// which the game uploads straight from the file mapping.
+// Every file is cooked on a worker thread: Decode, convert to linear float, build the mip
+// chain with a 2x2 box filter, convert back and optionally compress to BCn.
+//
+// Usage: textureCooker [-threads n] [-bc] [-linear] [-nomips] [-o outputDir] image...
+//     The output has the name of the input with .tex, next to it or in outputDir
+//     -bc      Compress: RGB -> BC1, RGBA -> BC3, R -> BC4, RG -> BC5
+//     -linear  Data textures (Normal maps, masks...), RGB(A) images are sRGB otherwise
+//     -nomips  Only store level 0
+// Returns 1 if a file could not be cooked
+
+#include <cmath>
+#include <cfloat>
+#include <climits>
+#include "../tools/toolCommon.hpp"
+
+
+
+// ------------------
+// --- COLORSPACE ---
+// ------------------
+// Filtering happens on linear values, averaging sRGB bytes darkens the smaller levels
+float srgbToLinearTable[256];
+#define LINEAR_TO_SRGB_TABLE_SIZE 4096
+byte linearToSrgbTable[LINEAR_TO_SRGB_TABLE_SIZE];
+
+void initColorspaceTables()
+{
+    for (int i = 0; i < 256; i++) {
+        float c = i / 255.0f;
+        srgbToLinearTable[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+    }
+    for (int i = 0; i < LINEAR_TO_SRGB_TABLE_SIZE; i++) {
+        float c = i / (float)(LINEAR_TO_SRGB_TABLE_SIZE - 1);
+        float s = c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+        linearToSrgbTable[i] = (byte)(s * 255.0f + 0.5f);
+    }
+}
+
+byte toByte(float linear, bool srgb)
+{
+    linear = linear < 0.0f ? 0.0f : (linear > 1.0f ? 1.0f : linear);
+    if (srgb) {
+        return linearToSrgbTable[(int)(linear * (LINEAR_TO_SRGB_TABLE_SIZE - 1) + 0.5f)];
+    }
+    return (byte)(linear * 255.0f + 0.5f);
+}
+
+// Pixels are always float RGBA while filtering, channels is the channel count of the file
+void toLinear(float* dst, const byte* src, int pixelCount, int channels, bool srgb)
+{
+    for (int i = 0; i < pixelCount; i++) {
+        float* p = dst + i * 4;
+        p[0] = p[1] = p[2] = 0.0f;
+        p[3] = 1.0f;
+        for (int c = 0; c < channels; c++) {
+            byte v = src[i * channels + c];
+            p[c] = (srgb && c < 3) ? srgbToLinearTable[v] : v / 255.0f;
+        }
+    }
+}
+
+void toBytes(byte* dst, const float* src, int pixelCount, int channels, bool srgb)
+{
+    for (int i = 0; i < pixelCount; i++) {
+        for (int c = 0; c < channels; c++) {
+            dst[i * channels + c] = toByte(src[i * 4 + c], srgb && c < 3);
+        }
+    }
+}
+
+
+
+// -----------------
+// --- MIP CHAIN ---
+// -----------------
+// One destination row of a 2x2 box filter, row0/row1 are the two source rows (2 * dstWidth RGBA pixels)
+void downsampleRowScalar(float* dst, const float* row0, const float* row1, int dstWidth)
+{
+    for (int x = 0; x < dstWidth; x++) {
+        for (int c = 0; c < 4; c++) {
+            dst[x * 4 + c] = 0.25f * (row0[x * 8 + c] + row0[x * 8 + 4 + c] + row1[x * 8 + c] + row1[x * 8 + 4 + c]);
+        }
+    }
+}
+
+#ifdef UPP_SSE
+// A RGBA pixel is one register
+void downsampleRowSSE(float* dst, const float* row0, const float* row1, int dstWidth)
+{
+    __m128 quarter = _mm_set1_ps(0.25f);
+    for (int x = 0; x < dstWidth; x++) {
+        __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(row0 + x * 8), _mm_loadu_ps(row0 + x * 8 + 4)),
+                _mm_add_ps(_mm_loadu_ps(row1 + x * 8), _mm_loadu_ps(row1 + x * 8 + 4)));
+        _mm_storeu_ps(dst + x * 4, _mm_mul_ps(sum, quarter));
+    }
+}
+
+// Two destination pixels per iteration: Sum the rows, then add the horizontal pairs across lanes
+UPP_TARGET_AVX2 void downsampleRowAVX2(float* dst, const float* row0, const float* row1, int dstWidth)
+{
+    __m256 quarter = _mm256_set1_ps(0.25f);
+    int x = 0;
+    for (; x + 2 <= dstWidth; x += 2)
+    {
+        __m256 a = _mm256_add_ps(_mm256_loadu_ps(row0 + x * 8), _mm256_loadu_ps(row1 + x * 8)); // p0 p1
+        __m256 b = _mm256_add_ps(_mm256_loadu_ps(row0 + x * 8 + 8), _mm256_loadu_ps(row1 + x * 8 + 8)); // p2 p3
+        __m256 even = _mm256_permute2f128_ps(a, b, 0x20); // p0 p2
+        __m256 odd = _mm256_permute2f128_ps(a, b, 0x31); // p1 p3
+        _mm256_storeu_ps(dst + x * 4, _mm256_mul_ps(_mm256_add_ps(even, odd), quarter));
+    }
+    downsampleRowScalar(dst + x * 4, row0 + x * 8, row1 + x * 8, dstWidth - x);
+}
+#endif
+
+// Dispatched to the widest path the cpu supports (See cpuFeatures.hpp)
+typedef void (*DownsampleRowFunc)(float* dst, const float* row0, const float* row1, int dstWidth);
+
+Kernel* downsampleRowKernel = createKernel("downsampleRow", {
+        {SimdLevel::SCALAR, (GenericFunc) &downsampleRowScalar},
+#ifdef UPP_SSE
+        {SimdLevel::SSE2, (GenericFunc) &downsampleRowSSE},
+        {SimdLevel::AVX2, (GenericFunc) &downsampleRowAVX2},
+#endif
+        });
+
+// Halves the size, odd sizes drop the last row/column, a size of 1 stays 1
+void downsample(float* dst, const float* src, int srcWidth, int srcHeight)
+{
+    int dstWidth = max(1, srcWidth / 2);
+    int dstHeight = max(1, srcHeight / 2);
+    DownsampleRowFunc downsampleRow = dispatch<DownsampleRowFunc>(downsampleRowKernel);
+    for (int y = 0; y < dstHeight; y++)
+    {
+        const float* row0 = src + (u64)min(y * 2, srcHeight - 1) * srcWidth * 4;
+        const float* row1 = src + (u64)min(y * 2 + 1, srcHeight - 1) * srcWidth * 4;
+        float* dstRow = dst + (u64)y * dstWidth * 4;
+        if (srcWidth == 1) {
+            for (int c = 0; c < 4; c++) {
+                dstRow[c] = 0.5f * (row0[c] + row1[c]);
+            }
+        }
+        else {
+            downsampleRow(dstRow, row0, row1, dstWidth);
+        }
+    }
+}
+
+int getMipLevelCount(int width, int height)
+{
+    int count = 1;
+    while ((width > 1 || height > 1) && count < TEXTURE_FILE_MAX_LEVELS) {
+        width = max(1, width / 2);
+        height = max(1, height / 2);
+        count++;
+    }
+    return count;
+}
+
+
+
+// -----------------------
+// --- BCn COMPRESSION ---
+// -----------------------
+// Blocks are fetched with clamping, so levels smaller than 4x4 repeat their edge pixels.
+// BC1: Endpoints are the extremes of the colors along the principal axis (Power iteration),
+// BC4: Endpoints are min/max of the channel, always the 8 value mode.
+// BC3 = BC4 alpha + BC1 color, BC5 = BC4 red + BC4 green.
+void fetchBlock(byte block[16][4], const byte* pixels, int width, int height, int channels, int bx, int by)
+{
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            int px = min(bx * 4 + x, width - 1);
+            int py = min(by * 4 + y, height - 1);
+            const byte* p = pixels + ((u64)py * width + px) * channels;
+            for (int c = 0; c < 4; c++) {
+                block[y * 4 + x][c] = c < channels ? p[c] : 255;
+            }
+        }
+    }
+}
+
+u16 toRGB565(const float* c) {
+    int r = (int)(c[0] * 31.0f / 255.0f + 0.5f);
+    int g = (int)(c[1] * 63.0f / 255.0f + 0.5f);
+    int b = (int)(c[2] * 31.0f / 255.0f + 0.5f);
+    return (u16)((clamp(r, 0, 31) << 11) | (clamp(g, 0, 63) << 5) | clamp(b, 0, 31));
+}
+
+void fromRGB565(u16 c, int* rgb) {
+    rgb[0] = ((c >> 11) & 31) * 255 / 31;
+    rgb[1] = ((c >> 5) & 63) * 255 / 63;
+    rgb[2] = (c & 31) * 255 / 31;
+}
+
+void encodeBC1(byte* out, byte block[16][4])
+{
+    // Principal axis of the colors
+    float mean[3] = {0, 0, 0};
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++) mean[c] += block[i][c] / 16.0f;
+    }
+    float cov[6] = {0, 0, 0, 0, 0, 0}; // rr rg rb gg gb bb
+    for (int i = 0; i < 16; i++) {
+        float r = block[i][0] - mean[0], g = block[i][1] - mean[1], b = block[i][2] - mean[2];
+        cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+        cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+    }
+    float axis[3] = {1, 1, 1};
+    for (int iter = 0; iter < 4; iter++) {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float len = fmaxf(fabsf(x), fmaxf(fabsf(y), fabsf(z)));
+        if (len < 1e-6f) break; // Flat block, any axis works
+        axis[0] = x / len; axis[1] = y / len; axis[2] = z / len;
+    }
+
+    // Extremes along the axis
+    int minIndex = 0, maxIndex = 0;
+    float minDot = FLT_MAX, maxDot = -FLT_MAX;
+    for (int i = 0; i < 16; i++) {
+        float d = block[i][0] * axis[0] + block[i][1] * axis[1] + block[i][2] * axis[2];
+        if (d < minDot) { minDot = d; minIndex = i; }
+        if (d > maxDot) { maxDot = d; maxIndex = i; }
+    }
+    float maxColor[3] = {(float)block[maxIndex][0], (float)block[maxIndex][1], (float)block[maxIndex][2]};
+    float minColor[3] = {(float)block[minIndex][0], (float)block[minIndex][1], (float)block[minIndex][2]};
+    u16 c0 = toRGB565(maxColor);
+    u16 c1 = toRGB565(minColor);
+    if (c0 < c1) {
+        u16 t = c0; c0 = c1; c1 = t;
+    }
+
+    // c0 > c1 selects the 4 color mode, palette: c0, c1, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1
+    u32 indices = 0;
+    if (c0 != c1)
+    {
+        int palette[4][3];
+        fromRGB565(c0, palette[0]);
+        fromRGB565(c1, palette[1]);
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (int i = 0; i < 16; i++) {
+            int best = 0, bestDist = INT_MAX;
+            for (int p = 0; p < 4; p++) {
+                int dr = block[i][0] - palette[p][0], dg = block[i][1] - palette[p][1], db = block[i][2] - palette[p][2];
+                int dist = dr * dr + dg * dg + db * db;
+                if (dist < bestDist) { bestDist = dist; best = p; }
+            }
+            indices |= (u32)best << (i * 2);
+        }
+    }
+    out[0] = c0 & 0xFF; out[1] = c0 >> 8;
+    out[2] = c1 & 0xFF; out[3] = c1 >> 8;
+    memcpy(out + 4, &indices, 4);
+}
+
+void encodeBC4(byte* out, byte block[16][4], int channel)
+{
+    int lo = 255, hi = 0;
+    for (int i = 0; i < 16; i++) {
+        lo = min(lo, (int)block[i][channel]);
+        hi = max(hi, (int)block[i][channel]);
+    }
+
+    // hi > lo selects the 8 value mode, codes: 0 = hi, 1 = lo, 2..7 = steps from hi to lo
+    u64 indices = 0;
+    if (hi != lo) {
+        for (int i = 0; i < 16; i++) {
+            int step = ((block[i][channel] - lo) * 14 + (hi - lo)) / (2 * (hi - lo)); // Rounded to 0..7
+            u64 code = step == 7 ? 0 : (step == 0 ? 1 : 8 - step);
+            indices |= code << (i * 3);
+        }
+    }
+    out[0] = (byte)hi;
+    out[1] = (byte)lo;
+    for (int b = 0; b < 6; b++) {
+        out[2 + b] = (byte)(indices >> (b * 8));
+    }
+}
+
+void compressLevel(byte* out, const byte* pixels, int width, int height, int channels, TextureFileFormat::ENUM format)
+{
+    int blockBytes = textureFormatInfoTable[format].blockBytes;
+    int blocksX = (width + 3) / 4;
+    int blocksY = (height + 3) / 4;
+    byte block[16][4];
+    for (int by = 0; by < blocksY; by++) {
+        for (int bx = 0; bx < blocksX; bx++)
+        {
+            fetchBlock(block, pixels, width, height, channels, bx, by);
+            byte* dst = out + ((u64)by * blocksX + bx) * blockBytes;
+            switch (format)
+            {
+            case TextureFileFormat::BC1: encodeBC1(dst, block); break;
+            case TextureFileFormat::BC3: encodeBC4(dst, block, 3); encodeBC1(dst + 8, block); break;
+            case TextureFileFormat::BC4: encodeBC4(dst, block, 0); break;
+            case TextureFileFormat::BC5: encodeBC4(dst, block, 0); encodeBC4(dst + 8, block, 1); break;
+            default: invalid_path("Not a compressed format\n");
+            }
+        }
+    }
+}
+
+
+
+// ---------------
+// --- COOKING ---
+// ---------------
+struct CookOptions
+{
+    bool compress;
+    bool linear;
+    bool mips;
+};
+
+struct CookJob
+{
+    const char* inputPath;
+    char outputPath[1024];
+    bool success;
+    int width;
+    int height;
+    int levelCount;
+    TextureFileFormat::ENUM format;
+    bool srgb;
+    u64 fileSize;
+    double decodeMs;
+    double totalMs;
+};
+
+void cook(CookJob* job, const CookOptions& options)
+{
+    auto start = std::chrono::steady_clock::now();
+    SystemAllocator alloc;
+    job->success = false;
+
+    int channels;
+    byte* pixels = stbi_load(job->inputPath, &job->width, &job->height, &channels, 0);
+    if (pixels == nullptr) {
+        loggf("Could not decode %s: %s\n", job->inputPath, stbi_failure_reason());
+        return;
+    }
+    SCOPE_EXIT(stbi_image_free(pixels););
+    job->decodeMs = msSince(start);
+    if (job->width > TEXTURE_FILE_MAX_SIZE || job->height > TEXTURE_FILE_MAX_SIZE) {
+        loggf("%s is %dx%d, the maximum is %d\n", job->inputPath, job->width, job->height, TEXTURE_FILE_MAX_SIZE);
+        return;
+    }
+
+    TextureFileFormat::ENUM rawFormats[] = {TextureFileFormat::R8, TextureFileFormat::RG8, TextureFileFormat::RGB8, TextureFileFormat::RGBA8};
+    TextureFileFormat::ENUM compressedFormats[] = {TextureFileFormat::BC4, TextureFileFormat::BC5, TextureFileFormat::BC1, TextureFileFormat::BC3};
+    job->format = options.compress ? compressedFormats[channels - 1] : rawFormats[channels - 1];
+    job->srgb = !options.linear && channels >= 3;
+    job->levelCount = options.mips ? getMipLevelCount(job->width, job->height) : 1;
+
+    // Float level i is filtered from float level i - 1, bytes are what gets written
+    u64 pixelCount = (u64)job->width * job->height;
+    Blk floatBlks[2] = {alloc.alloc(pixelCount * 4 * sizeof(float)), alloc.alloc(pixelCount * 4 * sizeof(float))};
+    Blk levelBlks[TEXTURE_FILE_MAX_LEVELS];
+    const void* levels[TEXTURE_FILE_MAX_LEVELS];
+    SCOPE_EXIT(
+        alloc.dealloc(floatBlks[0]);
+        alloc.dealloc(floatBlks[1]);
+        for (int i = 0; i < job->levelCount; i++) alloc.dealloc(levelBlks[i]);
+    );
+    Blk rawBlk = alloc.alloc(pixelCount * channels);
+    SCOPE_EXIT(alloc.dealloc(rawBlk););
+
+    float* current = (float*) floatBlks[0].data;
+    float* next = (float*) floatBlks[1].data;
+    toLinear(current, pixels, (int)pixelCount, channels, job->srgb);
+    int width = job->width;
+    int height = job->height;
+    for (int i = 0; i < job->levelCount; i++)
+    {
+        if (i > 0) {
+            downsample(next, current, width, height);
+            float* t = current; current = next; next = t;
+            width = max(1, width / 2);
+            height = max(1, height / 2);
+        }
+
+        // Level 0 is written as decoded, the float round trip could change bytes
+        const byte* raw = pixels;
+        if (i > 0) {
+            toBytes((byte*)rawBlk.data, current, width * height, channels, job->srgb);
+            raw = (const byte*)rawBlk.data;
+        }
+        levelBlks[i] = alloc.alloc(getTextureLevelSize(job->format, width, height));
+        if (options.compress) {
+            compressLevel((byte*)levelBlks[i].data, raw, width, height, channels, job->format);
+        }
+        else {
+            memcpy(levelBlks[i].data, raw, levelBlks[i].size);
+        }
+        levels[i] = levelBlks[i].data;
+    }
+
+    job->success = writeTextureFile(job->outputPath, job->format, job->srgb, job->width, job->height, levels, job->levelCount);
+    job->fileSize = job->success ? get_file_size(job->outputPath) : 0;
+    job->totalMs = msSince(start);
+}
+
+int main(int argc, char** argv)
+{
+    CookOptions options = {false, false, true};
+    SystemAllocator alloc;
+    DynArr<CookJob> jobs;
+    jobs.init(&alloc, 16);
+    SCOPE_EXIT(jobs.shutdown(););
+    ToolArgs args;
+    bool hasInputs = parseToolArgs(argc, argv, ".tex", &jobs, &args, [&](const char* flag) {
+        if (strcmp(flag, "-bc") == 0) options.compress = true;
+        else if (strcmp(flag, "-linear") == 0) options.linear = true;
+        else if (strcmp(flag, "-nomips") == 0) options.mips = false;
+        else return false;
+        return true;
+    });
+    if (!hasInputs) {
+        loggf("Usage: textureCooker [-threads n] [-bc] [-linear] [-nomips] [-o outputDir] image...\n");
+        return EXIT_FAILURE;
+    }
+
+    // Set up before the workers start, stb_image and the tables are shared
+    stbi_set_flip_vertically_on_load(true);
+    initColorspaceTables();
+
+    auto start = std::chrono::steady_clock::now();
+    int threadCount = runToolJobs(&jobs, args.threadCount, [&](CookJob* job) {
+        cook(job, options);
+    });
+
+    int failed = 0;
+    for (CookJob& job : jobs)
+    {
+        if (!job.success) {
+            loggf("FAILED %s\n", job.inputPath);
+            failed++;
+            continue;
+        }
+        loggf("%s -> %s: %dx%d %s%s, %d levels, %llu bytes (decode %.1f ms, total %.1f ms)\n",
+                job.inputPath, job.outputPath, job.width, job.height, toStr(job.format), job.srgb ? " sRGB" : "",
+                job.levelCount, job.fileSize, job.decodeMs, job.totalMs);
+    }
+    loggf("Cooked %d/%d files with %d threads in %.1f ms\n", jobs.size() - failed, jobs.size(), threadCount, msSince(start));
+    logKernelDispatch();
+
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,136 @@
+#ifndef __TOOL_COMMON_HPP__
+#define __TOOL_COMMON_HPP__
+
+// ------------------
+// --- TOOL SETUP ---
+// ------------------
+// Shared by the offline tools (meshConverter, textureCooker): Includes the renderer
+// without a gl context, stubs the platform functions and runs one job per input
+// file on worker threads.
+// A tool defines a job struct with (at least) inputPath and outputPath[1024], then:
+//
+//     ToolArgs args;
+//     if (!parseToolArgs(argc, argv, ".tex", &jobs, &args, [&](const char* flag) {...})) { usage }
+//     int threadCount = runToolJobs(&jobs, args.threadCount, [&](MyJob* job) {...});
+//
+// The flag callback returns false for arguments it does not know, those are inputs.
+
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <initializer_list>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include "uppLib.hpp"
+
+// Includes so that opengl types and enums are defined, the tools never call gl
+#define glActiveTexture __system_glActiveTexture
+#define glCompressedTexImage2D __system_glCompressedTexImage2D
+#define glCompressedTexSubImage2D __system_glCompressedTexSubImage2D
+#include <GL/gl.h>
+#undef glActiveTexture
+#undef glCompressedTexImage2D
+#undef glCompressedTexSubImage2D
+#include <GL/glext.h>
+typedef int (*PFNWGLSWAPINTERVALEXTPROC)(int);
+typedef const char* (*PFNWGLGETEXTENSIONSSTRINGARBPROC)(void*);
+
+#include "../platform.hpp"
+#include "../utils/tmpAlloc.hpp"
+#include "../rendering/openGLFunctions.hpp"
+#include "../rendering/renderer.hpp"
+#include "../headless/posixFileMapping.cpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#undef assert // stb_image includes <assert.h>, which hides the uppLib assert
+
+// Platform functions, the renderer code references them
+MappedFile mapFile(const char* path) {
+    return posixMapFile(path);
+}
+void unmapFile(MappedFile* file) {
+    posixUnmapFile(file);
+}
+ListenerToken createFileListener(const char* /*path*/, listenerCallbackFunc /*callback*/, void* /*userData*/) {
+    return 0;
+}
+void deleteFileListener(ListenerToken /*token*/) {}
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The name of the input with the extension replaced, next to it or in outputDir
+void setOutputPath(char* outputPath, int outputSize, const char* inputPath, const char* outputDir, const char* extension)
+{
+    const char* name = inputPath;
+    if (outputDir != nullptr) {
+        const char* slash = strrchr(name, '/');
+        name = slash != nullptr ? slash + 1 : name;
+        snprintf(outputPath, outputSize, "%s/%s", outputDir, name);
+    }
+    else {
+        snprintf(outputPath, outputSize, "%s", name);
+    }
+    char* dot = strrchr(outputPath, '.');
+    char* slash = strrchr(outputPath, '/');
+    if (dot != nullptr && (slash == nullptr || dot > slash)) {
+        *dot = '\0';
+    }
+    strncat(outputPath, extension, outputSize - strlen(outputPath) - 1);
+}
+
+struct ToolArgs
+{
+    int threadCount;
+    const char* outputDir;
+};
+
+// Handles -threads n and -o outputDir, everything the flag callback does not take
+// becomes a job. Returns false if there are no inputs
+template<typename Job, typename FlagFunc>
+bool parseToolArgs(int argc, char** argv, const char* extension, DynArr<Job>* jobs, ToolArgs* args, FlagFunc handleFlag)
+{
+    args->threadCount = (int) std::thread::hardware_concurrency();
+    args->outputDir = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) args->threadCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) args->outputDir = argv[++i];
+        else if (!handleFlag(argv[i])) {
+            Job job;
+            memset(&job, 0, sizeof(Job));
+            job.inputPath = argv[i];
+            jobs->push_back(job);
+        }
+    }
+    for (Job& job : *jobs) {
+        setOutputPath(job.outputPath, sizeof(job.outputPath), job.inputPath, args->outputDir, extension);
+    }
+    return jobs->size() > 0;
+}
+
+// Workers take the next job until all are done, returns the number of threads used
+template<typename Job, typename JobFunc>
+int runToolJobs(DynArr<Job>* jobs, int threadCount, JobFunc run)
+{
+    threadCount = max(1, min(threadCount, jobs->size()));
+    std::atomic<int> nextJob(0);
+    std::thread* threads = new std::thread[threadCount];
+    for (int t = 0; t < threadCount; t++) {
+        threads[t] = std::thread([&]() {
+            for (int i = nextJob++; i < jobs->size(); i = nextJob++) {
+                run(&(*jobs)[i]);
+            }
+        });
+    }
+    for (int t = 0; t < threadCount; t++) {
+        threads[t].join();
+    }
+    delete[] threads;
+    return threadCount;
+}
+
+#endif
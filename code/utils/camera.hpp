@@ -15,6 +15,11 @@ void init(Camera3D* cam, int width, int height) {
     cam->dir = vec3(0);
 }
 
+// World space view frustum of the current view and projection
+Frustum getFrustum(Camera3D* cam) {
+    return extractFrustum(cam->projection * cam->view);
+}
+
 
 
 
@@ -0,0 +1,238 @@
+#ifndef __MESH_FILE_HPP__
+#define __MESH_FILE_HPP__
+
+// -----------------
+// --- MESH FILE ---
+// -----------------
+// Binary mesh container (.mesh), written by the meshConverter tool (code/meshConverter).
+// The file is memory mapped and used in place: Attribs and indices are stored exactly like
+// the blks of a MeshData (One tightly packed stream per attrib, u32 indices), so loading
+// only points a MeshData into the mapping. There is no parsing and no copy before glBufferData.
+//
+// Layout: MeshFileHeader | streams of lod 0 | streams of lod 1 | ...
+// Every stream starts at a multiple of MESH_FILE_ALIGNMENT, offsets are from the start
+// of the file. The file is little endian, like all our targets.
+
+#include "meshSimplifier.hpp"
+
+#define MESH_FILE_MAGIC 0x4853454D // "MESH"
+#define MESH_FILE_VERSION 1
+#define MESH_FILE_ALIGNMENT 16
+
+struct MeshFileLod
+{
+    u32 vertexCount;
+    u32 indexCount;
+    float error; // Object space, see LodMesh
+    float sphereRadius;
+    float sphereCenter[3];
+    float aabbMin[3];
+    float aabbMax[3];
+    u32 padding;
+    u64 indexOffset;
+    u64 attribOffsets[MeshAttrib::COUNT]; // 0 if the mesh does not have the attrib
+};
+static_assert(sizeof(MeshFileLod) == 112, "MeshFileLod layout changed, increase MESH_FILE_VERSION");
+
+struct MeshFileHeader
+{
+    u32 magic;
+    u32 version;
+    u32 lodCount;
+    u32 attribMask; // Bit per MeshAttrib::ENUM
+    MeshFileLod lods[MAX_LOD_COUNT];
+};
+
+struct MeshFile
+{
+    MappedFile file;
+    MeshFileHeader* header;
+};
+
+u64 alignMeshFileOffset(u64 offset) {
+    return (offset + MESH_FILE_ALIGNMENT - 1) & ~((u64)MESH_FILE_ALIGNMENT - 1);
+}
+
+// Written so that corrupt offsets/sizes can't overflow
+bool isInFile(MeshFile* f, u64 offset, u64 size) {
+    return offset >= sizeof(MeshFileHeader) && offset <= f->file.size && size <= f->file.size - offset;
+}
+
+// Maps the file and checks the header, returns false (And logs why) if the file is not usable
+bool load(MeshFile* f, const char* path)
+{
+    memset(f, 0, sizeof(MeshFile));
+    f->file = mapFile(path);
+    if (f->file.data == nullptr) {
+        return false;
+    }
+    f->header = (MeshFileHeader*) f->file.data;
+
+    MeshFileHeader* h = f->header;
+    const char* error = nullptr;
+    if (f->file.size < sizeof(MeshFileHeader) || h->magic != MESH_FILE_MAGIC) {
+        error = "Not a mesh file";
+    }
+    else if (h->version != MESH_FILE_VERSION) {
+        error = "Wrong version, convert it again";
+    }
+    else if (h->lodCount == 0 || h->lodCount > MAX_LOD_COUNT) {
+        error = "Invalid lod count";
+    }
+    for (u32 i = 0; error == nullptr && i < h->lodCount; i++)
+    {
+        MeshFileLod& lod = h->lods[i];
+        if (!isInFile(f, lod.indexOffset, (u64)lod.indexCount * sizeof(u32))) {
+            error = "Index stream outside of file";
+        }
+        for (int a = 0; a < MeshAttrib::COUNT && error == nullptr; a++) {
+            bool hasAttrib = (h->attribMask & (1 << a)) != 0;
+            u64 size = (u64)lod.vertexCount * meshAttribInfoTable[a].size;
+            if (hasAttrib && !isInFile(f, lod.attribOffsets[a], size)) {
+                error = "Attrib stream outside of file";
+            }
+        }
+    }
+
+    if (error != nullptr) {
+        loggf("Mesh file %s: %s\n", path, error);
+        unmapFile(&f->file);
+        f->header = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void shutdown(MeshFile* f) {
+    unmapFile(&f->file);
+    f->header = nullptr;
+}
+
+// MeshData pointing into the mapping, valid until the file is shut down.
+// The blks are not owned, shutdown of the MeshData only frees the attrib array.
+void getMeshData(MeshFile* f, int lodIndex, MeshData* m, Allocator* alloc)
+{
+    assert(lodIndex < (int)f->header->lodCount, "Mesh file has no lod %d\n", lodIndex);
+    MeshFileLod& lod = f->header->lods[lodIndex];
+    byte* base = (byte*) f->file.data;
+
+    init(m, alloc);
+    m->ownsData = false;
+    m->vertexCount = lod.vertexCount;
+    m->indexCount = lod.indexCount;
+    m->indexData = Blk(base + lod.indexOffset, (u64)lod.indexCount * sizeof(u32));
+    for (int a = 0; a < MeshAttrib::COUNT; a++) {
+        if (f->header->attribMask & (1 << a)) {
+            Blk stream(base + lod.attribOffsets[a], (u64)lod.vertexCount * meshAttribInfoTable[a].size);
+            m->attribBlks.push_back(AttribBlk((MeshAttrib::ENUM)a, stream));
+        }
+    }
+}
+
+void getBounds(MeshFile* f, int lodIndex, AABB* aabb, BoundingSphere* sphere)
+{
+    MeshFileLod& lod = f->header->lods[lodIndex];
+    *aabb = AABB(vec3(lod.aabbMin[0], lod.aabbMin[1], lod.aabbMin[2]),
+            vec3(lod.aabbMax[0], lod.aabbMax[1], lod.aabbMax[2]));
+    *sphere = BoundingSphere(vec3(lod.sphereCenter[0], lod.sphereCenter[1], lod.sphereCenter[2]), lod.sphereRadius);
+}
+
+// Uploads all lods of the file, afterwards the file may be shut down.
+// The streams are uploaded straight from the mapping, one vbo per attrib,
+// interleaving would need a copy.
+void init(LodMesh* m, MeshFile* f, Allocator* alloc)
+{
+    *m = LodMesh();
+    for (u32 i = 0; i < f->header->lodCount; i++)
+    {
+        MeshData data;
+        getMeshData(f, i, &data, alloc);
+        SCOPE_EXIT(shutdown(&data););
+        AABB aabb;
+        BoundingSphere sphere;
+        getBounds(f, i, &aabb, &sphere);
+        init(addLod(m, f->header->lods[i].error), &data, aabb, sphere, alloc, false);
+    }
+}
+
+// Pads the file up to offset with zeros, then writes the stream
+void writeMeshFileStream(FILE* file, u64* written, u64 offset, const void* data, u64 size)
+{
+    static const byte padding[MESH_FILE_ALIGNMENT] = {};
+    *written += fwrite(padding, 1, offset - *written, file);
+    *written += fwrite(data, 1, size, file);
+}
+
+// Writes the lods (Lod 0 is the full mesh) to a mesh file, all lods must have the same attribs
+bool writeMeshFile(const char* path, MeshData* lods, float* errors, int lodCount)
+{
+    assert(lodCount > 0 && lodCount <= MAX_LOD_COUNT, "Invalid lod count %d\n", lodCount);
+    MeshFileHeader header;
+    memset(&header, 0, sizeof(MeshFileHeader));
+    header.magic = MESH_FILE_MAGIC;
+    header.version = MESH_FILE_VERSION;
+    header.lodCount = lodCount;
+    for (AttribBlk& a : lods[0].attribBlks) {
+        header.attribMask |= 1 << a.attrib;
+    }
+
+    // Offsets and bounds
+    u64 offset = alignMeshFileOffset(sizeof(MeshFileHeader));
+    for (int i = 0; i < lodCount; i++)
+    {
+        MeshData* m = &lods[i];
+        MeshFileLod& lod = header.lods[i];
+        lod.vertexCount = m->vertexCount;
+        lod.indexCount = m->indexCount;
+        lod.error = errors[i];
+        AABB aabb = computeAABB(m);
+        BoundingSphere sphere = computeBoundingSphere(m);
+        memcpy(lod.aabbMin, &aabb.min, sizeof(float) * 3);
+        memcpy(lod.aabbMax, &aabb.max, sizeof(float) * 3);
+        memcpy(lod.sphereCenter, &sphere.center, sizeof(float) * 3);
+        lod.sphereRadius = sphere.radius;
+
+        for (int a = 0; a < MeshAttrib::COUNT; a++) {
+            if ((header.attribMask & (1 << a)) == 0) {
+                continue;
+            }
+            assert(findAttribIndex(m, (MeshAttrib::ENUM)a) != -1, "Lod %d is missing attrib %s\n", i, toStr((MeshAttrib::ENUM)a));
+            lod.attribOffsets[a] = offset;
+            offset = alignMeshFileOffset(offset + (u64)m->vertexCount * meshAttribInfoTable[a].size);
+        }
+        lod.indexOffset = offset;
+        offset = alignMeshFileOffset(offset + (u64)m->indexCount * sizeof(u32));
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) {
+        loggf("Could not open %s for writing\n", path);
+        return false;
+    }
+    SCOPE_EXIT(fclose(file));
+
+    // Streams are written in offset order
+    u64 written = fwrite(&header, 1, sizeof(MeshFileHeader), file);
+    for (int i = 0; i < lodCount; i++)
+    {
+        MeshData* m = &lods[i];
+        MeshFileLod& lod = header.lods[i];
+        for (int a = 0; a < MeshAttrib::COUNT; a++) {
+            if (header.attribMask & (1 << a)) {
+                AttribBlk& blk = m->attribBlks[findAttribIndex(m, (MeshAttrib::ENUM)a)];
+                writeMeshFileStream(file, &written, lod.attribOffsets[a], blk.blk.data, (u64)m->vertexCount * meshAttribInfoTable[a].size);
+            }
+        }
+        writeMeshFileStream(file, &written, lod.indexOffset, m->indexData.data, (u64)m->indexCount * sizeof(u32));
+    }
+
+    if (ferror(file)) {
+        loggf("Writing %s failed\n", path);
+        return false;
+    }
+    return true;
+}
+
+
+
+#endif
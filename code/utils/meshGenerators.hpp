@@ -7,19 +7,19 @@ void createPlaneMeshData(MeshData* m, Allocator* alloc)
 {
     struct Vertex
     {
-        Vertex(vec3 pos, vec3 normal, vec2 uv) : pos(pos), normal(normal), uv(uv){}
+        constexpr Vertex(vec3 pos, vec3 normal, vec2 uv) : pos(pos), normal(normal), uv(uv){}
         vec3 pos;
         vec3 normal;
         vec2 uv;
     };
 
-    Vertex vertexData[] = {
+    static constexpr Vertex vertexData[] = {
         Vertex(vec3(-1, 0, -1), vec3(0, 1, 0), vec2(0, 0)),
         Vertex(vec3(-1, 0, 1), vec3(0, 1, 0), vec2(0, 1)),
         Vertex(vec3(1, 0, 1), vec3(0, 1, 0), vec2(1, 1)),
         Vertex(vec3(1, 0, -1), vec3(0, 1, 0), vec2(1, 0))
     };
-    u32 indexData[] = {
+    static constexpr u32 indexData[] = {
         0, 1, 2,
         0, 2, 3
     };
@@ -44,13 +44,13 @@ void createCubeMeshData(MeshData* m, Allocator* alloc)
     struct Vertex
     {
         Vertex(){};
-        Vertex(vec3 pos, vec3 normal, vec2 uv) : pos(pos), normal(normal), uv(uv){}
+        constexpr Vertex(vec3 pos, vec3 normal, vec2 uv) : pos(pos), normal(normal), uv(uv){}
         vec3 pos;
         vec3 normal;
         vec2 uv;
     };
-    // Fill vbo
-    Vertex vertexData[] = {
+    // Fill vbo, data is generated at compile time
+    static constexpr Vertex vertexData[] = {
         // Front face
         Vertex(vec3(-1.0f, -1.0f, 1.0f), vec3(0.0f, 0.0f, 1.0f), vec2(0, 0)),
         Vertex(vec3( 1.0f, -1.0f, 1.0f), vec3(0.0f, 0.0f, 1.0f), vec2(1, 0)),
@@ -82,7 +82,7 @@ void createCubeMeshData(MeshData* m, Allocator* alloc)
         Vertex(vec3( 1.0f, -1.0f, -1.0f), vec3(0.0f, -1.0f, 0.0f), vec2(1, 1)),
         Vertex(vec3(-1.0f, -1.0f, -1.0f), vec3(0.0f, -1.0f, 0.0f), vec2(0, 1)),
     };
-    u32 indexData[] = 
+    static constexpr u32 indexData[] = 
     {
         // Front
         0, 1, 2, 0, 2, 3,
@@ -113,15 +113,64 @@ void createCubeMesh(AutoMesh* m, Allocator* alloc)
     init(m, &cubeMeshData, alloc);
 }
 
+// Unit uv sphere, the seam column is duplicated for the uvs
+void createSphereMeshData(MeshData* m, int rings, int segments, Allocator* alloc)
+{
+    struct Vertex
+    {
+        vec3 pos;
+        vec3 normal;
+        vec2 uv;
+    };
+
+    int vertexCount = (rings + 1) * (segments + 1);
+    int indexCount = (rings - 1) * segments * 6; // No degenerate triangles at the poles
+    Blk vertexBlk = alloc->alloc(sizeof(Vertex) * vertexCount);
+    Blk indexBlk = alloc->alloc(sizeof(u32) * indexCount);
+    SCOPE_EXIT(alloc->dealloc(vertexBlk););
+    SCOPE_EXIT(alloc->dealloc(indexBlk););
+    Vertex* vertices = (Vertex*) vertexBlk.data;
+    u32* indices = (u32*) indexBlk.data;
+
+    for (int r = 0; r <= rings; r++) {
+        float theta = PI * r / rings;
+        for (int s = 0; s <= segments; s++) {
+            float phi = 2.0f * PI * s / segments;
+            Vertex& v = vertices[r * (segments + 1) + s];
+            v.pos = vec3(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+            v.normal = v.pos;
+            v.uv = vec2((float)s / segments, (float)r / rings);
+        }
+    }
+    int i = 0;
+    for (int r = 0; r < rings; r++) {
+        for (int s = 0; s < segments; s++) {
+            u32 a = r * (segments + 1) + s;
+            u32 b = a + segments + 1;
+            if (r != rings - 1) {
+                indices[i++] = a + 1; indices[i++] = b + 1; indices[i++] = b;
+            }
+            if (r != 0) {
+                indices[i++] = a; indices[i++] = a + 1; indices[i++] = b;
+            }
+        }
+    }
+
+    using namespace MeshAttrib;
+    init(m, alloc);
+    setAttribs(m, vertexCount, vertices, {POS3, NORMAL, UV});
+    setIndices(m, indexCount, indices);
+}
+
 void createPlane2DMeshData(MeshData* m, Allocator* alloc) 
 {
-    vec2 vertexData[] = {
+    static constexpr vec2 vertexData[] = {
         vec2(-1, -1),
         vec2(1, -1),
         vec2(1, 1),
         vec2(-1, 1),
     };
-    u32 indexData[] = {
+    static constexpr u32 indexData[] = {
         0, 1, 2,
         0, 2, 3
     };
@@ -0,0 +1,356 @@
+#ifndef __MESH_OPTIMIZER_HPP__
+#define __MESH_OPTIMIZER_HPP__
+
+// ----------------------
+// --- MESH OPTIMIZER ---
+// ----------------------
+// Reorders the indices and vertices of a MeshData so the gpu transforms fewer vertices:
+//  - Vertex cache: Triangles are reordered with Tipsify (Sander et al. 2007, "Fast
+//    Triangle Reordering for Vertex Locality and Reduced Overdraw"), linear in the
+//    triangle count. Fans around a vertex are emitted while the vertex is still cached.
+//  - Overdraw (Optional): Tipsify breaks the output into clusters at dead ends,
+//    the clusters are sorted so that outward facing ones on the hull are drawn first.
+//  - Vertex fetch: Vertices are renumbered in order of first use, unused ones are removed.
+//
+// Nothing here uses the tmpAlloc, so meshes can be optimized on multiple threads (See meshConverter).
+//
+// Quality is measured with a fifo cache simulation:
+//     ACMR (Average cache miss ratio) = transformed vertices / triangle count, 0.5 is optimal
+//     ATVR (Average transform to vertex ratio) = transformed vertices / vertex count, 1.0 is optimal
+
+#include "../rendering/renderer.hpp"
+
+#define MESH_OPTIMIZER_CACHE_SIZE 16
+
+struct VertexCacheStats
+{
+    int transforms; // Cache misses
+    float acmr;
+    float atvr;
+};
+
+void print(VertexCacheStats* s)
+{
+    loggf("ACMR: %1.3f, ATVR: %1.3f (%d transforms)", s->acmr, s->atvr, s->transforms);
+}
+
+VertexCacheStats analyzeVertexCache(const u32* indices, int indexCount, int vertexCount, 
+        Allocator* alloc, int cacheSize = MESH_OPTIMIZER_CACHE_SIZE)
+{
+    VertexCacheStats s;
+    memset(&s, 0, sizeof(VertexCacheStats));
+    if (indexCount == 0 || vertexCount == 0) {
+        return s;
+    }
+
+    // Fifo through timestamps, a vertex is cached if less than cacheSize vertices were added after it
+    Blk cacheTimeBlk = alloc->alloc(sizeof(int) * vertexCount);
+    SCOPE_EXIT(alloc->dealloc(cacheTimeBlk););
+    int* cacheTime = (int*) cacheTimeBlk.data;
+    memset(cacheTime, 0, sizeof(int) * vertexCount);
+    int time = cacheSize + 1;
+    for (int i = 0; i < indexCount; i++) {
+        u32 v = indices[i];
+        if (time - cacheTime[v] > cacheSize) {
+            cacheTime[v] = time++;
+            s.transforms++;
+        }
+    }
+    s.acmr = (float) s.transforms / (indexCount / 3);
+    s.atvr = (float) s.transforms / vertexCount;
+    return s;
+}
+
+VertexCacheStats analyzeVertexCache(MeshData* m, int cacheSize = MESH_OPTIMIZER_CACHE_SIZE) {
+    return analyzeVertexCache((u32*) m->indexData.data, m->indexCount, m->vertexCount, m->alloc, cacheSize);
+}
+
+// Tipsify, writes the reordered indices to out (Must not alias indices).
+// If clusterStarts is not null, the first triangle of each cluster is written to it
+// (At most triangle count entries), returns the cluster count.
+int optimizeVertexCache(u32* out, const u32* indices, int indexCount, int vertexCount,
+        Allocator* alloc, u32* clusterStarts = nullptr, int cacheSize = MESH_OPTIMIZER_CACHE_SIZE)
+{
+    int triangleCount = indexCount / 3;
+    if (triangleCount == 0) {
+        return 0;
+    }
+
+    // Scratch memory, may be larger than the tmpAlloc for big meshes
+    Blk scratch = alloc->alloc(sizeof(int) * (vertexCount * 3 + 1) + sizeof(u32) * (indexCount * 2) + triangleCount);
+    SCOPE_EXIT(alloc->dealloc(scratch););
+    int* live = (int*) scratch.data;              // Triangles not yet emitted per vertex
+    int* adjOffset = live + vertexCount;          // vertexCount + 1
+    int* cacheTime = adjOffset + vertexCount + 1;
+    u32* adjacency = (u32*) (cacheTime + vertexCount);
+    u32* deadEnd = adjacency + indexCount;
+    bool* emitted = (bool*) (deadEnd + indexCount);
+
+    // Vertex -> triangle adjacency
+    memset(live, 0, sizeof(int) * vertexCount);
+    for (int i = 0; i < indexCount; i++) {
+        live[indices[i]]++;
+    }
+    adjOffset[0] = 0;
+    for (int v = 0; v < vertexCount; v++) {
+        adjOffset[v + 1] = adjOffset[v] + live[v];
+    }
+    memcpy(cacheTime, adjOffset, sizeof(int) * vertexCount); // Used as insert cursor
+    for (int i = 0; i < indexCount; i++) {
+        adjacency[cacheTime[indices[i]]++] = i / 3;
+    }
+    memset(cacheTime, 0, sizeof(int) * vertexCount);
+    memset(emitted, 0, triangleCount);
+
+    int time = cacheSize + 1;
+    int deadEndCount = 0;
+    int cursor = 0; // Next vertex to check if the dead end stack is empty
+    int outCount = 0;
+    int clusterCount = 0;
+    int fanning = 0;
+    bool newCluster = true;
+    while (fanning >= 0)
+    {
+        // Emit all remaining triangles around the fanning vertex
+        int candidatesStart = deadEndCount;
+        for (int a = adjOffset[fanning]; a < adjOffset[fanning + 1]; a++)
+        {
+            u32 t = adjacency[a];
+            if (emitted[t]) {
+                continue;
+            }
+            if (newCluster && clusterStarts != nullptr) {
+                clusterStarts[clusterCount] = outCount / 3;
+            }
+            clusterCount += newCluster ? 1 : 0;
+            newCluster = false;
+            for (int k = 0; k < 3; k++) {
+                u32 v = indices[t * 3 + k];
+                out[outCount++] = v;
+                deadEnd[deadEndCount++] = v;
+                live[v]--;
+                if (time - cacheTime[v] > cacheSize) {
+                    cacheTime[v] = time++;
+                }
+            }
+            emitted[t] = true;
+        }
+
+        // Next fanning vertex: The one of the last triangles that stays longest in the cache
+        int next = -1;
+        int bestPriority = -1;
+        for (int c = candidatesStart; c < deadEndCount; c++)
+        {
+            u32 v = deadEnd[c];
+            if (live[v] <= 0) {
+                continue;
+            }
+            int priority = 0;
+            if (time - cacheTime[v] + 2 * live[v] <= cacheSize) {
+                priority = time - cacheTime[v];
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                next = v;
+            }
+        }
+
+        // Dead end, continue at a recently used vertex or the next unfinished one
+        if (next == -1)
+        {
+            newCluster = true;
+            while (deadEndCount > 0) {
+                u32 v = deadEnd[--deadEndCount];
+                if (live[v] > 0) {
+                    next = v;
+                    break;
+                }
+            }
+            while (next == -1 && cursor < vertexCount) {
+                if (live[cursor] > 0) {
+                    next = cursor;
+                }
+                cursor++;
+            }
+        }
+        fanning = next;
+    }
+    assert(outCount == triangleCount * 3, "Tipsify did not emit all triangles\n");
+
+    return clusterCount;
+}
+
+// Sorts the clusters (Ranges of triangles) of indices so that clusters facing away from the
+// mesh center are drawn first, these are the most likely to occlude the others
+void optimizeOverdraw(u32* indices, int indexCount, const float* positions, int vertexCount,
+        const u32* clusterStarts, int clusterCount, Allocator* alloc)
+{
+    int triangleCount = indexCount / 3;
+    if (clusterCount <= 1) {
+        return;
+    }
+
+    Blk scratch = alloc->alloc(sizeof(u64) * clusterCount * 2 + sizeof(u32) * (clusterCount * 2 + indexCount));
+    SCOPE_EXIT(alloc->dealloc(scratch););
+    u64* keys = (u64*) scratch.data;
+    u64* tmpKeys = keys + clusterCount;
+    u32* order = (u32*) (tmpKeys + clusterCount);
+    u32* tmpOrder = order + clusterCount;
+    u32* copy = tmpOrder + clusterCount;
+    memcpy(copy, indices, sizeof(u32) * indexCount);
+
+    vec3 meshCenter = vec3(0.0f);
+    for (int v = 0; v < vertexCount; v++) {
+        meshCenter = meshCenter + vec3(positions[v*3], positions[v*3 + 1], positions[v*3 + 2]);
+    }
+    meshCenter = meshCenter / (float) vertexCount;
+
+    for (int c = 0; c < clusterCount; c++)
+    {
+        int start = clusterStarts[c];
+        int end = c + 1 < clusterCount ? clusterStarts[c + 1] : triangleCount;
+        vec3 normal = vec3(0.0f);
+        vec3 center = vec3(0.0f);
+        float area = 0.0f;
+        for (int t = start; t < end; t++)
+        {
+            const float* p0 = &positions[copy[t*3 + 0] * 3];
+            const float* p1 = &positions[copy[t*3 + 1] * 3];
+            const float* p2 = &positions[copy[t*3 + 2] * 3];
+            vec3 a = vec3(p0[0], p0[1], p0[2]);
+            vec3 b = vec3(p1[0], p1[1], p1[2]);
+            vec3 d = vec3(p2[0], p2[1], p2[2]);
+            vec3 n = cross(b - a, d - a); // Length is twice the area
+            float triArea = length(n);
+            normal = normal + n;
+            center = center + (a + b + d) * (triArea / 3.0f);
+            area += triArea;
+        }
+        if (area > 0.0f) {
+            center = center / area;
+        }
+        float metric = dot(center - meshCenter, normalizeSafe(normal));
+
+        // Float to sortable bits, inverted so that the largest metric comes first
+        u32 bits;
+        memcpy(&bits, &metric, sizeof(u32));
+        bits = (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+        keys[c] = (u64) ~bits;
+        order[c] = c;
+    }
+    order = radixSort(keys, order, clusterCount, tmpKeys, tmpOrder);
+
+    int outCount = 0;
+    for (int i = 0; i < clusterCount; i++)
+    {
+        int c = order[i];
+        int start = clusterStarts[c];
+        int end = c + 1 < clusterCount ? clusterStarts[c + 1] : triangleCount;
+        memcpy(&indices[outCount], &copy[start * 3], sizeof(u32) * (end - start) * 3);
+        outCount += (end - start) * 3;
+    }
+}
+
+// Mapped meshes (See getMeshData) are read only, the optimizations work on an owned copy
+// of the indices. The attribs are replaced by reorderVertices, the mesh then owns all blks.
+void copyForeignIndices(MeshData* m)
+{
+    if (m->ownsData) {
+        return;
+    }
+    Blk indexData = m->alloc->alloc(sizeof(u32) * m->indexCount);
+    memcpy(indexData.data, m->indexData.data, sizeof(u32) * m->indexCount);
+    m->indexData = indexData;
+}
+
+// optimizeVertexFetch on indices that are already owned
+void reorderVertices(MeshData* m)
+{
+    if (m->vertexCount == 0) {
+        return;
+    }
+    Blk remapBlk = m->alloc->alloc(sizeof(u32) * m->vertexCount);
+    SCOPE_EXIT(m->alloc->dealloc(remapBlk););
+    u32* remap = (u32*) remapBlk.data;
+    memset(remap, 0xFF, sizeof(u32) * m->vertexCount);
+
+    u32* indices = (u32*) m->indexData.data;
+    u32 newCount = 0;
+    for (int i = 0; i < m->indexCount; i++) {
+        u32& r = remap[indices[i]];
+        if (r == 0xFFFFFFFF) {
+            r = newCount++;
+        }
+        indices[i] = r;
+    }
+
+    for (AttribBlk& a : m->attribBlks)
+    {
+        int size = meshAttribInfoTable[a.attrib].size;
+        Blk reordered = m->alloc->alloc(size * newCount);
+        byte* from = (byte*) a.blk.data;
+        byte* to = (byte*) reordered.data;
+        for (int v = 0; v < m->vertexCount; v++) {
+            if (remap[v] != 0xFFFFFFFF) {
+                memcpy(&to[remap[v] * size], &from[v * size], size);
+            }
+        }
+        if (m->ownsData) {
+            m->alloc->dealloc(a.blk);
+        }
+        a.blk = reordered;
+    }
+    m->vertexCount = newCount;
+    m->ownsData = true;
+}
+
+// Renumbers the vertices in order of first use and reorders all attribs of the mesh,
+// vertices that are not referenced by any index are removed
+void optimizeVertexFetch(MeshData* m)
+{
+    if (m->vertexCount == 0) {
+        return;
+    }
+    copyForeignIndices(m);
+    reorderVertices(m);
+}
+
+// Runs all optimizations on the mesh and logs the cache stats before and after.
+// Overdraw optimization needs POS3 and is skipped otherwise.
+void optimizeMesh(MeshData* m, bool optimizeForOverdraw = false, bool logStats = true)
+{
+    if (m->indexCount < 3) {
+        return;
+    }
+    copyForeignIndices(m);
+    u32* indices = (u32*) m->indexData.data;
+    VertexCacheStats before = analyzeVertexCache(m);
+
+    int triangleCount = m->indexCount / 3;
+    Blk outBlk = m->alloc->alloc(sizeof(u32) * m->indexCount + sizeof(u32) * triangleCount);
+    SCOPE_EXIT(m->alloc->dealloc(outBlk););
+    u32* out = (u32*) outBlk.data;
+    u32* clusterStarts = out + m->indexCount;
+    int clusterCount = optimizeVertexCache(out, indices, m->indexCount, m->vertexCount, m->alloc, clusterStarts);
+    memcpy(indices, out, sizeof(u32) * m->indexCount);
+
+    int posIndex = findAttribIndex(m, MeshAttrib::POS3);
+    if (optimizeForOverdraw && posIndex != -1) {
+        optimizeOverdraw(indices, m->indexCount, (float*) m->attribBlks[posIndex].blk.data, m->vertexCount,
+                clusterStarts, clusterCount, m->alloc);
+    }
+    reorderVertices(m);
+
+    if (logStats) {
+        VertexCacheStats after = analyzeVertexCache(m);
+        loggf("optimizeMesh (%d triangles, %d clusters): ", triangleCount, clusterCount);
+        print(&before);
+        loggf(" -> ");
+        print(&after);
+        loggf("\n");
+    }
+}
+
+
+
+#endif
@@ -0,0 +1,441 @@
+#ifndef __MESH_SIMPLIFIER_HPP__
+#define __MESH_SIMPLIFIER_HPP__
+
+// -----------------------
+// --- MESH SIMPLIFIER ---
+// -----------------------
+// Reduces the triangle count of a MeshData with quadric error metrics (Garland/Heckbert 1997).
+// Every vertex accumulates the (area weighted) planes of its triangles, collapsing the edge
+// u->v costs the squared distance of v to the planes of u and v.
+// Only half edge collapses are done (u is moved onto the existing vertex v), so the attribs
+// never have to be interpolated and the simplified mesh reuses the vertices of the source.
+//
+// Seams and borders: An edge that is used by only one triangle (In index space) is a border.
+// Uv and normal seams are borders as well, since the vertices on both sides are different.
+// Vertices on borders are locked, so seams and open edges keep their exact shape.
+//
+// Collapses are done in passes: All edges are sorted by cost, then the cheapest are
+// collapsed as long as they do not touch a vertex that was changed in the same pass.
+//
+// LodMesh holds a chain of simplified meshes, selectLod picks one from the projected size.
+
+#include <cfloat>
+#include "meshOptimizer.hpp"
+
+// Symmetric 4x4 matrix of the plane equations
+struct Quadric
+{
+    float a00, a01, a02, a03;
+    float      a11, a12, a13;
+    float           a22, a23;
+    float                a33;
+};
+
+Quadric planeQuadric(const vec3& n, float d, float weight)
+{
+    Quadric q;
+    q.a00 = n.x * n.x * weight; q.a01 = n.x * n.y * weight; q.a02 = n.x * n.z * weight; q.a03 = n.x * d * weight;
+    q.a11 = n.y * n.y * weight; q.a12 = n.y * n.z * weight; q.a13 = n.y * d * weight;
+    q.a22 = n.z * n.z * weight; q.a23 = n.z * d * weight;
+    q.a33 = d * d * weight;
+    return q;
+}
+
+void add(Quadric* q, const Quadric& o)
+{
+    q->a00 += o.a00; q->a01 += o.a01; q->a02 += o.a02; q->a03 += o.a03;
+    q->a11 += o.a11; q->a12 += o.a12; q->a13 += o.a13;
+    q->a22 += o.a22; q->a23 += o.a23;
+    q->a33 += o.a33;
+}
+
+// Sum of squared (weighted) distances of p to the planes
+float evaluate(const Quadric& q, const vec3& p)
+{
+    float x = p.x, y = p.y, z = p.z;
+    float e = q.a00*x*x + 2*q.a01*x*y + 2*q.a02*x*z + 2*q.a03*x
+            + q.a11*y*y + 2*q.a12*y*z + 2*q.a13*y
+            + q.a22*z*z + 2*q.a23*z
+            + q.a33;
+    return e < 0.0f ? 0.0f : e;
+}
+
+struct EdgeCollapse
+{
+    u32 from;
+    u32 to;
+    float error;
+};
+
+// Small open addressing set of directed edges, used to find border edges
+struct EdgeSet
+{
+    u64* keys; // 0 is empty, edges are stored with +1
+    u32 mask;
+};
+
+u64 hashEdge(u64 key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    return key;
+}
+
+void insert(EdgeSet* s, u32 a, u32 b)
+{
+    u64 key = (((u64)a << 32) | b) + 1;
+    u32 slot = (u32)hashEdge(key) & s->mask;
+    while (s->keys[slot] != 0 && s->keys[slot] != key) {
+        slot = (slot + 1) & s->mask;
+    }
+    s->keys[slot] = key;
+}
+
+bool contains(EdgeSet* s, u32 a, u32 b)
+{
+    u64 key = (((u64)a << 32) | b) + 1;
+    u32 slot = (u32)hashEdge(key) & s->mask;
+    while (s->keys[slot] != 0) {
+        if (s->keys[slot] == key) {
+            return true;
+        }
+        slot = (slot + 1) & s->mask;
+    }
+    return false;
+}
+
+vec3 getPos(const float* positions, u32 v) {
+    return vec3(positions[v*3], positions[v*3 + 1], positions[v*3 + 2]);
+}
+
+// Simplifies src until it has at most targetIndexCount indices or the next collapse would
+// exceed maxError (Distance in object space). The result is written to dst (Initialized here,
+// vertex cache and fetch optimized). Returns the error of the result, needs POS3.
+float simplifyMesh(MeshData* dst, MeshData* src, int targetIndexCount, float maxError, Allocator* alloc)
+{
+    int posIndex = findAttribIndex(src, MeshAttrib::POS3);
+    assert(posIndex != -1, "simplifyMesh called on mesh without POS3\n");
+    const float* positions = (const float*) src->attribBlks[posIndex].blk.data;
+    int vertexCount = src->vertexCount;
+    int indexCount = src->indexCount;
+    int triangleCount = indexCount / 3;
+
+    init(dst, alloc);
+    for (AttribBlk& a : src->attribBlks) {
+        AttribBlk copy(a.attrib, alloc->alloc(a.blk.size));
+        memcpy(copy.blk.data, a.blk.data, a.blk.size);
+        dst->attribBlks.push_back(copy);
+    }
+    dst->vertexCount = vertexCount;
+    setIndices(dst, indexCount, src->indexData.data);
+    u32* indices = (u32*) dst->indexData.data;
+    if (triangleCount == 0) {
+        return 0.0f;
+    }
+
+    // Scratch memory
+    u32 edgeSetSize = 1;
+    while (edgeSetSize < (u32)indexCount * 2) {
+        edgeSetSize *= 2;
+    }
+    Blk scratch = alloc->alloc(sizeof(Quadric) * vertexCount + sizeof(u64) * edgeSetSize
+            + sizeof(int) * (vertexCount + 1) + sizeof(u32) * indexCount
+            + (sizeof(EdgeCollapse) + sizeof(u64) * 2 + sizeof(u32) * 2) * indexCount
+            + vertexCount * 2);
+    SCOPE_EXIT(alloc->dealloc(scratch););
+    Quadric* quadrics = (Quadric*) scratch.data;
+    EdgeSet edges;
+    edges.keys = (u64*) (quadrics + vertexCount);
+    edges.mask = edgeSetSize - 1;
+    u64* keys = edges.keys + edgeSetSize;
+    u64* tmpKeys = keys + indexCount;
+    int* adjOffset = (int*) (tmpKeys + indexCount);
+    u32* adjacency = (u32*) (adjOffset + vertexCount + 1);
+    EdgeCollapse* collapses = (EdgeCollapse*) (adjacency + indexCount);
+    u32* order = (u32*) (collapses + indexCount);
+    u32* tmpOrder = order + indexCount;
+    bool* locked = (bool*) (tmpOrder + indexCount);
+    bool* touched = locked + vertexCount;
+
+    // Quadrics of the triangle planes
+    memset(quadrics, 0, sizeof(Quadric) * vertexCount);
+    for (int t = 0; t < triangleCount; t++)
+    {
+        vec3 p0 = getPos(positions, indices[t*3]);
+        vec3 p1 = getPos(positions, indices[t*3 + 1]);
+        vec3 p2 = getPos(positions, indices[t*3 + 2]);
+        vec3 n = cross(p1 - p0, p2 - p0);
+        float area = length(n);
+        if (area == 0.0f) {
+            continue;
+        }
+        n = n / area;
+        Quadric q = planeQuadric(n, -dot(n, p0), area * 0.5f);
+        for (int k = 0; k < 3; k++) {
+            add(&quadrics[indices[t*3 + k]], q);
+        }
+    }
+
+    // Lock border vertices, the edge a->b is a border if no triangle has b->a
+    memset(edges.keys, 0, sizeof(u64) * edgeSetSize);
+    memset(locked, 0, vertexCount);
+    for (int i = 0; i < indexCount; i++) {
+        u32 a = indices[i];
+        u32 b = indices[i % 3 == 2 ? i - 2 : i + 1];
+        insert(&edges, a, b);
+    }
+    for (int i = 0; i < indexCount; i++) {
+        u32 a = indices[i];
+        u32 b = indices[i % 3 == 2 ? i - 2 : i + 1];
+        if (!contains(&edges, b, a)) {
+            locked[a] = true;
+            locked[b] = true;
+        }
+    }
+
+    float maxErrorSq = maxError * maxError;
+    float resultErrorSq = 0.0f;
+    while (indexCount > targetIndexCount)
+    {
+        // Vertex -> triangle adjacency of the remaining triangles
+        memset(adjOffset, 0, sizeof(int) * (vertexCount + 1));
+        for (int i = 0; i < indexCount; i++) {
+            adjOffset[indices[i] + 1]++;
+        }
+        for (int v = 0; v < vertexCount; v++) {
+            adjOffset[v + 1] += adjOffset[v];
+        }
+        for (int i = 0; i < indexCount; i++) {
+            adjacency[adjOffset[indices[i]]++] = i / 3;
+        }
+        for (int v = vertexCount; v > 0; v--) {
+            adjOffset[v] = adjOffset[v - 1];
+        }
+        adjOffset[0] = 0;
+
+        // Cheapest direction of every edge
+        int collapseCount = 0;
+        for (int i = 0; i < indexCount; i++)
+        {
+            u32 a = indices[i];
+            u32 b = indices[i % 3 == 2 ? i - 2 : i + 1];
+            if (a > b && !locked[a] && !locked[b]) {
+                continue; // Interior edges are seen twice
+            }
+            vec3 pa = getPos(positions, a);
+            vec3 pb = getPos(positions, b);
+            Quadric q = quadrics[a];
+            add(&q, quadrics[b]);
+            float errorAB = locked[a] ? FLT_MAX : evaluate(q, pb);
+            float errorBA = locked[b] ? FLT_MAX : evaluate(q, pa);
+            if (errorAB == FLT_MAX && errorBA == FLT_MAX) {
+                continue;
+            }
+            EdgeCollapse& c = collapses[collapseCount];
+            c.from = errorAB <= errorBA ? a : b;
+            c.to = errorAB <= errorBA ? b : a;
+            c.error = min(errorAB, errorBA);
+            // Positive floats sort like their bits
+            u32 bits;
+            memcpy(&bits, &c.error, sizeof(u32));
+            keys[collapseCount] = bits;
+            order[collapseCount] = collapseCount;
+            collapseCount++;
+        }
+        if (collapseCount == 0) {
+            break;
+        }
+        u32* sorted = radixSort(keys, order, collapseCount, tmpKeys, tmpOrder);
+
+        // Collapse the cheapest edges, each removes about two triangles
+        int trianglesToRemove = (indexCount - targetIndexCount) / 3;
+        int removed = 0;
+        memset(touched, 0, vertexCount);
+        for (int i = 0; i < collapseCount && removed < trianglesToRemove; i++)
+        {
+            EdgeCollapse& c = collapses[sorted[i]];
+            if (c.error > maxErrorSq) {
+                break;
+            }
+            if (touched[c.from] || touched[c.to]) {
+                continue;
+            }
+
+            // Reject collapses that flip a triangle
+            bool flips = false;
+            vec3 target = getPos(positions, c.to);
+            for (int a = adjOffset[c.from]; a < adjOffset[c.from + 1] && !flips; a++)
+            {
+                u32* tri = &indices[adjacency[a] * 3];
+                if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) {
+                    continue;
+                }
+                vec3 p[3];
+                for (int k = 0; k < 3; k++) {
+                    p[k] = getPos(positions, tri[k]);
+                }
+                vec3 before = cross(p[1] - p[0], p[2] - p[0]);
+                for (int k = 0; k < 3; k++) {
+                    if (tri[k] == c.from) p[k] = target;
+                }
+                vec3 after = cross(p[1] - p[0], p[2] - p[0]);
+                flips = dot(before, after) <= 0.0f;
+            }
+            if (flips) {
+                continue;
+            }
+
+            for (int a = adjOffset[c.from]; a < adjOffset[c.from + 1]; a++)
+            {
+                u32* tri = &indices[adjacency[a] * 3];
+                bool degenerate = false;
+                for (int k = 0; k < 3; k++) {
+                    degenerate |= tri[k] == c.to;
+                }
+                removed += degenerate ? 1 : 0;
+                for (int k = 0; k < 3; k++) {
+                    if (tri[k] == c.from) tri[k] = c.to;
+                    touched[tri[k]] = true;
+                }
+            }
+            add(&quadrics[c.to], quadrics[c.from]);
+            touched[c.from] = true;
+            resultErrorSq = max(resultErrorSq, c.error);
+        }
+        if (removed == 0) {
+            break;
+        }
+
+        // Remove collapsed triangles
+        int writeCount = 0;
+        for (int i = 0; i < indexCount; i += 3) {
+            u32 a = indices[i], b = indices[i + 1], d = indices[i + 2];
+            if (a == b || b == d || a == d) {
+                continue;
+            }
+            indices[writeCount++] = a;
+            indices[writeCount++] = b;
+            indices[writeCount++] = d;
+        }
+        indexCount = writeCount;
+    }
+    dst->indexCount = indexCount;
+
+    optimizeMesh(dst, false, false);
+    return sqrtf(resultErrorSq);
+}
+
+
+
+// LOD MESH
+#define MAX_LOD_COUNT 4
+// Maximum projected error (Fraction of the screen height) of a lod, 0.002 is ~2 pixels at 1080p
+#define LOD_MAX_SCREEN_ERROR 0.002f
+// Relative margin around the switch sizes, so lods do not flicker at the boundary
+#define LOD_HYSTERESIS 0.1f
+// Triangle ratios of the generated lods
+#define LOD_DEFAULT_RATIOS {0.5f, 0.25f, 0.1f}
+
+struct LodMesh
+{
+    AutoMesh lods[MAX_LOD_COUNT];
+    float errors[MAX_LOD_COUNT];      // Object space
+    float screenSizes[MAX_LOD_COUNT]; // Lod i is used when the mesh is smaller than screenSizes[i]
+    int lodCount;
+};
+
+// Per object state, so that the hysteresis works when many objects share a LodMesh
+struct LodInstance
+{
+    LodMesh* mesh;
+    int lod;
+};
+
+// Simplifies src to each of the triangle ratios, results that do not remove triangles compared to
+// the previous one (E.g. everything is on a seam) are skipped. Returns the number of written lods.
+int generateLods(MeshData* lods, float* errors, int maxLods, MeshData* src, Allocator* alloc,
+        std::initializer_list<float> ratios = LOD_DEFAULT_RATIOS)
+{
+    int count = 0;
+    int lastIndexCount = src->indexCount;
+    for (float ratio : ratios)
+    {
+        if (count == maxLods) {
+            break;
+        }
+        int targetIndexCount = ((int)(src->indexCount / 3 * ratio)) * 3;
+        MeshData* lod = &lods[count];
+        float error = simplifyMesh(lod, src, targetIndexCount, FLT_MAX, alloc);
+        if (lod->indexCount >= lastIndexCount) {
+            shutdown(lod);
+            continue;
+        }
+        lastIndexCount = lod->indexCount;
+        errors[count++] = error;
+    }
+    return count;
+}
+
+// Returns the AutoMesh of the next lod, which the caller has to init.
+// Lod 0 must be the full mesh, the switch size of the others is derived from their error
+AutoMesh* addLod(LodMesh* m, float error)
+{
+    assert(m->lodCount < MAX_LOD_COUNT, "LodMesh already has MAX_LOD_COUNT lods\n");
+    int i = m->lodCount++;
+    m->errors[i] = error;
+    if (i == 0) {
+        m->screenSizes[0] = FLT_MAX;
+        return &m->lods[0];
+    }
+    // screenSize is the projected diameter, so the projected error is screenSize * error / (2 * radius)
+    float radius = m->lods[0].boundingSphere.radius;
+    m->screenSizes[i] = error > 0.0f ? LOD_MAX_SCREEN_ERROR * 2.0f * radius / error : FLT_MAX;
+    m->screenSizes[i] = min(m->screenSizes[i], m->screenSizes[i - 1]);
+    return &m->lods[i];
+}
+
+// Lod 0 is the source mesh, the others are generated with generateLods
+void init(LodMesh* m, MeshData* src, Allocator* alloc, std::initializer_list<float> ratios = LOD_DEFAULT_RATIOS)
+{
+    *m = LodMesh();
+    init(addLod(m, 0.0f), src, alloc);
+
+    MeshData lods[MAX_LOD_COUNT - 1];
+    float errors[MAX_LOD_COUNT - 1];
+    int count = generateLods(lods, errors, MAX_LOD_COUNT - 1, src, alloc, ratios);
+    for (int i = 0; i < count; i++) 
+    {
+        init(addLod(m, errors[i]), &lods[i], alloc);
+        loggf("Lod %d: %d triangles, error %f, used below screen size %f\n",
+                i + 1, lods[i].indexCount / 3, errors[i], m->screenSizes[i + 1]);
+        shutdown(&lods[i]);
+    }
+}
+
+void shutdown(LodMesh* m) {
+    for (int i = 0; i < m->lodCount; i++) {
+        shutdown(&m->lods[i]);
+    }
+}
+
+void init(LodInstance* i, LodMesh* m) {
+    i->mesh = m;
+    i->lod = 0;
+}
+
+// screenSize is the projected diameter of the bounding sphere divided by the screen height
+int selectLod(LodMesh* m, float screenSize, int currentLod)
+{
+    int lod = min(currentLod, m->lodCount - 1);
+    while (lod + 1 < m->lodCount && screenSize < m->screenSizes[lod + 1] * (1.0f - LOD_HYSTERESIS)) {
+        lod++;
+    }
+    while (lod > 0 && screenSize > m->screenSizes[lod] * (1.0f + LOD_HYSTERESIS)) {
+        lod--;
+    }
+    return lod;
+}
+
+
+
+#endif
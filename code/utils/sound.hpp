@@ -42,7 +42,10 @@ double oscillatorGetAmp(Oscillator* osc, double t)
     {
         case Waveform::SINUS:
         {
-            return sin(t * 2 * PI * osc->frequency);
+            // Phase is reduced in double, so precision does not degrade for long sounds
+            double phase = t * osc->frequency;
+            phase -= floor(phase);
+            return fastSin((float)(phase * 2.0 * PI));
         }
         case Waveform::SQUARE:
         {
@@ -10,7 +10,7 @@ struct Transform
     }
 
     mat3 toNormalMat() const {
-        return mat3(1);
+        return normalMatrix(toModelMat());
     }
 
     vec3 pos;
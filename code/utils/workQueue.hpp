@@ -0,0 +1,128 @@
+#ifndef __WORK_QUEUE_HPP__
+#define __WORK_QUEUE_HPP__
+
+// ------------------
+// --- WORK QUEUE ---
+// ------------------
+// Fixed pool of worker threads executing WorkFuncs in submission order.
+// The threads are owned by the game module, so the queue must be shut down in
+// gameBeforeReload: shutdown finishes all queued work and joins the workers before
+// the dll is unloaded.
+//
+// Work runs in parallel to the game tick, it must not touch gl, tmpAlloc or any
+// allocator that is used from the main thread.
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "uppLib.hpp"
+
+#define WORK_QUEUE_MAX_THREADS 8
+#define WORK_QUEUE_CAPACITY 1024
+
+typedef void (*WorkFunc)(void* userData);
+
+struct WorkItem
+{
+    WorkFunc func;
+    void* userData;
+};
+
+struct WorkQueue
+{
+    std::thread threads[WORK_QUEUE_MAX_THREADS];
+    int threadCount;
+    std::mutex mutex;
+    std::condition_variable workAdded;
+    std::condition_variable workDone;
+    // Ring buffer, guarded by mutex
+    WorkItem items[WORK_QUEUE_CAPACITY];
+    int head;
+    int count;
+    int running; // Items taken by a worker but not finished
+    bool quit;
+};
+
+void workerLoop(WorkQueue* q)
+{
+    std::unique_lock<std::mutex> lock(q->mutex);
+    while (true)
+    {
+        q->workAdded.wait(lock, [q]() { return q->count > 0 || q->quit; });
+        if (q->count == 0) {
+            return; // Quit, but only once the queue is empty
+        }
+        WorkItem item = q->items[q->head];
+        q->head = (q->head + 1) % WORK_QUEUE_CAPACITY;
+        q->count--;
+        q->running++;
+
+        lock.unlock();
+        item.func(item.userData);
+        lock.lock();
+
+        q->running--;
+        if (q->count == 0 && q->running == 0) {
+            q->workDone.notify_all();
+        }
+    }
+}
+
+// threadCount 0 uses all cores but one, the main thread keeps its core
+void init(WorkQueue* q, int threadCount = 0)
+{
+    if (threadCount <= 0) {
+        threadCount = (int)std::thread::hardware_concurrency() - 1;
+    }
+    q->threadCount = clamp(threadCount, 1, WORK_QUEUE_MAX_THREADS);
+    q->head = 0;
+    q->count = 0;
+    q->running = 0;
+    q->quit = false;
+    for (int i = 0; i < q->threadCount; i++) {
+        q->threads[i] = std::thread(workerLoop, q);
+    }
+}
+
+void shutdown(WorkQueue* q)
+{
+    {
+        std::lock_guard<std::mutex> lock(q->mutex);
+        q->quit = true;
+    }
+    q->workAdded.notify_all();
+    for (int i = 0; i < q->threadCount; i++) {
+        q->threads[i].join();
+    }
+    q->threadCount = 0;
+}
+
+// If the queue is full the work is executed right away on the calling thread
+void addWork(WorkQueue* q, WorkFunc func, void* userData)
+{
+    {
+        std::lock_guard<std::mutex> lock(q->mutex);
+        if (q->count < WORK_QUEUE_CAPACITY)
+        {
+            WorkItem& item = q->items[(q->head + q->count) % WORK_QUEUE_CAPACITY];
+            item.func = func;
+            item.userData = userData;
+            q->count++;
+            q->workAdded.notify_one();
+            return;
+        }
+    }
+    loggf("WorkQueue full, executing work on the calling thread\n");
+    func(userData);
+}
+
+// Blocks until all queued work is finished
+void completeAllWork(WorkQueue* q)
+{
+    std::unique_lock<std::mutex> lock(q->mutex);
+    q->workDone.wait(lock, [q]() { return q->count == 0 && q->running == 0; });
+}
+
+
+
+#endif
@@ -17,8 +17,10 @@
 #undef far
 
 #include "win32_glFunctions.hpp"
+#include "../rendering/headlessGL.hpp"
 #include "../utils/tmpAlloc.hpp"
 #include "win32_fileListener.cpp"
+#include "win32_fileMapping.cpp"
 
 // ---------------
 // --- GLOBALS ---
@@ -381,6 +383,9 @@ void setGameFunctionPtrs()
         &checkFilesChanged,
         &createFileListener,
         &deleteFileListener,
+        // File mapping
+        &mapFile,
+        &unmapFile,
         // OpenGL functions
         glDebugMessageCallback,
         glGenVertexArrays,
@@ -457,7 +462,50 @@ void setGameFunctionPtrs()
         glGenRenderbuffers,
         glDeleteRenderbuffers,
         glBindRenderbuffer,
-        glRenderbufferStorage
+        glRenderbufferStorage,
+        glClear,
+        glClearColor,
+        glEnable,
+        glDisable,
+        glCullFace,
+        glFrontFace,
+        glDepthFunc,
+        glDepthMask,
+        glBlendFunc,
+        glViewport,
+        glDrawArrays,
+        glDrawElements,
+        glGenTextures,
+        glDeleteTextures,
+        glBindTexture,
+        glTexImage2D,
+        glTexSubImage2D,
+        glTexParameteri,
+        glPixelStorei,
+        glVertexAttribDivisor,
+        glDrawElementsInstanced,
+        glGetUniformBlockIndex,
+        glUniformBlockBinding,
+        glBindBufferBase,
+        glBufferSubData,
+        glBufferStorage,
+        glMapBufferRange,
+        glUnmapBuffer,
+        glFenceSync,
+        glClientWaitSync,
+        glDeleteSync,
+        glBindVertexBuffer,
+        glVertexAttribFormat,
+        glVertexAttribBinding,
+        glVertexBindingDivisor,
+        glCompressedTexImage2D,
+        glCompressedTexSubImage2D,
+        glGetString,
+        glGetIntegerv,
+        glProgramParameteri,
+        glGetProgramBinary,
+        glProgramBinary,
+        glBindBufferRange
     };
 
     gameLoadFunctionPtrs(functionPtrs);
@@ -777,6 +825,8 @@ void initWindowAndOpenGL(HINSTANCE instance, HWND& hwnd, HDC& deviceContext, HGL
 
     // DEBUG START
     loggf("Dummy context creation worked!\n");
+    // glGetString is a function pointer like all gl functions, loadAllFunctions runs on the real context
+    glGetString = (PFNGLGETSTRINGPROC) getAnyGLFuncAddress("glGetString");
     char* version = (char*)glGetString(GL_VERSION);
     loggf("dummy context version: \"%s\"\n", version);
     // DEBUG END
@@ -1202,6 +1252,12 @@ int WINAPI WinMain(HINSTANCE instance, HINSTANCE unused, PSTR cmdLine, int cmdSh
     HGLRC glContext;
     initWindowAndOpenGL(instance, hwnd, deviceContext, glContext);
 
+    // With -headless the game gets the recording gl backend instead of the driver functions
+    bool headless = strstr(cmdLine, "-headless") != nullptr;
+    if (headless) {
+        loadHeadlessGLFunctions(&sysAlloc);
+    }
+
     // Init subsystems
     initFileListener(&sysAlloc);
     initInput();
@@ -1239,6 +1295,9 @@ int WINAPI WinMain(HINSTANCE instance, HINSTANCE unused, PSTR cmdLine, int cmdSh
         //debugGameTick();
         gameTick(&gameState);
         resetInputState();
+        if (headless) {
+            headlessGLEndFrame();
+        }
 
         // Show buffer (Hint: Maybe wait for vblanc to swap?)
         if (actualWinState.continuousDraw || actualWinState.redraw) {
@@ -1269,6 +1328,11 @@ int WINAPI WinMain(HINSTANCE instance, HINSTANCE unused, PSTR cmdLine, int cmdSh
     // Shutdown
     DestroyWindow(hwnd);
     gameShutdown(&gameState);
+    if (headless) {
+        loggf("HeadlessGL total (%d frames):\n", headlessGL.frameCount);
+        printStats(&headlessGL.total);
+        shutdownHeadlessGL();
+    }
     loggf("Program exit\n");
     //sleepFor(2);
     //debugWaitForConsoleInput();
@@ -0,0 +1,59 @@
+#ifndef __WIN32_FILEMAPPING_CPP__
+#define __WIN32_FILEMAPPING_CPP__
+
+// Read only file mapping, handed to the game as platform callback.
+// The view stays valid until unmapFile, even if the file handle is closed.
+
+MappedFile mapFile(const char* path)
+{
+    MappedFile file;
+    memset(&file, 0, sizeof(MappedFile));
+
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, 
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        loggf("mapFile: Could not open %s\n", path);
+        return file;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+        loggf("mapFile: %s is empty or size query failed\n", path);
+        CloseHandle(handle);
+        return file;
+    }
+
+    HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        loggf("mapFile: CreateFileMapping failed on %s\n", path);
+        CloseHandle(handle);
+        return file;
+    }
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr) {
+        loggf("mapFile: MapViewOfFile failed on %s\n", path);
+        CloseHandle(mapping);
+        CloseHandle(handle);
+        return file;
+    }
+
+    file.data = data;
+    file.size = (u64) size.QuadPart;
+    file.fileHandle = handle;
+    file.mappingHandle = mapping;
+    return file;
+}
+
+void unmapFile(MappedFile* file)
+{
+    if (file->data == nullptr) {
+        return;
+    }
+    UnmapViewOfFile(file->data);
+    CloseHandle((HANDLE) file->mappingHandle);
+    CloseHandle((HANDLE) file->fileHandle);
+    memset(file, 0, sizeof(MappedFile));
+}
+
+
+
+#endif
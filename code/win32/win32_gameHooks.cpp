@@ -1,7 +1,7 @@
 #ifndef __WIN32_GAME_HOOKS__
 #define __WIN32_GAME_HOOKS__
 
-#include "..\rendering\renderState.hpp"
+#include "../rendering/renderState.hpp"
 
 // GameAllocator
 struct GameDataAndAlloc
@@ -86,6 +86,19 @@ void deleteFileListener(ListenerToken token) {
     _deleteFileListener(token);
 }
 
+typedef MappedFile (*mapFileFunc)(const char* path);
+typedef void (*unmapFileFunc)(MappedFile* file);
+mapFileFunc _mapFile;
+unmapFileFunc _unmapFile;
+
+MappedFile mapFile(const char* path) {
+    return _mapFile(path);
+}
+
+void unmapFile(MappedFile* file) {
+    _unmapFile(file);
+}
+
 // BINDINGS FOR DLL LOADING
 extern "C"
 {
@@ -104,6 +117,7 @@ extern "C"
     __declspec(dllexport) void gameTick(GameState* state) {
         //initGlobals(state);
         renderState.frameCounter++;
+        renderState.tickCounter++;
         gameTick();
     }
 
@@ -111,12 +125,16 @@ extern "C"
         initGlobals(state);
         gameBeforeReload();
         gameShutdown();
+        shutdownVaoCache();
+        shutdownRenderer();
         shutdownTmpAlloc();
     }
 
     __declspec(dllexport) void gameBeforeReset(GameState* state) {
         initGlobals(state);
         gameBeforeReload();
+        shutdownVaoCache(); // Meshes survive the reset, their vaos are recreated on the next draw
+        shutdownRenderer();
         gameDataAndAlloc->oldGameDataSize = sizeof(GameData);
         shutdownTmpAlloc();
     }
@@ -162,6 +180,8 @@ extern "C"
         i++; // check file changed
         _createFileListener = (createFileListenerFunc) functions[i++];
         _deleteFileListener = (deleteFileListenerFunc) functions[i++];
+        _mapFile = (mapFileFunc) functions[i++];
+        _unmapFile = (unmapFileFunc) functions[i++];
         glDebugMessageCallback = (PFNGLDEBUGMESSAGECALLBACKPROC) functions[i++];
         glGenVertexArrays = (PFNGLGENVERTEXARRAYSPROC) functions[i++];
         glBindVertexArray = (PFNGLBINDVERTEXARRAYPROC) functions[i++];
@@ -238,6 +258,49 @@ extern "C"
         glDeleteRenderbuffers = (PFNGLDELETERENDERBUFFERSPROC) functions[i++];
         glBindRenderbuffer = (PFNGLBINDRENDERBUFFERPROC) functions[i++];
         glRenderbufferStorage = (PFNGLRENDERBUFFERSTORAGEPROC) functions[i++];
+        glClear = (PFNGLCLEARPROC) functions[i++];
+        glClearColor = (PFNGLCLEARCOLORPROC) functions[i++];
+        glEnable = (PFNGLENABLEPROC) functions[i++];
+        glDisable = (PFNGLDISABLEPROC) functions[i++];
+        glCullFace = (PFNGLCULLFACEPROC) functions[i++];
+        glFrontFace = (PFNGLFRONTFACEPROC) functions[i++];
+        glDepthFunc = (PFNGLDEPTHFUNCPROC) functions[i++];
+        glDepthMask = (PFNGLDEPTHMASKPROC) functions[i++];
+        glBlendFunc = (PFNGLBLENDFUNCPROC) functions[i++];
+        glViewport = (PFNGLVIEWPORTPROC) functions[i++];
+        glDrawArrays = (PFNGLDRAWARRAYSPROC) functions[i++];
+        glDrawElements = (PFNGLDRAWELEMENTSPROC) functions[i++];
+        glGenTextures = (PFNGLGENTEXTURESPROC) functions[i++];
+        glDeleteTextures = (PFNGLDELETETEXTURESPROC) functions[i++];
+        glBindTexture = (PFNGLBINDTEXTUREPROC) functions[i++];
+        glTexImage2D = (PFNGLTEXIMAGE2DPROC) functions[i++];
+        glTexSubImage2D = (PFNGLTEXSUBIMAGE2DPROC) functions[i++];
+        glTexParameteri = (PFNGLTEXPARAMETERIPROC) functions[i++];
+        glPixelStorei = (PFNGLPIXELSTOREIPROC) functions[i++];
+        glVertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISORPROC) functions[i++];
+        glDrawElementsInstanced = (PFNGLDRAWELEMENTSINSTANCEDPROC) functions[i++];
+        glGetUniformBlockIndex = (PFNGLGETUNIFORMBLOCKINDEXPROC) functions[i++];
+        glUniformBlockBinding = (PFNGLUNIFORMBLOCKBINDINGPROC) functions[i++];
+        glBindBufferBase = (PFNGLBINDBUFFERBASEPROC) functions[i++];
+        glBufferSubData = (PFNGLBUFFERSUBDATAPROC) functions[i++];
+        glBufferStorage = (PFNGLBUFFERSTORAGEPROC) functions[i++];
+        glMapBufferRange = (PFNGLMAPBUFFERRANGEPROC) functions[i++];
+        glUnmapBuffer = (PFNGLUNMAPBUFFERPROC) functions[i++];
+        glFenceSync = (PFNGLFENCESYNCPROC) functions[i++];
+        glClientWaitSync = (PFNGLCLIENTWAITSYNCPROC) functions[i++];
+        glDeleteSync = (PFNGLDELETESYNCPROC) functions[i++];
+        glBindVertexBuffer = (PFNGLBINDVERTEXBUFFERPROC) functions[i++];
+        glVertexAttribFormat = (PFNGLVERTEXATTRIBFORMATPROC) functions[i++];
+        glVertexAttribBinding = (PFNGLVERTEXATTRIBBINDINGPROC) functions[i++];
+        glVertexBindingDivisor = (PFNGLVERTEXBINDINGDIVISORPROC) functions[i++];
+        glCompressedTexImage2D = (PFNGLCOMPRESSEDTEXIMAGE2DPROC) functions[i++];
+        glCompressedTexSubImage2D = (PFNGLCOMPRESSEDTEXSUBIMAGE2DPROC) functions[i++];
+        glGetString = (PFNGLGETSTRINGPROC) functions[i++];
+        glGetIntegerv = (PFNGLGETINTEGERVPROC) functions[i++];
+        glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC) functions[i++];
+        glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC) functions[i++];
+        glProgramBinary = (PFNGLPROGRAMBINARYPROC) functions[i++];
+        glBindBufferRange = (PFNGLBINDBUFFERRANGEPROC) functions[i++];
     }
 }
 
@@ -79,7 +79,6 @@ bool loadAllFunctions()
     glGenVertexArrays = (PFNGLGENVERTEXARRAYSPROC) getAnyGLFuncAddress("glGenVertexArrays");
     glBindVertexArray = (PFNGLBINDVERTEXARRAYPROC) getAnyGLFuncAddress("glBindVertexArray");
     glUseProgram = (PFNGLUSEPROGRAMPROC) getAnyGLFuncAddress("glUseProgram");
-    //glViewport = (PFNGLVIEWPORTPROC) getAnyGLFuncAddress("glViewport");
     glGetActiveUniform = (PFNGLGETACTIVEUNIFORMPROC) getAnyGLFuncAddress("glGetActiveUniform");
     glGetUniformLocation = (PFNGLGETUNIFORMLOCATIONPROC) getAnyGLFuncAddress("glGetUniformLocation");
     glUniform1f = (PFNGLUNIFORM1FPROC) getAnyGLFuncAddress("glUniform1f");
@@ -132,6 +131,50 @@ bool loadAllFunctions()
     glDeleteRenderbuffers = (PFNGLDELETERENDERBUFFERSPROC) getAnyGLFuncAddress("glDeleteRenderbuffers");
     glBindRenderbuffer = (PFNGLBINDRENDERBUFFERPROC) getAnyGLFuncAddress("glBindRenderbuffer");
     glRenderbufferStorage = (PFNGLRENDERBUFFERSTORAGEPROC) getAnyGLFuncAddress("glRenderbufferStorage");
+    // GL 1.1 (Exported by opengl32.dll, wglGetProcAddress fails for these)
+    glClear = (PFNGLCLEARPROC) getAnyGLFuncAddress("glClear");
+    glClearColor = (PFNGLCLEARCOLORPROC) getAnyGLFuncAddress("glClearColor");
+    glEnable = (PFNGLENABLEPROC) getAnyGLFuncAddress("glEnable");
+    glDisable = (PFNGLDISABLEPROC) getAnyGLFuncAddress("glDisable");
+    glCullFace = (PFNGLCULLFACEPROC) getAnyGLFuncAddress("glCullFace");
+    glFrontFace = (PFNGLFRONTFACEPROC) getAnyGLFuncAddress("glFrontFace");
+    glDepthFunc = (PFNGLDEPTHFUNCPROC) getAnyGLFuncAddress("glDepthFunc");
+    glDepthMask = (PFNGLDEPTHMASKPROC) getAnyGLFuncAddress("glDepthMask");
+    glBlendFunc = (PFNGLBLENDFUNCPROC) getAnyGLFuncAddress("glBlendFunc");
+    glViewport = (PFNGLVIEWPORTPROC) getAnyGLFuncAddress("glViewport");
+    glDrawArrays = (PFNGLDRAWARRAYSPROC) getAnyGLFuncAddress("glDrawArrays");
+    glDrawElements = (PFNGLDRAWELEMENTSPROC) getAnyGLFuncAddress("glDrawElements");
+    glGenTextures = (PFNGLGENTEXTURESPROC) getAnyGLFuncAddress("glGenTextures");
+    glDeleteTextures = (PFNGLDELETETEXTURESPROC) getAnyGLFuncAddress("glDeleteTextures");
+    glBindTexture = (PFNGLBINDTEXTUREPROC) getAnyGLFuncAddress("glBindTexture");
+    glTexImage2D = (PFNGLTEXIMAGE2DPROC) getAnyGLFuncAddress("glTexImage2D");
+    glTexSubImage2D = (PFNGLTEXSUBIMAGE2DPROC) getAnyGLFuncAddress("glTexSubImage2D");
+    glTexParameteri = (PFNGLTEXPARAMETERIPROC) getAnyGLFuncAddress("glTexParameteri");
+    glPixelStorei = (PFNGLPIXELSTOREIPROC) getAnyGLFuncAddress("glPixelStorei");
+    glVertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISORPROC) getAnyGLFuncAddress("glVertexAttribDivisor");
+    glDrawElementsInstanced = (PFNGLDRAWELEMENTSINSTANCEDPROC) getAnyGLFuncAddress("glDrawElementsInstanced");
+    glGetUniformBlockIndex = (PFNGLGETUNIFORMBLOCKINDEXPROC) getAnyGLFuncAddress("glGetUniformBlockIndex");
+    glUniformBlockBinding = (PFNGLUNIFORMBLOCKBINDINGPROC) getAnyGLFuncAddress("glUniformBlockBinding");
+    glBindBufferBase = (PFNGLBINDBUFFERBASEPROC) getAnyGLFuncAddress("glBindBufferBase");
+    glBufferSubData = (PFNGLBUFFERSUBDATAPROC) getAnyGLFuncAddress("glBufferSubData");
+    glBufferStorage = (PFNGLBUFFERSTORAGEPROC) getAnyGLFuncAddress("glBufferStorage");
+    glMapBufferRange = (PFNGLMAPBUFFERRANGEPROC) getAnyGLFuncAddress("glMapBufferRange");
+    glUnmapBuffer = (PFNGLUNMAPBUFFERPROC) getAnyGLFuncAddress("glUnmapBuffer");
+    glFenceSync = (PFNGLFENCESYNCPROC) getAnyGLFuncAddress("glFenceSync");
+    glClientWaitSync = (PFNGLCLIENTWAITSYNCPROC) getAnyGLFuncAddress("glClientWaitSync");
+    glDeleteSync = (PFNGLDELETESYNCPROC) getAnyGLFuncAddress("glDeleteSync");
+    glBindVertexBuffer = (PFNGLBINDVERTEXBUFFERPROC) getAnyGLFuncAddress("glBindVertexBuffer");
+    glVertexAttribFormat = (PFNGLVERTEXATTRIBFORMATPROC) getAnyGLFuncAddress("glVertexAttribFormat");
+    glVertexAttribBinding = (PFNGLVERTEXATTRIBBINDINGPROC) getAnyGLFuncAddress("glVertexAttribBinding");
+    glVertexBindingDivisor = (PFNGLVERTEXBINDINGDIVISORPROC) getAnyGLFuncAddress("glVertexBindingDivisor");
+    glCompressedTexImage2D = (PFNGLCOMPRESSEDTEXIMAGE2DPROC) getAnyGLFuncAddress("glCompressedTexImage2D");
+    glCompressedTexSubImage2D = (PFNGLCOMPRESSEDTEXSUBIMAGE2DPROC) getAnyGLFuncAddress("glCompressedTexSubImage2D");
+    glGetString = (PFNGLGETSTRINGPROC) getAnyGLFuncAddress("glGetString");
+    glGetIntegerv = (PFNGLGETINTEGERVPROC) getAnyGLFuncAddress("glGetIntegerv");
+    glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC) getAnyGLFuncAddress("glProgramParameteri");
+    glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC) getAnyGLFuncAddress("glGetProgramBinary");
+    glProgramBinary = (PFNGLPROGRAMBINARYPROC) getAnyGLFuncAddress("glProgramBinary");
+    glBindBufferRange = (PFNGLBINDBUFFERRANGEPROC) getAnyGLFuncAddress("glBindBufferRange");
 
     bool success = true;
     success = success && 
@@ -196,7 +239,6 @@ bool loadAllFunctions()
         (glDeleteVertexArrays != NULL) &&
         (glGetActiveAttrib != NULL) &&
         (glGetAttribLocation != NULL) &&
-        //        (glViewport != NULL) &&
         (glGetProgramInfoLog != NULL) &&
         (glGenerateMipmap != NULL) &&
         (glActiveTexture != NULL) &&
@@ -209,7 +251,49 @@ bool loadAllFunctions()
         (glGenRenderbuffers != NULL) &&
         (glDeleteRenderbuffers != NULL) &&
         (glBindRenderbuffer != NULL) &&
-        (glRenderbufferStorage != NULL);
+        (glRenderbufferStorage != NULL) &&
+        (glClear != NULL) &&
+        (glClearColor != NULL) &&
+        (glEnable != NULL) &&
+        (glDisable != NULL) &&
+        (glCullFace != NULL) &&
+        (glFrontFace != NULL) &&
+        (glDepthFunc != NULL) &&
+        (glDepthMask != NULL) &&
+        (glBlendFunc != NULL) &&
+        (glViewport != NULL) &&
+        (glDrawArrays != NULL) &&
+        (glDrawElements != NULL) &&
+        (glGenTextures != NULL) &&
+        (glDeleteTextures != NULL) &&
+        (glBindTexture != NULL) &&
+        (glTexImage2D != NULL) &&
+        (glTexSubImage2D != NULL) &&
+        (glTexParameteri != NULL) &&
+        (glPixelStorei != NULL) &&
+        (glVertexAttribDivisor != NULL) &&
+        (glDrawElementsInstanced != NULL) &&
+        (glGetUniformBlockIndex != NULL) &&
+        (glUniformBlockBinding != NULL) &&
+        (glBindBufferBase != NULL) &&
+        (glBufferSubData != NULL) &&
+        (glMapBufferRange != NULL) &&
+        (glUnmapBuffer != NULL) &&
+        (glFenceSync != NULL) &&
+        (glClientWaitSync != NULL) &&
+        (glDeleteSync != NULL) &&
+        (glBindVertexBuffer != NULL) &&
+        (glVertexAttribFormat != NULL) &&
+        (glVertexAttribBinding != NULL) &&
+        (glVertexBindingDivisor != NULL) &&
+        (glCompressedTexImage2D != NULL) &&
+        (glCompressedTexSubImage2D != NULL) &&
+        (glGetString != NULL) &&
+        (glGetIntegerv != NULL) &&
+        (glProgramParameteri != NULL) &&
+        (glGetProgramBinary != NULL) &&
+        (glProgramBinary != NULL) &&
+        (glBindBufferRange != NULL);
 
     // Load extensions
     success = success && loadExtensions();
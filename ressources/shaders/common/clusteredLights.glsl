@@ -0,0 +1,54 @@
+// Point and spot lights assigned to view space clusters on the cpu (LightClusters in lightClusters.hpp)
+#include "common/frameUniforms.glsl"
+
+#define LIGHT_CLUSTER_X 16
+#define LIGHT_CLUSTER_Y 9
+#define LIGHT_CLUSTER_Z 24
+#define MAX_CLUSTER_LIGHTS 1024
+
+struct ClusterLight
+{
+    vec4 posRange;
+    vec4 colorCosInner;
+    vec4 dirCosOuter; // cosOuter is -2 for point lights
+};
+
+layout(std430, binding = 1) readonly buffer ClusteredLights
+{
+    vec4 u_clusterDepth; // Slice = log(viewDepth) * x + y
+    uvec4 u_clusterGrid; // Cluster counts and light count
+    ClusterLight u_lights[MAX_CLUSTER_LIGHTS];
+    uvec2 u_clusters[LIGHT_CLUSTER_X * LIGHT_CLUSTER_Y * LIGHT_CLUSTER_Z]; // Offset and count
+    uint u_lightIndices[];
+};
+
+uint getClusterIndex(vec3 worldPos)
+{
+    float depth = -(u_view * vec4(worldPos, 1)).z;
+    uint slice = uint(clamp(log(max(depth, 1e-6)) * u_clusterDepth.x + u_clusterDepth.y, 0, LIGHT_CLUSTER_Z - 1));
+    uvec2 tile = uvec2(clamp(gl_FragCoord.xy / u_resolution * vec2(LIGHT_CLUSTER_X, LIGHT_CLUSTER_Y),
+                vec2(0), vec2(LIGHT_CLUSTER_X - 1, LIGHT_CLUSTER_Y - 1)));
+    return tile.x + LIGHT_CLUSTER_X * (tile.y + LIGHT_CLUSTER_Y * slice);
+}
+
+// Diffuse and specular light of all lights in the cluster of the fragment
+vec3 shadeClusteredLights(vec3 worldPos, vec3 normal, vec3 viewDir, vec3 albedo, float specStrength, float specPow)
+{
+    uvec2 cluster = u_clusters[getClusterIndex(worldPos)];
+    vec3 col = vec3(0);
+    for (uint i = 0; i < cluster.y; i++)
+    {
+        ClusterLight l = u_lights[u_lightIndices[cluster.x + i]];
+        vec3 toLight = l.posRange.xyz - worldPos;
+        float dist = length(toLight);
+        vec3 lightDir = toLight / max(dist, 1e-4);
+        // Smooth window to zero at the range
+        float window = clamp(1.0 - pow(dist / l.posRange.w, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (dist * dist + 1.0);
+        attenuation *= smoothstep(l.dirCosOuter.w, l.colorCosInner.w, dot(-lightDir, l.dirCosOuter.xyz));
+        vec3 light = l.colorCosInner.rgb * attenuation;
+        col += albedo * max(dot(normal, lightDir), 0.0) * light;
+        col += pow(max(0.0, dot(reflect(viewDir, normal), lightDir)), specPow) * specStrength * light;
+    }
+    return col;
+}
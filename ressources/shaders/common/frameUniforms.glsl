@@ -0,0 +1,12 @@
+// Per frame uniforms, filled once per frame (FrameUniformData in renderState.hpp)
+layout(std140, binding = 0) uniform FrameUniforms
+{
+    mat4 u_view;
+    mat4 u_projection;
+    mat4 u_vp;
+    mat3 u_invView;
+    vec3 u_camPos;
+    float u_time;
+    vec2 u_resolution;
+    vec2 u_mouse;
+};
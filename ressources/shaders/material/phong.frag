@@ -5,8 +5,10 @@ in vec3 f_pos;
 
 out vec4 o_color;
 
+#include "common/frameUniforms.glsl"
+#include "common/clusteredLights.glsl"
+
 // Shading uniforms
-uniform vec3 u_camPos;
 uniform vec3 u_lightDir;
 uniform vec3 u_albedo;
 uniform vec3 u_ambient;
@@ -23,6 +25,7 @@ void main()
     col += u_albedo * dot(normal, -u_lightDir); // Diffuse part
     col += u_albedo * u_ambient; // Ambient part
     col += pow(max(0.0, dot(reflect(viewDir, normal), -u_lightDir)), specPow) * specStrength;
+    col += shadeClusteredLights(f_pos, normal, viewDir, u_albedo, specStrength, specPow); // Point and spot lights
     
     // Test
     o_color = vec4(normal*.5 + .5, 1);
@@ -3,15 +3,19 @@
 in vec3 a_pos;
 in vec3 a_normal;
 
+// Per instance, MaterialRenderer draws are instanced
+in mat4 i_model;
+in mat3 i_normal;
+
 out vec3 f_normal;
 out vec3 f_pos;
 
-uniform mat4 u_MVP;
-uniform mat4 u_MODEL;
+#include "common/frameUniforms.glsl"
 
 void main()
 {
-    gl_Position = u_MVP * vec4(a_pos, 1);
-    f_pos = vec3(u_MODEL * vec4(a_pos, 1)); 
-    f_normal = a_normal; // TODO Normal matrix multiplication
+    vec4 worldPos = i_model * vec4(a_pos, 1);
+    gl_Position = u_vp * worldPos;
+    f_pos = vec3(worldPos); 
+    f_normal = i_normal * a_normal;
 }
@@ -0,0 +1,12 @@
+#version 430 core
+
+in vec2 f_uv;
+in vec4 f_color;
+out vec4 o_color;
+
+uniform sampler2D atlas;
+
+void main()
+{
+    o_color = texture(atlas, f_uv) * f_color;
+}
@@ -0,0 +1,17 @@
+#version 430 core
+
+layout(location = 0) in vec2 a_pos;
+layout(location = 1) in vec2 a_uv;
+layout(location = 2) in vec4 a_color;
+
+out vec2 f_uv;
+out vec4 f_color;
+
+uniform vec2 u_screenSize;
+
+void main()
+{
+    f_uv = a_uv;
+    f_color = a_color;
+    gl_Position = vec4(a_pos / u_screenSize * 2.0 - 1.0, 0.0, 1.0);
+}
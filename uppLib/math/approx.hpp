@@ -0,0 +1,459 @@
+#ifndef __APPROX_HPP__
+#define __APPROX_HPP__
+
+// ------------------------------------
+// --- FAST APPROXIMATE FUNCTIONS ---
+// ------------------------------------
+// Polynomial approximations (Cephes style minimax polynomials) of sin, cos, exp, log
+// and 1/sqrt, as scalar, 4 wide (SSE2) and 8 wide (AVX2) versions.
+// All widths use the same polynomials, so results only differ by rounding (FMA).
+// Max errors, measured against libm in test_approx (uppLib/test/main.cpp):
+//  * fastSin/fastCos: absolute error < 5e-7 for |x| <= 8192, no special handling of inf/nan
+//  * fastExp:         relative error < 3e-7, input is clamped to [-87.3, 88.7] (No denormals/inf)
+//  * fastLog:         error < 3e-7 * max(1, |log(x)|) for x in [1e-30, 1e30], x must be positive and normal
+//  * fastRsqrt:       relative error < 5e-7 (SSE estimate + one newton step),
+//                     < 5e-6 without SSE (bit trick + two newton steps), x must be > 0
+// The batch versions (fastSinBatch...) are dispatched to the widest path (See cpuFeatures.hpp).
+// Use the batches for many values, scalar exp/log are mainly fallbacks (Not faster than a good libm)
+
+#include <cstring> // memcpy for bit casts
+
+// Cody-Waite split of PI/2, so that x - q*PI/2 stays exact for big q
+#define APPROX_PIO2_1 1.5703125f
+#define APPROX_PIO2_2 4.837512969970703125e-4f
+#define APPROX_PIO2_3 7.54978995489188216e-8f
+#define APPROX_2OPI 0.636619772367581343f
+// ln2 split
+#define APPROX_LN2_HI 0.693359375f
+#define APPROX_LN2_LO -2.12194440e-4f
+#define APPROX_LOG2E 1.44269504088896341f
+#define APPROX_SQRTHF 0.707106781186547524f
+
+// Sin and cos polynomials on [-PI/4, PI/4]
+#define APPROX_SIN_C0 -1.9515295891e-4f
+#define APPROX_SIN_C1 8.3321608736e-3f
+#define APPROX_SIN_C2 -1.6666654611e-1f
+#define APPROX_COS_C0 2.443315711809948e-5f
+#define APPROX_COS_C1 -1.388731625493765e-3f
+#define APPROX_COS_C2 4.166664568298827e-2f
+
+// -------------
+// --- SCALAR ---
+// -------------
+inline int approxRoundToInt(float x) {
+#ifdef UPP_SSE
+    return _mm_cvtss_si32(_mm_set_ss(x)); // Round to nearest
+#else
+    return (int)(x + (x >= 0.0f ? 0.5f : -0.5f));
+#endif
+}
+
+inline float approxSinPoly(float r, float r2) {
+    return r + r * r2 * ((APPROX_SIN_C0 * r2 + APPROX_SIN_C1) * r2 + APPROX_SIN_C2);
+}
+
+inline float approxCosPoly(float r2) {
+    return 1.0f - 0.5f * r2 + r2 * r2 * ((APPROX_COS_C0 * r2 + APPROX_COS_C1) * r2 + APPROX_COS_C2);
+}
+
+inline float approxReduce(float x, int* quadrant)
+{
+    int q = approxRoundToInt(x * APPROX_2OPI);
+    float qf = (float)q;
+    *quadrant = q;
+    return ((x - qf * APPROX_PIO2_1) - qf * APPROX_PIO2_2) - qf * APPROX_PIO2_3;
+}
+
+inline void fastSinCos(float x, float* s, float* c)
+{
+    int q;
+    float r = approxReduce(x, &q);
+    float r2 = r * r;
+    float sr = approxSinPoly(r, r2);
+    float cr = approxCosPoly(r2);
+    switch (q & 3)
+    {
+    case 0: *s = sr; *c = cr; break;
+    case 1: *s = cr; *c = -sr; break;
+    case 2: *s = -sr; *c = -cr; break;
+    default: *s = -cr; *c = sr; break;
+    }
+}
+
+// Both polynomials are evaluated and selected without branches,
+// quadrants of random inputs would mispredict half of the time
+inline float approxSinCosQuadrant(float r, int q)
+{
+    float r2 = r * r;
+    float sr = approxSinPoly(r, r2);
+    float cr = approxCosPoly(r2);
+    u32 sBits, cBits;
+    memcpy(&sBits, &sr, 4);
+    memcpy(&cBits, &cr, 4);
+    u32 useCos = 0u - ((u32)q & 1);
+    u32 bits = ((cBits & useCos) | (sBits & ~useCos)) ^ (((u32)q & 2) << 30);
+    float v;
+    memcpy(&v, &bits, 4);
+    return v;
+}
+
+inline float fastSin(float x)
+{
+    int q;
+    float r = approxReduce(x, &q);
+    return approxSinCosQuadrant(r, q);
+}
+
+inline float fastCos(float x)
+{
+    int q;
+    float r = approxReduce(x, &q);
+    return approxSinCosQuadrant(r, q + 1); // cos(x) = sin(x + PI/2)
+}
+
+inline float fastExp(float x)
+{
+    x = clamp(x, -87.3f, 88.7f);
+    int n = approxRoundToInt(x * APPROX_LOG2E);
+    float nf = (float)n;
+    float r = (x - nf * APPROX_LN2_HI) - nf * APPROX_LN2_LO;
+    float p = 1.9875691500e-4f;
+    p = p * r + 1.3981999507e-3f;
+    p = p * r + 8.3334519073e-3f;
+    p = p * r + 4.1665795894e-2f;
+    p = p * r + 1.6666665459e-1f;
+    p = p * r + 5.0000001201e-1f;
+    p = p * r * r + r + 1.0f;
+    // Scale by 2^n, done in two steps so that n = 128 does not overflow the exponent
+    int n1 = n / 2;
+    u32 b1 = (u32)(n1 + 127) << 23;
+    u32 b2 = (u32)(n - n1 + 127) << 23;
+    float s1, s2;
+    memcpy(&s1, &b1, 4);
+    memcpy(&s2, &b2, 4);
+    return p * s1 * s2;
+}
+
+inline float fastLog(float x)
+{
+    u32 bits;
+    memcpy(&bits, &x, 4);
+    int e = (int)((bits >> 23) & 0xFF) - 126;
+    bits = (bits & 0x807FFFFF) | 0x3F000000; // Mantissa in [0.5, 1)
+    float m;
+    memcpy(&m, &bits, 4);
+    // Mantissa in [sqrt(0.5), sqrt(2)), without a branch
+    int small = m < APPROX_SQRTHF;
+    e -= small;
+    m = m * (float)(1 + small) - 1.0f;
+    float ef = (float)e;
+    float z = m * m;
+    float p = 7.0376836292e-2f;
+    p = p * m - 1.1514610310e-1f;
+    p = p * m + 1.1676998740e-1f;
+    p = p * m - 1.2420140846e-1f;
+    p = p * m + 1.4249322787e-1f;
+    p = p * m - 1.6668057665e-1f;
+    p = p * m + 2.0000714765e-1f;
+    p = p * m - 2.4999993993e-1f;
+    p = p * m + 3.3333331174e-1f;
+    float y = m * z * p;
+    y += ef * APPROX_LN2_LO;
+    y -= 0.5f * z;
+    return m + y + ef * APPROX_LN2_HI;
+}
+
+inline float fastRsqrt(float x)
+{
+#ifdef UPP_SSE
+    float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+    return y * (1.5f - 0.5f * x * y * y);
+#else
+    u32 bits;
+    memcpy(&bits, &x, 4);
+    bits = 0x5F3759DF - (bits >> 1);
+    float y;
+    memcpy(&y, &bits, 4);
+    y = y * (1.5f - 0.5f * x * y * y);
+    return y * (1.5f - 0.5f * x * y * y);
+#endif
+}
+
+
+
+// -------------------
+// --- SSE, 4 WIDE ---
+// -------------------
+#ifdef UPP_SSE
+inline __m128 approxSelect4(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Returns sin(r) for even quadrants and cos(r) for odd ones, sign flipped for quadrants 2 and 3
+inline __m128 approxSinCosQuadrant4(__m128 r, __m128i q)
+{
+    __m128 r2 = _mm_mul_ps(r, r);
+    __m128 sp = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(APPROX_SIN_C0), r2), _mm_set1_ps(APPROX_SIN_C1));
+    sp = _mm_add_ps(_mm_mul_ps(sp, r2), _mm_set1_ps(APPROX_SIN_C2));
+    sp = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), sp));
+    __m128 cp = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(APPROX_COS_C0), r2), _mm_set1_ps(APPROX_COS_C1));
+    cp = _mm_add_ps(_mm_mul_ps(cp, r2), _mm_set1_ps(APPROX_COS_C2));
+    cp = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), r2)), _mm_mul_ps(_mm_mul_ps(r2, r2), cp));
+
+    __m128 useCos = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    __m128 v = approxSelect4(useCos, cp, sp);
+    __m128 sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), 30));
+    return _mm_xor_ps(v, sign);
+}
+
+inline __m128 approxReduce4(__m128 x, __m128i* q)
+{
+    *q = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(APPROX_2OPI))); // Rounds to nearest
+    __m128 qf = _mm_cvtepi32_ps(*q);
+    x = _mm_sub_ps(x, _mm_mul_ps(qf, _mm_set1_ps(APPROX_PIO2_1)));
+    x = _mm_sub_ps(x, _mm_mul_ps(qf, _mm_set1_ps(APPROX_PIO2_2)));
+    return _mm_sub_ps(x, _mm_mul_ps(qf, _mm_set1_ps(APPROX_PIO2_3)));
+}
+
+inline __m128 fastSin4(__m128 x)
+{
+    __m128i q;
+    __m128 r = approxReduce4(x, &q);
+    return approxSinCosQuadrant4(r, q);
+}
+
+inline __m128 fastCos4(__m128 x)
+{
+    __m128i q;
+    __m128 r = approxReduce4(x, &q);
+    return approxSinCosQuadrant4(r, _mm_add_epi32(q, _mm_set1_epi32(1)));
+}
+
+inline __m128 fastExp4(__m128 x)
+{
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-87.3f)), _mm_set1_ps(88.7f));
+    __m128i n = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(APPROX_LOG2E)));
+    __m128 nf = _mm_cvtepi32_ps(n);
+    __m128 r = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(nf, _mm_set1_ps(APPROX_LN2_HI))), _mm_mul_ps(nf, _mm_set1_ps(APPROX_LN2_LO)));
+    __m128 p = _mm_set1_ps(1.9875691500e-4f);
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.3981999507e-3f));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(8.3334519073e-3f));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(4.1665795894e-2f));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.6666665459e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(5.0000001201e-1f));
+    p = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, r), r), r), _mm_set1_ps(1.0f));
+    __m128i n1 = _mm_srai_epi32(n, 1);
+    __m128i n2 = _mm_sub_epi32(n, n1);
+    __m128 s1 = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n1, _mm_set1_epi32(127)), 23));
+    __m128 s2 = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n2, _mm_set1_epi32(127)), 23));
+    return _mm_mul_ps(_mm_mul_ps(p, s1), s2);
+}
+
+inline __m128 fastLog4(__m128 x)
+{
+    __m128i bits = _mm_castps_si128(x);
+    __m128i e = _mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(bits, 23), _mm_set1_epi32(0xFF)), _mm_set1_epi32(126));
+    __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x807FFFFF)), _mm_set1_epi32(0x3F000000)));
+    __m128 small = _mm_cmplt_ps(m, _mm_set1_ps(APPROX_SQRTHF));
+    e = _mm_add_epi32(e, _mm_castps_si128(small)); // mask is -1
+    m = _mm_sub_ps(_mm_add_ps(m, _mm_and_ps(small, m)), _mm_set1_ps(1.0f));
+    __m128 ef = _mm_cvtepi32_ps(e);
+    __m128 z = _mm_mul_ps(m, m);
+    __m128 p = _mm_set1_ps(7.0376836292e-2f);
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-1.1514610310e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(1.1676998740e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-1.2420140846e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(1.4249322787e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-1.6668057665e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(2.0000714765e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-2.4999993993e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(3.3333331174e-1f));
+    __m128 y = _mm_mul_ps(_mm_mul_ps(m, z), p);
+    y = _mm_add_ps(y, _mm_mul_ps(ef, _mm_set1_ps(APPROX_LN2_LO)));
+    y = _mm_sub_ps(y, _mm_mul_ps(_mm_set1_ps(0.5f), z));
+    return _mm_add_ps(_mm_add_ps(m, y), _mm_mul_ps(ef, _mm_set1_ps(APPROX_LN2_HI)));
+}
+
+inline __m128 fastRsqrt4(__m128 x)
+{
+    __m128 y = _mm_rsqrt_ps(x);
+    __m128 yyx = _mm_mul_ps(_mm_mul_ps(y, y), x);
+    return _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_set1_ps(0.5f), yyx)));
+}
+
+
+
+// ---------------------
+// --- AVX2, 8 WIDE ---
+// ---------------------
+// Only call these if the cpu supports AVX2 and FMA (getSupportedSimdLevel)
+UPP_TARGET_AVX2 inline __m256 approxSinCosQuadrant8(__m256 r, __m256i q)
+{
+    __m256 r2 = _mm256_mul_ps(r, r);
+    __m256 sp = _mm256_fmadd_ps(_mm256_set1_ps(APPROX_SIN_C0), r2, _mm256_set1_ps(APPROX_SIN_C1));
+    sp = _mm256_fmadd_ps(sp, r2, _mm256_set1_ps(APPROX_SIN_C2));
+    sp = _mm256_fmadd_ps(_mm256_mul_ps(r, r2), sp, r);
+    __m256 cp = _mm256_fmadd_ps(_mm256_set1_ps(APPROX_COS_C0), r2, _mm256_set1_ps(APPROX_COS_C1));
+    cp = _mm256_fmadd_ps(cp, r2, _mm256_set1_ps(APPROX_COS_C2));
+    cp = _mm256_fmadd_ps(_mm256_mul_ps(r2, r2), cp, _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), r2, _mm256_set1_ps(1.0f)));
+
+    __m256 useCos = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+    __m256 v = _mm256_blendv_ps(sp, cp, useCos);
+    __m256 sign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q, _mm256_set1_epi32(2)), 30));
+    return _mm256_xor_ps(v, sign);
+}
+
+UPP_TARGET_AVX2 inline __m256 approxReduce8(__m256 x, __m256i* q)
+{
+    *q = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(APPROX_2OPI)));
+    __m256 qf = _mm256_cvtepi32_ps(*q);
+    x = _mm256_fnmadd_ps(qf, _mm256_set1_ps(APPROX_PIO2_1), x);
+    x = _mm256_fnmadd_ps(qf, _mm256_set1_ps(APPROX_PIO2_2), x);
+    return _mm256_fnmadd_ps(qf, _mm256_set1_ps(APPROX_PIO2_3), x);
+}
+
+UPP_TARGET_AVX2 inline __m256 fastSin8(__m256 x)
+{
+    __m256i q;
+    __m256 r = approxReduce8(x, &q);
+    return approxSinCosQuadrant8(r, q);
+}
+
+UPP_TARGET_AVX2 inline __m256 fastCos8(__m256 x)
+{
+    __m256i q;
+    __m256 r = approxReduce8(x, &q);
+    return approxSinCosQuadrant8(r, _mm256_add_epi32(q, _mm256_set1_epi32(1)));
+}
+
+UPP_TARGET_AVX2 inline __m256 fastExp8(__m256 x)
+{
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-87.3f)), _mm256_set1_ps(88.7f));
+    __m256i n = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(APPROX_LOG2E)));
+    __m256 nf = _mm256_cvtepi32_ps(n);
+    __m256 r = _mm256_fnmadd_ps(nf, _mm256_set1_ps(APPROX_LN2_HI), x);
+    r = _mm256_fnmadd_ps(nf, _mm256_set1_ps(APPROX_LN2_LO), r);
+    __m256 p = _mm256_set1_ps(1.9875691500e-4f);
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.3981999507e-3f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(8.3334519073e-3f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(4.1665795894e-2f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.6666665459e-1f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(5.0000001201e-1f));
+    p = _mm256_add_ps(_mm256_fmadd_ps(_mm256_mul_ps(p, r), r, r), _mm256_set1_ps(1.0f));
+    __m256i n1 = _mm256_srai_epi32(n, 1);
+    __m256i n2 = _mm256_sub_epi32(n, n1);
+    __m256 s1 = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n1, _mm256_set1_epi32(127)), 23));
+    __m256 s2 = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n2, _mm256_set1_epi32(127)), 23));
+    return _mm256_mul_ps(_mm256_mul_ps(p, s1), s2);
+}
+
+UPP_TARGET_AVX2 inline __m256 fastLog8(__m256 x)
+{
+    __m256i bits = _mm256_castps_si256(x);
+    __m256i e = _mm256_sub_epi32(_mm256_srli_epi32(_mm256_and_si256(bits, _mm256_set1_epi32(0x7F800000)), 23), _mm256_set1_epi32(126));
+    __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x807FFFFF)), _mm256_set1_epi32(0x3F000000)));
+    __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(APPROX_SQRTHF), _CMP_LT_OQ);
+    e = _mm256_add_epi32(e, _mm256_castps_si256(small));
+    m = _mm256_sub_ps(_mm256_add_ps(m, _mm256_and_ps(small, m)), _mm256_set1_ps(1.0f));
+    __m256 ef = _mm256_cvtepi32_ps(e);
+    __m256 z = _mm256_mul_ps(m, m);
+    __m256 p = _mm256_set1_ps(7.0376836292e-2f);
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(-1.1514610310e-1f));
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(1.1676998740e-1f));
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(-1.2420140846e-1f));
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(1.4249322787e-1f));
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(-1.6668057665e-1f));
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(2.0000714765e-1f));
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(-2.4999993993e-1f));
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(3.3333331174e-1f));
+    __m256 y = _mm256_mul_ps(_mm256_mul_ps(m, z), p);
+    y = _mm256_fmadd_ps(ef, _mm256_set1_ps(APPROX_LN2_LO), y);
+    y = _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), z, y);
+    return _mm256_fmadd_ps(ef, _mm256_set1_ps(APPROX_LN2_HI), _mm256_add_ps(m, y));
+}
+
+UPP_TARGET_AVX2 inline __m256 fastRsqrt8(__m256 x)
+{
+    __m256 y = _mm256_rsqrt_ps(x);
+    __m256 yyx = _mm256_mul_ps(_mm256_mul_ps(y, y), x);
+    return _mm256_mul_ps(y, _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), yyx, _mm256_set1_ps(1.5f)));
+}
+#endif
+
+
+
+// ---------------
+// --- BATCHES ---
+// ---------------
+// out[i] = f(in[i]), in and out may be the same array
+typedef void (*ApproxBatchFunc)(const float* in, float* out, int count);
+
+#define APPROX_BATCH_SCALAR(name, func) \
+    void name(const float* in, float* out, int count) { \
+        for (int i = 0; i < count; i++) out[i] = func(in[i]); \
+    }
+#define APPROX_BATCH_SSE(name, func4, func) \
+    void name(const float* in, float* out, int count) { \
+        int i = 0; \
+        for (; i + 4 <= count; i += 4) _mm_storeu_ps(out + i, func4(_mm_loadu_ps(in + i))); \
+        for (; i < count; i++) out[i] = func(in[i]); \
+    }
+#define APPROX_BATCH_AVX2(name, func8, func) \
+    UPP_TARGET_AVX2 void name(const float* in, float* out, int count) { \
+        int i = 0; \
+        for (; i + 8 <= count; i += 8) _mm256_storeu_ps(out + i, func8(_mm256_loadu_ps(in + i))); \
+        _mm256_zeroupper(); /* The tail and the caller are sse code */ \
+        for (; i < count; i++) out[i] = func(in[i]); \
+    }
+
+APPROX_BATCH_SCALAR(fastSinBatchScalar, fastSin)
+APPROX_BATCH_SCALAR(fastCosBatchScalar, fastCos)
+APPROX_BATCH_SCALAR(fastExpBatchScalar, fastExp)
+APPROX_BATCH_SCALAR(fastLogBatchScalar, fastLog)
+APPROX_BATCH_SCALAR(fastRsqrtBatchScalar, fastRsqrt)
+#ifdef UPP_SSE
+APPROX_BATCH_SSE(fastSinBatchSSE, fastSin4, fastSin)
+APPROX_BATCH_SSE(fastCosBatchSSE, fastCos4, fastCos)
+APPROX_BATCH_SSE(fastExpBatchSSE, fastExp4, fastExp)
+APPROX_BATCH_SSE(fastLogBatchSSE, fastLog4, fastLog)
+APPROX_BATCH_SSE(fastRsqrtBatchSSE, fastRsqrt4, fastRsqrt)
+APPROX_BATCH_AVX2(fastSinBatchAVX2, fastSin8, fastSin)
+APPROX_BATCH_AVX2(fastCosBatchAVX2, fastCos8, fastCos)
+APPROX_BATCH_AVX2(fastExpBatchAVX2, fastExp8, fastExp)
+APPROX_BATCH_AVX2(fastLogBatchAVX2, fastLog8, fastLog)
+APPROX_BATCH_AVX2(fastRsqrtBatchAVX2, fastRsqrt8, fastRsqrt)
+#define APPROX_KERNEL(name) \
+    Kernel* name##Kernel = createKernel(#name, { \
+            {SimdLevel::SCALAR, (GenericFunc) &name##Scalar}, \
+            {SimdLevel::SSE2, (GenericFunc) &name##SSE}, \
+            {SimdLevel::AVX2, (GenericFunc) &name##AVX2}});
+#else
+#define APPROX_KERNEL(name) \
+    Kernel* name##Kernel = createKernel(#name, {{SimdLevel::SCALAR, (GenericFunc) &name##Scalar}});
+#endif
+
+APPROX_KERNEL(fastSinBatch)
+APPROX_KERNEL(fastCosBatch)
+APPROX_KERNEL(fastExpBatch)
+APPROX_KERNEL(fastLogBatch)
+APPROX_KERNEL(fastRsqrtBatch)
+
+void fastSinBatch(const float* in, float* out, int count) {
+    dispatch<ApproxBatchFunc>(fastSinBatchKernel)(in, out, count);
+}
+void fastCosBatch(const float* in, float* out, int count) {
+    dispatch<ApproxBatchFunc>(fastCosBatchKernel)(in, out, count);
+}
+void fastExpBatch(const float* in, float* out, int count) {
+    dispatch<ApproxBatchFunc>(fastExpBatchKernel)(in, out, count);
+}
+void fastLogBatch(const float* in, float* out, int count) {
+    dispatch<ApproxBatchFunc>(fastLogBatchKernel)(in, out, count);
+}
+void fastRsqrtBatch(const float* in, float* out, int count) {
+    dispatch<ApproxBatchFunc>(fastRsqrtBatchKernel)(in, out, count);
+}
+
+
+
+#endif
@@ -0,0 +1,517 @@
+#ifndef __BOUNDS_HPP__
+#define __BOUNDS_HPP__
+
+// ------------------------------------
+// --- BOUNDING VOLUMES AND CULLING ---
+// ------------------------------------
+// Axis aligned bounding boxes, bounding spheres and view frustums.
+// The batch culling functions take their volumes in SoA layout
+// (One array per component) so that 4 (SSE) or 8 (AVX2) volumes can be tested per iteration.
+// They write the indices of all visible volumes into an output array
+// and return the visible count. overlapSpheresAABB works the same way with a box
+// instead of a frustum (E.g. Lights against the clusters of a clustered renderer).
+
+struct AABB
+{
+    AABB(){}
+    AABB(const vec3& min, const vec3& max) : min(min), max(max) {}
+    vec3 min;
+    vec3 max;
+};
+
+vec3 getCenter(const AABB& b) {
+    return (b.min + b.max) * 0.5f;
+}
+
+vec3 getExtent(const AABB& b) {
+    return (b.max - b.min) * 0.5f;
+}
+
+struct BoundingSphere
+{
+    BoundingSphere(){}
+    BoundingSphere(const vec3& center, float radius) : center(center), radius(radius) {}
+    vec3 center;
+    float radius;
+};
+
+// Transforms the box and returns the aabb around the result (Arvo's method)
+AABB transform(const AABB& b, const mat4& m)
+{
+    vec3 center = m * getCenter(b);
+    vec3 extent = getExtent(b);
+    vec3 newExtent = vec3(
+            fabsf(m.columns[0].x)*extent.x + fabsf(m.columns[1].x)*extent.y + fabsf(m.columns[2].x)*extent.z,
+            fabsf(m.columns[0].y)*extent.x + fabsf(m.columns[1].y)*extent.y + fabsf(m.columns[2].y)*extent.z,
+            fabsf(m.columns[0].z)*extent.x + fabsf(m.columns[1].z)*extent.y + fabsf(m.columns[2].z)*extent.z);
+    return AABB(center - newExtent, center + newExtent);
+}
+
+// Radius is scaled with the biggest axis scale, so the sphere stays conservative
+BoundingSphere transform(const BoundingSphere& s, const mat4& m)
+{
+    float scaleSq = max(lengthSq(vec3(m.columns[0].x, m.columns[0].y, m.columns[0].z)),
+            max(lengthSq(vec3(m.columns[1].x, m.columns[1].y, m.columns[1].z)),
+                lengthSq(vec3(m.columns[2].x, m.columns[2].y, m.columns[2].z))));
+    return BoundingSphere(m * s.center, s.radius * sqrtf(scaleSq));
+}
+
+
+
+// ---------------
+// --- FRUSTUM ---
+// ---------------
+namespace FrustumPlane
+{
+    enum ENUM
+    {
+        LEFT = 0,
+        RIGHT,
+        BOTTOM,
+        TOP,
+        NEAR_PLANE, // NEAR and FAR are macros on windows
+        FAR_PLANE,
+
+        COUNT // MUST STAY LAST
+    };
+};
+
+// Planes are stored as (normal, d), normals point inside
+// and are normalized, so dot(plane, vec4(p, 1)) is the signed distance
+struct Frustum
+{
+    vec4 planes[FrustumPlane::COUNT];
+};
+
+// Gribb/Hartmann plane extraction, works with any (view-)projection matrix
+// using OpenGL clip space (-w <= x, y, z <= w)
+Frustum extractFrustum(const mat4& viewProjection)
+{
+    const mat4& m = viewProjection;
+    vec4 row[4];
+    for (int i = 0; i < 4; i++) {
+        const float* c0 = &m.columns[0].x;
+        const float* c1 = &m.columns[1].x;
+        const float* c2 = &m.columns[2].x;
+        const float* c3 = &m.columns[3].x;
+        row[i] = vec4(c0[i], c1[i], c2[i], c3[i]);
+    }
+
+    Frustum f;
+    f.planes[FrustumPlane::LEFT] = row[3] + row[0];
+    f.planes[FrustumPlane::RIGHT] = row[3] - row[0];
+    f.planes[FrustumPlane::BOTTOM] = row[3] + row[1];
+    f.planes[FrustumPlane::TOP] = row[3] - row[1];
+    f.planes[FrustumPlane::NEAR_PLANE] = row[3] + row[2];
+    f.planes[FrustumPlane::FAR_PLANE] = row[3] - row[2];
+    for (int i = 0; i < FrustumPlane::COUNT; i++) {
+        vec4& p = f.planes[i];
+        p = p / length(vec3(p.x, p.y, p.z));
+    }
+
+    return f;
+}
+
+float planeDist(const vec4& plane, const vec3& p) {
+    return plane.x*p.x + plane.y*p.y + plane.z*p.z + plane.w;
+}
+
+// Returns false if the volume is completely outside
+bool intersects(const Frustum& f, const BoundingSphere& s)
+{
+    for (int i = 0; i < FrustumPlane::COUNT; i++) {
+        if (planeDist(f.planes[i], s.center) < -s.radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool intersects(const Frustum& f, const AABB& b)
+{
+    vec3 center = getCenter(b);
+    vec3 extent = getExtent(b);
+    for (int i = 0; i < FrustumPlane::COUNT; i++)
+    {
+        const vec4& p = f.planes[i];
+        float r = fabsf(p.x)*extent.x + fabsf(p.y)*extent.y + fabsf(p.z)*extent.z;
+        if (planeDist(p, center) < -r) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Distance from the sphere center to the box, compared squared
+bool intersects(const AABB& b, const BoundingSphere& s)
+{
+    float dx = max(max(b.min.x - s.center.x, s.center.x - b.max.x), 0.0f);
+    float dy = max(max(b.min.y - s.center.y, s.center.y - b.max.y), 0.0f);
+    float dz = max(max(b.min.z - s.center.z, s.center.z - b.max.z), 0.0f);
+    return dx*dx + dy*dy + dz*dz <= s.radius*s.radius;
+}
+
+
+
+// -------------------
+// --- BATCH TESTS ---
+// -------------------
+int cullSpheresScalar(const Frustum& f, int count,
+        const float* x, const float* y, const float* z, const float* radius, int* visibleIndices)
+{
+    int visibleCount = 0;
+    for (int i = 0; i < count; i++) {
+        if (intersects(f, BoundingSphere(vec3(x[i], y[i], z[i]), radius[i]))) {
+            visibleIndices[visibleCount++] = i;
+        }
+    }
+    return visibleCount;
+}
+
+// Boxes are given as center and extent (half size)
+int cullAABBsScalar(const Frustum& f, int count,
+        const float* cx, const float* cy, const float* cz,
+        const float* ex, const float* ey, const float* ez, int* visibleIndices)
+{
+    int visibleCount = 0;
+    for (int i = 0; i < count; i++)
+    {
+        vec3 c = vec3(cx[i], cy[i], cz[i]);
+        vec3 e = vec3(ex[i], ey[i], ez[i]);
+        if (intersects(f, AABB(c - e, c + e))) {
+            visibleIndices[visibleCount++] = i;
+        }
+    }
+    return visibleCount;
+}
+
+int overlapSpheresAABBScalar(const AABB& b, int count,
+        const float* x, const float* y, const float* z, const float* radius, int* overlapIndices)
+{
+    int overlapCount = 0;
+    for (int i = 0; i < count; i++) {
+        if (intersects(b, BoundingSphere(vec3(x[i], y[i], z[i]), radius[i]))) {
+            overlapIndices[overlapCount++] = i;
+        }
+    }
+    return overlapCount;
+}
+
+#ifdef UPP_SSE
+// Index of the lowest set bit, mask must not be 0
+inline int lowestSetBit(u32 mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int) index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+// Writes the indices of all set bits in the 4/8 bit mask
+inline int writeVisibleIndices(int mask, int baseIndex, int* visibleIndices)
+{
+    int count = 0;
+    while (mask != 0) {
+        visibleIndices[count++] = baseIndex + lowestSetBit((u32) mask);
+        mask &= mask - 1;
+    }
+    return count;
+}
+
+int cullSpheresSSE(const Frustum& f, int count,
+        const float* x, const float* y, const float* z, const float* radius, int* visibleIndices)
+{
+    // Broadcast planes once
+    __m128 px[FrustumPlane::COUNT], py[FrustumPlane::COUNT], pz[FrustumPlane::COUNT], pw[FrustumPlane::COUNT];
+    for (int p = 0; p < FrustumPlane::COUNT; p++) {
+        px[p] = _mm_set1_ps(f.planes[p].x);
+        py[p] = _mm_set1_ps(f.planes[p].y);
+        pz[p] = _mm_set1_ps(f.planes[p].z);
+        pw[p] = _mm_set1_ps(f.planes[p].w);
+    }
+
+    int visibleCount = 0;
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 vz = _mm_loadu_ps(z + i);
+        __m128 negR = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < FrustumPlane::COUNT; p++)
+        {
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px[p], vx), _mm_mul_ps(py[p], vy)),
+                    _mm_add_ps(_mm_mul_ps(pz[p], vz), pw[p]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negR));
+        }
+        visibleCount += writeVisibleIndices(_mm_movemask_ps(inside), i, visibleIndices + visibleCount);
+    }
+
+    // Remainder
+    for (; i < count; i++) {
+        if (intersects(f, BoundingSphere(vec3(x[i], y[i], z[i]), radius[i]))) {
+            visibleIndices[visibleCount++] = i;
+        }
+    }
+    return visibleCount;
+}
+
+int cullAABBsSSE(const Frustum& f, int count,
+        const float* cx, const float* cy, const float* cz,
+        const float* ex, const float* ey, const float* ez, int* visibleIndices)
+{
+    __m128 px[FrustumPlane::COUNT], py[FrustumPlane::COUNT], pz[FrustumPlane::COUNT], pw[FrustumPlane::COUNT];
+    __m128 ax[FrustumPlane::COUNT], ay[FrustumPlane::COUNT], az[FrustumPlane::COUNT];
+    for (int p = 0; p < FrustumPlane::COUNT; p++) {
+        px[p] = _mm_set1_ps(f.planes[p].x);
+        py[p] = _mm_set1_ps(f.planes[p].y);
+        pz[p] = _mm_set1_ps(f.planes[p].z);
+        pw[p] = _mm_set1_ps(f.planes[p].w);
+        ax[p] = _mm_set1_ps(fabsf(f.planes[p].x));
+        ay[p] = _mm_set1_ps(fabsf(f.planes[p].y));
+        az[p] = _mm_set1_ps(fabsf(f.planes[p].z));
+    }
+
+    int visibleCount = 0;
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 vcx = _mm_loadu_ps(cx + i);
+        __m128 vcy = _mm_loadu_ps(cy + i);
+        __m128 vcz = _mm_loadu_ps(cz + i);
+        __m128 vex = _mm_loadu_ps(ex + i);
+        __m128 vey = _mm_loadu_ps(ey + i);
+        __m128 vez = _mm_loadu_ps(ez + i);
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < FrustumPlane::COUNT; p++)
+        {
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px[p], vcx), _mm_mul_ps(py[p], vcy)),
+                    _mm_add_ps(_mm_mul_ps(pz[p], vcz), pw[p]));
+            __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax[p], vex), _mm_mul_ps(ay[p], vey)),
+                    _mm_mul_ps(az[p], vez));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), _mm_setzero_ps()));
+        }
+        visibleCount += writeVisibleIndices(_mm_movemask_ps(inside), i, visibleIndices + visibleCount);
+    }
+
+    for (; i < count; i++)
+    {
+        vec3 c = vec3(cx[i], cy[i], cz[i]);
+        vec3 e = vec3(ex[i], ey[i], ez[i]);
+        if (intersects(f, AABB(c - e, c + e))) {
+            visibleIndices[visibleCount++] = i;
+        }
+    }
+    return visibleCount;
+}
+
+int overlapSpheresAABBSSE(const AABB& b, int count,
+        const float* x, const float* y, const float* z, const float* radius, int* overlapIndices)
+{
+    __m128 minX = _mm_set1_ps(b.min.x), minY = _mm_set1_ps(b.min.y), minZ = _mm_set1_ps(b.min.z);
+    __m128 maxX = _mm_set1_ps(b.max.x), maxY = _mm_set1_ps(b.max.y), maxZ = _mm_set1_ps(b.max.z);
+    __m128 zero = _mm_setzero_ps();
+
+    int overlapCount = 0;
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 vz = _mm_loadu_ps(z + i);
+        __m128 r = _mm_loadu_ps(radius + i);
+        __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minX, vx), _mm_sub_ps(vx, maxX)), zero);
+        __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minY, vy), _mm_sub_ps(vy, maxY)), zero);
+        __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minZ, vz), _mm_sub_ps(vz, maxZ)), zero);
+        __m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        __m128 overlap = _mm_cmple_ps(distSq, _mm_mul_ps(r, r));
+        overlapCount += writeVisibleIndices(_mm_movemask_ps(overlap), i, overlapIndices + overlapCount);
+    }
+
+    for (; i < count; i++) {
+        if (intersects(b, BoundingSphere(vec3(x[i], y[i], z[i]), radius[i]))) {
+            overlapIndices[overlapCount++] = i;
+        }
+    }
+    return overlapCount;
+}
+
+// 8 volumes per iteration
+UPP_TARGET_AVX2 int cullSpheresAVX2(const Frustum& f, int count,
+        const float* x, const float* y, const float* z, const float* radius, int* visibleIndices)
+{
+    __m256 px[FrustumPlane::COUNT], py[FrustumPlane::COUNT], pz[FrustumPlane::COUNT], pw[FrustumPlane::COUNT];
+    for (int p = 0; p < FrustumPlane::COUNT; p++) {
+        px[p] = _mm256_set1_ps(f.planes[p].x);
+        py[p] = _mm256_set1_ps(f.planes[p].y);
+        pz[p] = _mm256_set1_ps(f.planes[p].z);
+        pw[p] = _mm256_set1_ps(f.planes[p].w);
+    }
+
+    int visibleCount = 0;
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 vx = _mm256_loadu_ps(x + i);
+        __m256 vy = _mm256_loadu_ps(y + i);
+        __m256 vz = _mm256_loadu_ps(z + i);
+        __m256 negR = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radius + i));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < FrustumPlane::COUNT; p++)
+        {
+            __m256 d = _mm256_fmadd_ps(px[p], vx, _mm256_fmadd_ps(py[p], vy, _mm256_fmadd_ps(pz[p], vz, pw[p])));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, negR, _CMP_GE_OQ));
+        }
+        visibleCount += writeVisibleIndices(_mm256_movemask_ps(inside), i, visibleIndices + visibleCount);
+    }
+
+    // The tail calls the sse compiled intersects, clear the upper halves first
+    _mm256_zeroupper();
+    for (; i < count; i++) {
+        if (intersects(f, BoundingSphere(vec3(x[i], y[i], z[i]), radius[i]))) {
+            visibleIndices[visibleCount++] = i;
+        }
+    }
+    return visibleCount;
+}
+
+UPP_TARGET_AVX2 int cullAABBsAVX2(const Frustum& f, int count,
+        const float* cx, const float* cy, const float* cz,
+        const float* ex, const float* ey, const float* ez, int* visibleIndices)
+{
+    __m256 px[FrustumPlane::COUNT], py[FrustumPlane::COUNT], pz[FrustumPlane::COUNT], pw[FrustumPlane::COUNT];
+    __m256 ax[FrustumPlane::COUNT], ay[FrustumPlane::COUNT], az[FrustumPlane::COUNT];
+    for (int p = 0; p < FrustumPlane::COUNT; p++) {
+        px[p] = _mm256_set1_ps(f.planes[p].x);
+        py[p] = _mm256_set1_ps(f.planes[p].y);
+        pz[p] = _mm256_set1_ps(f.planes[p].z);
+        pw[p] = _mm256_set1_ps(f.planes[p].w);
+        ax[p] = _mm256_set1_ps(fabsf(f.planes[p].x));
+        ay[p] = _mm256_set1_ps(fabsf(f.planes[p].y));
+        az[p] = _mm256_set1_ps(fabsf(f.planes[p].z));
+    }
+
+    int visibleCount = 0;
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 vcx = _mm256_loadu_ps(cx + i);
+        __m256 vcy = _mm256_loadu_ps(cy + i);
+        __m256 vcz = _mm256_loadu_ps(cz + i);
+        __m256 vex = _mm256_loadu_ps(ex + i);
+        __m256 vey = _mm256_loadu_ps(ey + i);
+        __m256 vez = _mm256_loadu_ps(ez + i);
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < FrustumPlane::COUNT; p++)
+        {
+            __m256 d = _mm256_fmadd_ps(px[p], vcx, _mm256_fmadd_ps(py[p], vcy, _mm256_fmadd_ps(pz[p], vcz, pw[p])));
+            __m256 r = _mm256_fmadd_ps(ax[p], vex, _mm256_fmadd_ps(ay[p], vey, _mm256_mul_ps(az[p], vez)));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(d, r), _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+        visibleCount += writeVisibleIndices(_mm256_movemask_ps(inside), i, visibleIndices + visibleCount);
+    }
+
+    // The tail calls the sse compiled intersects, clear the upper halves first
+    _mm256_zeroupper();
+    for (; i < count; i++)
+    {
+        vec3 c = vec3(cx[i], cy[i], cz[i]);
+        vec3 e = vec3(ex[i], ey[i], ez[i]);
+        if (intersects(f, AABB(c - e, c + e))) {
+            visibleIndices[visibleCount++] = i;
+        }
+    }
+    return visibleCount;
+}
+
+// No fma here (Unlike the culling paths), the results match the scalar version exactly
+UPP_TARGET_AVX2 int overlapSpheresAABBAVX2(const AABB& b, int count,
+        const float* x, const float* y, const float* z, const float* radius, int* overlapIndices)
+{
+    __m256 minX = _mm256_set1_ps(b.min.x), minY = _mm256_set1_ps(b.min.y), minZ = _mm256_set1_ps(b.min.z);
+    __m256 maxX = _mm256_set1_ps(b.max.x), maxY = _mm256_set1_ps(b.max.y), maxZ = _mm256_set1_ps(b.max.z);
+    __m256 zero = _mm256_setzero_ps();
+
+    int overlapCount = 0;
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 vx = _mm256_loadu_ps(x + i);
+        __m256 vy = _mm256_loadu_ps(y + i);
+        __m256 vz = _mm256_loadu_ps(z + i);
+        __m256 r = _mm256_loadu_ps(radius + i);
+        __m256 dx = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(minX, vx), _mm256_sub_ps(vx, maxX)), zero);
+        __m256 dy = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(minY, vy), _mm256_sub_ps(vy, maxY)), zero);
+        __m256 dz = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(minZ, vz), _mm256_sub_ps(vz, maxZ)), zero);
+        __m256 distSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+        __m256 overlap = _mm256_cmp_ps(distSq, _mm256_mul_ps(r, r), _CMP_LE_OQ);
+        overlapCount += writeVisibleIndices(_mm256_movemask_ps(overlap), i, overlapIndices + overlapCount);
+    }
+
+    // The tail calls the sse compiled intersects, clear the upper halves first
+    _mm256_zeroupper();
+    for (; i < count; i++) {
+        if (intersects(b, BoundingSphere(vec3(x[i], y[i], z[i]), radius[i]))) {
+            overlapIndices[overlapCount++] = i;
+        }
+    }
+    return overlapCount;
+}
+#endif
+
+// Dispatched to the widest path the cpu supports (See cpuFeatures.hpp)
+typedef int (*CullSpheresFunc)(const Frustum& f, int count,
+        const float* x, const float* y, const float* z, const float* radius, int* visibleIndices);
+typedef int (*CullAABBsFunc)(const Frustum& f, int count,
+        const float* cx, const float* cy, const float* cz,
+        const float* ex, const float* ey, const float* ez, int* visibleIndices);
+typedef int (*OverlapSpheresAABBFunc)(const AABB& b, int count,
+        const float* x, const float* y, const float* z, const float* radius, int* overlapIndices);
+
+Kernel* cullSpheresKernel = createKernel("cullSpheres", {
+        {SimdLevel::SCALAR, (GenericFunc) &cullSpheresScalar},
+#ifdef UPP_SSE
+        {SimdLevel::SSE2, (GenericFunc) &cullSpheresSSE},
+        {SimdLevel::AVX2, (GenericFunc) &cullSpheresAVX2},
+#endif
+        });
+
+Kernel* cullAABBsKernel = createKernel("cullAABBs", {
+        {SimdLevel::SCALAR, (GenericFunc) &cullAABBsScalar},
+#ifdef UPP_SSE
+        {SimdLevel::SSE2, (GenericFunc) &cullAABBsSSE},
+        {SimdLevel::AVX2, (GenericFunc) &cullAABBsAVX2},
+#endif
+        });
+
+Kernel* overlapSpheresAABBKernel = createKernel("overlapSpheresAABB", {
+        {SimdLevel::SCALAR, (GenericFunc) &overlapSpheresAABBScalar},
+#ifdef UPP_SSE
+        {SimdLevel::SSE2, (GenericFunc) &overlapSpheresAABBSSE},
+        {SimdLevel::AVX2, (GenericFunc) &overlapSpheresAABBAVX2},
+#endif
+        });
+
+int cullSpheres(const Frustum& f, int count,
+        const float* x, const float* y, const float* z, const float* radius, int* visibleIndices) {
+    return dispatch<CullSpheresFunc>(cullSpheresKernel)(f, count, x, y, z, radius, visibleIndices);
+}
+
+int cullAABBs(const Frustum& f, int count,
+        const float* cx, const float* cy, const float* cz,
+        const float* ex, const float* ey, const float* ez, int* visibleIndices) {
+    return dispatch<CullAABBsFunc>(cullAABBsKernel)(f, count, cx, cy, cz, ex, ey, ez, visibleIndices);
+}
+
+int overlapSpheresAABB(const AABB& b, int count,
+        const float* x, const float* y, const float* z, const float* radius, int* overlapIndices) {
+    return dispatch<OverlapSpheresAABBFunc>(overlapSpheresAABBKernel)(b, count, x, y, z, radius, overlapIndices);
+}
+
+
+
+#endif
@@ -10,27 +10,23 @@
 struct mat2
 {
     mat2() {}
-    explicit mat2(float s) { // Diagonal matrix with entries s
-        columns[0] = vec2(s, 0.0f);
-        columns[1] = vec2(0.0f, s);
-    } 
-    mat2(const vec2& v1, const vec2& v2) { // Diagonal matrix with entries s
-        columns[0] = v1;
-        columns[1] = v2;
-    } 
+    constexpr explicit mat2(float s) // Diagonal matrix with entries s
+        : columns{vec2(s, 0.0f), vec2(0.0f, s)} {}
+    constexpr mat2(const vec2& v1, const vec2& v2)
+        : columns{v1, v2} {}
 
     vec2 columns[2];
 };
 
-vec2 operator*(const mat2& m, const vec2& v) {
+constexpr vec2 operator*(const mat2& m, const vec2& v) {
     return m.columns[0]*v.x + m.columns[1]*v.y;
 }
 
-mat2 operator*(const mat2& m1, const mat2& m2) {
+constexpr mat2 operator*(const mat2& m1, const mat2& m2) {
     return mat2(m1*m2.columns[0], m1*m2.columns[1]);    
 }
 
-mat2 transpose(const mat2& m) {
+constexpr mat2 transpose(const mat2& m) {
     return mat2(vec2(m.columns[0].x, m.columns[1].x),
             vec2(m.columns[0].y, m.columns[1].y));
 }
@@ -41,48 +37,48 @@ mat2 rotate(float angle) {
     return mat2(vec2(c, s), vec2(-s, c));
 }
 
-mat2 scale(const vec2& s) {
+constexpr mat2 scale(const vec2& s) {
     return mat2(vec2(s.x, 0.0f), vec2(0.0f, s.y));
 }
 
+constexpr float determinant(const mat2& m) {
+    return m.columns[0].x * m.columns[1].y - m.columns[1].x * m.columns[0].y;
+}
+
+constexpr mat2 inverse(const mat2& m) {
+    float invDet = 1.0f / determinant(m);
+    return mat2(vec2(m.columns[1].y, -m.columns[0].y) * invDet,
+            vec2(-m.columns[1].x, m.columns[0].x) * invDet);
+}
+
 // Mat 3
 struct mat3
 {
     mat3(){}
-    explicit mat3(float s) {
-        columns[0] = vec3(s, 0.0f, 0.0f);
-        columns[1] = vec3(0.0f, s, 0.0f);
-        columns[2] = vec3(0.0f, 0.0f, s);
-    }
-    mat3(const vec3& v1, const vec3& v2, const vec3& v3) {
-        columns[0] = v1;
-        columns[1] = v2;
-        columns[2] = v3;
-    }
-    mat3(const mat2& m) {
-        columns[0] = vec3(m.columns[0], 0.0f);
-        columns[1] = vec3(m.columns[1], 0.0f);
-        columns[2] = vec3(0.0f, 0.0f, 1.0f);
-    }
-    mat3(float* data) {
-        columns[0] = vec3(data[0], data[1], data[2]);
-        columns[1] = vec3(data[3], data[4], data[5]);
-        columns[2] = vec3(data[6], data[7], data[8]);
-    }
+    constexpr explicit mat3(float s)
+        : columns{vec3(s, 0.0f, 0.0f), vec3(0.0f, s, 0.0f), vec3(0.0f, 0.0f, s)} {}
+    constexpr mat3(const vec3& v1, const vec3& v2, const vec3& v3)
+        : columns{v1, v2, v3} {}
+    constexpr mat3(const mat2& m)
+        : columns{vec3(m.columns[0], 0.0f), vec3(m.columns[1], 0.0f), vec3(0.0f, 0.0f, 1.0f)} {}
+    constexpr mat3(const float* data)
+        : columns{vec3(data[0], data[1], data[2]), 
+                  vec3(data[3], data[4], data[5]), 
+                  vec3(data[6], data[7], data[8])} {}
 
     vec3 columns[3];
 };
 
-vec3 operator*(const mat3& m, const vec3& v) {
+constexpr vec3 operator*(const mat3& m, const vec3& v) {
     return m.columns[0]*v.x + m.columns[1]*v.y + m.columns[2]*v.z;
 }
 
-vec2 operator*(const mat3& m, const vec2& v) {
+constexpr vec2 operator*(const mat3& m, const vec2& v) {
     vec3 r = m * vec3(v, 1.0f);
     return vec2(r.x, r.y);
 }
 
-mat3 operator*(const mat3& m1, const mat3& m2) {
+constexpr mat3 operator*(const mat3& m1, const mat3& m2) {
     return mat3(m1*m2.columns[0], m1*m2.columns[1], m1*m2.columns[2]);    
 }
 
@@ -90,46 +86,56 @@ mat3 rotate(float yaw, float pitch, float roll) {
     return mat3(0.0f);
 }
 
-mat3 scale(const vec3& s) {
+constexpr mat3 scale(const vec3& s) {
     return mat3(vec3(s.x, 0.0f, 0.0f),
             vec3(0.0f, s.y, 0.0f),
             vec3(0.0f, 0.0f, s.z));
 }
 
-mat3 translate(const vec2& t) {
+constexpr mat3 translate(const vec2& t) {
     return mat3(vec3(1.0f, 0.0f, 0.0f),
             vec3(0.0f, 1.0f, 0.0f),
             vec3(t.x, t.y, 1.0f));
 }
 
-mat3 transpose(const mat3& m) {
+constexpr mat3 transpose(const mat3& m) {
     return mat3(vec3(m.columns[0].x, m.columns[1].x, m.columns[2].x),
             vec3(m.columns[0].y, m.columns[1].y, m.columns[2].y),
             vec3(m.columns[0].z, m.columns[1].z, m.columns[2].z));
 }
 
+constexpr float determinant(const mat3& m) {
+    return dot(m.columns[0], cross(m.columns[1], m.columns[2]));
+}
+
+// Inverse transpose, which is what normals have to be transformed with.
+// The cross products of the columns are the rows of the adjugate, 
+// so no transpose is needed here.
+constexpr mat3 normalMatrix(const mat3& m) 
+{
+    vec3 c0 = cross(m.columns[1], m.columns[2]);
+    vec3 c1 = cross(m.columns[2], m.columns[0]);
+    vec3 c2 = cross(m.columns[0], m.columns[1]);
+    float invDet = 1.0f / dot(m.columns[0], c0);
+    return mat3(c0 * invDet, c1 * invDet, c2 * invDet);
+}
+
+constexpr mat3 inverse(const mat3& m) {
+    return transpose(normalMatrix(m));
+}
+
 // MATRIX 4x4
 struct mat4
 {
     mat4() {}
-    explicit mat4(float s) {
-        columns[0] = vec4(s, 0.0f, 0.0f, 0.0f);
-        columns[1] = vec4(0.0f, s, 0.0f, 0.0f);
-        columns[2] = vec4(0.0f, 0.0f, s, 0.0f);
-        columns[3] = vec4(0.0f, 0.0f, 0.0f, s);
-    }
-    mat4(const vec4& v1, const vec4& v2, const vec4& v3, const vec4& v4) {
-        columns[0] = v1;
-        columns[1] = v2;
-        columns[2] = v3;
-        columns[3] = v4;
-    }
-    mat4(const mat3& m) {
-        columns[0] = vec4(m.columns[0], 0.0f);
-        columns[1] = vec4(m.columns[1], 0.0f);
-        columns[2] = vec4(m.columns[2], 0.0f);
-        columns[3] = vec4(0.0f, 0.0f, 0.0f, 1.0f);
-    }
+    constexpr explicit mat4(float s)
+        : columns{vec4(s, 0.0f, 0.0f, 0.0f), vec4(0.0f, s, 0.0f, 0.0f), 
+                  vec4(0.0f, 0.0f, s, 0.0f), vec4(0.0f, 0.0f, 0.0f, s)} {}
+    constexpr mat4(const vec4& v1, const vec4& v2, const vec4& v3, const vec4& v4)
+        : columns{v1, v2, v3, v4} {}
+    constexpr mat4(const mat3& m)
+        : columns{vec4(m.columns[0], 0.0f), vec4(m.columns[1], 0.0f), 
+                  vec4(m.columns[2], 0.0f), vec4(0.0f, 0.0f, 0.0f, 1.0f)} {}
     float* getDataPtr() {
         return (float*)columns;
     }
@@ -137,47 +143,229 @@ struct mat4
     vec4 columns[4];
 };
 
-vec4 operator*(const mat4& m, const vec4& v) {
+constexpr vec4 operator*(const mat4& m, const vec4& v) {
     return m.columns[0]*v.x + m.columns[1]*v.y + m.columns[2]*v.z + m.columns[3]*v.w;
 }
 
-vec3 operator*(const mat4& m, const vec3& v) {
+constexpr vec3 operator*(const mat4& m, const vec3& v) {
     vec4 r = m * vec4(v, 1.0f);
     return vec3(r.x, r.y, r.z);
 }
 
-mat4 operator*(const mat4& m1, const mat4& m2) {
+constexpr mat4 operator*(const mat4& m1, const mat4& m2) {
     return mat4(m1*m2.columns[0], m1*m2.columns[1], m1*m2.columns[2], m1*m2.columns[3]);    
 }
 
-mat4 translate(const vec3& t) {
+constexpr mat4 translate(const vec3& t) {
     return mat4(vec4(1.0f, 0.0f, 0.0f, 0.0f),
             vec4(0.0f, 1.0f, 0.0f, 0.0f),
             vec4(0.0f, 0.0f, 1.0f, 0.0f),
             vec4(t.x, t.y, t.z, 1.0f));
 }
 
-mat4 transpose(const mat4& m) {
+constexpr mat4 transpose(const mat4& m) {
     return mat4(vec4(m.columns[0].x, m.columns[1].x, m.columns[2].x, m.columns[3].x),
             vec4(m.columns[0].y, m.columns[1].y, m.columns[2].y, m.columns[3].y),
             vec4(m.columns[0].z, m.columns[1].z, m.columns[2].z, m.columns[3].z),
             vec4(m.columns[0].w, m.columns[1].w, m.columns[2].w, m.columns[3].w));
 }
 
-mat4 projection(float near, float far, float fovX, float aspectRatio) 
+// Upper left 3x3 part, e.g. rotation and scale of a model matrix
+constexpr mat3 toMat3(const mat4& m) {
+    return mat3(vec3(m.columns[0].x, m.columns[0].y, m.columns[0].z),
+            vec3(m.columns[1].x, m.columns[1].y, m.columns[1].z),
+            vec3(m.columns[2].x, m.columns[2].y, m.columns[2].z));
+}
+
+// INVERSES
+// inverse() works for all invertible matrices, the other two are faster
+// but only valid if their preconditions are met:
+//  - inverseAffine: last row is (0, 0, 0, 1) (Translation, rotation, scale, shear)
+//  - inverseRigid:  additionally the 3x3 part is orthonormal (Translation and rotation only, e.g. view matrices)
+constexpr mat4 inverseAffine(const mat4& m)
+{
+    mat3 invRot = inverse(toMat3(m));
+    vec3 t = -(invRot * vec3(m.columns[3].x, m.columns[3].y, m.columns[3].z));
+    mat4 result = mat4(invRot);
+    result.columns[3] = vec4(t, 1.0f);
+    return result;
+}
+
+constexpr mat4 inverseRigid(const mat4& m)
 {
-    mat4 projection;
+    mat3 invRot = transpose(toMat3(m));
+    vec3 t = -(invRot * vec3(m.columns[3].x, m.columns[3].y, m.columns[3].z));
+    mat4 result = mat4(invRot);
+    result.columns[3] = vec4(t, 1.0f);
+    return result;
+}
 
-    float fovY;
+// Normal matrix (inverse transpose of the 3x3 part) of a model or model-view matrix
+constexpr mat3 normalMatrix(const mat4& m) {
+    return normalMatrix(toMat3(m));
+}
+
+constexpr float determinant(const mat4& m)
+{
+    // Laplace expansion using the 2x2 sub-determinants of the first and last two columns
+    const vec4& a = m.columns[0];
+    const vec4& b = m.columns[1];
+    const vec4& c = m.columns[2];
+    const vec4& d = m.columns[3];
+    float s0 = a.x*b.y - b.x*a.y;
+    float s1 = a.x*b.z - b.x*a.z;
+    float s2 = a.x*b.w - b.x*a.w;
+    float s3 = a.y*b.z - b.y*a.z;
+    float s4 = a.y*b.w - b.y*a.w;
+    float s5 = a.z*b.w - b.z*a.w;
+    float c5 = c.z*d.w - d.z*c.w;
+    float c4 = c.y*d.w - d.y*c.w;
+    float c3 = c.y*d.z - d.y*c.z;
+    float c2 = c.x*d.w - d.x*c.w;
+    float c1 = c.x*d.z - d.x*c.z;
+    float c0 = c.x*d.y - d.x*c.y;
+    return s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0;
+}
+
+#ifdef UPP_SSE
+// The 4x4 matrix is split into 2x2 blocks | A B |, each stored in one register as (m00, m01, m10, m11).
+//                                         | C D |
+// The inverse is then calculated blockwise with 2x2 adjugates (See "Fast 4x4 Matrix Inverse with SSE SIMD").
+// The algorithm does not care if the matrix is row or column major, since inverse(transpose(M)) = transpose(inverse(M)).
+#define SSE_SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps((a), (b), _MM_SHUFFLE((w), (z), (y), (x)))
+#define SSE_SWIZZLE(a, x, y, z, w) SSE_SHUFFLE((a), (a), (x), (y), (z), (w))
+
+// 2x2 A*B
+inline __m128 sseMat2Mul(__m128 a, __m128 b) {
+    return _mm_add_ps(_mm_mul_ps(a, SSE_SWIZZLE(b, 0, 3, 0, 3)),
+            _mm_mul_ps(SSE_SWIZZLE(a, 1, 0, 3, 2), SSE_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// 2x2 adjugate(A)*B
+inline __m128 sseMat2AdjMul(__m128 a, __m128 b) {
+    return _mm_sub_ps(_mm_mul_ps(SSE_SWIZZLE(a, 3, 3, 0, 0), b),
+            _mm_mul_ps(SSE_SWIZZLE(a, 1, 1, 2, 2), SSE_SWIZZLE(b, 2, 3, 0, 1)));
+}
+
+// 2x2 A*adjugate(B)
+inline __m128 sseMat2MulAdj(__m128 a, __m128 b) {
+    return _mm_sub_ps(_mm_mul_ps(a, SSE_SWIZZLE(b, 3, 0, 3, 0)),
+            _mm_mul_ps(SSE_SWIZZLE(a, 1, 0, 3, 2), SSE_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+mat4 inverse(const mat4& m)
+{
+    __m128 c0 = _mm_loadu_ps(&m.columns[0].x);
+    __m128 c1 = _mm_loadu_ps(&m.columns[1].x);
+    __m128 c2 = _mm_loadu_ps(&m.columns[2].x);
+    __m128 c3 = _mm_loadu_ps(&m.columns[3].x);
+
+    // Sub matrices
+    __m128 A = _mm_movelh_ps(c0, c1);
+    __m128 B = _mm_movehl_ps(c1, c0);
+    __m128 C = _mm_movelh_ps(c2, c3);
+    __m128 D = _mm_movehl_ps(c3, c2);
+
+    // Determinants of the sub matrices as (|A|, |B|, |C|, |D|)
+    __m128 detSub = _mm_sub_ps(
+            _mm_mul_ps(SSE_SHUFFLE(c0, c2, 0, 2, 0, 2), SSE_SHUFFLE(c1, c3, 1, 3, 1, 3)),
+            _mm_mul_ps(SSE_SHUFFLE(c0, c2, 1, 3, 1, 3), SSE_SHUFFLE(c1, c3, 0, 2, 0, 2)));
+    __m128 detA = SSE_SWIZZLE(detSub, 0, 0, 0, 0);
+    __m128 detB = SSE_SWIZZLE(detSub, 1, 1, 1, 1);
+    __m128 detC = SSE_SWIZZLE(detSub, 2, 2, 2, 2);
+    __m128 detD = SSE_SWIZZLE(detSub, 3, 3, 3, 3);
+
+    // inverse(M) = 1/|M| * | X Y |, all blocks are calculated as adjugates first
+    //                      | Z W |
+    __m128 D_C = sseMat2AdjMul(D, C);
+    __m128 A_B = sseMat2AdjMul(A, B);
+    __m128 X_ = _mm_sub_ps(_mm_mul_ps(detD, A), sseMat2Mul(B, D_C));
+    __m128 W_ = _mm_sub_ps(_mm_mul_ps(detA, D), sseMat2Mul(C, A_B));
+    __m128 Y_ = _mm_sub_ps(_mm_mul_ps(detB, C), sseMat2MulAdj(D, A_B));
+    __m128 Z_ = _mm_sub_ps(_mm_mul_ps(detC, B), sseMat2MulAdj(A, D_C));
+
+    // |M| = |A|*|D| + |B|*|C| - trace(A#B * D#C)
+    __m128 detM = _mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC));
+    __m128 tr = _mm_mul_ps(A_B, SSE_SWIZZLE(D_C, 0, 2, 1, 3));
+    tr = _mm_add_ps(tr, SSE_SWIZZLE(tr, 1, 0, 3, 2));
+    tr = _mm_add_ps(tr, SSE_SWIZZLE(tr, 2, 3, 0, 1));
+    detM = _mm_sub_ps(detM, tr);
+
+    // (1/|M|, -1/|M|, -1/|M|, 1/|M|)
+    __m128 rDetM = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+    X_ = _mm_mul_ps(X_, rDetM);
+    Y_ = _mm_mul_ps(Y_, rDetM);
+    Z_ = _mm_mul_ps(Z_, rDetM);
+    W_ = _mm_mul_ps(W_, rDetM);
+
+    // Apply adjugate shuffle and store
+    mat4 result;
+    _mm_storeu_ps(&result.columns[0].x, SSE_SHUFFLE(X_, Y_, 3, 1, 3, 1));
+    _mm_storeu_ps(&result.columns[1].x, SSE_SHUFFLE(X_, Y_, 2, 0, 2, 0));
+    _mm_storeu_ps(&result.columns[2].x, SSE_SHUFFLE(Z_, W_, 3, 1, 3, 1));
+    _mm_storeu_ps(&result.columns[3].x, SSE_SHUFFLE(Z_, W_, 2, 0, 2, 0));
+    return result;
+}
+
+#undef SSE_SHUFFLE
+#undef SSE_SWIZZLE
+#else
+mat4 inverse(const mat4& m)
+{
+    // Same 2x2 sub-determinants as in determinant(mat4), inverse = adjugate / det
+    const vec4& a = m.columns[0];
+    const vec4& b = m.columns[1];
+    const vec4& c = m.columns[2];
+    const vec4& d = m.columns[3];
+    float s0 = a.x*b.y - b.x*a.y;
+    float s1 = a.x*b.z - b.x*a.z;
+    float s2 = a.x*b.w - b.x*a.w;
+    float s3 = a.y*b.z - b.y*a.z;
+    float s4 = a.y*b.w - b.y*a.w;
+    float s5 = a.z*b.w - b.z*a.w;
+    float c5 = c.z*d.w - d.z*c.w;
+    float c4 = c.y*d.w - d.y*c.w;
+    float c3 = c.y*d.z - d.y*c.z;
+    float c2 = c.x*d.w - d.x*c.w;
+    float c1 = c.x*d.z - d.x*c.z;
+    float c0 = c.x*d.y - d.x*c.y;
+    float invDet = 1.0f / (s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0);
+
+    mat4 r;
+    r.columns[0] = vec4( b.y*c5 - b.z*c4 + b.w*c3,
+                        -a.y*c5 + a.z*c4 - a.w*c3,
+                         d.y*s5 - d.z*s4 + d.w*s3,
+                        -c.y*s5 + c.z*s4 - c.w*s3) * invDet;
+    r.columns[1] = vec4(-b.x*c5 + b.z*c2 - b.w*c1,
+                         a.x*c5 - a.z*c2 + a.w*c1,
+                        -d.x*s5 + d.z*s2 - d.w*s1,
+                         c.x*s5 - c.z*s2 + c.w*s1) * invDet;
+    r.columns[2] = vec4( b.x*c4 - b.y*c2 + b.w*c0,
+                        -a.x*c4 + a.y*c2 - a.w*c0,
+                         d.x*s4 - d.y*s2 + d.w*s0,
+                        -c.x*s4 + c.y*s2 - c.w*s0) * invDet;
+    r.columns[3] = vec4(-b.x*c3 + b.y*c1 - b.z*c0,
+                         a.x*c3 - a.y*c1 + a.z*c0,
+                        -d.x*s3 + d.y*s1 - d.z*s0,
+                         c.x*s3 - c.y*s1 + c.z*s0) * invDet;
+    return r;
+}
+#endif
+
+// Shared by projection and ctProjection, tanFunc is tanf or ctTan
+constexpr mat4 projectionWithTan(float near, float far, float fovX, float aspectRatio, float (*tanFunc)(float))
+{
+    mat4 projection(0.0f);
+
+    float fovY = fovX;
     if (aspectRatio > 1.0f) {
         fovY = fovX / aspectRatio;
     }
     else {
-        fovY = fovX;
         fovX = fovX * aspectRatio;
     }
-    float sx = 1.0f / tanf(fovX/2.0f);
-    float sy = 1.0f / tanf(fovY/2.0f);
+    float sx = 1.0f / tanFunc(fovX/2.0f);
+    float sy = 1.0f / tanFunc(fovY/2.0f);
     projection.columns[0] = vec4(sx, 0.0f, 0.0f, 0.0f);
     projection.columns[1] = vec4(0.0f, sy, 0.0f, 0.0f);
     projection.columns[2] = vec4(0.0f, 0.0f, -(far+near)/(far-near), -1.0f);
@@ -186,6 +374,15 @@ mat4 projection(float near, float far, float fovX, float aspectRatio)
     return projection;
 }
 
+mat4 projection(float near, float far, float fovX, float aspectRatio) {
+    return projectionWithTan(near, far, fovX, aspectRatio, tanf);
+}
+
+// Uses ctTan, so constant projections can be created at compile time
+constexpr mat4 ctProjection(float near, float far, float fovX, float aspectRatio) {
+    return projectionWithTan(near, far, fovX, aspectRatio, ctTan);
+}
+
 mat4 lookInDir(const vec3& pos, const vec3& dir, const vec3& up) 
 {
     mat4 view;
@@ -5,42 +5,43 @@
 // --- SCALAR FUNCTIONS ---
 // ------------------------
 // Take one or multiple scalars and produce another scalar
+// Functions that do not depend on cmath are constexpr
 
 // Basic functions
 template<typename T>
-T max(T a, T b) {
+constexpr T max(T a, T b) {
     return a > b ? a : b;
 }
 
 template<typename T>
-T min(T a, T b) {
+constexpr T min(T a, T b) {
     return a < b ? a : b;
 }
 
 template<typename T>
-T abs(T a) {
+constexpr T abs(T a) {
     return max(-a, a);
 }
 
 template<typename T>
-T clamp(T x, T minimum, T maximum) {
+constexpr T clamp(T x, T minimum, T maximum) {
     return min(max(x, minimum), maximum);
 }
 
 template<typename T>
-T lerp(T t1, T t2, float a) {
+constexpr T lerp(T t1, T t2, float a) {
     return t1 * (1.0f-a) + a * t2;
 }
 
 // Rounding functions
 
 // Rounds down to next lower multiple
-u64 floor(u64 x, u64 m) { 
+constexpr u64 floor(u64 x, u64 m) { 
     return x - x % m;
 }
 
 // Rounds up to next higher multiple
-u64 ceil(u64 x, u64 m) {
+constexpr u64 ceil(u64 x, u64 m) {
     if (x % m == 0) {
         return x;
     }
@@ -54,32 +55,32 @@ template<typename T>
 struct Interval
 {
     Interval(){};
-    Interval(T min, T max) : min(min), max(max) {}
+    constexpr Interval(T min, T max) : min(min), max(max) {}
     T min, max;
 };
 
 template<typename T>
-bool inIntervalOpen(T x, const Interval<T>& i) {
+constexpr bool inIntervalOpen(T x, const Interval<T>& i) {
     return x > i.min && x < i.max;
 }
 
 template<typename T>
-bool inIntervalClosed(T x, const Interval<T>& i) {
+constexpr bool inIntervalClosed(T x, const Interval<T>& i) {
     return x >= i.min && x <= i.max;
 }
 
 template<typename T>
-bool noOverlap(const Interval<T>& a, const Interval<T>& b) {
+constexpr bool noOverlap(const Interval<T>& a, const Interval<T>& b) {
     return a.max < b.min || b.max < a.min;
 }
 
 template<typename T>
-bool overlap(Interval<T> a, Interval<T> b) {
+constexpr bool overlap(Interval<T> a, Interval<T> b) {
     return !noOverlap(a, b);
 }
 
 template<typename T>
-bool inside(const Interval<T> x, Interval<T> surrounding) {
+constexpr bool inside(const Interval<T> x, Interval<T> surrounding) {
     return x.min >= surrounding.min && x.max <= surrounding.max;
 }
 
@@ -88,7 +89,7 @@ bool inside(const Interval<T> x, Interval<T> surrounding) {
 // MODULO FUNCTIONS
 // These are used because the c++ % operator is actually the remainder, not modulo
 
-int mod(int x, int m) {
+constexpr int mod(int x, int m) {
     return (x % m + x) % m;
 }
 
@@ -106,16 +107,68 @@ float modInt(float x, float min, float max) {
 // Are defined in cmath, these are just some helper functions
 
 // Radians to degree
-float radians2degree(float r) {
+constexpr float radians2degree(float r) {
     return r / PI * 180.0f;
 }
 // degreeToRadians
-float degree2radians(float d) {
+constexpr float degree2radians(float d) {
     return d / (180.0f) * PI;
 }
 
 #define r2d(x) radians2degree((x))
 #define d2r(x) degree2radians((x))
 
+// COMPILE TIME FUNCTIONS
+// cmath is not constexpr, so these are used where values should be computed 
+// at compile time (Tables, constant matrices). They are calculated in double
+// precision, the results are accurate to float precision.
+
+// Newton iteration, returns 0 for x <= 0
+constexpr float ctSqrt(float x)
+{
+    if (x <= 0.0f) {
+        return 0.0f;
+    }
+    double v = (double)x;
+    double r = v > 1.0 ? v : 1.0;
+    for (int i = 0; i < 64; i++) {
+        double next = 0.5 * (r + v / r);
+        if (next == r) break;
+        r = next;
+    }
+    return (float)r;
+}
+
+constexpr float ctSin(float x)
+{
+    // Reduce to [-PI, PI]
+    const double pi = 3.14159265358979323846;
+    double v = (double)x;
+    double turns = v / (2.0 * pi);
+    long long whole = (long long)(turns < 0.0 ? turns - 0.5 : turns + 0.5);
+    v -= (double)whole * 2.0 * pi;
+    // Reduce to [-PI/2, PI/2] with sin(PI - x) = sin(x)
+    if (v > pi / 2.0) v = pi - v;
+    if (v < -pi / 2.0) v = -pi - v;
+
+    // Taylor series
+    double v2 = v * v;
+    double term = v;
+    double sum = v;
+    for (int i = 1; i < 12; i++) {
+        term *= -v2 / ((2.0*i) * (2.0*i + 1.0));
+        sum += term;
+    }
+    return (float)sum;
+}
+
+constexpr float ctCos(float x) {
+    return ctSin(x + PI / 2.0f);
+}
+
+constexpr float ctTan(float x) {
+    return ctSin(x) / ctCos(x);
+}
+
 
 #endif
@@ -9,10 +9,11 @@
 vec3 spherical2euclidean(const vec2& s)
 {
     // The s vector is made up of (azimuth angle, polar angle (measured from zenith pointing up))
-    float y = sinf(s.y);
-    float len_xz = cosf(s.y);
-    float z = -cosf(s.x) * len_xz;
-    float x = -sinf(s.x) * len_xz;
+    float y, len_xz, sinAzimuth, cosAzimuth;
+    fastSinCos(s.y, &y, &len_xz);
+    fastSinCos(s.x, &sinAzimuth, &cosAzimuth);
+    float z = -cosAzimuth * len_xz;
+    float x = -sinAzimuth * len_xz;
     return vec3(x, y, z);
 }
 
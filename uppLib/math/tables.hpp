@@ -0,0 +1,115 @@
+#ifndef __TABLES_HPP__
+#define __TABLES_HPP__
+
+// ------------------------------
+// --- COMPILE TIME TABLES ---
+// ------------------------------
+// Lookup tables that are generated by the compiler. Declare them constexpr 
+// (e.g. constexpr SinTable<256> sinTable;) and they cost nothing at startup
+// and are placed in read only memory.
+// Sizes should stay small (<= 1024), because compilers limit constexpr evaluation steps.
+
+// EASING FUNCTIONS
+// All take t in [0, 1] and return 0 at t=0 and 1 at t=1
+constexpr float easeLinear(float t) { return t; }
+constexpr float easeInQuad(float t) { return t*t; }
+constexpr float easeOutQuad(float t) { return t*(2.0f - t); }
+constexpr float easeInOutQuad(float t) { 
+    return t < 0.5f ? 2.0f*t*t : -1.0f + (4.0f - 2.0f*t)*t; 
+}
+constexpr float easeInCubic(float t) { return t*t*t; }
+constexpr float easeOutCubic(float t) { return (t-1.0f)*(t-1.0f)*(t-1.0f) + 1.0f; }
+constexpr float easeInOutCubic(float t) {
+    return t < 0.5f ? 4.0f*t*t*t : (t-1.0f)*(2.0f*t-2.0f)*(2.0f*t-2.0f) + 1.0f;
+}
+constexpr float smoothstep(float t) { return t*t*(3.0f - 2.0f*t); }
+constexpr float smootherstep(float t) { return t*t*t*(t*(t*6.0f - 15.0f) + 10.0f); }
+constexpr float easeInSine(float t) { return 1.0f - ctCos(t * PI / 2.0f); }
+constexpr float easeOutSine(float t) { return ctSin(t * PI / 2.0f); }
+
+typedef float (*EasingFunc)(float t);
+
+// SIN TABLE
+// N samples of one period, lookups interpolate linearly
+template<int N>
+struct SinTable
+{
+    constexpr SinTable() : values{} {
+        for (int i = 0; i <= N; i++) {
+            values[i] = ctSin(2.0f * PI * (float)i / (float)N);
+        }
+    }
+    float values[N+1]; // Last value is a copy of the first, so interpolation needs no wrap
+};
+
+template<int N>
+float lookupSin(const SinTable<N>& table, float x)
+{
+    float t = x / (2.0f * PI);
+    t = (t - floorf(t)) * (float)N;
+    int i = (int)t;
+    if (i >= N) i = N - 1;
+    float a = t - (float)i;
+    return table.values[i] * (1.0f - a) + table.values[i+1] * a;
+}
+
+template<int N>
+float lookupCos(const SinTable<N>& table, float x) {
+    return lookupSin(table, x + PI / 2.0f);
+}
+
+// EASING TABLE
+// Samples an easing function at N+1 points in [0, 1]
+template<int N>
+struct EasingTable
+{
+    constexpr EasingTable(EasingFunc func) : values{} {
+        for (int i = 0; i <= N; i++) {
+            values[i] = func((float)i / (float)N);
+        }
+    }
+    float values[N+1];
+};
+
+template<int N>
+constexpr float lookupEasing(const EasingTable<N>& table, float t)
+{
+    t = clamp(t, 0.0f, 1.0f) * (float)N;
+    int i = (int)t;
+    if (i >= N) i = N - 1;
+    float a = t - (float)i;
+    return table.values[i] * (1.0f - a) + table.values[i+1] * a;
+}
+
+// NOISE PERMUTATION TABLE
+// Shuffled 0..N-1 (Fisher-Yates with a xorshift rng), repeated twice
+// so that perm[perm[x] + y] does not need a wrap (Like in perlin noise)
+template<int N>
+struct PermutationTable
+{
+    constexpr PermutationTable(u32 seed) : values{} 
+    {
+        for (int i = 0; i < N; i++) {
+            values[i] = (u16)i;
+        }
+        u32 state = seed != 0 ? seed : 1;
+        for (int i = N-1; i > 0; i--) 
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            int j = (int)(state % (u32)(i+1));
+            u16 tmp = values[i];
+            values[i] = values[j];
+            values[j] = tmp;
+        }
+        for (int i = 0; i < N; i++) {
+            values[N+i] = values[i];
+        }
+    }
+    u16 values[2*N];
+};
+
+
+
+#endif
@@ -6,10 +6,23 @@
 // Defines
 #define PI 3.14159265359f
 
+// SIMD
+// Some hot functions (e.g. the mat4 inverse) have SSE paths.
+// Define UPP_NO_SIMD to force the scalar implementations.
+#if !defined(UPP_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define UPP_SSE
+#include <emmintrin.h>
+#endif
+// Wider paths (AVX2) are selected at runtime, see cpuFeatures.hpp
+#include "../utils/cpuFeatures.hpp"
+
 #include "scalars.hpp"
+#include "approx.hpp"
 #include "vectors.hpp"
 #include "matrices.hpp"
 #include "spherical.hpp"
+#include "bounds.hpp"
+#include "tables.hpp"
 
 
 
@@ -330,6 +330,439 @@ void test_strings()
     arr[0] = str;
 }
 
+// Double precision reference inverse (Gauss-Jordan with partial pivoting), column major like mat4
+bool referenceInverse(const mat4& m, double* out)
+{
+    double a[4][8];
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 4; c++) {
+            a[r][c] = ((float*)m.columns)[c*4 + r];
+            a[r][c+4] = r == c ? 1.0 : 0.0;
+        }
+    }
+    for (int c = 0; c < 4; c++)
+    {
+        int pivot = c;
+        for (int r = c+1; r < 4; r++) {
+            if (fabs(a[r][c]) > fabs(a[pivot][c])) pivot = r;
+        }
+        if (fabs(a[pivot][c]) < 1e-12) return false;
+        for (int i = 0; i < 8; i++) {
+            double tmp = a[c][i]; a[c][i] = a[pivot][i]; a[pivot][i] = tmp;
+        }
+        double p = a[c][c];
+        for (int i = 0; i < 8; i++) a[c][i] /= p;
+        for (int r = 0; r < 4; r++) {
+            if (r == c) continue;
+            double f = a[r][c];
+            for (int i = 0; i < 8; i++) a[r][i] -= f * a[c][i];
+        }
+    }
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 4; c++) {
+            out[c*4 + r] = a[r][c+4];
+        }
+    }
+    return true;
+}
+
+// Max relative error of m compared to the reference
+double inverseError(const mat4& m, double* ref)
+{
+    double maxRef = 0.0;
+    double maxErr = 0.0;
+    for (int i = 0; i < 16; i++) {
+        maxRef = max(maxRef, fabs(ref[i]));
+        maxErr = max(maxErr, fabs(((float*)m.columns)[i] - ref[i]));
+    }
+    return maxErr / max(maxRef, 1.0);
+}
+
+float randomFloat(float min, float max) {
+    return min + (max - min) * (float)rand() / (float)RAND_MAX;
+}
+
+void test_matrices()
+{
+    srand(17);
+    double ref[16];
+    double maxGeneral = 0.0, maxAffine = 0.0, maxRigid = 0.0, maxNormal = 0.0;
+    for (int i = 0; i < 10000; i++)
+    {
+        // General matrix (Diagonal is boosted so the matrix is well conditioned)
+        mat4 m;
+        for (int j = 0; j < 16; j++) {
+            ((float*)m.columns)[j] = randomFloat(-10.0f, 10.0f);
+        }
+        for (int j = 0; j < 4; j++) {
+            ((float*)m.columns)[j*5] += 30.0f;
+        }
+        if (referenceInverse(m, ref)) {
+            maxGeneral = max(maxGeneral, inverseError(inverse(m), ref));
+        }
+
+        // Affine matrix (translation * rotation * scale)
+        vec3 axis = normalizeSafe(vec3(randomFloat(-1, 1), randomFloat(-1, 1), randomFloat(-1, 1)));
+        vec2 angles = vec2(randomFloat(-PI, PI), randomFloat(-PI/2.0f, PI/2.0f));
+        mat4 rot = inverseRigid(lookInDir(vec3(0.0f), sp2eu(angles), axis));
+        mat4 t = translate(vec3(randomFloat(-100, 100), randomFloat(-100, 100), randomFloat(-100, 100)));
+        mat4 s = mat4(scale(vec3(randomFloat(0.1f, 10), randomFloat(0.1f, 10), randomFloat(0.1f, 10))));
+        mat4 rigid = t * rot;
+        mat4 affine = rigid * s;
+        if (referenceInverse(affine, ref)) {
+            maxAffine = max(maxAffine, inverseError(inverseAffine(affine), ref));
+            // Normal matrix should be the transposed upper 3x3 of the inverse
+            mat4 normal = mat4(transpose(normalMatrix(affine)));
+            for (int j = 0; j < 3; j++) {
+                ref[12+j] = 0.0;
+                ref[j*4+3] = 0.0;
+            }
+            ref[15] = 1.0;
+            maxNormal = max(maxNormal, inverseError(normal, ref));
+        }
+        if (referenceInverse(rigid, ref)) {
+            maxRigid = max(maxRigid, inverseError(inverseRigid(rigid), ref));
+        }
+    }
+
+    loggf("inverse max rel error (should be < 1e-4): %e\n", maxGeneral);
+    loggf("inverseAffine max rel error (should be < 1e-4): %e\n", maxAffine);
+    loggf("inverseRigid max rel error (should be < 1e-4): %e\n", maxRigid);
+    loggf("normalMatrix max rel error (should be < 1e-4): %e\n", maxNormal);
+
+    mat3 m3 = mat3(vec3(2, 0, 1), vec3(1, 3, 0), vec3(0, 1, 4));
+    mat3 id3 = m3 * inverse(m3);
+    loggf("mat3 * inverse should be identity:\n\t%f %f %f\n\t%f %f %f\n\t%f %f %f\n",
+            id3.columns[0].x, id3.columns[1].x, id3.columns[2].x,
+            id3.columns[0].y, id3.columns[1].y, id3.columns[2].y,
+            id3.columns[0].z, id3.columns[1].z, id3.columns[2].z);
+    mat2 m2 = mat2(vec2(4, 2), vec2(7, 6));
+    mat2 id2 = m2 * inverse(m2);
+    loggf("mat2 * inverse should be identity: %f %f %f %f\n", 
+            id2.columns[0].x, id2.columns[1].x, id2.columns[0].y, id2.columns[1].y);
+}
+
+#include <chrono>
+double secondsSince(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Random spheres (x, y, z, r) and boxes (x, y, z, ex, ey, ez) in SoA layout, with output
+// buffers for the batch results and separate scalar references
+struct CullingVolumes
+{
+    SystemAllocator sa;
+    Blk mem;
+    float* x;
+    float* y;
+    float* z;
+    float* r;
+    float* ex;
+    float* ey;
+    float* ez;
+    int* visible;
+    int* sphereRef;
+    int* boxRef;
+};
+
+void init(CullingVolumes* v, int count)
+{
+    v->mem = v->sa.alloc(sizeof(float) * count * 7 + sizeof(int) * count * 3);
+    v->x = (float*) v->mem.data;
+    v->y = v->x + count;
+    v->z = v->y + count;
+    v->r = v->z + count;
+    v->ex = v->r + count;
+    v->ey = v->ex + count;
+    v->ez = v->ey + count;
+    v->visible = (int*) (v->ez + count);
+    v->sphereRef = v->visible + count;
+    v->boxRef = v->sphereRef + count;
+    for (int i = 0; i < count; i++) {
+        v->x[i] = randomFloat(-150, 150);
+        v->y[i] = randomFloat(-150, 150);
+        v->z[i] = randomFloat(-150, 150);
+        v->r[i] = randomFloat(0.1f, 5.0f);
+        v->ex[i] = randomFloat(0.1f, 5.0f);
+        v->ey[i] = randomFloat(0.1f, 5.0f);
+        v->ez[i] = randomFloat(0.1f, 5.0f);
+    }
+}
+
+void shutdown(CullingVolumes* v) {
+    v->sa.dealloc(v->mem);
+}
+
+void test_culling()
+{
+    srand(5);
+    Frustum f = extractFrustum(projection(0.1f, 100.0f, d2r(90), 16.0f/9.0f) * 
+            lookAt(vec3(0, 0, 10), vec3(0), vec3(0, 1, 0)));
+
+    // Simple checks
+    loggf("Sphere at origin visible, should be 1: %d\n", intersects(f, BoundingSphere(vec3(0), 1.0f)));
+    loggf("Sphere behind camera visible, should be 0: %d\n", intersects(f, BoundingSphere(vec3(0, 0, 15), 1.0f)));
+    loggf("Sphere touching near plane visible, should be 1: %d\n", intersects(f, BoundingSphere(vec3(0, 0, 10.5f), 1.0f)));
+    loggf("Box far left visible, should be 0: %d\n", intersects(f, AABB(vec3(-100, -1, -1), vec3(-90, 1, 1))));
+    loggf("Box around camera visible, should be 1: %d\n", intersects(f, AABB(vec3(-20), vec3(20))));
+
+    // Batch tests against scalar reference
+    const int count = 100000;
+    CullingVolumes v;
+    init(&v, count);
+    SCOPE_EXIT(shutdown(&v));
+    float *x = v.x, *y = v.y, *z = v.z, *r = v.r, *ex = v.ex, *ey = v.ey, *ez = v.ez;
+    int* visible = v.visible;
+
+    int sphereCount = cullSpheres(f, count, x, y, z, r, visible);
+    int sphereRefCount = cullSpheresScalar(f, count, x, y, z, r, v.sphereRef);
+    bool spheresMatch = sphereCount == sphereRefCount && memcmp(visible, v.sphereRef, sizeof(int) * sphereCount) == 0;
+    loggf("Sphere batch visible: %d, scalar: %d, match should be 1: %d\n", sphereCount, sphereRefCount, spheresMatch);
+
+    int boxCount = cullAABBs(f, count, x, y, z, ex, ey, ez, visible);
+    int boxRefCount = cullAABBsScalar(f, count, x, y, z, ex, ey, ez, v.boxRef);
+    bool boxesMatch = boxCount == boxRefCount && memcmp(visible, v.boxRef, sizeof(int) * boxCount) == 0;
+    loggf("AABB batch visible: %d, scalar: %d, match should be 1: %d\n", boxCount, boxRefCount, boxesMatch);
+
+    // Benchmark, 100k objects per frame
+    const int frames = 100;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < frames; i++) cullSpheresScalar(f, count, x, y, z, r, visible);
+    double sphereScalar = secondsSince(start) / frames;
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < frames; i++) cullSpheres(f, count, x, y, z, r, visible);
+    double sphereBatch = secondsSince(start) / frames;
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < frames; i++) cullAABBsScalar(f, count, x, y, z, ex, ey, ez, visible);
+    double boxScalar = secondsSince(start) / frames;
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < frames; i++) cullAABBs(f, count, x, y, z, ex, ey, ez, visible);
+    double boxBatch = secondsSince(start) / frames;
+    loggf("Culling %d spheres: scalar %.3f ms, batch %.3f ms\n", count, sphereScalar * 1000, sphereBatch * 1000);
+    loggf("Culling %d aabbs: scalar %.3f ms, batch %.3f ms\n", count, boxScalar * 1000, boxBatch * 1000);
+}
+
+void test_dispatch()
+{
+    srand(7);
+    Frustum f = extractFrustum(projection(0.1f, 100.0f, d2r(90), 16.0f/9.0f) * 
+            lookAt(vec3(0, 0, 10), vec3(0), vec3(0, 1, 0)));
+    const int count = 100003; // Not a multiple of 8, so remainder loops run
+    CullingVolumes v;
+    init(&v, count);
+    SCOPE_EXIT(shutdown(&v));
+    float *x = v.x, *y = v.y, *z = v.z, *r = v.r, *ex = v.ex, *ey = v.ey, *ez = v.ez;
+    int* visible = v.visible;
+    int sphereRefCount = cullSpheresScalar(f, count, x, y, z, r, v.sphereRef);
+    int boxRefCount = cullAABBsScalar(f, count, x, y, z, ex, ey, ez, v.boxRef);
+
+    // Run every level up to the supported one against the scalar reference
+    SimdLevel::ENUM supported = getSupportedSimdLevel(getCpuFeatures());
+    for (int level = 0; level <= supported; level++)
+    {
+        setMaxSimdLevel((SimdLevel::ENUM) level);
+        int sphereCount = cullSpheres(f, count, x, y, z, r, visible);
+        bool spheresMatch = sphereCount == sphereRefCount && memcmp(visible, v.sphereRef, sizeof(int) * sphereCount) == 0;
+        int boxCount = cullAABBs(f, count, x, y, z, ex, ey, ez, visible);
+        bool boxesMatch = boxCount == boxRefCount && memcmp(visible, v.boxRef, sizeof(int) * boxCount) == 0;
+
+        const int frames = 100;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < frames; i++) cullSpheres(f, count, x, y, z, r, visible);
+        double sphereTime = secondsSince(start) / frames;
+        loggf("Max level %s (cullSpheres uses %s): spheres match should be 1: %d, boxes match should be 1: %d, %.3f ms\n",
+                toStr((SimdLevel::ENUM) level), toStr(cullSpheresKernel->selectedLevel), 
+                spheresMatch, boxesMatch, sphereTime * 1000);
+    }
+    setMaxSimdLevel(supported);
+    logKernelDispatch();
+}
+
+void test_overlap()
+{
+    srand(9);
+    loggf("Sphere inside box overlaps, should be 1: %d\n", intersects(AABB(vec3(-1), vec3(1)), BoundingSphere(vec3(0), 0.1f)));
+    loggf("Sphere touching box corner overlaps, should be 1: %d\n", intersects(AABB(vec3(-1), vec3(1)), BoundingSphere(vec3(2, 1, 1), 1.0f)));
+    loggf("Sphere near box corner overlaps, should be 0: %d\n", intersects(AABB(vec3(-1), vec3(1)), BoundingSphere(vec3(2, 2, 2), 1.5f)));
+
+    const int count = 1027; // Not a multiple of 8, so remainder loops run
+    SystemAllocator sa;
+    Blk mem = sa.alloc(sizeof(float) * count * 4 + sizeof(int) * count * 2);
+    SCOPE_EXIT(sa.dealloc(mem));
+    float* x = (float*) mem.data;
+    float* y = x + count;
+    float* z = y + count;
+    float* r = z + count;
+    int* overlap = (int*) (r + count);
+    int* overlapRef = overlap + count;
+    for (int i = 0; i < count; i++) {
+        x[i] = randomFloat(-50, 50);
+        y[i] = randomFloat(-50, 50);
+        z[i] = randomFloat(-50, 50);
+        r[i] = randomFloat(0.5f, 10.0f);
+    }
+    const int boxCount = 3456; // Clusters of a 16x9x24 grid
+    Blk boxBlk = sa.alloc(sizeof(AABB) * boxCount);
+    SCOPE_EXIT(sa.dealloc(boxBlk));
+    AABB* boxes = (AABB*) boxBlk.data;
+    for (int i = 0; i < boxCount; i++) {
+        vec3 min = vec3(randomFloat(-50, 50), randomFloat(-50, 50), randomFloat(-50, 50));
+        boxes[i] = AABB(min, min + vec3(randomFloat(0.5f, 8.0f), randomFloat(0.5f, 8.0f), randomFloat(0.5f, 8.0f)));
+    }
+
+    SimdLevel::ENUM supported = getSupportedSimdLevel(getCpuFeatures());
+    for (int level = 0; level <= supported; level++)
+    {
+        setMaxSimdLevel((SimdLevel::ENUM) level);
+        bool match = true;
+        int total = 0;
+        for (int i = 0; i < boxCount; i++) {
+            int c = overlapSpheresAABB(boxes[i], count, x, y, z, r, overlap);
+            int refCount = overlapSpheresAABBScalar(boxes[i], count, x, y, z, r, overlapRef);
+            match &= c == refCount && memcmp(overlap, overlapRef, sizeof(int) * c) == 0;
+            total += c;
+        }
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < boxCount; i++) overlapSpheresAABB(boxes[i], count, x, y, z, r, overlap);
+        double time = secondsSince(start);
+        loggf("Max level %s (overlapSpheresAABB uses %s): %d overlaps, match should be 1: %d, %d boxes x %d spheres %.3f ms\n",
+                toStr((SimdLevel::ENUM) level), toStr(overlapSpheresAABBKernel->selectedLevel),
+                total, match, boxCount, count, time * 1000);
+    }
+    setMaxSimdLevel(supported);
+}
+
+// Max error of a batch function against a double precision reference.
+// Relative error is error/|ref|, otherwise error/max(1, |ref|) (absolute for small results)
+double approxMaxError(ApproxBatchFunc batch, double (*reference)(double), 
+        const float* in, float* out, int count, bool relative)
+{
+    batch(in, out, count);
+    double maxError = 0;
+    for (int i = 0; i < count; i++) {
+        double ref = reference((double)in[i]);
+        double error = fabs((double)out[i] - ref);
+        error /= relative ? fabs(ref) : max(1.0, fabs(ref));
+        maxError = max(maxError, error);
+    }
+    return maxError;
+}
+
+double rsqrtReference(double x) { return 1.0 / sqrt(x); }
+void libmSinBatch(const float* in, float* out, int count) { for (int i = 0; i < count; i++) out[i] = sinf(in[i]); }
+void libmExpBatch(const float* in, float* out, int count) { for (int i = 0; i < count; i++) out[i] = expf(in[i]); }
+void libmLogBatch(const float* in, float* out, int count) { for (int i = 0; i < count; i++) out[i] = logf(in[i]); }
+void libmRsqrtBatch(const float* in, float* out, int count) { for (int i = 0; i < count; i++) out[i] = 1.0f / sqrtf(in[i]); }
+
+double approxBenchmark(ApproxBatchFunc batch, const float* in, float* out, int count)
+{
+    const int runs = 50;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < runs; i++) batch(in, out, count);
+    return secondsSince(start) / runs * 1000.0;
+}
+
+void test_approx()
+{
+    srand(11);
+    const int count = 1 << 20;
+    SystemAllocator sa;
+    Blk mem = sa.alloc(sizeof(float) * count * 5);
+    SCOPE_EXIT(sa.dealloc(mem));
+    float* trigIn = (float*) mem.data;
+    float* expIn = trigIn + count;
+    float* logIn = expIn + count;
+    float* rsqrtIn = logIn + count;
+    float* out = rsqrtIn + count;
+    for (int i = 0; i < count; i++) {
+        trigIn[i] = randomFloat(-8192.0f, 8192.0f);
+        expIn[i] = randomFloat(-87.0f, 88.0f);
+        logIn[i] = powf(10.0f, randomFloat(-30.0f, 30.0f));
+        rsqrtIn[i] = powf(10.0f, randomFloat(-30.0f, 30.0f));
+    }
+
+    // Accuracy of every path the cpu supports
+    SimdLevel::ENUM supported = getSupportedSimdLevel(getCpuFeatures());
+    for (int level = 0; level <= supported; level++)
+    {
+        setMaxSimdLevel((SimdLevel::ENUM) level);
+        loggf("%s path (%s):\n", toStr((SimdLevel::ENUM) level), toStr(fastSinBatchKernel->selectedLevel));
+        loggf("    sin max abs error, should be < 5e-7: %e\n", approxMaxError(fastSinBatch, sin, trigIn, out, count, false));
+        loggf("    cos max abs error, should be < 5e-7: %e\n", approxMaxError(fastCosBatch, cos, trigIn, out, count, false));
+        loggf("    exp max rel error, should be < 3e-7: %e\n", approxMaxError(fastExpBatch, exp, expIn, out, count, true));
+        loggf("    log max error, should be < 3e-7: %e\n", approxMaxError(fastLogBatch, log, logIn, out, count, false));
+#ifdef UPP_SSE
+        loggf("    rsqrt max rel error, should be < 5e-7: %e\n", approxMaxError(fastRsqrtBatch, rsqrtReference, rsqrtIn, out, count, true));
+#else
+        loggf("    rsqrt max rel error, should be < 5e-6: %e\n", approxMaxError(fastRsqrtBatch, rsqrtReference, rsqrtIn, out, count, true));
+#endif
+        loggf("    ms per %d values: sin %.3f, exp %.3f, log %.3f, rsqrt %.3f\n", count,
+                approxBenchmark(fastSinBatch, trigIn, out, count), approxBenchmark(fastExpBatch, expIn, out, count),
+                approxBenchmark(fastLogBatch, logIn, out, count), approxBenchmark(fastRsqrtBatch, rsqrtIn, out, count));
+    }
+    setMaxSimdLevel(supported);
+    loggf("libm ms per %d values: sin %.3f, exp %.3f, log %.3f, rsqrt %.3f\n", count,
+            approxBenchmark(libmSinBatch, trigIn, out, count), approxBenchmark(libmExpBatch, expIn, out, count),
+            approxBenchmark(libmLogBatch, logIn, out, count), approxBenchmark(libmRsqrtBatch, rsqrtIn, out, count));
+
+    // Scalar helpers
+    float s, c;
+    fastSinCos(2.0f, &s, &c);
+    loggf("fastSinCos(2): %f %f, should be %f %f\n", s, c, sinf(2.0f), cosf(2.0f));
+    vec3 n = normalize(vec3(3, 4, 12));
+    loggf("normalize(3, 4, 12): %f %f %f, should be %f %f %f\n", n.x, n.y, n.z, 3/13.0f, 4/13.0f, 12/13.0f);
+}
+
+// Evaluated by the compiler, a failing static_assert stops the build
+constexpr SinTable<256> sinTable;
+constexpr EasingTable<64> smoothTable(smootherstep);
+constexpr PermutationTable<256> permTable(1337);
+static_assert(dot(vec3(1, 2, 3), vec3(4, 5, 6)) == 32.0f, "constexpr dot");
+static_assert(cross(vec3(1, 0, 0), vec3(0, 1, 0)).z == 1.0f, "constexpr cross");
+static_assert((translate(vec3(1, 2, 3)) * vec4(0, 0, 0, 1)).y == 2.0f, "constexpr translate");
+static_assert(determinant(scale(vec3(2, 3, 4))) == 24.0f, "constexpr determinant");
+static_assert(ctSqrt(16.0f) == 4.0f, "constexpr sqrt");
+static_assert(sinTable.values[64] > 0.9999f, "sin table");
+static_assert(smoothTable.values[64] == 1.0f, "easing table");
+
+void test_constexpr()
+{
+    constexpr mat4 proj = ctProjection(0.1f, 100.0f, d2r(90), 16.0f/9.0f);
+    mat4 projRef = projection(0.1f, 100.0f, d2r(90), 16.0f/9.0f);
+    loggf("constexpr projection sx: %f, runtime: %f\n", proj.columns[0].x, projRef.columns[0].x);
+
+    float maxSinError = 0, maxTanError = 0, maxSqrtError = 0, maxTableError = 0, maxEasingError = 0;
+    for (int i = 0; i < 10000; i++) 
+    {
+        float x = randomFloat(-20.0f, 20.0f);
+        maxSinError = max(maxSinError, fabsf(ctSin(x) - sinf(x)));
+        maxTableError = max(maxTableError, fabsf(lookupSin(sinTable, x) - sinf(x)));
+        float t = randomFloat(-1.5f, 1.5f);
+        maxTanError = max(maxTanError, fabsf(ctTan(t) - tanf(t)) / max(1.0f, fabsf(tanf(t))));
+        float s = randomFloat(0.0f, 10000.0f);
+        maxSqrtError = max(maxSqrtError, fabsf(ctSqrt(s) - sqrtf(s)) / max(1.0f, sqrtf(s)));
+        float e = randomFloat(0.0f, 1.0f);
+        maxEasingError = max(maxEasingError, fabsf(lookupEasing(smoothTable, e) - smootherstep(e)));
+    }
+    loggf("ctSin max error, should be < 1e-6: %e\n", maxSinError);
+    loggf("ctTan max rel error, should be < 1e-5: %e\n", maxTanError);
+    loggf("ctSqrt max rel error, should be < 1e-6: %e\n", maxSqrtError);
+    loggf("SinTable<256> max error, should be < 1e-3: %e\n", maxTableError);
+    // Linear interpolation between the 65 samples, the error peaks at ~1.8e-4 around t=0.2
+    loggf("Smootherstep table max error, should be < 2e-4: %e\n", maxEasingError);
+
+    bool isPermutation = true;
+    int seen[256] = {};
+    for (int i = 0; i < 256; i++) {
+        seen[permTable.values[i]]++;
+        isPermutation = isPermutation && permTable.values[i] == permTable.values[256 + i];
+    }
+    for (int i = 0; i < 256; i++) {
+        isPermutation = isPermutation && seen[i] == 1;
+    }
+    loggf("Permutation table valid, should be 1: %d\n", isPermutation);
+}
+
 int main(int argc, char** argv)
 {
     //test_scopedExit();
@@ -337,6 +770,12 @@ int main(int argc, char** argv)
     //test_allocators();
     test_datastructures();
     //test_strings();
+    test_matrices();
+    test_culling();
+    test_constexpr();
+    test_dispatch();
+    test_overlap();
+    test_approx();
 
     return 0;
 }
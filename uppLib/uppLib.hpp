@@ -5,6 +5,7 @@
 #include "utils/scopeExit.hpp"
 #include "utils/debugging_tools.hpp"
 #include "utils/helperMacros.hpp"
+#include "utils/cpuFeatures.hpp"
 #include "math/umath.hpp"
 #include "allocators/allocator.hpp"
 #include "datastructures/datastructures.hpp"
@@ -0,0 +1,257 @@
+#ifndef __CPU_FEATURES_HPP__
+#define __CPU_FEATURES_HPP__
+
+// ------------------------------------
+// --- CPU FEATURES/KERNEL DISPATCH ---
+// ------------------------------------
+// The library is compiled for a baseline instruction set (SSE2 on x64),
+// wider paths are compiled per function (UPP_TARGET_AVX2) and only called
+// if the cpu supports them.
+// A Kernel holds one function pointer per SimdLevel, on creation the best
+// implementation the cpu supports gets selected:
+//
+//     Kernel* myKernel = createKernel("myKernel", {
+//         {SimdLevel::SCALAR, (GenericFunc) &myKernelScalar},
+//         {SimdLevel::AVX2, (GenericFunc) &myKernelAVX2}});
+//     dispatch<MyKernelFunc>(myKernel)(args...);
+//
+// setMaxSimdLevel() limits the selection (For testing/benchmarking the fallbacks),
+// logKernelDispatch() prints the detected features and the selected paths.
+
+#include <initializer_list>
+#include "datatypes.hpp"
+#include "debugging_tools.hpp"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define UPP_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// MSVC allows all intrinsics in all functions, gcc/clang need the target per function
+#if defined(UPP_X86) && !defined(_MSC_VER)
+#define UPP_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define UPP_TARGET_AVX2
+#endif
+
+struct CpuFeatures
+{
+    bool sse2;
+    bool sse41;
+    bool sse42;
+    bool popcnt;
+    bool avx;
+    bool avx2;
+    bool fma;
+    bool avx512f;
+    bool avx512bw;
+    bool avx512vl;
+};
+
+namespace SimdLevel
+{
+    enum ENUM
+    {
+        SCALAR = 0,
+        SSE2,
+        SSE42,
+        AVX2, // Includes FMA
+        AVX512,
+
+        COUNT // MUST STAY LAST
+    };
+};
+
+const char* toStr(SimdLevel::ENUM level)
+{
+    switch (level)
+    {
+    case SimdLevel::SCALAR: return "SCALAR";
+    case SimdLevel::SSE2: return "SSE2";
+    case SimdLevel::SSE42: return "SSE4.2";
+    case SimdLevel::AVX2: return "AVX2";
+    case SimdLevel::AVX512: return "AVX512";
+    default: break;
+    }
+    return "INVALID";
+}
+
+#ifdef UPP_X86
+void cpuid(int leaf, int subleaf, u32 regs[4])
+{
+#ifdef _MSC_VER
+    int r[4];
+    __cpuidex(r, leaf, subleaf);
+    for (int i = 0; i < 4; i++) regs[i] = (u32)r[i];
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Which register states the os saves on context switches
+u64 xgetbv0()
+{
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    u32 eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((u64)edx << 32) | eax;
+#endif
+}
+#endif
+
+CpuFeatures detectCpuFeatures()
+{
+    CpuFeatures f = {};
+#ifdef UPP_X86
+    u32 regs[4]; // eax, ebx, ecx, edx
+    cpuid(0, 0, regs);
+    u32 maxLeaf = regs[0];
+
+    cpuid(1, 0, regs);
+    f.sse2 = (regs[3] >> 26) & 1;
+    f.sse41 = (regs[2] >> 19) & 1;
+    f.sse42 = (regs[2] >> 20) & 1;
+    f.popcnt = (regs[2] >> 23) & 1;
+    f.fma = (regs[2] >> 12) & 1;
+    bool osxsave = (regs[2] >> 27) & 1;
+    bool cpuAvx = (regs[2] >> 28) & 1;
+
+    // Avx registers are only usable if the os saves them (xmm/ymm bits, zmm bits for avx512)
+    u64 xcr0 = osxsave ? xgetbv0() : 0;
+    bool osAvx = (xcr0 & 0x6) == 0x6;
+    bool osAvx512 = (xcr0 & 0xE6) == 0xE6;
+
+    f.avx = cpuAvx && osAvx;
+    f.fma = f.fma && osAvx;
+    if (maxLeaf >= 7) {
+        cpuid(7, 0, regs);
+        f.avx2 = ((regs[1] >> 5) & 1) && osAvx;
+        f.avx512f = ((regs[1] >> 16) & 1) && osAvx512;
+        f.avx512bw = ((regs[1] >> 30) & 1) && osAvx512;
+        f.avx512vl = ((regs[1] >> 31) & 1) && osAvx512;
+    }
+#endif
+    return f;
+}
+
+const CpuFeatures& getCpuFeatures() {
+    static CpuFeatures features = detectCpuFeatures();
+    return features;
+}
+
+SimdLevel::ENUM getSupportedSimdLevel(const CpuFeatures& f)
+{
+    if (f.avx512f && f.avx512bw && f.avx512vl && f.avx2 && f.fma) return SimdLevel::AVX512;
+    if (f.avx2 && f.fma) return SimdLevel::AVX2;
+    if (f.sse42) return SimdLevel::SSE42;
+    if (f.sse2) return SimdLevel::SSE2;
+    return SimdLevel::SCALAR;
+}
+
+
+
+// ---------------
+// --- KERNELS ---
+// ---------------
+// Functionpointers of different types are stored as GenericFunc and
+// casted back to their real type in dispatch
+typedef void (*GenericFunc)();
+
+struct KernelImpl
+{
+    SimdLevel::ENUM level;
+    GenericFunc func;
+};
+
+struct Kernel
+{
+    const char* name;
+    GenericFunc implementations[SimdLevel::COUNT];
+    GenericFunc selected;
+    SimdLevel::ENUM selectedLevel;
+};
+
+// Kernels live here so setMaxSimdLevel can reselect them
+struct KernelRegistry
+{
+    Kernel kernels[64];
+    int count;
+    SimdLevel::ENUM maxLevel;
+    bool maxLevelSet;
+};
+
+KernelRegistry kernelRegistry;
+
+SimdLevel::ENUM getDispatchSimdLevel()
+{
+    SimdLevel::ENUM supported = getSupportedSimdLevel(getCpuFeatures());
+    if (kernelRegistry.maxLevelSet && kernelRegistry.maxLevel < supported) {
+        return kernelRegistry.maxLevel;
+    }
+    return supported;
+}
+
+void selectImplementation(Kernel* k)
+{
+    int level = getDispatchSimdLevel();
+    while (k->implementations[level] == nullptr) {
+        level--;
+    }
+    k->selected = k->implementations[level];
+    k->selectedLevel = (SimdLevel::ENUM) level;
+}
+
+// Kernels are globals, so the selection happens during static initialization,
+// before any thread can call dispatch
+Kernel* createKernel(const char* name, std::initializer_list<KernelImpl> impls)
+{
+    assert(kernelRegistry.count < 64, "Too many kernels registered\n");
+    Kernel* k = &kernelRegistry.kernels[kernelRegistry.count++];
+    k->name = name;
+    for (const KernelImpl& impl : impls) {
+        k->implementations[impl.level] = impl.func;
+    }
+    assert(k->implementations[SimdLevel::SCALAR] != nullptr, "Kernel %s needs a scalar fallback\n", name);
+    selectImplementation(k);
+    return k;
+}
+
+template<typename Func>
+inline Func dispatch(const Kernel* k)
+{
+    return (Func) k->selected;
+}
+
+// Reselects all kernels, must not be called while other threads dispatch
+void setMaxSimdLevel(SimdLevel::ENUM level)
+{
+    kernelRegistry.maxLevel = level;
+    kernelRegistry.maxLevelSet = true;
+    for (int i = 0; i < kernelRegistry.count; i++) {
+        selectImplementation(&kernelRegistry.kernels[i]);
+    }
+}
+
+void logKernelDispatch()
+{
+    const CpuFeatures& f = getCpuFeatures();
+    loggf("CPU features: SSE2 %d, SSE4.1 %d, SSE4.2 %d, POPCNT %d, AVX %d, AVX2 %d, FMA %d, AVX512(F/BW/VL) %d/%d/%d\n",
+            f.sse2, f.sse41, f.sse42, f.popcnt, f.avx, f.avx2, f.fma, f.avx512f, f.avx512bw, f.avx512vl);
+    loggf("SIMD level: supported %s, used %s\n",
+            toStr(getSupportedSimdLevel(f)), toStr(getDispatchSimdLevel()));
+    for (int i = 0; i < kernelRegistry.count; i++) {
+        Kernel* k = &kernelRegistry.kernels[i];
+        loggf("    %s: %s\n", k->name, toStr(k->selectedLevel));
+    }
+}
+
+
+
+#endif